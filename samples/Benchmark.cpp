@@ -0,0 +1,718 @@
+#define MLG_LOGGER_NAME "BNCH"
+
+#include "Camera.h"
+#include "DynamicResolution.h"
+#include "FileFetcher.h"
+#include "GltfLoader.h"
+#include "GpuHelper.h"
+#include "Level.h"
+#include "Log.h"
+#include "PerfMetrics.h"
+#include "PropKit.h"
+#include "Scene.h"
+#include "ShapeMeshDefs.h"
+#include "StaticBatcher.h"
+#include "ThreadPool.h"
+#include "Timer.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <filesystem>
+#include <format>
+#include <map>
+#include <numbers>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <vector>
+
+// Renders a level offscreen along a scripted camera path and logs CPU timing stats.
+// No window or surface is needed, so it can run in CI on Dawn's Null or SwiftShader adapters.
+//
+// Usage: Benchmark [--frames N] [--width W] [--height H] [--backend null|vulkan|metal|d3d12]
+//                  [--fallback] [--occlusion] [--prepass] [--quantize] [--optimize-meshes]
+//                  [--static-batching] [--fused-transforms] [--normal-matrices]
+//                  [--target-fps N] [--grid-size N] [--views N] [--separate-views]
+//                  [path/to/level.gltf]
+//
+// Without a glTF path a generated grid of N^3 shapes is rendered, 16^3 by default.
+// With --views the target is split into N side by side views, each following the camera path
+// from a different point, which are rendered together by Scene::RenderViews(). With
+// --separate-views each view is rendered by its own call to Scene::Render() instead, to compare
+// against. Each of those calls clears the target, so only the last view is kept.
+// With --target-fps the resolution scale is adjusted to hold N frames per second, from measured
+// GPU frame times where timestamp queries are supported and from frame times otherwise, e.g. on
+// the Null backend. Frames are paced by the GPU, so frame times track GPU time when it's the
+// bottleneck.
+
+namespace
+{
+constexpr Dimension2 kDefaultDimensions{ .Width = 1280, .Height = 720 };
+constexpr uint32_t kDefaultFrameCount = 600;
+constexpr uint32_t kDefaultGridSize = 16;
+
+// Frames rendered before measuring, while pipelines and static bundles are created.
+constexpr uint32_t kWarmupFrameCount = 16;
+
+// Limits how far the CPU can run ahead of the GPU, as presenting would.
+constexpr uint64_t kMaxFramesInFlight = 2;
+
+// The camera circles the level kOrbitCount times at this fraction of its bounding radius,
+// bobbing up and down once.
+constexpr float kOrbitRadiusScale = 0.75f;
+constexpr float kOrbitHeightScale = 0.25f;
+constexpr float kOrbitCount = 2;
+
+constexpr size_t kMaxPerfStats = 256;
+
+struct BenchmarkOptions
+{
+    GpuHelper::HeadlessOptions Headless{ .Dimensions = kDefaultDimensions };
+    uint32_t FrameCount{ kDefaultFrameCount };
+    bool OcclusionCulling{ false };
+    bool DepthPrepass{ false };
+    bool QuantizeVertices{ false };
+    bool OptimizeMeshes{ false };
+    bool StaticBatching{ false };
+    bool FusedTransforms{ false };
+    bool NormalMatrices{ false };
+    uint32_t ViewCount{ 1 };
+    bool SeparateViews{ false };
+    uint32_t GridSize{ kDefaultGridSize };
+    // Zero disables dynamic resolution.
+    uint32_t TargetFps{ 0 };
+    std::filesystem::path GltfPath;
+};
+
+Result<uint32_t>
+ParseUint(const std::string_view name, const std::string_view value)
+{
+    uint32_t result = 0;
+    const auto [ptr, ec] = std::from_chars(value.data(), value.data() + value.size(), result);
+
+    MLG_CHECK(ec == std::errc{} && ptr == value.data() + value.size() && result > 0,
+        "Invalid value for {}: {}",
+        name,
+        value);
+
+    return result;
+}
+
+Result<wgpu::BackendType>
+ParseBackend(const std::string_view value)
+{
+    constexpr std::pair<std::string_view, wgpu::BackendType> kBackends[] //
+        {
+            { "null", wgpu::BackendType::Null },
+            { "vulkan", wgpu::BackendType::Vulkan },
+            { "metal", wgpu::BackendType::Metal },
+            { "d3d12", wgpu::BackendType::D3D12 },
+            { "opengl", wgpu::BackendType::OpenGL },
+        };
+
+    for(const auto& [name, backendType] : kBackends)
+    {
+        if(name == value)
+        {
+            return backendType;
+        }
+    }
+
+    MLG_ERROR("Unknown backend: {}", value);
+    return Result<>::Fail;
+}
+
+Result<BenchmarkOptions>
+ParseOptions(const std::span<char*> args)
+{
+    BenchmarkOptions options;
+
+    for(size_t i = 1; i < args.size(); ++i)
+    {
+        const std::string_view arg = args[i];
+
+        auto nextValue = [&]() -> Result<std::string_view>
+        {
+            MLG_CHECK(i + 1 < args.size(), "Missing value for {}", arg);
+            return std::string_view(args[++i]);
+        };
+
+        if(arg == "--frames"
+            || arg == "--width"
+            || arg == "--height"
+            || arg == "--target-fps"
+            || arg == "--grid-size"
+            || arg == "--views")
+        {
+            auto value = nextValue();
+            MLG_CHECK(value);
+
+            auto number = ParseUint(arg, *value);
+            MLG_CHECK(number);
+
+            if(arg == "--frames")
+            {
+                options.FrameCount = *number;
+            }
+            else if(arg == "--target-fps")
+            {
+                options.TargetFps = *number;
+            }
+            else if(arg == "--grid-size")
+            {
+                options.GridSize = *number;
+            }
+            else if(arg == "--views")
+            {
+                MLG_CHECK(*number <= Scene::kMaxViews,
+                    "At most {} views are supported",
+                    Scene::kMaxViews);
+                options.ViewCount = *number;
+            }
+            else if(arg == "--width")
+            {
+                options.Headless.Dimensions.Width = *number;
+            }
+            else
+            {
+                options.Headless.Dimensions.Height = *number;
+            }
+        }
+        else if(arg == "--backend")
+        {
+            auto value = nextValue();
+            MLG_CHECK(value);
+
+            auto backendType = ParseBackend(*value);
+            MLG_CHECK(backendType);
+
+            options.Headless.BackendType = *backendType;
+        }
+        else if(arg == "--fallback")
+        {
+            options.Headless.ForceFallbackAdapter = true;
+        }
+        else if(arg == "--occlusion")
+        {
+            options.OcclusionCulling = true;
+        }
+        else if(arg == "--prepass")
+        {
+            options.DepthPrepass = true;
+        }
+        else if(arg == "--quantize")
+        {
+            options.QuantizeVertices = true;
+        }
+        else if(arg == "--optimize-meshes")
+        {
+            options.OptimizeMeshes = true;
+        }
+        else if(arg == "--static-batching")
+        {
+            options.StaticBatching = true;
+        }
+        else if(arg == "--fused-transforms")
+        {
+            options.FusedTransforms = true;
+        }
+        else if(arg == "--normal-matrices")
+        {
+            options.NormalMatrices = true;
+        }
+        else if(arg == "--separate-views")
+        {
+            options.SeparateViews = true;
+        }
+        else
+        {
+            MLG_CHECK(!arg.starts_with("--"), "Unknown option: {}", arg);
+            options.GltfPath = arg;
+        }
+    }
+
+    MLG_CHECK(options.ViewCount <= options.Headless.Dimensions.Width,
+        "Too many views for a width of {}",
+        options.Headless.Dimensions.Width);
+
+    return options;
+}
+
+Result<std::unique_ptr<GpuHelper>>
+CreateGpuHelper(const GpuHelper::HeadlessOptions& options)
+{
+    auto task = GpuHelper::CreateHeadless(options);
+    MLG_CHECK(task, "Failed to create GpuHelper");
+
+    while(!task->IsComplete())
+    {
+        MLG_CHECK(task->Update());
+    }
+
+    return task->Get();
+}
+
+// Generates a gridSize^3 grid of static shapes.
+void
+GenerateLevel(const uint32_t gridSize, PropKitDef& outPropKitDef, LevelDef& outLevelDef)
+{
+    constexpr float kSpacing = 4.0f;
+    constexpr float kShapeExtent = 2.0f;
+
+    outPropKitDef = PropKitDef //
+        {
+            .ModelDefs //
+            {
+                {
+                    .Name{ "Ball" },
+                    .MeshDefs{ ShapeMeshDefs::Ball({ .Radius = kShapeExtent * 0.5f }) },
+                },
+                {
+                    .Name{ "Box" },
+                    .MeshDefs //
+                    {
+                        ShapeMeshDefs::Box({
+                            .Width = kShapeExtent,
+                            .Height = kShapeExtent,
+                            .Depth = kShapeExtent,
+                        }),
+                    },
+                },
+            },
+        };
+
+    const float halfExtent = static_cast<float>(gridSize - 1) * kSpacing * 0.5f;
+
+    for(uint32_t x = 0; x < gridSize; ++x)
+    {
+        for(uint32_t y = 0; y < gridSize; ++y)
+        {
+            for(uint32_t z = 0; z < gridSize; ++z)
+            {
+                const Vec3f position = Vec3f(static_cast<float>(x),
+                                           static_cast<float>(y),
+                                           static_cast<float>(z))
+                        * kSpacing
+                    - Vec3f(halfExtent);
+
+                RootNodeDef nodeDef //
+                    {
+                        .Name{ std::format("Shape{}_{}_{}", x, y, z) },
+                        .Transform{ .T{ position } },
+                        .Model = ModelRef{ .Name = (x + y + z) % 2 == 0 ? "Ball" : "Box" },
+                    };
+
+                outLevelDef.NodeDefs.push_back(std::move(nodeDef));
+            }
+        }
+    }
+
+    if(outLevelDef.StaticBatching)
+    {
+        const size_t batchedCount = StaticBatcher::Build(outPropKitDef, outLevelDef);
+        MLG_INFO("Static batching merged {} meshes, leaving {} models",
+            batchedCount,
+            outPropKitDef.ModelDefs.size());
+    }
+}
+
+Result<std::tuple<PropKit, Level>>
+LoadLevel(GpuHelper& gpuHelper,
+    ThreadPool& threadPool,
+    FileFetcher& fileFetcher,
+    const BenchmarkOptions& options)
+{
+    const std::filesystem::path& path = options.GltfPath;
+
+    PropKitDef propKitDef;
+    LevelDef levelDef //
+        {
+            .StaticBatching = options.StaticBatching,
+        };
+
+    if(path.empty())
+    {
+        GenerateLevel(options.GridSize, propKitDef, levelDef);
+    }
+    else
+    {
+        MLG_CHECK(GltfLoader::Load(path.string(), propKitDef, levelDef),
+            "Failed to load glTF file: {}",
+            path.string());
+    }
+
+    propKitDef.VertexFormat =
+        options.QuantizeVertices ? VertexFormat::Quantized : VertexFormat::Float;
+    propKitDef.OptimizeMeshes = options.OptimizeMeshes;
+
+    auto propKit =
+        PropKit::Create(gpuHelper, threadPool, fileFetcher, path.parent_path(), propKitDef);
+    MLG_CHECK(propKit, "Failed to create PropKit");
+
+    auto level = Level::Create(levelDef, *propKit);
+    MLG_CHECK(level, "Failed to create Level");
+
+    return std::make_tuple(std::move(*propKit), std::move(*level));
+}
+
+// Returns a sphere enclosing the level's models.
+BoundingSphere
+GetLevelBounds(const Level& level)
+{
+    const std::span<const ModelNode> modelNodes = level.GetAllModelNodes();
+
+    if(modelNodes.empty())
+    {
+        return BoundingSphere(Vec3f(0), 1);
+    }
+
+    Vec3f center(0);
+
+    for(const ModelNode& modelNode : modelNodes)
+    {
+        center += (modelNode.GetWorldTransform() * modelNode.GetBoundingSphere()).GetCenter();
+    }
+
+    center = center / static_cast<float>(modelNodes.size());
+
+    float radius = 0;
+
+    for(const ModelNode& modelNode : modelNodes)
+    {
+        const BoundingSphere bs = modelNode.GetWorldTransform() * modelNode.GetBoundingSphere();
+        radius = std::max(radius, (bs.GetCenter() - center).Length() + bs.GetRadius());
+    }
+
+    return BoundingSphere(center, radius);
+}
+
+// Returns the camera transform for a point along the scripted path, where t runs from 0 to 1.
+TrTransformf
+GetCameraTransform(const BoundingSphere& levelBounds, const float t)
+{
+    constexpr float kTwoPi = 2 * std::numbers::pi_v<float>;
+
+    const float orbitAngle = kTwoPi * kOrbitCount * t;
+    const float orbitRadius = levelBounds.GetRadius() * kOrbitRadiusScale;
+    const float height = levelBounds.GetRadius() * kOrbitHeightScale * std::sin(kTwoPi * t);
+
+    const Vec3f position = levelBounds.GetCenter()
+        + Vec3f(-std::sin(orbitAngle) * orbitRadius, height, -std::cos(orbitAngle) * orbitRadius);
+
+    // Look at the center of the level. Yaw rotates +Z towards +X and pitch rotates +Z
+    // towards -Y.
+    const Vec3f forward = (levelBounds.GetCenter() - position).Normalize();
+    const float yaw = std::atan2(forward.x, forward.z);
+    const float pitch = std::asin(std::clamp(-forward.y, -1.0f, 1.0f));
+
+    return TrTransformf //
+        {
+            .T{ position },
+            .R = UnitQuatf(Radiansf(yaw), Vec3f::YAXIS())
+                * UnitQuatf(Radiansf(pitch), Vec3f::XAXIS()),
+        };
+}
+
+void
+OnFrameDone(wgpu::QueueWorkDoneStatus status, wgpu::StringView message, uint64_t* completedFrames)
+{
+    if(status != wgpu::QueueWorkDoneStatus::Success)
+    {
+        MLG_ERROR("OnSubmittedWorkDone failed: {}", std::string_view(message.data, message.length));
+    }
+
+    ++*completedFrames;
+}
+
+// Per-frame values of each perf counter, keyed by counter name.
+using CounterSamples = std::map<std::string, std::vector<double>, std::less<>>;
+
+template<typename Cat>
+void
+SampleCounters(CounterSamples& samples)
+{
+    PerfStats perfStats[kMaxPerfStats];
+    std::span<PerfStats> perfStatsSpan(perfStats);
+
+    const size_t counterCount = PerfMetrics::SampleCounters<Cat>(perfStatsSpan);
+
+    for(const PerfStats& stats : perfStatsSpan.first(counterCount))
+    {
+        samples[stats.GetName().c_str()].push_back(stats.GetLastValue());
+    }
+}
+
+double
+Percentile(const std::span<const double> sortedValues, const double fraction)
+{
+    const double rank = fraction * static_cast<double>(sortedValues.size() - 1);
+    return sortedValues[static_cast<size_t>(std::lround(rank))];
+}
+
+void
+LogStats(const CounterSamples& samples, const std::string_view title)
+{
+    MLG_INFO("{:<48} {:>10} {:>10} {:>10} {:>10} {:>10}",
+        title,
+        "mean",
+        "p50",
+        "p95",
+        "p99",
+        "max");
+
+    for(const auto& [name, values] : samples)
+    {
+        std::vector<double> sorted = values;
+        std::ranges::sort(sorted);
+
+        if(sorted.empty() || sorted.back() == 0)
+        {
+            // Not updated while measuring.
+            continue;
+        }
+
+        double sum = 0;
+        for(const double value : sorted)
+        {
+            sum += value;
+        }
+
+        MLG_INFO("{:<48} {:>10.3f} {:>10.3f} {:>10.3f} {:>10.3f} {:>10.3f}",
+            name,
+            sum / static_cast<double>(sorted.size()),
+            Percentile(sorted, 0.5),
+            Percentile(sorted, 0.95),
+            Percentile(sorted, 0.99),
+            sorted.back());
+    }
+}
+
+Result<>
+RunBenchmark(const BenchmarkOptions& options)
+{
+    auto gpuHelperResult = CreateGpuHelper(options.Headless);
+    MLG_CHECK(gpuHelperResult);
+
+    GpuHelper& gpuHelper = **gpuHelperResult;
+
+    auto fileFetcherResult = FileFetcher::Create();
+    MLG_CHECK(fileFetcherResult, "Failed to create FileFetcher");
+    FileFetcher& fileFetcher = **fileFetcherResult;
+
+    auto threadPoolResult = ThreadPool::Create();
+    MLG_CHECK(threadPoolResult, "Failed to create ThreadPool");
+    ThreadPool& threadPool = **threadPoolResult;
+
+    auto loadResult = LoadLevel(gpuHelper, threadPool, fileFetcher, options);
+    MLG_CHECK(loadResult);
+
+    auto&& [propKit, level] = std::move(*loadResult);
+
+    auto sceneResult = Scene::Create(gpuHelper, fileFetcher, level.GetAllModelNodes());
+    MLG_CHECK(sceneResult);
+
+    Scene scene = std::move(*sceneResult);
+    scene.SetOcclusionCullingEnabled(options.OcclusionCulling, &threadPool);
+    scene.SetDepthPrepassEnabled(options.DepthPrepass);
+    scene.SetFusedTransformsEnabled(options.FusedTransforms);
+    scene.SetNormalMatricesEnabled(options.NormalMatrices);
+
+    const BoundingSphere levelBounds = GetLevelBounds(level);
+    Camera camera((Viewport(gpuHelper.GetScreenDimensions())));
+
+    // Side by side views, each with a camera the size of its rect.
+    const Dimension2 screenDimensions = gpuHelper.GetScreenDimensions();
+    const uint32_t viewWidth = screenDimensions.Width / options.ViewCount;
+
+    // Views point at their cameras, so the cameras must not be reallocated.
+    std::vector<Camera> viewCameras;
+    viewCameras.reserve(options.ViewCount);
+
+    std::vector<Scene::View> views;
+
+    for(uint32_t i = 0; i < options.ViewCount; ++i)
+    {
+        const Rect viewRect({ .X = static_cast<int>(i * viewWidth),
+            .Y = 0,
+            .Width = viewWidth,
+            .Height = screenDimensions.Height });
+
+        const Camera& viewCamera = viewCameras.emplace_back(
+            Viewport(Dimension2{ .Width = viewWidth, .Height = screenDimensions.Height }));
+
+        views.push_back(Scene::View //
+            {
+                .ViewCamera = &viewCamera,
+                .CameraXForm{},
+                .Target = nullptr,
+                .DstRect = viewRect,
+            });
+    }
+
+    const wgpu::Queue queue = gpuHelper.GetDevice().GetQueue();
+    const wgpu::Instance& instance = gpuHelper.GetInstance();
+
+    std::optional<DynamicResolution> dynamicResolution;
+
+    if(options.TargetFps > 0)
+    {
+        dynamicResolution.emplace(DynamicResolution::Params //
+            {
+                .TargetFrameSeconds = 1.0f / static_cast<float>(options.TargetFps),
+            });
+    }
+
+    Timer frameTimer;
+    double scaleSum = 0;
+
+    uint64_t submittedFrames = 0;
+    uint64_t completedFrames = 0;
+
+    CounterSamples timerSamples;
+    CounterSamples counterSamples;
+
+    // Discard anything counted while loading.
+    SampleCounters<PerfTimerCategory>(timerSamples);
+    SampleCounters<PerfCounterDefaultCategory>(counterSamples);
+
+    const uint32_t totalFrames = kWarmupFrameCount + options.FrameCount;
+
+    for(uint32_t frame = 0; frame < totalFrames; ++frame)
+    {
+        if(frame == kWarmupFrameCount)
+        {
+            timerSamples.clear();
+            counterSamples.clear();
+            scaleSum = 0;
+        }
+
+        frameTimer.Restart();
+
+        {
+            MLG_SCOPED_TIMER("Benchmark.Frame");
+
+            const float t = static_cast<float>(frame) / static_cast<float>(totalFrames);
+            const TrTransformf cameraXForm = GetCameraTransform(levelBounds, t);
+
+            auto target = gpuHelper.GetSwapChainTexture();
+            MLG_CHECK(target);
+
+            if(options.ViewCount == 1)
+            {
+                MLG_CHECK(scene.Render(camera, cameraXForm, propKit, *target));
+            }
+            else
+            {
+                for(uint32_t i = 0; i < options.ViewCount; ++i)
+                {
+                    // The path is periodic, so views can start past its end.
+                    const float viewT =
+                        t + static_cast<float>(i) / static_cast<float>(options.ViewCount);
+
+                    views[i].CameraXForm = GetCameraTransform(levelBounds, viewT);
+                    views[i].Target = &*target;
+                }
+
+                if(options.SeparateViews)
+                {
+                    for(const Scene::View& view : views)
+                    {
+                        MLG_CHECK(scene.Render(*view.ViewCamera,
+                            view.CameraXForm,
+                            propKit,
+                            *target,
+                            view.DstRect));
+                    }
+                }
+                else
+                {
+                    MLG_CHECK(scene.RenderViews(views, propKit));
+                }
+            }
+        }
+
+        queue.OnSubmittedWorkDone(wgpu::CallbackMode::AllowProcessEvents,
+            OnFrameDone,
+            &completedFrames);
+        ++submittedFrames;
+
+        {
+            MLG_SCOPED_TIMER("Benchmark.WaitForGpu");
+
+            instance.ProcessEvents();
+
+            while(submittedFrames - completedFrames > kMaxFramesInFlight)
+            {
+                instance.ProcessEvents();
+            }
+        }
+
+        SampleCounters<PerfTimerCategory>(timerSamples);
+        SampleCounters<PerfCounterDefaultCategory>(counterSamples);
+
+        scaleSum += scene.GetResolutionScale();
+
+        if(dynamicResolution)
+        {
+            const float gpuSeconds = scene.GetGpuFrameSeconds();
+            const float frameSeconds = gpuSeconds > 0 ? gpuSeconds : frameTimer.GetElapsedSeconds();
+
+            scene.SetResolutionScale(dynamicResolution->Update(frameSeconds));
+        }
+    }
+
+    // Callbacks reference completedFrames.
+    while(completedFrames < submittedFrames)
+    {
+        instance.ProcessEvents();
+    }
+
+    const Dimension2 dimensions = gpuHelper.GetScreenDimensions();
+
+    MLG_INFO("Rendered {} frames at {}x{} ({} warmup frames excluded)",
+        options.FrameCount,
+        dimensions.Width,
+        dimensions.Height,
+        kWarmupFrameCount);
+
+    MLG_INFO("{} model nodes, {} transforms",
+        level.GetAllModelNodes().size(),
+        options.FusedTransforms ? "fused" : "precomputed");
+
+    if(options.ViewCount > 1)
+    {
+        MLG_INFO("{} views rendered {}",
+            options.ViewCount,
+            options.SeparateViews ? "separately" : "together");
+    }
+
+    if(dynamicResolution)
+    {
+        MLG_INFO("Targeting {} fps, mean resolution scale {:.3f}, final resolution scale {:.3f}",
+            options.TargetFps,
+            scaleSum / static_cast<double>(options.FrameCount),
+            scene.GetResolutionScale());
+    }
+
+    LogStats(timerSamples, "CPU time per frame (ms)");
+    LogStats(counterSamples, "Counters per frame");
+
+    return Result<>::Ok;
+}
+} // namespace
+
+int
+main(int argc, char** argv)
+{
+    auto options = ParseOptions(std::span<char*>(argv, static_cast<size_t>(argc)));
+
+    if(!options || !RunBenchmark(*options))
+    {
+        return -1;
+    }
+
+    return 0;
+}
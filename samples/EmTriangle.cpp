@@ -204,12 +204,10 @@ TriangleApp::InnerUpdate(System& system)
                 m_Viewport = Viewport(gpuHelper.GetScreenDimensions());
                 m_Camera.SetViewport(m_Viewport);
 
-                MLG_CHECK(m_Scene->Render(m_Camera, m_CameraXForm, *m_PropKit));
-
                 auto target = gpuHelper.GetSwapChainTexture();
                 MLG_CHECKV(target, "Failed to get swap chain texture");
 
-                MLG_CHECK(m_Scene->Composite(*target));
+                MLG_CHECK(m_Scene->Render(m_Camera, m_CameraXForm, *m_PropKit, *target));
 
                 MLG_CHECK(
                     system.GetImGuiRenderer().Render(gpuHelper.GetDevice(), *target, RenderGui));
@@ -8,6 +8,7 @@
 #include "PropKit.h"
 #include "Scene.h"
 #include "ShapeMeshDefs.h"
+#include "SimulationThread.h"
 #include "System.h"
 #include "ThreadPool.h"
 
@@ -39,6 +40,12 @@ constexpr float kGravitationalConstant = 0.1f; // 6.674e-11f;//(m^3 kg^-1 s^-2)
 
 constexpr bool kApplyGravityMultithreaded = true;
 
+// Steps the simulation on its own thread, overlapping it with rendering. Otherwise the
+// simulation steps once per frame before the scene renders.
+constexpr bool kRunSimulationOnThread = true;
+
+constexpr float kImpulseMagnitude = 5.0f;
+
 struct PerfCounterGlobals
 {
     static inline PerfCounter TotalPE{ { .Name = "Energy.PE" } }; // Potential Energy
@@ -542,6 +549,45 @@ ComputeKineticEnergy(const Level& level)
     return kineticEnergy;
 }
 
+/// @brief Advances the simulation by one time step.
+void
+StepSimulation(Level& level, ThreadPool& threadPool, const float timeStep)
+{
+    level.Update(timeStep);
+    ApplyGravity(level, threadPool);
+
+    const float kineticEnergy = ComputeKineticEnergy(level);
+    const double totalEnergy = kineticEnergy + PerfCounterGlobals::TotalPE.GetValue();
+
+    PerfCounterGlobals::TotalKE.Set(kineticEnergy);
+    PerfCounterGlobals::TotalEnergy.Set(totalEnergy);
+}
+
+/// @brief State shared with the simulation thread.
+struct SimulationContext
+{
+    Level* SimLevel{ nullptr };
+    ThreadPool* SimThreadPool{ nullptr };
+};
+
+void
+StepSimulationOnThread(SimulationContext* context, const float timeStep)
+{
+    StepSimulation(*context->SimLevel, *context->SimThreadPool, timeStep);
+}
+
+void
+ExplodeCommand(SimulationContext* context)
+{
+    ApplyExplosionImpulse(*context->SimLevel, kImpulseMagnitude);
+}
+
+void
+StopAllCommand(SimulationContext* context)
+{
+    StopAll(*context->SimLevel);
+}
+
 Result<>
 MainLoop()
 {
@@ -578,6 +624,23 @@ MainLoop()
 
     ApplyRandomVelocities(level);
 
+    SimulationContext simContext{ .SimLevel = &level, .SimThreadPool = &threadPool };
+    std::unique_ptr<SimulationThread> simThread;
+
+    if constexpr(kRunSimulationOnThread)
+    {
+        auto simThreadResult = SimulationThread::Create<StepSimulationOnThread>(kPhysicsTimeStep,
+            level.GetAllModelNodes(),
+            &simContext);
+        MLG_CHECK(simThreadResult);
+
+        simThread = std::move(*simThreadResult);
+
+        // The level belongs to the simulation thread from here on. The scene renders the
+        // transforms it publishes.
+        scene.SetTransformSnapshots(&simThread->GetSnapshots(), simThread->GetModelNodes());
+    }
+
     constexpr float kInitialCameraDistance = 40.0f;
 
     TrTransformf cameraXForm{ .T{ 0, 0, -kInitialCameraDistance } };
@@ -716,28 +779,39 @@ MainLoop()
         }
         if(inputMapper.Action(explode))
         {
-            constexpr float kImpulseMagnitude = 5.0f;
-            ApplyExplosionImpulse(level, kImpulseMagnitude);
+            if(simThread)
+            {
+                simThread->Post<ExplodeCommand>(&simContext);
+            }
+            else
+            {
+                ApplyExplosionImpulse(level, kImpulseMagnitude);
+            }
         }
         if(inputMapper.Action(stopAll))
         {
-            StopAll(level);
+            if(simThread)
+            {
+                simThread->Post<StopAllCommand>(&simContext);
+            }
+            else
+            {
+                StopAll(level);
+            }
         }
         if(inputMapper.Action(pause))
         {
             pauseSim = !pauseSim;
+
+            if(simThread)
+            {
+                simThread->SetPaused(pauseSim);
+            }
         }
 
-        if(!pauseSim)
+        if(!simThread && !pauseSim)
         {
-            level.Update(kPhysicsTimeStep);
-            ApplyGravity(level, threadPool);
-
-            const float kineticEnergy = ComputeKineticEnergy(level);
-            const double totalEnergy = kineticEnergy + PerfCounterGlobals::TotalPE.GetValue();
-
-            PerfCounterGlobals::TotalKE.Set(kineticEnergy);
-            PerfCounterGlobals::TotalEnergy.Set(totalEnergy);
+            StepSimulation(level, threadPool, kPhysicsTimeStep);
         }
 
         if(isCameraActorActive)
@@ -758,8 +832,11 @@ MainLoop()
             const Viewport sceneViewport(scenePanelRect.GetDimensions());
             cameraActor.SetViewport(sceneViewport);
 
-            MLG_CHECK(scene.Render(cameraActor.GetCamera(), cameraXForm, propKit));
-            MLG_CHECK(scene.Composite(*target, scenePanelRect));
+            MLG_CHECK(scene.Render(cameraActor.GetCamera(),
+                cameraXForm,
+                propKit,
+                *target,
+                scenePanelRect));
         }
 
         auto renderGui = [&]() { return devUi.Render(); };
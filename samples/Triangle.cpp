@@ -243,8 +243,7 @@ MainLoop()
         auto target = gpuHelper->GetSwapChainTexture();
         MLG_CHECKV(target, "Failed to get swap chain texture");
 
-        MLG_CHECK(scene.Render(camera, cameraXForm, propKit));
-        MLG_CHECK(scene.Composite(*target));
+        MLG_CHECK(scene.Render(camera, cameraXForm, propKit, *target));
 
         MLG_CHECK(imGuiRenderer->Render(gpuHelper->GetDevice(), *target, RenderGui));
 
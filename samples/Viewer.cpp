@@ -1,4 +1,5 @@
 #include "CameraActor.h"
+#include "DynamicResolution.h"
 #include "GltfLoader.h"
 #include "GpuColorPass.h"
 #include "GpuHelper.h"
@@ -20,6 +21,22 @@ namespace
 {
 constexpr const char* kAppName = "Viewer";
 
+// Sponza is heavily occluded, so software occlusion culling pays off.
+constexpr bool kEnableOcclusionCulling = true;
+
+// Sponza's overlapping walls and arches shade many hidden fragments without a depth prepass.
+constexpr bool kEnableDepthPrepass = true;
+
+// Sponza is hundreds of small static meshes sharing a few dozen materials, so batching them
+// cuts draw calls.
+constexpr bool kEnableStaticBatching = true;
+
+// Lowers the resolution the scene is rendered at when the GPU can't hold the target frame rate.
+// Driven by GPU frame times, which aren't capped by presentation, so it does nothing without
+// timestamp queries.
+constexpr bool kEnableDynamicResolution = true;
+constexpr float kTargetFrameSeconds = 1.0f / 60;
+
 Result<>
 RenderGui()
 {
@@ -83,7 +100,10 @@ LoadLevel(GpuHelper& gpuHelper,
     const std::filesystem::path& path)
 {
     PropKitDef propKitDef;
-    LevelDef levelDef;
+    LevelDef levelDef //
+        {
+            .StaticBatching = kEnableStaticBatching,
+        };
     MLG_CHECK(GltfLoader::Load(path.string(), propKitDef, levelDef),
         "Failed to load glTF file: {}",
         path.string());
@@ -98,6 +118,9 @@ LoadLevel(GpuHelper& gpuHelper,
     auto scene = Scene::Create(gpuHelper, fileFetcher, level->GetAllModelNodes());
     MLG_CHECK(scene, "Failed to create Scene for {}", path.string());
 
+    scene->SetOcclusionCullingEnabled(kEnableOcclusionCulling, &threadPool);
+    scene->SetDepthPrepassEnabled(kEnableDepthPrepass);
+
     return std::make_tuple(std::move(*propKit), std::move(*level), std::move(*scene));
 }
 
@@ -214,6 +237,8 @@ MainLoop()
 
     InputMapper inputMapper(actionMappings);
 
+    DynamicResolution dynamicResolution({ .TargetFrameSeconds = kTargetFrameSeconds });
+
     Timer frameTimer;
 
     bool isCameraActorActive = false;
@@ -302,6 +327,8 @@ MainLoop()
             propKit = std::move(newPropKit);
             level = std::move(newLevel);
             scene = std::move(newScene);
+
+            scene.SetResolutionScale(dynamicResolution.GetScale());
         }
 
         const Dimension2 curScreenDimensions = gpuHelper.GetScreenDimensions();
@@ -321,8 +348,12 @@ MainLoop()
         auto target = gpuHelper.GetSwapChainTexture();
         MLG_CHECKV(target, "Failed to get swap chain texture");
 
-        MLG_CHECK(scene.Render(camera, cameraXForm, propKit));
-        MLG_CHECK(scene.Composite(*target));
+        MLG_CHECK(scene.Render(camera, cameraXForm, propKit, *target));
+
+        if(kEnableDynamicResolution && scene.GetGpuFrameSeconds() > 0)
+        {
+            scene.SetResolutionScale(dynamicResolution.Update(scene.GetGpuFrameSeconds()));
+        }
 
         MLG_CHECK(imGuiRenderer.Render(gpuHelper.GetDevice(), *target, RenderGui));
 
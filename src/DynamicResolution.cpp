@@ -0,0 +1,75 @@
+#include "DynamicResolution.h"
+
+#include "AssertHelper.h"
+
+#include <algorithm>
+#include <cmath>
+
+DynamicResolution::DynamicResolution(const Params& params)
+    : m_Params(params),
+      m_Scale(params.MaxScale)
+{
+    MLG_ASSERT(params.TargetFrameSeconds > 0, "Target frame time must be positive");
+    MLG_ASSERT(params.MinScale > 0 && params.MinScale <= params.MaxScale,
+        "Invalid scale range: {} - {}",
+        params.MinScale,
+        params.MaxScale);
+}
+
+float
+DynamicResolution::Update(const float frameSeconds)
+{
+    m_SmoothedFrameSeconds = m_SmoothedFrameSeconds > 0
+        ? m_SmoothedFrameSeconds + ((frameSeconds - m_SmoothedFrameSeconds) * kSmoothing)
+        : frameSeconds;
+
+    if(m_SettleFrames > 0)
+    {
+        --m_SettleFrames;
+        return m_Scale;
+    }
+
+    const float targetSeconds = m_Params.TargetFrameSeconds;
+    float scale = m_Scale;
+
+    if(m_SmoothedFrameSeconds > targetSeconds)
+    {
+        // Drop straight to the largest scale expected to fit the target.
+        const float fittingScale = m_Scale * std::sqrt(targetSeconds / m_SmoothedFrameSeconds);
+
+        scale = std::min(std::floor(fittingScale / kScaleStep) * kScaleStep, m_Scale - kScaleStep);
+    }
+    else if(m_SmoothedFrameSeconds < targetSeconds * (1 - kHeadroom))
+    {
+        // Rise a step at a time, and only if the larger scale is expected to fit the target.
+        const float raisedScale = m_Scale + kScaleStep;
+        const float ratio = raisedScale / m_Scale;
+
+        if(m_SmoothedFrameSeconds * ratio * ratio <= targetSeconds)
+        {
+            scale = raisedScale;
+        }
+    }
+
+    scale = std::clamp(scale, m_Params.MinScale, m_Params.MaxScale);
+
+    if(scale != m_Scale)
+    {
+        m_Scale = scale;
+        m_SettleFrames = kSettleFrameCount;
+    }
+
+    return m_Scale;
+}
+
+Dimension2
+DynamicResolution::Scale(const Dimension2& dimensions) const
+{
+    auto scale = [this](const unsigned size)
+    {
+        const float scaled = std::round(static_cast<float>(size) * m_Scale);
+        return std::max(1u, static_cast<unsigned>(scaled));
+    };
+
+    return Dimension2{ .Width = scale(dimensions.Width), .Height = scale(dimensions.Height) };
+}
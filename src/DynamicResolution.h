@@ -0,0 +1,62 @@
+#pragma once
+
+#include "VecMath.h"
+
+#include <cstdint>
+
+/// @brief Adjusts the scale at which a scene is rendered, from measured frame times, to hold a
+/// target frame time.
+///
+/// Rendering cost is assumed to be proportional to the number of pixels rendered, i.e. to the
+/// square of the scale. Frame times are smoothed, and after each change the scale is held for a
+/// few frames so the smoothed frame time reflects it before it's changed again.
+///
+/// Frame times should be GPU frame times, e.g. from Scene::GetGpuFrameSeconds(). CPU frame times
+/// only track the GPU when it's the bottleneck, and when presenting waits for vsync they never
+/// drop below the refresh interval, so a lowered scale wouldn't be raised again.
+///
+/// Scales are multiples of kScaleStep so only a few render target sizes are ever used, and
+/// targets for them can be reused as the scale changes.
+class DynamicResolution final
+{
+public:
+    static constexpr float kScaleStep = 1.0f / 16;
+
+    /// @brief Weight of each new frame time in the smoothed frame time.
+    static constexpr float kSmoothing = 0.1f;
+
+    /// @brief The scale is raised only when the smoothed frame time is at least this fraction
+    /// below the target, so it doesn't oscillate around the target.
+    static constexpr float kHeadroom = 0.15f;
+
+    /// @brief Frames the scale is held for after it changes.
+    static constexpr uint32_t kSettleFrameCount = 16;
+
+    struct Params
+    {
+        float TargetFrameSeconds{ 1.0f / 60 };
+        float MinScale{ 0.5f };
+        float MaxScale{ 1.0f };
+    };
+
+    DynamicResolution() = delete;
+
+    /// @brief Creates a controller that starts at the maximum scale.
+    explicit DynamicResolution(const Params& params);
+
+    /// @brief Adds a measured frame time and returns the scale to render the next frame at.
+    float Update(const float frameSeconds);
+
+    float GetScale() const { return m_Scale; }
+
+    float GetSmoothedFrameSeconds() const { return m_SmoothedFrameSeconds; }
+
+    /// @brief Returns dimensions scaled by the current scale, at least 1x1.
+    Dimension2 Scale(const Dimension2& dimensions) const;
+
+private:
+    Params m_Params;
+    float m_Scale;
+    float m_SmoothedFrameSeconds{ 0 };
+    uint32_t m_SettleFrames{ 0 };
+};
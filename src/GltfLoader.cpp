@@ -10,6 +10,7 @@
 #include "narrow_cast.h"
 #include "PropKit.h"
 #include "scope_exit.h"
+#include "StaticBatcher.h"
 #include "Vertex.h"
 
 #include <cgltf.h>
@@ -185,6 +186,25 @@ CreateMaterialDef(const cgltf_material* gltfMaterial)
     RgbaColorf color = kDefaultColor;
     float metalness = 0;
     float roughness = 0;
+    AlphaMode alphaMode = AlphaMode::Opaque;
+    float alphaCutoff = MaterialDef{}.AlphaCutoff;
+
+    if(gltfMaterial)
+    {
+        switch(gltfMaterial->alpha_mode)
+        {
+            case cgltf_alpha_mode_mask:
+                alphaMode = AlphaMode::Mask;
+                alphaCutoff = gltfMaterial->alpha_cutoff;
+                break;
+            case cgltf_alpha_mode_blend:
+                alphaMode = AlphaMode::Blend;
+                break;
+            case cgltf_alpha_mode_opaque:
+            default:
+                break;
+        }
+    }
 
     if(!gltfMaterial)
     {
@@ -231,6 +251,8 @@ CreateMaterialDef(const cgltf_material* gltfMaterial)
             .Color = color,
             .Metalness = metalness,
             .Roughness = roughness,
+            .AlphaMode = alphaMode,
+            .AlphaCutoff = alphaCutoff,
         };
 
     return std::move(materialDef);
@@ -613,13 +635,16 @@ GltfLoader::Load(const std::string& path, PropKitDef& outPropKit, LevelDef& outL
             .ModelDefs = std::move(*modelDefs),
         };
 
-    LevelDef levelDef //
-        {
-            .NodeDefs = std::move(*rootNodeDefs),
-        };
-
     outPropKit = std::move(propKit);
-    outLevelDef = std::move(levelDef);
+    outLevelDef.NodeDefs = std::move(*rootNodeDefs);
+
+    if(outLevelDef.StaticBatching)
+    {
+        const size_t batchedCount = StaticBatcher::Build(outPropKit, outLevelDef);
+        MLG_INFO("Static batching merged {} meshes, leaving {} models",
+            batchedCount,
+            outPropKit.ModelDefs.size());
+    }
 
     return Result<>::Ok;
 }
\ No newline at end of file
@@ -18,5 +18,8 @@ public:
     GltfLoader(GltfLoader&&) = delete;
     GltfLoader& operator=(GltfLoader&&) = delete;
 
+    /// @brief Loads the models and nodes of a glTF file, replacing those in the defs.
+    ///
+    /// Statically batches the loaded nodes if outLevelDef.StaticBatching is set.
     static Result<> Load(const std::string& path, PropKitDef& outPropKit, LevelDef& outLevelDef);
 };
\ No newline at end of file
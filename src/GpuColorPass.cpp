@@ -6,6 +6,9 @@
 #include "PerfMetrics.h"
 #include "PropKit.h"
 
+#include <algorithm>
+#include <vector>
+
 namespace
 {
 
@@ -70,6 +73,28 @@ CreateInputsBindGroupLayout(const wgpu::Device& gpuDevice)
                 .minBindingSize = sizeof(ShaderInterop::CameraParams),
             },
         },
+        // Instance remap.
+        {
+            .binding = 5,
+            .visibility = wgpu::ShaderStage::Vertex,
+            .buffer =
+            {
+                .type = wgpu::BufferBindingType::ReadOnlyStorage,
+                .hasDynamicOffset = false,
+                .minBindingSize = sizeof(ShaderInterop::InstanceRemap),
+            },
+        },
+        // Normal matrices.
+        {
+            .binding = 6,
+            .visibility = wgpu::ShaderStage::Vertex,
+            .buffer =
+            {
+                .type = wgpu::BufferBindingType::ReadOnlyStorage,
+                .hasDynamicOffset = false,
+                .minBindingSize = sizeof(ShaderInterop::NormalMatrix),
+            },
+        },
     };
 
     const wgpu::BindGroupLayoutDescriptor desc //
@@ -87,34 +112,62 @@ CreateInputsBindGroupLayout(const wgpu::Device& gpuDevice)
 
 Result<wgpu::PipelineLayout>
 CreatePipelineLayout(const wgpu::Device& gpuDevice,
-    const wgpu::BindGroupLayout& inputsBindGroupLayout,
-    const wgpu::BindGroupLayout& textureBindGroupLayout)
+    const std::span<const wgpu::BindGroupLayout> bindGroupLayouts,
+    const char* label)
 {
-    MLG_CHECK(inputsBindGroupLayout, "Inputs bind group layout is not valid");
-    MLG_CHECK(textureBindGroupLayout, "Texture bind group layout is not valid");
-
-    const wgpu::BindGroupLayout bindGroupLayouts[] //
-        {
-            inputsBindGroupLayout,
-            textureBindGroupLayout,
-        };
+    for(const wgpu::BindGroupLayout& bindGroupLayout : bindGroupLayouts)
+    {
+        MLG_CHECK(bindGroupLayout, "Bind group layout is not valid");
+    }
 
     const wgpu::PipelineLayoutDescriptor pipelineLayoutDesc //
         {
-            .label = "GpuColorPass",
-            .bindGroupLayoutCount = std::size(bindGroupLayouts),
-            .bindGroupLayouts = &bindGroupLayouts[0],
+            .label = label,
+            .bindGroupLayoutCount = bindGroupLayouts.size(),
+            .bindGroupLayouts = bindGroupLayouts.data(),
         };
 
     const wgpu::PipelineLayout pipelineLayout = gpuDevice.CreatePipelineLayout(&pipelineLayoutDesc);
-    MLG_CHECK(pipelineLayout, "Failed to create color pipeline layout");
+    MLG_CHECK(pipelineLayout, "Failed to create pipeline layout: {}", label);
 
     return pipelineLayout;
 }
 
 wgpu::VertexBufferLayout
-GetVertexBufferLayout()
+GetVertexBufferLayout(const VertexFormat vertexFormat)
 {
+    static const wgpu::VertexAttribute quantizedAttributes[] = //
+        {
+            {
+                .format = wgpu::VertexFormat::Unorm16x4,
+                .offset = offsetof(QuantizedVertex, pos),
+                .shaderLocation = 0,
+            },
+            {
+                .format = wgpu::VertexFormat::Snorm16x2,
+                .offset = offsetof(QuantizedVertex, normal),
+                .shaderLocation = 1,
+            },
+            {
+                .format = wgpu::VertexFormat::Float16x2,
+                .offset = offsetof(QuantizedVertex, uv),
+                .shaderLocation = 2,
+            },
+        };
+
+    static const wgpu::VertexBufferLayout quantizedLayout = //
+        {
+            .stepMode = wgpu::VertexStepMode::Vertex,
+            .arrayStride = sizeof(QuantizedVertex),
+            .attributeCount = std::size(quantizedAttributes),
+            .attributes = &quantizedAttributes[0],
+        };
+
+    if(vertexFormat == VertexFormat::Quantized)
+    {
+        return quantizedLayout;
+    }
+
     static const wgpu::VertexAttribute attributes[] = //
         {
             {
@@ -145,6 +198,62 @@ GetVertexBufferLayout()
     return layout;
 }
 
+// Fetches only positions from the shared vertex buffer, for the depth prepass.
+wgpu::VertexBufferLayout
+GetPositionVertexBufferLayout(const VertexFormat vertexFormat)
+{
+    static const wgpu::VertexAttribute quantizedAttribute //
+        {
+            .format = wgpu::VertexFormat::Unorm16x4,
+            .offset = offsetof(QuantizedVertex, pos),
+            .shaderLocation = 0,
+        };
+
+    static const wgpu::VertexBufferLayout quantizedLayout = //
+        {
+            .stepMode = wgpu::VertexStepMode::Vertex,
+            .arrayStride = sizeof(QuantizedVertex),
+            .attributeCount = 1,
+            .attributes = &quantizedAttribute,
+        };
+
+    if(vertexFormat == VertexFormat::Quantized)
+    {
+        return quantizedLayout;
+    }
+
+    static const wgpu::VertexAttribute attribute //
+        {
+            .format = wgpu::VertexFormat::Float32x3,
+            .offset = offsetof(Vertex, pos),
+            .shaderLocation = 0,
+        };
+
+    static const wgpu::VertexBufferLayout layout = //
+        {
+            .stepMode = wgpu::VertexStepMode::Vertex,
+            .arrayStride = sizeof(Vertex),
+            .attributeCount = 1,
+            .attributes = &attribute,
+        };
+
+    return layout;
+}
+
+// Shared by the depth prepass and color pipelines so both rasterize the same fragments.
+wgpu::PrimitiveState
+GetPrimitiveState()
+{
+    return wgpu::PrimitiveState //
+        {
+            .topology = wgpu::PrimitiveTopology::TriangleList,
+            .stripIndexFormat = wgpu::IndexFormat::Undefined,
+            .frontFace = wgpu::FrontFace::CW,
+            .cullMode = wgpu::CullMode::Back,
+            .unclippedDepth = false,
+        };
+}
+
 bool
 BindGroup0NeedsRefresh(const GpuColorPass::Inputs& currentInputs,
     const GpuColorPass::Inputs& newInputs)
@@ -153,14 +262,302 @@ BindGroup0NeedsRefresh(const GpuColorPass::Inputs& currentInputs,
         != newInputs.WorldTransforms.GetGpuBuffer().Get()
         || currentInputs.ClipSpaceTransforms.GetGpuBuffer().Get()
         != newInputs.ClipSpaceTransforms.GetGpuBuffer().Get()
+        || currentInputs.NormalMatrices.GetGpuBuffer().Get()
+        != newInputs.NormalMatrices.GetGpuBuffer().Get()
         || currentInputs.MeshProperties.GetGpuBuffer().Get()
         != newInputs.MeshProperties.GetGpuBuffer().Get()
+        || currentInputs.InstanceRemap.GetGpuBuffer().Get()
+        != newInputs.InstanceRemap.GetGpuBuffer().Get()
         || currentInputs.MaterialConstants.GetGpuBuffer().Get()
         != newInputs.MaterialConstants.GetGpuBuffer().Get()
         || currentInputs.CameraParams.GetGpuBuffer().Get()
         != newInputs.CameraParams.GetGpuBuffer().Get();
 }
 
+// Binds the vertex buffer. Index buffers are bound by the draw encoders, which draw batches
+// of both index formats. Encoder is a render pass or render bundle encoder.
+template<typename Encoder>
+void
+SetGeometryBuffers(const Encoder& encoder, const GpuColorPass::Inputs& inputs)
+{
+    const wgpu::Buffer& vertexBuffer = GetGpuBuffer(inputs.Vertices);
+
+    encoder.SetVertexBuffer(0, vertexBuffer, 0, vertexBuffer.GetSize());
+}
+
+// Binds the index buffer that holds indices of the given format.
+// Encoder is a render pass or render bundle encoder.
+template<typename Encoder>
+void
+SetIndexBuffer(const Encoder& encoder,
+    const GpuColorPass::Inputs& inputs,
+    const IndexFormat indexFormat)
+{
+    static_assert(sizeof(VertexIndex) == sizeof(uint32_t), "VertexIndex must be 32 bits");
+    static_assert(sizeof(VertexIndex16) == sizeof(uint16_t), "VertexIndex16 must be 16 bits");
+
+    if(indexFormat == IndexFormat::Uint16)
+    {
+        encoder.SetIndexBuffer(inputs.Indices16.GetGpuBuffer(),
+            wgpu::IndexFormat::Uint16,
+            0,
+            inputs.Indices16.BufferSize());
+    }
+    else
+    {
+        encoder.SetIndexBuffer(inputs.Indices.GetGpuBuffer(),
+            wgpu::IndexFormat::Uint32,
+            0,
+            inputs.Indices.BufferSize());
+    }
+}
+
+// Binds the index buffer of each batch's index format as it changes, then encodes the batch's
+// indirect draw.
+template<typename Encoder>
+class DrawEncoder
+{
+public:
+    DrawEncoder(const Encoder& encoder, const GpuColorPass::Inputs& inputs)
+        : m_Encoder(&encoder),
+          m_Inputs(&inputs)
+    {
+    }
+
+    void Draw(const DrawBatch& drawBatch)
+    {
+        if(drawBatch.IndexFormat != m_IndexFormat)
+        {
+            m_IndexFormat = drawBatch.IndexFormat;
+
+            SetIndexBuffer(*m_Encoder, *m_Inputs, drawBatch.IndexFormat);
+        }
+
+        const uint64_t indirectOffset =
+            uint64_t{ drawBatch.DrawIndex } * sizeof(ShaderInterop::DrawIndirectParams);
+        m_Encoder->DrawIndexedIndirect(m_Inputs->DrawIndirectBuffer.GetGpuBuffer(), indirectOffset);
+    }
+
+private:
+    const Encoder* m_Encoder;
+    const GpuColorPass::Inputs* m_Inputs;
+    // Unset until the first draw, as nothing is bound yet.
+    std::optional<IndexFormat> m_IndexFormat;
+};
+
+// Returns the batches drawn by the alpha modes in [firstMode, lastMode].
+// Batches are sorted by alpha mode.
+std::span<const DrawBatch>
+GetBatches(const std::span<const DrawBatch> drawBatches,
+    const AlphaMode firstMode,
+    const AlphaMode lastMode)
+{
+    MLG_ASSERT(std::ranges::is_sorted(drawBatches, {}, &DrawBatch::AlphaMode),
+        "Draw batches must be sorted by alpha mode");
+
+    const auto first =
+        std::ranges::lower_bound(drawBatches, firstMode, {}, &DrawBatch::AlphaMode);
+    const auto last = std::ranges::upper_bound(drawBatches, lastMode, {}, &DrawBatch::AlphaMode);
+
+    return { first, last };
+}
+
+using VertexConstants = std::array<wgpu::ConstantEntry, 2>;
+
+// Returns the values of the overridable constants for vertex states.
+VertexConstants
+GetVertexConstants(const bool fusedTransforms, const bool normalMatrices)
+{
+    return VertexConstants //
+        {
+            wgpu::ConstantEntry //
+            {
+                .key = GpuColorPass::kFusedTransformsOverride,
+                .value = fusedTransforms ? 1.0 : 0.0,
+            },
+            wgpu::ConstantEntry //
+            {
+                .key = GpuColorPass::kNormalMatricesOverride,
+                .value = normalMatrices ? 1.0 : 0.0,
+            },
+        };
+}
+
+Result<wgpu::RenderPipeline>
+CreateColorPipeline(const wgpu::Device& gpuDevice,
+    const wgpu::ShaderModule& shader,
+    const wgpu::PipelineLayout& pipelineLayout,
+    const AlphaMode alphaMode,
+    const ShaderVariant shaderVariant,
+    const bool depthPrepass,
+    const VertexConstants& vertexConstants,
+    const VertexFormat vertexFormat,
+    const wgpu::TextureFormat colorFormat)
+{
+    const wgpu::BlendState blendState //
+        {
+            .color =
+            {
+                .operation = wgpu::BlendOperation::Add,
+                .srcFactor = wgpu::BlendFactor::SrcAlpha,
+                .dstFactor = wgpu::BlendFactor::OneMinusSrcAlpha,
+            },
+            .alpha =
+            {
+                .operation = wgpu::BlendOperation::Add,
+                .srcFactor = wgpu::BlendFactor::One,
+                .dstFactor = wgpu::BlendFactor::Zero,
+            },
+        };
+
+    const bool blend = alphaMode == AlphaMode::Blend;
+
+    const wgpu::ColorTargetState colorTargetState //
+        {
+            .format = colorFormat,
+            .blend = blend ? &blendState : nullptr,
+            .writeMask = wgpu::ColorWriteMask::All,
+        };
+
+    // After the depth prepass only the nearest opaque surface of each pixel passes, and the
+    // depth buffer already holds it. Blended surfaces don't hide what's behind them.
+    const bool depthEqual = depthPrepass && alphaMode == AlphaMode::Opaque;
+
+    const wgpu::DepthStencilState depthStencilState //
+        {
+            .format = GpuHelper::kDepthBufferFormat,
+            .depthWriteEnabled = !depthEqual && !blend,
+            .depthCompare = depthEqual ? wgpu::CompareFunction::Equal : wgpu::CompareFunction::Less,
+            .depthBias = 0,
+            .depthBiasSlopeScale = 0.0f,
+            .depthBiasClamp = 0.0f,
+        };
+
+    const bool mask = alphaMode == AlphaMode::Mask;
+
+    const wgpu::FragmentState fragmentState //
+        {
+            .module = shader,
+            .entryPoint = shaderVariant == ShaderVariant::Textured
+                ? (mask ? GpuColorPass::MaskFragmentEntry : GpuColorPass::FragmentEntry)
+                : (mask ? GpuColorPass::UntexturedMaskFragmentEntry
+                        : GpuColorPass::UntexturedFragmentEntry),
+            .targetCount = 1,
+            .targets = &colorTargetState,
+        };
+
+    const wgpu::VertexBufferLayout vertexBufferLayout = GetVertexBufferLayout(vertexFormat);
+
+    constexpr const char* kLabels[kAlphaModeCount][kShaderVariantCount] = //
+        {
+            { "GpuColorPass::Opaque::Untextured", "GpuColorPass::Opaque" },
+            { "GpuColorPass::Mask::Untextured", "GpuColorPass::Mask" },
+            { "GpuColorPass::Blend::Untextured", "GpuColorPass::Blend" },
+        };
+
+    const wgpu::RenderPipelineDescriptor descriptor//
+    {
+        .label = kLabels[static_cast<size_t>(alphaMode)][static_cast<size_t>(shaderVariant)],
+        .layout = pipelineLayout,
+        .vertex =
+        {
+            .module = shader,
+            .entryPoint = vertexFormat == VertexFormat::Quantized
+                ? GpuColorPass::QuantizedVertexEntry
+                : GpuColorPass::VertexEntry,
+            .constantCount = vertexConstants.size(),
+            .constants = vertexConstants.data(),
+            .bufferCount = 1,
+            .buffers = &vertexBufferLayout,
+        },
+        .primitive = GetPrimitiveState(),
+        .depthStencil = &depthStencilState,
+        .multisample =
+        {
+            .count = 1,
+            .mask = 0xFFFFFFFF,
+            .alphaToCoverageEnabled = false,
+        },
+        .fragment = &fragmentState,
+    };
+
+    wgpu::RenderPipeline pipeline = gpuDevice.CreateRenderPipeline(&descriptor);
+    MLG_CHECK(pipeline, "Failed to create render pipeline");
+
+    return pipeline;
+}
+
+// Encodes one indirect draw per batch, binding pipelines, texture array bind groups and index
+// buffers as they change. Untextured batches leave the bound texture array as it is, as their
+// pipelines don't use it. Encoder is a render pass or render bundle encoder.
+// Returns the number of bind group changes.
+template<typename Encoder>
+size_t
+EncodeDrawBatches(const Encoder& encoder,
+    const GpuColorPass::Pipelines& pipelines,
+    const GpuColorPass::Inputs& inputs,
+    const std::span<const DrawBatch> drawBatches,
+    const PropKit& propKit)
+{
+    size_t bindGroupChanges = 0;
+
+    DrawEncoder<Encoder> drawEncoder(encoder, inputs);
+
+    const wgpu::RenderPipeline* lastPipeline = nullptr;
+    const wgpu::BindGroup* lastBindGroup = nullptr;
+
+    for(const DrawBatch& drawBatch : drawBatches)
+    {
+        const wgpu::RenderPipeline* pipeline = &pipelines[static_cast<size_t>(
+            drawBatch.AlphaMode)][static_cast<size_t>(drawBatch.ShaderVariant)];
+
+        if(pipeline != lastPipeline)
+        {
+            lastPipeline = pipeline;
+
+            encoder.SetPipeline(*pipeline);
+        }
+
+        if(drawBatch.ShaderVariant == ShaderVariant::Textured)
+        {
+            const wgpu::BindGroup* bindGroup =
+                propKit.GetTextureArrayBindGroup(drawBatch.TextureArrayIndex);
+            MLG_ASSERT(bindGroup,
+                "Failed to get bind group for texture array {}",
+                drawBatch.TextureArrayIndex);
+
+            if(bindGroup != lastBindGroup)
+            {
+                ++bindGroupChanges;
+
+                lastBindGroup = bindGroup;
+
+                encoder.SetBindGroup(1, *bindGroup, 0, nullptr);
+            }
+        }
+
+        drawEncoder.Draw(drawBatch);
+    }
+
+    return bindGroupChanges;
+}
+
+// Encodes one indirect draw per batch for the depth prepass, which doesn't bind textures.
+// Encoder is a render pass or render bundle encoder.
+template<typename Encoder>
+void
+EncodeDepthDraws(const Encoder& encoder,
+    const GpuColorPass::Inputs& inputs,
+    const std::span<const DrawBatch> drawBatches)
+{
+    DrawEncoder<Encoder> drawEncoder(encoder, inputs);
+
+    for(const DrawBatch& drawBatch : drawBatches)
+    {
+        drawEncoder.Draw(drawBatch);
+    }
+}
+
 } // namespace
 
 Result<GpuColorPass>
@@ -175,11 +572,26 @@ GpuColorPass::Create(const GpuHelper& gpuHelper, FileFetcher& fileFetcher)
     auto textureBindGroupLayout = gpuHelper.GetTextureBindGroupLayout();
     MLG_CHECK(textureBindGroupLayout, "Failed to get texture bind group layout");
 
+    const wgpu::BindGroupLayout bindGroupLayouts[] //
+        {
+            *inputsBindGroupLayout,
+            textureBindGroupLayout,
+        };
+
     auto pipelineLayout =
-        CreatePipelineLayout(gpuHelper.GetDevice(), *inputsBindGroupLayout, textureBindGroupLayout);
+        CreatePipelineLayout(gpuHelper.GetDevice(), bindGroupLayouts, "GpuColorPass");
     MLG_CHECK(pipelineLayout, "Failed to create pipeline layout");
 
-    return GpuColorPass(gpuHelper, *shader, *inputsBindGroupLayout, *pipelineLayout);
+    auto inputsPipelineLayout = CreatePipelineLayout(gpuHelper.GetDevice(),
+        std::span(bindGroupLayouts).first(1),
+        "GpuColorPass::Inputs");
+    MLG_CHECK(inputsPipelineLayout, "Failed to create inputs pipeline layout");
+
+    return GpuColorPass(gpuHelper,
+        *shader,
+        *inputsBindGroupLayout,
+        *pipelineLayout,
+        *inputsPipelineLayout);
 }
 
 Result<>
@@ -193,6 +605,13 @@ GpuColorPass::SetInputs(const Inputs& inputs)
         m_InputsBindGroup = {};
     }
 
+    if(m_Inputs && GetVertexFormat(m_Inputs->Vertices) != GetVertexFormat(inputs.Vertices))
+    {
+        // Pipelines fetch and decode vertices according to their format.
+        m_Pipelines = {};
+        m_DepthPipeline = {};
+    }
+
     m_Inputs = inputs;
 
     return Result<>::Ok;
@@ -203,11 +622,56 @@ GpuColorPass::SetOutputs(const Outputs& outputs)
 {
     MLG_CHECK(outputs.Validate(), "Outputs are not valid");
 
+    if(m_Outputs && m_Outputs->RenderTarget->GetFormat() != outputs.RenderTarget->GetFormat())
+    {
+        // Pipelines write to render targets of one format.
+        m_Pipelines = {};
+        m_DepthPipeline = {};
+    }
+
     m_Outputs = outputs;
 
     return Result<>::Ok;
 }
 
+void
+GpuColorPass::SetDepthPrepassEnabled(const bool enabled)
+{
+    if(enabled != m_DepthPrepassEnabled)
+    {
+        m_DepthPrepassEnabled = enabled;
+
+        // The opaque pipelines' depth state depends on the prepass.
+        m_Pipelines[static_cast<size_t>(AlphaMode::Opaque)] = {};
+    }
+}
+
+void
+GpuColorPass::SetFusedTransformsEnabled(const bool enabled)
+{
+    if(enabled != m_FusedTransformsEnabled)
+    {
+        m_FusedTransformsEnabled = enabled;
+
+        // Every vertex shader is specialized for the transform mode.
+        m_Pipelines = {};
+        m_DepthPipeline = {};
+    }
+}
+
+void
+GpuColorPass::SetNormalMatricesEnabled(const bool enabled)
+{
+    if(enabled != m_NormalMatricesEnabled)
+    {
+        m_NormalMatricesEnabled = enabled;
+
+        // The depth prepass doesn't transform normals, but its constants must match too.
+        m_Pipelines = {};
+        m_DepthPipeline = {};
+    }
+}
+
 Result<GpuColorPass::Invocation>
 GpuColorPass::Prepare()
 {
@@ -230,12 +694,16 @@ GpuColorPass::Prepare()
 Result<GpuColorPass::Invocation>
 GpuColorPass::Prepare(const wgpu::CommandEncoder& cmdEncoder)
 {
-    MLG_CHECK(EnsurePipeline());
+    MLG_CHECK(EnsurePipelines());
+    MLG_CHECK(EnsureDepthPipeline());
     MLG_CHECK(EnsureInputsBindGroup());
 
     MLG_CHECKV(m_Inputs, "Inputs are not valid - forget to call SetInputs()?");
     MLG_CHECKV(m_Outputs, "Outputs are not valid - forget to call SetOutputs()?");
 
+    const wgpu::RenderPipeline depthPipeline =
+        m_DepthPrepassEnabled ? m_DepthPipeline : wgpu::RenderPipeline{};
+
     const wgpu::RenderPassColorAttachment attachment //
         {
             .view = m_Outputs->RenderTarget->CreateView(),
@@ -270,7 +738,11 @@ GpuColorPass::Prepare(const wgpu::CommandEncoder& cmdEncoder)
     {
         MLG_SCOPED_TIMER("GpuColorPass.Prepare.SetPipeline");
 
-        renderPass.SetPipeline(m_Pipeline);
+        // The depth prepass draws first. Otherwise pipelines are set per draw batch.
+        if(depthPipeline)
+        {
+            renderPass.SetPipeline(depthPipeline);
+        }
     }
 
     {
@@ -281,25 +753,7 @@ GpuColorPass::Prepare(const wgpu::CommandEncoder& cmdEncoder)
     {
         MLG_SCOPED_TIMER("GpuColorPass.Prepare.SetBuffers");
 
-        constexpr size_t kU16BitWidth = 16;
-        constexpr size_t kU32BitWidth = 32;
-
-        static_assert(VERTEX_INDEX_BITS == kU32BitWidth || VERTEX_INDEX_BITS == kU16BitWidth,
-            "Unsupported index buffer format: only 16-bit and 32-bit indices are supported");
-
-        constexpr wgpu::IndexFormat idxFmt = (VERTEX_INDEX_BITS == kU32BitWidth)
-            ? wgpu::IndexFormat::Uint32
-            : wgpu::IndexFormat::Uint16;
-
-        renderPass.SetVertexBuffer(0,
-            m_Inputs->Vertices.GetGpuBuffer(),
-            0,
-            m_Inputs->Vertices.BufferSize());
-
-        renderPass.SetIndexBuffer(m_Inputs->Indices.GetGpuBuffer(),
-            idxFmt,
-            0,
-            m_Inputs->Indices.BufferSize());
+        SetGeometryBuffers(renderPass, *m_Inputs);
     }
 
     const Viewport& viewport = m_Inputs->Viewport;
@@ -318,40 +772,171 @@ GpuColorPass::Prepare(const wgpu::CommandEncoder& cmdEncoder)
 
     return Invocation(m_GpuHelper->GetDevice(),
         std::move(renderPass),
-        m_Inputs->DrawIndirectBuffer);
+        *m_Inputs,
+        m_InputsBindGroup,
+        m_Pipelines,
+        depthPipeline);
+}
+
+Result<GpuColorPass::Bundle>
+GpuColorPass::RecordBundle(const std::span<const DrawBatch> drawBatches, const PropKit& propKit)
+{
+    MLG_SCOPED_TIMER("GpuColorPass.RecordBundle");
+
+    static PerfCounter pcBundles({ .Name = "GpuColorPass.RecordBundle.Bundles" });
+
+    MLG_CHECK(EnsurePipelines());
+    MLG_CHECK(EnsureDepthPipeline());
+    MLG_CHECK(EnsureInputsBindGroup());
+
+    MLG_CHECKV(m_Inputs, "Inputs are not valid - forget to call SetInputs()?");
+    MLG_CHECKV(m_Outputs, "Outputs are not valid - forget to call SetOutputs()?");
+
+    const std::span<const DrawBatch> opaqueBatches =
+        GetBatches(drawBatches, AlphaMode::Opaque, AlphaMode::Opaque);
+    const std::span<const DrawBatch> colorBatches =
+        GetBatches(drawBatches, AlphaMode::Opaque, AlphaMode::Mask);
+    const std::span<const DrawBatch> blendBatches =
+        GetBatches(drawBatches, AlphaMode::Blend, AlphaMode::Blend);
+
+    Bundle bundle;
+
+    // Bundles don't inherit state from the render pass that executes them.
+
+    if(m_DepthPrepassEnabled && !opaqueBatches.empty())
+    {
+        auto bundleEncoder = CreateBundleEncoder();
+        MLG_CHECK(bundleEncoder);
+
+        bundleEncoder->SetPipeline(m_DepthPipeline);
+        bundleEncoder->SetBindGroup(0, m_InputsBindGroup, 0, nullptr);
+        SetGeometryBuffers(*bundleEncoder, *m_Inputs);
+
+        EncodeDepthDraws(*bundleEncoder, *m_Inputs, opaqueBatches);
+
+        const wgpu::RenderBundleDescriptor bundleDesc = { .label = "GpuColorPass::DepthBundle" };
+        bundle.Depth = bundleEncoder->Finish(&bundleDesc);
+        MLG_CHECK(bundle.Depth, "Failed to finish depth render bundle");
+    }
+
+    if(!colorBatches.empty())
+    {
+        auto bundleEncoder = CreateBundleEncoder();
+        MLG_CHECK(bundleEncoder);
+
+        bundleEncoder->SetBindGroup(0, m_InputsBindGroup, 0, nullptr);
+        SetGeometryBuffers(*bundleEncoder, *m_Inputs);
+
+        EncodeDrawBatches(*bundleEncoder, m_Pipelines, *m_Inputs, colorBatches, propKit);
+
+        const wgpu::RenderBundleDescriptor bundleDesc = { .label = "GpuColorPass::Bundle" };
+        bundle.Color = bundleEncoder->Finish(&bundleDesc);
+        MLG_CHECK(bundle.Color, "Failed to finish render bundle");
+    }
+
+    if(!blendBatches.empty())
+    {
+        auto bundleEncoder = CreateBundleEncoder();
+        MLG_CHECK(bundleEncoder);
+
+        bundleEncoder->SetBindGroup(0, m_InputsBindGroup, 0, nullptr);
+        SetGeometryBuffers(*bundleEncoder, *m_Inputs);
+
+        EncodeDrawBatches(*bundleEncoder, m_Pipelines, *m_Inputs, blendBatches, propKit);
+
+        const wgpu::RenderBundleDescriptor bundleDesc = { .label = "GpuColorPass::BlendBundle" };
+        bundle.Blend = bundleEncoder->Finish(&bundleDesc);
+        MLG_CHECK(bundle.Blend, "Failed to finish blend render bundle");
+    }
+
+    pcBundles.Increment(1);
+
+    return bundle;
 }
 
 // private:
 
+Result<wgpu::RenderBundleEncoder>
+GpuColorPass::CreateBundleEncoder() const
+{
+    MLG_CHECKV(m_Outputs, "Outputs are not valid - forget to call SetOutputs()?");
+
+    // Must match the attachments of the render pass begun by Prepare().
+    const wgpu::TextureFormat colorFormat = m_Outputs->RenderTarget->GetFormat();
+
+    const wgpu::RenderBundleEncoderDescriptor encoderDesc //
+        {
+            .label = "GpuColorPass::Bundle",
+            .colorFormatCount = 1,
+            .colorFormats = &colorFormat,
+            .depthStencilFormat = GpuHelper::kDepthBufferFormat,
+            .sampleCount = 1,
+            .depthReadOnly = false,
+            .stencilReadOnly = false,
+        };
+
+    wgpu::RenderBundleEncoder bundleEncoder =
+        m_GpuHelper->GetDevice().CreateRenderBundleEncoder(&encoderDesc);
+    MLG_CHECK(bundleEncoder, "Failed to create render bundle encoder");
+
+    return bundleEncoder;
+}
+
+Result<>
+GpuColorPass::EnsurePipelines()
+{
+    MLG_CHECKV(m_Inputs, "Inputs are not valid - forget to call SetInputs()?");
+    MLG_CHECKV(m_Outputs, "Outputs are not valid - forget to call SetOutputs()?");
+
+    for(size_t i = 0; i < kAlphaModeCount; ++i)
+    {
+        for(size_t j = 0; j < kShaderVariantCount; ++j)
+        {
+            if(m_Pipelines[i][j])
+            {
+                continue;
+            }
+
+            const ShaderVariant shaderVariant = static_cast<ShaderVariant>(j);
+            const wgpu::PipelineLayout& pipelineLayout = shaderVariant == ShaderVariant::Textured
+                ? m_PipelineLayout
+                : m_InputsPipelineLayout;
+
+            auto pipeline = CreateColorPipeline(m_GpuHelper->GetDevice(),
+                m_Shader,
+                pipelineLayout,
+                static_cast<AlphaMode>(i),
+                shaderVariant,
+                m_DepthPrepassEnabled,
+                GetVertexConstants(m_FusedTransformsEnabled, m_NormalMatricesEnabled),
+                GetVertexFormat(m_Inputs->Vertices),
+                m_Outputs->RenderTarget->GetFormat());
+            MLG_CHECK(pipeline);
+
+            m_Pipelines[i][j] = *pipeline;
+        }
+    }
+
+    return Result<>::Ok;
+}
+
 Result<>
-GpuColorPass::EnsurePipeline()
+GpuColorPass::EnsureDepthPipeline()
 {
-    if(m_Pipeline)
+    if(m_DepthPipeline || !m_DepthPrepassEnabled)
     {
         return Result<>::Ok;
     }
 
-    const wgpu::BlendState blendState //
-        {
-            .color =
-            {
-                .operation = wgpu::BlendOperation::Add,
-                .srcFactor = wgpu::BlendFactor::SrcAlpha,
-                .dstFactor = wgpu::BlendFactor::OneMinusSrcAlpha,
-            },
-            .alpha =
-            {
-                .operation = wgpu::BlendOperation::Add,
-                .srcFactor = wgpu::BlendFactor::One,
-                .dstFactor = wgpu::BlendFactor::Zero,
-            },
-        };
+    MLG_CHECKV(m_Inputs, "Inputs are not valid - forget to call SetInputs()?");
+    MLG_CHECKV(m_Outputs, "Outputs are not valid - forget to call SetOutputs()?");
 
+    // The pass has a color attachment, so the pipeline needs a matching target, but it doesn't
+    // write to it.
     const wgpu::ColorTargetState colorTargetState //
         {
-            .format = GpuHelper::kTextureFormat,
-            .blend = &blendState,
-            .writeMask = wgpu::ColorWriteMask::All,
+            .format = m_Outputs->RenderTarget->GetFormat(),
+            .writeMask = wgpu::ColorWriteMask::None,
         };
 
     const wgpu::DepthStencilState depthStencilState //
@@ -359,22 +944,6 @@ GpuColorPass::EnsurePipeline()
             .format = GpuHelper::kDepthBufferFormat,
             .depthWriteEnabled = true,
             .depthCompare = wgpu::CompareFunction::Less,
-            /*.stencilFront =
-            {
-                .compare = wgpu::CompareFunction::Always,
-                .failOp = wgpu::StencilOperation::Keep,
-                .depthFailOp = wgpu::StencilOperation::Keep,
-                .passOp = wgpu::StencilOperation::Keep,
-            },
-            .stencilBack =
-            {
-                .compare = wgpu::CompareFunction::Always,
-                .failOp = wgpu::StencilOperation::Keep,
-                .depthFailOp = wgpu::StencilOperation::Keep,
-                .passOp = wgpu::StencilOperation::Keep,
-            },
-            .stencilReadMask = 0xFF,
-            .stencilWriteMask = 0xFF,*/
             .depthBias = 0,
             .depthBiasSlopeScale = 0.0f,
             .depthBiasClamp = 0.0f,
@@ -383,32 +952,33 @@ GpuColorPass::EnsurePipeline()
     const wgpu::FragmentState fragmentState //
         {
             .module = m_Shader,
-            .entryPoint = FragmentEntry,
+            .entryPoint = DepthFragmentEntry,
             .targetCount = 1,
             .targets = &colorTargetState,
         };
 
-    const wgpu::VertexBufferLayout vertexBufferLayout = GetVertexBufferLayout();
+    const VertexFormat vertexFormat = GetVertexFormat(m_Inputs->Vertices);
+    const wgpu::VertexBufferLayout vertexBufferLayout =
+        GetPositionVertexBufferLayout(vertexFormat);
+    const VertexConstants vertexConstants =
+        GetVertexConstants(m_FusedTransformsEnabled, m_NormalMatricesEnabled);
 
     const wgpu::RenderPipelineDescriptor descriptor//
     {
-        .label = "GpuColorPass",
-        .layout = m_PipelineLayout,
+        .label = "GpuColorPass::DepthPrepass",
+        .layout = m_InputsPipelineLayout,
         .vertex =
         {
             .module = m_Shader,
-            .entryPoint = VertexEntry,
+            .entryPoint = vertexFormat == VertexFormat::Quantized
+                ? QuantizedDepthVertexEntry
+                : DepthVertexEntry,
+            .constantCount = vertexConstants.size(),
+            .constants = vertexConstants.data(),
             .bufferCount = 1,
             .buffers = &vertexBufferLayout,
         },
-        .primitive =
-        {
-            .topology = wgpu::PrimitiveTopology::TriangleList,
-            .stripIndexFormat = wgpu::IndexFormat::Undefined,
-            .frontFace = wgpu::FrontFace::CW,
-            .cullMode = wgpu::CullMode::Back,
-            .unclippedDepth = false,
-        },
+        .primitive = GetPrimitiveState(),
         .depthStencil = &depthStencilState,
         .multisample =
         {
@@ -419,8 +989,8 @@ GpuColorPass::EnsurePipeline()
         .fragment = &fragmentState,
     };
 
-    m_Pipeline = m_GpuHelper->GetDevice().CreateRenderPipeline(&descriptor);
-    MLG_CHECK(m_Pipeline, "Failed to create render pipeline");
+    m_DepthPipeline = m_GpuHelper->GetDevice().CreateRenderPipeline(&descriptor);
+    MLG_CHECK(m_DepthPipeline, "Failed to create depth prepass pipeline");
 
     return Result<>::Ok;
 }
@@ -467,6 +1037,18 @@ GpuColorPass::EnsureInputsBindGroup()
                 .offset = 0,
                 .size = m_Inputs->CameraParams.BufferSize(),
             },
+            {
+                .binding = 5,
+                .buffer = m_Inputs->InstanceRemap.GetGpuBuffer(),
+                .offset = 0,
+                .size = m_Inputs->InstanceRemap.BufferSize(),
+            },
+            {
+                .binding = 6,
+                .buffer = m_Inputs->NormalMatrices.GetGpuBuffer(),
+                .offset = 0,
+                .size = m_Inputs->NormalMatrices.BufferSize(),
+            },
         };
 
     const wgpu::BindGroupDescriptor desc = //
@@ -491,7 +1073,16 @@ GpuColorPass::Invocation::~Invocation()
 }
 
 Result<>
-GpuColorPass::Invocation::Execute(const std::span<MeshInstance> visibleMeshes, const PropKit& propKit)
+GpuColorPass::Invocation::Execute(const std::span<const DrawBatch> drawBatches,
+    const PropKit& propKit)
+{
+    return Execute(drawBatches, {}, propKit);
+}
+
+Result<>
+GpuColorPass::Invocation::Execute(const std::span<const DrawBatch> drawBatches,
+    const std::span<const Bundle> bundles,
+    const PropKit& propKit)
 {
     MLG_SCOPED_TIMER("GpuColorPass.Execute")
 
@@ -502,32 +1093,86 @@ GpuColorPass::Invocation::Execute(const std::span<MeshInstance> visibleMeshes, c
 
     m_RenderPass = {};
 
-    // Track how many times we have to change materials.
-    static PerfCounter pcMaterialChanges({ .Name = "GpuColorPass.Execute.MaterialChanges" });
+    // Track how many times we have to change texture arrays.
+    static PerfCounter pcBindGroupChanges({ .Name = "GpuColorPass.Execute.BindGroupChanges" });
+    static PerfCounter pcBundles({ .Name = "GpuColorPass.Execute.Bundles" });
 
-    MaterialIdentifier lastMaterialId;
+    const std::span<const DrawBatch> opaqueBatches =
+        GetBatches(drawBatches, AlphaMode::Opaque, AlphaMode::Opaque);
+    const std::span<const DrawBatch> colorBatches =
+        GetBatches(drawBatches, AlphaMode::Opaque, AlphaMode::Mask);
+    const std::span<const DrawBatch> blendBatches =
+        GetBatches(drawBatches, AlphaMode::Blend, AlphaMode::Blend);
 
-    for(const MeshInstance& meshInstance : visibleMeshes)
+    std::vector<wgpu::RenderBundle> renderBundles;
+    renderBundles.reserve(bundles.size());
+
+    // Executes the non-null bundles selected by member and returns how many were executed.
+    auto executeBundles =
+        [&renderPass, &renderBundles, bundles](wgpu::RenderBundle Bundle::* const member)
     {
-        if(meshInstance.GetMaterialId() != lastMaterialId)
+        renderBundles.clear();
+
+        for(const Bundle& bundle : bundles)
         {
-            pcMaterialChanges.Increment(1);
+            if(bundle.*member)
+            {
+                renderBundles.push_back(bundle.*member);
+            }
+        }
 
-            lastMaterialId = meshInstance.GetMaterialId();
+        if(!renderBundles.empty())
+        {
+            renderPass.ExecuteBundles(renderBundles.size(), renderBundles.data());
+        }
 
-            const wgpu::BindGroup* bindGroup = propKit.GetMaterialBindGroup(lastMaterialId);
-            MLG_ASSERT(bindGroup,
-                "Failed to get material bind group for material ID {}",
-                lastMaterialId.GetValue());
+        return renderBundles.size();
+    };
 
-            renderPass.SetBindGroup(1, *bindGroup, 0, nullptr);
+    size_t bundleCount = 0;
+
+    if(m_DepthPipeline)
+    {
+        MLG_SCOPED_TIMER("GpuColorPass.Execute.DepthPrepass");
+
+        // Prepare() bound the depth prepass pipeline.
+        EncodeDepthDraws(renderPass, m_Inputs, opaqueBatches);
+
+        for(const Bundle& bundle : bundles)
+        {
+            MLG_CHECKV(bundle.Depth || !bundle.Color,
+                "Bundle was recorded without the depth prepass");
         }
 
-        const uint64_t indirectOffset =
-            meshInstance.GetInstanceIndex() * sizeof(ShaderInterop::DrawIndirectParams);
-        renderPass.DrawIndexedIndirect(m_DrawIndirectBuffer.GetGpuBuffer(), indirectOffset);
+        // Executing bundles resets the pass state.
+        if(executeBundles(&Bundle::Depth) > 0)
+        {
+            RestoreState(renderPass);
+        }
     }
 
+    // Opaque and masked geometry.
+    pcBindGroupChanges.Increment(
+        EncodeDrawBatches(renderPass, m_Pipelines, m_Inputs, colorBatches, propKit));
+
+    bundleCount += executeBundles(&Bundle::Color);
+
+    // Blended geometry goes last so it blends over everything opaque, including bundles.
+    if(!blendBatches.empty())
+    {
+        if(bundleCount > 0)
+        {
+            RestoreState(renderPass);
+        }
+
+        pcBindGroupChanges.Increment(
+            EncodeDrawBatches(renderPass, m_Pipelines, m_Inputs, blendBatches, propKit));
+    }
+
+    bundleCount += executeBundles(&Bundle::Blend);
+
+    pcBundles.Increment(bundleCount);
+
     renderPass.End();
 
     // If m_CmdEncoder is null then it's owned by the caller and they are responsible for submitting
@@ -544,4 +1189,13 @@ GpuColorPass::Invocation::Execute(const std::span<MeshInstance> visibleMeshes, c
     }
 
     return Result<>::Ok;
+}
+
+// private:
+
+void
+GpuColorPass::Invocation::RestoreState(const wgpu::RenderPassEncoder& renderPass) const
+{
+    renderPass.SetBindGroup(0, m_InputsBindGroup, 0, nullptr);
+    SetGeometryBuffers(renderPass, m_Inputs);
 }
\ No newline at end of file
@@ -4,6 +4,7 @@
 #include "GpuTypes.h"
 #include "SceneTypes.h"
 
+#include <array>
 #include <optional>
 
 class FileFetcher;
@@ -16,16 +17,33 @@ public:
     static constexpr const char* ShaderPath = "shaders/ColorShader.wgsl";
     static constexpr const char* VertexEntry = "vs_main";
     static constexpr const char* FragmentEntry = "fs_main";
+    static constexpr const char* MaskFragmentEntry = "fs_mask";
+    // Fragment entry points for ShaderVariant::Untextured, which don't sample textures.
+    static constexpr const char* UntexturedFragmentEntry = "fs_main_untextured";
+    static constexpr const char* UntexturedMaskFragmentEntry = "fs_mask_untextured";
+    static constexpr const char* DepthVertexEntry = "vs_depth";
+    // Vertex entry points for VertexFormat::Quantized vertex buffers.
+    static constexpr const char* QuantizedVertexEntry = "vs_main_quantized";
+    static constexpr const char* QuantizedDepthVertexEntry = "vs_depth_quantized";
+    static constexpr const char* DepthFragmentEntry = "fs_depth";
+    // Pipeline-overridable constants that select fused transforms and normal matrices.
+    static constexpr const char* kFusedTransformsOverride = "FusedTransforms";
+    static constexpr const char* kNormalMatricesOverride = "NormalMatrices";
     static constexpr float kClearDepth = 1.0f;
 
     struct Inputs
     {
         Viewport Viewport;
-        GpuVertexBuffer Vertices;
+        GpuMeshVertexBuffer Vertices;
+        // Indices of meshes with IndexFormat::Uint32 and IndexFormat::Uint16 respectively.
         GpuIndexBuffer Indices;
+        GpuIndex16Buffer Indices16;
         GpuWorldTransformBuffer WorldTransforms;
         GpuClipSpaceBuffer ClipSpaceTransforms;
+        // Only read when normal matrices are enabled, but always bound.
+        GpuNormalMatrixBuffer NormalMatrices;
         GpuMeshPropertiesBuffer MeshProperties;
+        GpuInstanceRemapBuffer InstanceRemap;
         GpuMaterialConstantsBuffer MaterialConstants;
         GpuCameraParamsBuffer CameraParams;
         GpuDrawIndirectBuffer DrawIndirectBuffer;
@@ -40,9 +58,12 @@ public:
             return a.Viewport == b.Viewport
                 && a.Vertices == b.Vertices
                 && a.Indices == b.Indices
+                && a.Indices16 == b.Indices16
                 && a.WorldTransforms == b.WorldTransforms
                 && a.ClipSpaceTransforms == b.ClipSpaceTransforms
+                && a.NormalMatrices == b.NormalMatrices
                 && a.MeshProperties == b.MeshProperties
+                && a.InstanceRemap == b.InstanceRemap
                 && a.MaterialConstants == b.MaterialConstants
                 && a.CameraParams == b.CameraParams
                 && a.DrawIndirectBuffer == b.DrawIndirectBuffer;
@@ -62,6 +83,24 @@ public:
         friend bool operator==(const Outputs& a, const Outputs& b) = default;
     };
 
+    /// @brief Render bundles recorded with GpuColorPass::RecordBundle().
+    /// Bundles that would draw nothing are null.
+    struct Bundle
+    {
+        // Opaque and alpha masked batches.
+        wgpu::RenderBundle Color;
+
+        // Alpha blended batches.
+        wgpu::RenderBundle Blend;
+
+        // Opaque batches, depth only. Only recorded when the depth prepass is enabled.
+        wgpu::RenderBundle Depth;
+    };
+
+    // Color pipelines, indexed by AlphaMode, then ShaderVariant.
+    using Pipelines =
+        std::array<std::array<wgpu::RenderPipeline, kShaderVariantCount>, kAlphaModeCount>;
+
     class Invocation
     {
     public:
@@ -72,23 +111,48 @@ public:
         Invocation(Invocation&&) = default;
         Invocation& operator=(Invocation&&) = delete;
 
-        Result<> Execute(const std::span<MeshInstance> visibleMeshes, const PropKit& propKit);
+        /// @brief Issues one instanced indirect draw per batch.
+        /// Batches must be sorted by alpha mode, and should then be sorted by shader variant and
+        /// texture array to minimize pipeline and bind group changes.
+        Result<> Execute(const std::span<const DrawBatch> drawBatches, const PropKit& propKit);
+
+        /// @brief Issues one instanced indirect draw per batch, and replays render bundles
+        /// recorded with GpuColorPass::RecordBundle().
+        /// Opaque and alpha masked geometry is drawn first, batches before bundles, then alpha
+        /// blended geometry in the same order. With the depth prepass enabled opaque geometry
+        /// is drawn depth only before anything else.
+        Result<> Execute(const std::span<const DrawBatch> drawBatches,
+            const std::span<const Bundle> bundles,
+            const PropKit& propKit);
 
     private:
         friend class GpuColorPass;
 
         Invocation(wgpu::Device gpuDevice,
             wgpu::RenderPassEncoder renderPass,
-            GpuDrawIndirectBuffer drawIndirectBuffer)
+            const Inputs& inputs,
+            wgpu::BindGroup inputsBindGroup,
+            const Pipelines& pipelines,
+            wgpu::RenderPipeline depthPipeline)
             : m_GpuDevice(std::move(gpuDevice)),
               m_RenderPass(std::move(renderPass)),
-              m_DrawIndirectBuffer(std::move(drawIndirectBuffer))
+              m_Inputs(inputs),
+              m_InputsBindGroup(std::move(inputsBindGroup)),
+              m_Pipelines(pipelines),
+              m_DepthPipeline(std::move(depthPipeline))
         {
         }
 
+        // Rebinds the state that executing bundles resets.
+        void RestoreState(const wgpu::RenderPassEncoder& renderPass) const;
+
         wgpu::Device m_GpuDevice;
         wgpu::RenderPassEncoder m_RenderPass;
-        GpuDrawIndirectBuffer m_DrawIndirectBuffer;
+        Inputs m_Inputs;
+        wgpu::BindGroup m_InputsBindGroup;
+        Pipelines m_Pipelines;
+        // Null unless the depth prepass is enabled.
+        wgpu::RenderPipeline m_DepthPipeline;
         wgpu::CommandEncoder m_CmdEncoder;
     };
 
@@ -102,8 +166,37 @@ public:
     static Result<GpuColorPass> Create(const GpuHelper& gpuHelper, FileFetcher& fileFetcher);
 
     Result<> SetInputs(const Inputs& inputs);
+
+    /// @brief Sets the targets the pass renders into.
+    /// Pipelines render into targets of the render target's format. They're recreated when it
+    /// changes, and bundles recorded before the change must be re-recorded.
     Result<> SetOutputs(const Outputs& outputs);
 
+    /// @brief Enables a depth-only prepass of opaque geometry.
+    /// The prepass draws positions only and writes depth. The color pass then tests depth for
+    /// equality without writing it, so each pixel is shaded once regardless of overdraw.
+    /// Bundles recorded before the change must be re-recorded.
+    void SetDepthPrepassEnabled(const bool enabled);
+
+    bool IsDepthPrepassEnabled() const { return m_DepthPrepassEnabled; }
+
+    /// @brief Makes the vertex shaders transform positions by the world transforms and the
+    /// camera's view-projection matrix, rather than reading the clip space transforms written by
+    /// GpuTransformPass, so the transform pass isn't needed.
+    /// Fused transforms cost a matrix multiply per vertex instead of one per node, so they win
+    /// when many nodes are culled or each node has few vertices.
+    /// Bundles recorded before the change must be re-recorded.
+    void SetFusedTransformsEnabled(const bool enabled);
+
+    bool IsFusedTransformsEnabled() const { return m_FusedTransformsEnabled; }
+
+    /// @brief Makes the vertex shaders transform normals by Inputs::NormalMatrices rather than by
+    /// the world transforms, so normals stay correct under non-uniform scales.
+    /// Bundles recorded before the change must be re-recorded.
+    void SetNormalMatricesEnabled(const bool enabled);
+
+    bool IsNormalMatricesEnabled() const { return m_NormalMatricesEnabled; }
+
     /// @brief Prepares an invocation of the pass for execution.
     /// This variant of Prepare creates a command encoder that's owned and
     /// submitted to the GPU by the invocation.
@@ -114,24 +207,40 @@ public:
     /// The caller is responsible for submitting the command encoder to the GPU.
     Result<Invocation> Prepare(const wgpu::CommandEncoder& cmdEncoder);
 
+    /// @brief Records draw batches into render bundles that can be replayed with
+    /// Invocation::Execute().
+    /// The bundles capture the current inputs, render target format and depth prepass setting.
+    /// They must be re-recorded if any of the input buffers are replaced, and the draw
+    /// parameters they reference must stay in place in the draw indirect buffer while they are in
+    /// use.
+    Result<Bundle> RecordBundle(const std::span<const DrawBatch> drawBatches,
+        const PropKit& propKit);
+
 private:
     explicit GpuColorPass(const GpuHelper& gpuHelper,
         wgpu::ShaderModule shader,
         wgpu::BindGroupLayout inputsBindGroupLayout,
-        wgpu::PipelineLayout pipelineLayout)
+        wgpu::PipelineLayout pipelineLayout,
+        wgpu::PipelineLayout inputsPipelineLayout)
         : m_GpuHelper(&gpuHelper),
           m_Shader(std::move(shader)),
           m_InputsBindGroupLayout(std::move(inputsBindGroupLayout)),
-          m_PipelineLayout(std::move(pipelineLayout))
+          m_PipelineLayout(std::move(pipelineLayout)),
+          m_InputsPipelineLayout(std::move(inputsPipelineLayout))
     {
         MLG_ASSERT(m_Shader, "Shader module is not valid");
         MLG_ASSERT(m_InputsBindGroupLayout, "Inputs bind group layout is not valid");
         MLG_ASSERT(m_PipelineLayout, "Pipeline layout is not valid");
+        MLG_ASSERT(m_InputsPipelineLayout, "Inputs pipeline layout is not valid");
     }
 
-    Result<> EnsurePipeline();
+    Result<> EnsurePipelines();
+    Result<> EnsureDepthPipeline();
     Result<> EnsureInputsBindGroup();
 
+    // Creates a render bundle encoder compatible with the render pass begun by Prepare().
+    Result<wgpu::RenderBundleEncoder> CreateBundleEncoder() const;
+
     const GpuHelper* m_GpuHelper{ nullptr };
 
     std::optional<Inputs> m_Inputs;
@@ -140,6 +249,14 @@ private:
     wgpu::ShaderModule m_Shader;
     wgpu::BindGroupLayout m_InputsBindGroupLayout;
     wgpu::PipelineLayout m_PipelineLayout;
+    // Only has the inputs bind group, for the depth prepass and untextured pipelines, which
+    // don't sample textures.
+    wgpu::PipelineLayout m_InputsPipelineLayout;
     wgpu::BindGroup m_InputsBindGroup;
-    wgpu::RenderPipeline m_Pipeline;
+    // The opaque pipelines test depth for equality when the depth prepass is enabled.
+    Pipelines m_Pipelines;
+    wgpu::RenderPipeline m_DepthPipeline;
+    bool m_DepthPrepassEnabled{ false };
+    bool m_FusedTransformsEnabled{ false };
+    bool m_NormalMatricesEnabled{ false };
 };
\ No newline at end of file
@@ -16,8 +16,10 @@ CreateSampler(const GpuHelper& gpuHelper)
             .addressModeU = wgpu::AddressMode::ClampToEdge,
             .addressModeV = wgpu::AddressMode::ClampToEdge,
             .addressModeW = wgpu::AddressMode::Undefined,
-            .magFilter = wgpu::FilterMode::Nearest,
-            .minFilter = wgpu::FilterMode::Nearest,
+            // Filtered so scenes rendered at a reduced resolution are upscaled smoothly.
+            // Sampling a texture of the destination's size still reads texel centers exactly.
+            .magFilter = wgpu::FilterMode::Linear,
+            .minFilter = wgpu::FilterMode::Linear,
             .mipmapFilter = wgpu::MipmapFilterMode::Undefined,
             .lodMinClamp = 0.0f,
             .lodMaxClamp = 32.0f,
@@ -198,7 +200,7 @@ GpuCompositorPass::Prepare(const wgpu::CommandEncoder& cmdEncoder)
     const wgpu::RenderPassColorAttachment attachment //
         {
             .view = m_Outputs->RenderTarget->CreateView(),
-            .loadOp = wgpu::LoadOp::Clear,
+            .loadOp = m_Outputs->ClearTarget ? wgpu::LoadOp::Clear : wgpu::LoadOp::Load,
             .storeOp = wgpu::StoreOp::Store,
             .clearValue = { .r = 0.0f, .g = 0.0f, .b = 0.0f, .a = 1.0f },
         };
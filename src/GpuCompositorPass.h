@@ -39,6 +39,10 @@ public:
     struct Outputs
     {
         GpuRenderTarget RenderTarget;
+        // Whether the output texture is cleared before compositing. Disable it to keep what's
+        // outside the destination rectangle, e.g. when compositing several views into one
+        // texture.
+        bool ClearTarget{ true };
 
         Result<> Validate() const // NOLINT(readability-convert-member-functions-to-static)
         {
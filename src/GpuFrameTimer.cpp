@@ -0,0 +1,192 @@
+#define MLG_LOGGER_NAME "GTMR"
+
+#include "GpuFrameTimer.h"
+
+#include "Log.h"
+
+#include <algorithm>
+#include <cstring>
+#include <string_view>
+
+namespace
+{
+// Begin and end timestamps of a frame, in nanoseconds.
+constexpr uint64_t kTimestampsSize = 2 * sizeof(uint64_t);
+} // namespace
+
+Result<std::unique_ptr<GpuFrameTimer>>
+GpuFrameTimer::Create(wgpu::Instance instance, wgpu::Device device)
+{
+    MLG_CHECKV(instance, "Invalid wgpu::Instance");
+    MLG_CHECKV(device, "Invalid wgpu::Device");
+    MLG_CHECKV(device.HasFeature(wgpu::FeatureName::TimestampQuery),
+        "TimestampQuery feature is not enabled");
+
+    const wgpu::QuerySetDescriptor querySetDesc //
+        {
+            .label = "GpuFrameTimer::QuerySet",
+            .type = wgpu::QueryType::Timestamp,
+            .count = 2 * kSlotCount,
+        };
+
+    wgpu::QuerySet querySet = device.CreateQuerySet(&querySetDesc);
+    MLG_CHECKV(querySet, "Failed to create timestamp query set");
+
+    std::unique_ptr<GpuFrameTimer> timer(
+        new GpuFrameTimer(std::move(instance), std::move(querySet)));
+
+    for(Slot& slot : timer->m_Slots)
+    {
+        const wgpu::BufferDescriptor resolveDesc //
+            {
+                .label = "GpuFrameTimer::Resolve",
+                .usage = wgpu::BufferUsage::QueryResolve | wgpu::BufferUsage::CopySrc,
+                .size = kTimestampsSize,
+            };
+
+        const wgpu::BufferDescriptor readbackDesc //
+            {
+                .label = "GpuFrameTimer::Readback",
+                .usage = wgpu::BufferUsage::MapRead | wgpu::BufferUsage::CopyDst,
+                .size = kTimestampsSize,
+            };
+
+        slot.Owner = timer.get();
+        slot.ResolveBuffer = device.CreateBuffer(&resolveDesc);
+        slot.ReadbackBuffer = device.CreateBuffer(&readbackDesc);
+        MLG_CHECKV(slot.ResolveBuffer && slot.ReadbackBuffer,
+            "Failed to create timestamp buffers");
+    }
+
+    return timer;
+}
+
+GpuFrameTimer::~GpuFrameTimer()
+{
+    // Map callbacks reference the slots. Wait for them to be delivered before releasing them.
+    while(std::ranges::any_of(m_Slots,
+        [](const Slot& slot) { return slot.State == SlotState::Mapping; }))
+    {
+        m_Instance.ProcessEvents();
+    }
+}
+
+void
+GpuFrameTimer::BeginFrame(const wgpu::CommandEncoder& cmdEncoder)
+{
+    // A frame that failed to record never reached ReadBack().
+    if(m_CurrentSlot)
+    {
+        m_CurrentSlot->State = SlotState::Free;
+    }
+
+    auto it = std::ranges::find(m_Slots, SlotState::Free, &Slot::State);
+
+    // Every slot is still being read back, so this frame isn't measured.
+    if(it == m_Slots.end())
+    {
+        m_CurrentSlot = nullptr;
+        return;
+    }
+
+    m_CurrentSlot = &*it;
+    m_CurrentSlot->State = SlotState::Recording;
+
+    const uint32_t slotIndex = static_cast<uint32_t>(it - m_Slots.begin());
+    WriteTimestamp(cmdEncoder, 2 * slotIndex);
+}
+
+void
+GpuFrameTimer::EndFrame(const wgpu::CommandEncoder& cmdEncoder)
+{
+    if(!m_CurrentSlot)
+    {
+        return;
+    }
+
+    const uint32_t queryIndex = 2 * static_cast<uint32_t>(m_CurrentSlot - m_Slots.data());
+    WriteTimestamp(cmdEncoder, queryIndex + 1);
+
+    cmdEncoder.ResolveQuerySet(m_QuerySet, queryIndex, 2, m_CurrentSlot->ResolveBuffer, 0);
+    cmdEncoder.CopyBufferToBuffer(m_CurrentSlot->ResolveBuffer,
+        0,
+        m_CurrentSlot->ReadbackBuffer,
+        0,
+        kTimestampsSize);
+
+    m_CurrentSlot->State = SlotState::Recorded;
+}
+
+void
+GpuFrameTimer::ReadBack()
+{
+    if(!m_CurrentSlot || m_CurrentSlot->State != SlotState::Recorded)
+    {
+        return;
+    }
+
+    // Mapping completes once the GPU has executed the frame's commands.
+    m_CurrentSlot->State = SlotState::Mapping;
+    m_CurrentSlot->ReadbackBuffer.MapAsync(wgpu::MapMode::Read,
+        0,
+        kTimestampsSize,
+        wgpu::CallbackMode::AllowProcessEvents,
+        OnMapped,
+        m_CurrentSlot);
+
+    m_CurrentSlot = nullptr;
+}
+
+// private:
+
+GpuFrameTimer::GpuFrameTimer(wgpu::Instance instance, wgpu::QuerySet querySet)
+    : m_Instance(std::move(instance)),
+      m_QuerySet(std::move(querySet))
+{
+}
+
+void
+GpuFrameTimer::WriteTimestamp(const wgpu::CommandEncoder& cmdEncoder,
+    const uint32_t queryIndex) const
+{
+    // Timestamps are written at the boundaries of passes, so an empty pass marks the point in
+    // the command stream.
+    const wgpu::PassTimestampWrites timestampWrites //
+        {
+            .querySet = m_QuerySet,
+            .beginningOfPassWriteIndex = queryIndex,
+            .endOfPassWriteIndex = wgpu::kQuerySetIndexUndefined,
+        };
+
+    const wgpu::ComputePassDescriptor passDesc //
+        {
+            .label = "GpuFrameTimer::Timestamp",
+            .timestampWrites = &timestampWrites,
+        };
+
+    cmdEncoder.BeginComputePass(&passDesc).End();
+}
+
+void
+GpuFrameTimer::OnMapped(wgpu::MapAsyncStatus status, wgpu::StringView message, Slot* slot)
+{
+    if(status != wgpu::MapAsyncStatus::Success)
+    {
+        MLG_ERROR("Failed to map timestamp buffer: {}",
+            std::string_view(message.data, message.length));
+        slot->State = SlotState::Free;
+        return;
+    }
+
+    uint64_t timestamps[2];
+    std::memcpy(timestamps, slot->ReadbackBuffer.GetConstMappedRange(), kTimestampsSize);
+    slot->ReadbackBuffer.Unmap();
+    slot->State = SlotState::Free;
+
+    // Timestamps are in nanoseconds. Some implementations can reorder them, e.g. when the GPU
+    // changes power states, and those frames are ignored.
+    if(timestamps[1] > timestamps[0])
+    {
+        slot->Owner->m_FrameSeconds = static_cast<float>(timestamps[1] - timestamps[0]) * 1e-9f;
+    }
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include "GpuTypes.h"
+#include "Result.h"
+
+#include <array>
+#include <cstdint>
+#include <memory>
+
+/// @brief Measures how long the GPU takes to execute the commands of a frame.
+///
+/// Timestamps are written before and after the frame's commands and read back asynchronously,
+/// so the measured time trails the frame being recorded by a few frames. Frames are only
+/// measured while a readback slot is free.
+///
+/// Map callbacks are delivered from Instance::ProcessEvents(), which must be called regularly
+/// (e.g. once per frame).
+///
+/// Requires a device with the TimestampQuery feature.
+class GpuFrameTimer final
+{
+public:
+    /// @brief Number of frames that can be measured at once.
+    static constexpr uint32_t kSlotCount = 4;
+
+    static Result<std::unique_ptr<GpuFrameTimer>> Create(wgpu::Instance instance,
+        wgpu::Device device);
+
+    GpuFrameTimer() = delete;
+    ~GpuFrameTimer();
+    GpuFrameTimer(const GpuFrameTimer&) = delete;
+    GpuFrameTimer& operator=(const GpuFrameTimer&) = delete;
+    GpuFrameTimer(GpuFrameTimer&&) = delete;
+    GpuFrameTimer& operator=(GpuFrameTimer&&) = delete;
+
+    /// @brief Records a timestamp before the frame's commands.
+    void BeginFrame(const wgpu::CommandEncoder& cmdEncoder);
+
+    /// @brief Records a timestamp after the frame's commands and a copy of both timestamps for
+    /// readback.
+    void EndFrame(const wgpu::CommandEncoder& cmdEncoder);
+
+    /// @brief Starts reading back the timestamps of the frame. Must be called after the command
+    /// buffer recorded between BeginFrame() and EndFrame() has been submitted.
+    void ReadBack();
+
+    /// @brief Returns the GPU time of the most recently measured frame, or 0 until a frame has
+    /// been measured.
+    float GetFrameSeconds() const { return m_FrameSeconds; }
+
+private:
+    enum class SlotState
+    {
+        Free,
+        Recording,
+        Recorded,
+        Mapping,
+    };
+
+    struct Slot
+    {
+        GpuFrameTimer* Owner{ nullptr };
+        wgpu::Buffer ResolveBuffer;
+        wgpu::Buffer ReadbackBuffer;
+        SlotState State{ SlotState::Free };
+    };
+
+    GpuFrameTimer(wgpu::Instance instance, wgpu::QuerySet querySet);
+
+    // Writes a timestamp at the current point of the command stream.
+    void WriteTimestamp(const wgpu::CommandEncoder& cmdEncoder, const uint32_t queryIndex) const;
+
+    static void OnMapped(wgpu::MapAsyncStatus status, wgpu::StringView message, Slot* slot);
+
+    wgpu::Instance m_Instance;
+    wgpu::QuerySet m_QuerySet;
+    std::array<Slot, kSlotCount> m_Slots;
+
+    // Slot of the frame being recorded, if it's measured.
+    Slot* m_CurrentSlot{ nullptr };
+
+    float m_FrameSeconds{ 0 };
+};
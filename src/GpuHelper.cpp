@@ -300,14 +300,12 @@ CreateDefaultTexture(GpuHelper& gpuHelper)
 
     MLG_CHECK(texture);
 
-    auto stagingBuffer = gpuHelper.CreateStagingBuffer(*texture, "DefaultTextureStagingBuffer");
-    MLG_CHECK(stagingBuffer);
+    GpuUploadRing& uploadRing = gpuHelper.GetUploadRing();
 
-    void* mapped = stagingBuffer->GetMappedRange();
-    MLG_CHECK(mapped);
+    auto staging = uploadRing.AllocateTexture(*texture);
+    MLG_CHECK(staging);
 
-    const std::span<uint8_t> mappedSpan(static_cast<uint8_t*>(mapped),
-        narrow_cast<size_t>(stagingBuffer->GetSize()));
+    const std::span<std::byte> mappedSpan = staging->Data;
 
     const size_t rowStride = GpuHelper::GetTextureAlignedRowStride(kDefaultTextureWidth);
 
@@ -318,14 +316,19 @@ CreateDefaultTexture(GpuHelper& gpuHelper)
         for(size_t x = 0; x < kDefaultTextureWidth; ++x, offset += 4)
         {
             // Magenta
-            mappedSpan[offset + 0] = kDefaultTextureColor.r;
-            mappedSpan[offset + 1] = kDefaultTextureColor.g;
-            mappedSpan[offset + 2] = kDefaultTextureColor.b;
-            mappedSpan[offset + 3] = kDefaultTextureColor.a;
+            mappedSpan[offset + 0] = std::byte{ kDefaultTextureColor.r };
+            mappedSpan[offset + 1] = std::byte{ kDefaultTextureColor.g };
+            mappedSpan[offset + 2] = std::byte{ kDefaultTextureColor.b };
+            mappedSpan[offset + 3] = std::byte{ kDefaultTextureColor.a };
         }
     }
 
-    MLG_CHECK(gpuHelper.CommitStagingBuffer(*texture, *stagingBuffer));
+    const wgpu::CommandEncoder cmdEncoder = gpuHelper.GetDevice().CreateCommandEncoder();
+    MLG_CHECK(cmdEncoder, "Failed to create command encoder");
+
+    GpuUploadRing::CopyToTexture(cmdEncoder, *staging, *texture);
+
+    MLG_CHECK(uploadRing.Submit(cmdEncoder.Finish()));
 
     return *texture;
 }
@@ -361,7 +364,7 @@ CreateTextureBindGroupLayout(const wgpu::Device& gpuDevice)
             .texture =
             {
                 .sampleType = wgpu::TextureSampleType::Float,
-                .viewDimension = wgpu::TextureViewDimension::e2D,
+                .viewDimension = wgpu::TextureViewDimension::e2DArray,
                 .multisampled = false,
             },
         },
@@ -575,18 +578,32 @@ GpuHelper::CreateTask::Get()
 
     std::unique_ptr<GpuHelper> gpuHelper = std::move(bye->m_GpuHelper);
 
-    int width{ 0 }, height{ 0 };
-    SDL_GetWindowSize(gpuHelper->m_Window, &width, &height);
+    if(gpuHelper->IsHeadless())
+    {
+        const Dimension2& dimensions = gpuHelper->m_HeadlessOptions->Dimensions;
 
-    auto surfaceFormat = ConfigureSurface(gpuHelper->m_Adapter,
-        gpuHelper->m_Device,
-        gpuHelper->m_Surface,
-        static_cast<uint32_t>(width),
-        static_cast<uint32_t>(height));
+        auto offscreenTarget =
+            gpuHelper->CreateRenderTarget(dimensions.Width, dimensions.Height, "OffscreenTarget");
+        MLG_CHECK(offscreenTarget);
 
-    MLG_CHECK(surfaceFormat);
+        gpuHelper->m_OffscreenTarget = std::move(*offscreenTarget);
+        gpuHelper->m_SurfaceFormat = kTextureFormat;
+    }
+    else
+    {
+        int width{ 0 }, height{ 0 };
+        SDL_GetWindowSize(gpuHelper->m_Window, &width, &height);
+
+        auto surfaceFormat = ConfigureSurface(gpuHelper->m_Adapter,
+            gpuHelper->m_Device,
+            gpuHelper->m_Surface,
+            static_cast<uint32_t>(width),
+            static_cast<uint32_t>(height));
+
+        MLG_CHECK(surfaceFormat);
 
-    gpuHelper->m_SurfaceFormat = *surfaceFormat;
+        gpuHelper->m_SurfaceFormat = *surfaceFormat;
+    }
 
     auto defaultSampler = CreateDefaultSampler(gpuHelper->m_Device);
     MLG_CHECK(defaultSampler);
@@ -596,6 +613,10 @@ GpuHelper::CreateTask::Get()
     MLG_CHECK(textureBindGroupLayout);
     gpuHelper->m_TextureBindGroupLayout = std::move(*textureBindGroupLayout);
 
+    auto uploadRing = GpuUploadRing::Create(gpuHelper->m_Instance, gpuHelper->m_Device);
+    MLG_CHECK(uploadRing);
+    gpuHelper->m_UploadRing = std::move(*uploadRing);
+
     auto defaultTexture = CreateDefaultTexture(*gpuHelper);
     MLG_CHECK(defaultTexture);
 
@@ -640,6 +661,32 @@ GpuHelper::CreateTask::Begin(const std::string_view& appName)
     return Result<>::Ok;
 }
 
+Result<>
+GpuHelper::CreateTask::BeginHeadless(const HeadlessOptions& options)
+{
+    MLG_CHECKV(!m_TaskImpl, "CreateTask is already started");
+    MLG_CHECKV(options.Dimensions.Width > 0 && options.Dimensions.Height > 0,
+        "Invalid offscreen target dimensions: {}x{}",
+        options.Dimensions.Width,
+        options.Dimensions.Height);
+
+    MLG_INFO("Creating headless GpuHelper...");
+
+    std::unique_ptr<GpuHelper> gpuHelper = std::unique_ptr<GpuHelper>(new GpuHelper());
+
+    gpuHelper->m_HeadlessOptions = options;
+
+    auto instance = CreateInstance();
+    MLG_CHECK(instance);
+    gpuHelper->m_Instance = std::move(*instance);
+
+    m_TaskImpl = std::make_unique<Impl>();
+    m_TaskImpl->m_GpuHelper = std::move(gpuHelper);
+    m_TaskImpl->m_State = CreateTask::State::CreateAdapter;
+
+    return Result<>::Ok;
+}
+
 Result<>
 GpuHelper::CreateTask::CreateAdapter()
 {
@@ -651,7 +698,7 @@ GpuHelper::CreateTask::CreateAdapter()
 
     EnumerateAdapters();
 
-    const wgpu::RequestAdapterOptions options //
+    wgpu::RequestAdapterOptions options //
         {
             .nextInChain = nullptr,
             .featureLevel = wgpu::FeatureLevel::Core,
@@ -670,6 +717,13 @@ GpuHelper::CreateTask::CreateAdapter()
             .compatibleSurface = m_TaskImpl->m_GpuHelper->m_Surface,
         };
 
+    if(const std::optional<HeadlessOptions>& headless = m_TaskImpl->m_GpuHelper->m_HeadlessOptions)
+    {
+        // Without a surface any adapter will do, including Dawn's Null and SwiftShader ones.
+        options.backendType = headless->BackendType;
+        options.forceFallbackAdapter = headless->ForceFallbackAdapter;
+    }
+
     m_TaskImpl->m_GpuHelper->m_Instance.RequestAdapter(&options,
         wgpu::CallbackMode::AllowSpontaneous,
         RequestAdapterCb,
@@ -730,12 +784,18 @@ GpuHelper::CreateTask::CreateDevice()
     // toggles.disabledToggles = disabledToggles;
 #endif
 
+    // Timestamp queries are optional and last, so they can be left out. Without them GPU frame
+    // times aren't measured.
     const wgpu::FeatureName requiredFeatures[] = //
         {
             wgpu::FeatureName::IndirectFirstInstance,
             // wgpu::FeatureName::MultiDrawIndirect
+            wgpu::FeatureName::TimestampQuery,
         };
 
+    const bool hasTimestampQuery =
+        m_TaskImpl->m_GpuHelper->m_Adapter.HasFeature(wgpu::FeatureName::TimestampQuery);
+
     const wgpu::Limits requiredLimits{};
     /*requiredLimits.maxTextureDimension2D = 4096;
     requiredLimits.maxBindGroups = 3;
@@ -752,7 +812,7 @@ GpuHelper::CreateTask::CreateDevice()
 #endif
                 .nextInChain = nullptr,
                 .label = "MainDevice",
-                .requiredFeatureCount = std::size(requiredFeatures),
+                .requiredFeatureCount = std::size(requiredFeatures) - (hasTimestampQuery ? 0 : 1),
                 .requiredFeatures = &requiredFeatures[0],
                 .requiredLimits = &requiredLimits,
             },
@@ -818,6 +878,16 @@ GpuHelper::Create(const std::string_view& appName)
     return std::move(createTask);
 }
 
+Result<GpuHelper::CreateTask>
+GpuHelper::CreateHeadless(const HeadlessOptions& options)
+{
+    CreateTask createTask;
+
+    MLG_CHECK(createTask.BeginHeadless(options));
+
+    return std::move(createTask);
+}
+
 SDL_Window*
 GpuHelper::GetWindow() const
 {
@@ -860,9 +930,21 @@ GpuHelper::GetTextureBindGroupLayout() const
     return m_TextureBindGroupLayout;
 }
 
+GpuUploadRing&
+GpuHelper::GetUploadRing() const
+{
+    MLG_ASSERT(m_UploadRing, "Upload ring is not initialized");
+    return *m_UploadRing;
+}
+
 Dimension2
 GpuHelper::GetScreenDimensions() const
 {
+    if(IsHeadless())
+    {
+        return m_HeadlessOptions->Dimensions;
+    }
+
     int width = 0, height = 0;
     if(!SDL_GetWindowSizeInPixels(GetWindow(), &width, &height))
     {
@@ -878,6 +960,11 @@ GpuHelper::GetScreenDimensions() const
 Result<GpuRenderTarget>
 GpuHelper::GetSwapChainTexture() const
 {
+    if(IsHeadless())
+    {
+        return *m_OffscreenTarget;
+    }
+
     wgpu::SurfaceTexture surfaceTexture;
     GetSurface().GetCurrentTexture(&surfaceTexture);
 
@@ -940,6 +1027,22 @@ GpuHelper::GetSwapChainFormat() const
 Result<>
 GpuHelper::Resize(const uint32_t width, const uint32_t height)
 {
+    if(IsHeadless())
+    {
+        Dimension2& dimensions = m_HeadlessOptions->Dimensions;
+
+        if(width != dimensions.Width || height != dimensions.Height)
+        {
+            auto offscreenTarget = CreateRenderTarget(width, height, "OffscreenTarget");
+            MLG_CHECK(offscreenTarget);
+
+            m_OffscreenTarget = std::move(*offscreenTarget);
+            dimensions = { .Width = width, .Height = height };
+        }
+
+        return Result<>::Ok;
+    }
+
     wgpu::SurfaceTexture currentTexture;
     GetSurface().GetCurrentTexture(&currentTexture);
     if(width != currentTexture.texture.GetWidth() || height != currentTexture.texture.GetHeight())
@@ -996,7 +1099,9 @@ GpuHelper::CreateTexture(
     const wgpu::TextureDescriptor desc //
         {
             .label = name,
-            .usage = wgpu::TextureUsage::TextureBinding | wgpu::TextureUsage::CopyDst,
+            .usage = wgpu::TextureUsage::TextureBinding
+                | wgpu::TextureUsage::CopyDst
+                | wgpu::TextureUsage::CopySrc,
             .dimension = wgpu::TextureDimension::e2D,
             .size = //
             {
@@ -1015,14 +1120,49 @@ GpuHelper::CreateTexture(
     return texture;
 }
 
+Result<wgpu::Texture>
+GpuHelper::CreateTextureArray(const unsigned width,
+    const unsigned height,
+    const unsigned layerCount,
+    const std::string_view& name) const
+{
+    const wgpu::TextureDescriptor desc //
+        {
+            .label = name,
+            .usage = wgpu::TextureUsage::TextureBinding | wgpu::TextureUsage::CopyDst,
+            .dimension = wgpu::TextureDimension::e2D,
+            .size = //
+            {
+                .width = width,
+                .height = height,
+                .depthOrArrayLayers = layerCount,
+            },
+            .format = kTextureFormat,
+            .mipLevelCount = 1,
+            .sampleCount = 1,
+        };
+
+    wgpu::Texture texture = GetDevice().CreateTexture(&desc);
+    MLG_CHECK(texture, "Failed to create texture array");
+
+    return texture;
+}
+
 Result<wgpu::BindGroup>
 GpuHelper::CreateTextureBindGroup(const wgpu::Texture& texture, const std::string_view& name) const
 {
+    // Single layer textures are viewed as arrays of one layer.
+    const wgpu::TextureViewDescriptor viewDesc //
+        {
+            .label = name,
+            .dimension = wgpu::TextureViewDimension::e2DArray,
+        };
+
     const wgpu::BindGroupEntry entries[] = //
         {
             {
                 .binding = 0,
-                .textureView = texture.CreateView(),
+                .textureView = texture.CreateView(&viewDesc),
             },
             {
                 .binding = 1,
@@ -1097,101 +1237,11 @@ GpuHelper::CreateDepthBuffer(
     return GpuDepthTarget(depthBuffer);
 }
 
-// A note on using staging buffers to upload data to the GPU:
-// When copying data to textures we use a staging buffer.
-// When copying data to other buffers we could also use a staging buffer, but it's simpler to use
-// Queue::WriteBuffer which doesn't require a staging buffer. The equivalent of WriteBuffer for
-// textures is Queue::WriteTexture howerver Queue::WriteTexture contains a bunch of validation and
-// is slow compared to using a staging buffer and CopyBufferToTexture.
-
-Result<wgpu::Buffer>
-GpuHelper::CreateStagingBuffer(wgpu::Texture texture, const std::string_view& name) const
-{
-    const size_t rowStride = GetTextureAlignedRowStride(texture.GetWidth());
-    const size_t sizeofBuffer = rowStride * texture.GetHeight();
-    const wgpu::BufferUsage usage = wgpu::BufferUsage::MapWrite | wgpu::BufferUsage::CopySrc;
-
-    auto buffer = CreateGpuBuffer(usage, sizeofBuffer, BufferMappedState::Mapped, name);
-    MLG_CHECK(buffer, "Failed to create staging buffer");
-
-    return buffer;
-}
-
-Result<>
-GpuHelper::CommitStagingBuffer(wgpu::Texture texture, wgpu::Buffer stagingBuffer) const
-{
-    const wgpu::CommandEncoder cmdEncoder = GetDevice().CreateCommandEncoder();
-
-    MLG_CHECK(CommitStagingBuffer(texture, stagingBuffer, cmdEncoder));
-
-    const wgpu::CommandBuffer commandBuffer = cmdEncoder.Finish();
-
-    GetDevice().GetQueue().Submit(1, &commandBuffer);
-
-    return Result<>::Ok;
-}
-
-Result<>
-GpuHelper::CommitStagingBuffer(
-    wgpu::Texture texture, wgpu::Buffer stagingBuffer, wgpu::CommandEncoder cmdEncoder)
-{
-    stagingBuffer.Unmap();
-
-    const wgpu::TexelCopyBufferInfo copySrc = //
-        {
-            .layout = //
-            {
-                .offset = 0,
-                .bytesPerRow = static_cast<uint32_t>(
-                    GpuHelper::GetTextureAlignedRowStride(texture.GetWidth())),
-                .rowsPerImage = texture.GetHeight(),
-            },
-            .buffer = stagingBuffer,
-        };
-
-    const wgpu::TexelCopyTextureInfo copyDst = //
-        {
-            .texture = texture,
-            .mipLevel = 0,
-            .origin{},
-        };
-
-    const wgpu::Extent3D copySize = //
-        {
-            .width = texture.GetWidth(),
-            .height = texture.GetHeight(),
-            .depthOrArrayLayers = 1,
-        };
-
-    cmdEncoder.CopyBufferToTexture(&copySrc, &copyDst, &copySize);
-
-    return Result<>::Ok;
-}
-
-Result<GpuVertexBuffer>
-GpuHelper::CreateVertexBuffer(const size_t count, const std::string_view& name) const
-{
-    const wgpu::BufferUsage usage = wgpu::BufferUsage::Vertex | wgpu::BufferUsage::CopyDst;
-
-    auto buffer = CreateGpuBuffer(usage, count * sizeof(Vertex), BufferMappedState::Unmapped, name);
-
-    MLG_CHECK(buffer, "Failed to create vertex buffer");
-
-    return GpuVertexBuffer::Create(GetDevice(), *buffer);
-}
-
-Result<GpuIndexBuffer>
-GpuHelper::CreateIndexBuffer(const size_t count, const std::string_view& name) const
-{
-    const wgpu::BufferUsage usage = wgpu::BufferUsage::Index | wgpu::BufferUsage::CopyDst;
-
-    auto buffer =
-        CreateGpuBuffer(usage, count * sizeof(VertexIndex), BufferMappedState::Unmapped, name);
-
-    MLG_CHECK(buffer, "Failed to create index buffer");
-
-    return GpuIndexBuffer::Create(GetDevice(), *buffer);
-}
+// A note on uploading data to the GPU:
+// Per-frame data and texture data are written to staging memory from the upload ring and copied
+// with CopyBufferToBuffer/CopyBufferToTexture. Queue::WriteBuffer is still used for one-off
+// uploads of static data, e.g. vertex and index buffers. Queue::WriteTexture contains a bunch of
+// validation and is slow compared to using a staging buffer and CopyBufferToTexture.
 
 // Texture staging buffer rows must be a multiple of 256 bytes.
 size_t
@@ -1224,6 +1274,28 @@ GpuHelper::CreateGpuBuffer(const wgpu::BufferUsage usage,
     return buffer;
 }
 
+Result<wgpu::Buffer>
+GpuHelper::CreateVertexBuffer(const size_t size, const std::string_view& name) const
+{
+    const wgpu::BufferUsage usage = wgpu::BufferUsage::Vertex | wgpu::BufferUsage::CopyDst;
+
+    auto buffer = CreateGpuBuffer(usage, size, BufferMappedState::Unmapped, name);
+    MLG_CHECK(buffer, "Failed to create vertex buffer");
+
+    return buffer;
+}
+
+Result<wgpu::Buffer>
+GpuHelper::CreateIndexBuffer(const size_t size, const std::string_view& name) const
+{
+    const wgpu::BufferUsage usage = wgpu::BufferUsage::Index | wgpu::BufferUsage::CopyDst;
+
+    auto buffer = CreateGpuBuffer(usage, size, BufferMappedState::Unmapped, name);
+    MLG_CHECK(buffer, "Failed to create index buffer");
+
+    return buffer;
+}
+
 Result<wgpu::Buffer>
 GpuHelper::CreateIndirectBuffer(const size_t size, const std::string_view& name) const
 {
@@ -1238,7 +1310,9 @@ GpuHelper::CreateIndirectBuffer(const size_t size, const std::string_view& name)
 Result<wgpu::Buffer>
 GpuHelper::CreateStorageBuffer(const size_t size, const std::string_view& name) const
 {
-    const wgpu::BufferUsage usage = wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopyDst;
+    // CopySrc allows storage arrays to grow by copying into a larger buffer.
+    const wgpu::BufferUsage usage =
+        wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopyDst | wgpu::BufferUsage::CopySrc;
 
     auto buffer = CreateGpuBuffer(usage, size, BufferMappedState::Unmapped, name);
     MLG_CHECK(buffer, "Failed to create storage buffer");
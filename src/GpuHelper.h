@@ -1,10 +1,12 @@
 #pragma once
 
 #include "GpuTypes.h"
+#include "GpuUploadRing.h"
 #include "VecMath.h"
 
 #include <atomic>
 #include <memory>
+#include <optional>
 #include <string_view>
 
 class FileFetcher;
@@ -18,6 +20,20 @@ public:
     static constexpr size_t kNumTextureChannels = 4;
     static constexpr wgpu::TextureFormat kDepthBufferFormat = wgpu::TextureFormat::Depth24Plus;
 
+    /// @brief Options for a GpuHelper that renders offscreen, without a window or surface.
+    struct HeadlessOptions
+    {
+        /// @brief Dimensions of the offscreen target.
+        Dimension2 Dimensions{};
+
+        /// @brief Backend to request. Null measures CPU cost without any GPU work, Undefined
+        /// lets Dawn choose.
+        wgpu::BackendType BackendType{ wgpu::BackendType::Undefined };
+
+        /// @brief Requests a CPU fallback adapter such as SwiftShader.
+        bool ForceFallbackAdapter{ false };
+    };
+
     /// @brief A task that creates a GpuHelper instance asynchronously.
     class CreateTask
     {
@@ -77,6 +93,7 @@ public:
         CreateTask() = default;
 
         Result<> Begin(const std::string_view& appName);
+        Result<> BeginHeadless(const HeadlessOptions& options);
         Result<> CreateAdapter();
         Result<> FinalizeAdapter();
         Result<> CreateDevice();
@@ -116,6 +133,14 @@ public:
     ///
     static Result<CreateTask> Create(const std::string_view& appName);
 
+    /// @brief Creates a GpuHelper instance asynchronously that renders into an offscreen target
+    /// rather than a window.
+    /// GetSwapChainTexture() returns the offscreen target and there's no surface to present.
+    static Result<CreateTask> CreateHeadless(const HeadlessOptions& options);
+
+    /// @brief Returns true if the GpuHelper renders offscreen, without a window or surface.
+    bool IsHeadless() const { return m_HeadlessOptions.has_value(); }
+
     SDL_Window* GetWindow() const;
     const wgpu::Instance& GetInstance() const;
     const wgpu::Device& GetDevice() const;
@@ -127,7 +152,11 @@ public:
     Result<GpuRenderTarget> GetSwapChainTexture() const;
     wgpu::TextureFormat GetSwapChainFormat() const;
 
-    /// @brief Resizes the swap chain to the given width and height.
+    /// @brief Returns the ring used to stage uploads of buffer and texture data.
+    GpuUploadRing& GetUploadRing() const;
+
+    /// @brief Resizes the swap chain, or the offscreen target if headless, to the given width and
+    /// height.
     Result<> Resize(const uint32_t width, const uint32_t height);
 
     /// @brief Loads a shader from the given file path.
@@ -139,7 +168,15 @@ public:
     Result<wgpu::Texture> CreateTexture(
         const unsigned width, const unsigned height, const std::string_view& name) const;
 
-    /// @brief Creates a bind group that includes the texture and the default sampler.
+    /// @brief Creates an empty 2D texture array with the given dimensions, layer count and name.
+    /// Layers are filled by copying from textures created with CreateTexture().
+    Result<wgpu::Texture> CreateTextureArray(const unsigned width,
+        const unsigned height,
+        const unsigned layerCount,
+        const std::string_view& name) const;
+
+    /// @brief Creates a bind group that includes the texture, viewed as a 2D texture array, and
+    /// the default sampler.
     Result<wgpu::BindGroup> CreateTextureBindGroup(const wgpu::Texture& texture,
         const std::string_view& name) const;
 
@@ -151,22 +188,33 @@ public:
     Result<GpuDepthTarget> CreateDepthBuffer(
         const unsigned width, const unsigned height, const std::string_view& name) const;
 
-    /// @brief Creates a staging buffer for copying texture data to the GPU.
-    Result<wgpu::Buffer> CreateStagingBuffer(wgpu::Texture texture,
-        const std::string_view& name) const;
-
-    /// @brief Commits the data in the staging buffer to texture memory on the GPU.
-    Result<> CommitStagingBuffer(wgpu::Texture texture, wgpu::Buffer stagingBuffer) const;
+    /// @brief Creates a vertex buffer with capacity for the given number of vertices.
+    template<typename T>
+    Result<T> CreateVertexBuffer(const size_t count, const std::string_view& name) const
+    {
+        static_assert(is_gpu_vertex_buffer_type_v<T>,
+            "T must be a GpuBuffer type with GpuBufferUsage::Vertex");
 
-    /// @brief Commits the data in the staging buffer to texture memory on the GPU.
-    static Result<> CommitStagingBuffer(
-        wgpu::Texture texture, wgpu::Buffer stagingBuffer, wgpu::CommandEncoder cmdEncoder);
+        const size_t bufferSize = count * sizeof(typename T::value_type);
+        auto bufferResult = CreateVertexBuffer(bufferSize, name);
+        MLG_CHECK(bufferResult);
 
-    /// @brief Creates a vertex buffer with capacity for the given number of vertices.
-    Result<GpuVertexBuffer> CreateVertexBuffer(const size_t count, const std::string_view& name) const;
+        return T::Create(GetDevice(), *bufferResult);
+    }
 
     /// @brief Creates an index buffer with capacity for the given number of indices.
-    Result<GpuIndexBuffer> CreateIndexBuffer(const size_t count, const std::string_view& name) const;
+    template<typename T>
+    Result<T> CreateIndexBuffer(const size_t count, const std::string_view& name) const
+    {
+        static_assert(is_gpu_index_buffer_type_v<T>,
+            "T must be a GpuBuffer type with GpuBufferUsage::Index");
+
+        const size_t bufferSize = count * sizeof(typename T::value_type);
+        auto bufferResult = CreateIndexBuffer(bufferSize, name);
+        MLG_CHECK(bufferResult);
+
+        return T::Create(GetDevice(), *bufferResult);
+    }
 
     /// @brief Creates a semantically-typed storage buffer.
     template<typename T>
@@ -230,6 +278,8 @@ private:
         BufferMappedState mappedState,
         const std::string_view name) const;
 
+    Result<wgpu::Buffer> CreateVertexBuffer(const size_t size, const std::string_view& name) const;
+    Result<wgpu::Buffer> CreateIndexBuffer(const size_t size, const std::string_view& name) const;
     Result<wgpu::Buffer> CreateIndirectBuffer(const size_t size,
         const std::string_view& name) const;
     Result<wgpu::Buffer> CreateStorageBuffer(const size_t size, const std::string_view& name) const;
@@ -245,4 +295,11 @@ private:
     wgpu::BindGroupLayout m_TextureBindGroupLayout{ nullptr };
     wgpu::Texture m_DefaultTexture{ nullptr };
     wgpu::Sampler m_DefaultSampler{ nullptr };
+
+    // Set when rendering offscreen, in place of the window and surface.
+    std::optional<HeadlessOptions> m_HeadlessOptions;
+    std::optional<GpuRenderTarget> m_OffscreenTarget;
+
+    // Declared last so it's destroyed while the instance and device are still alive.
+    std::unique_ptr<GpuUploadRing> m_UploadRing;
 };
\ No newline at end of file
@@ -0,0 +1,89 @@
+#define MLG_LOGGER_NAME "RTPL"
+
+#include "GpuRenderTargetPool.h"
+
+#include "GpuHelper.h"
+
+#include <algorithm>
+
+namespace
+{
+// Returns the texture of the given size and instance in entries, creating it with create() if
+// needed, and marks it used in the current frame.
+template<typename EntryType, typename CreateFunc>
+auto
+GetOrCreate(std::vector<EntryType>& entries,
+    const Dimension2& dimensions,
+    const uint32_t instance,
+    const uint64_t frameIndex,
+    CreateFunc&& create) -> Result<decltype(EntryType::Texture)>
+{
+    auto it = std::ranges::find_if(entries,
+        [&dimensions, instance](const EntryType& entry)
+        { return entry.Dimensions == dimensions && entry.Instance == instance; });
+
+    if(it == entries.end())
+    {
+        auto texture = create();
+        MLG_CHECK(texture);
+
+        it = entries.insert(entries.end(),
+            EntryType{ .Dimensions = dimensions,
+                .Instance = instance,
+                .Texture = *texture,
+                .LastUsedFrame = 0 });
+    }
+
+    it->LastUsedFrame = frameIndex;
+
+    return it->Texture;
+}
+} // namespace
+
+Result<GpuRenderTarget>
+GpuRenderTargetPool::GetRenderTarget(const Dimension2& dimensions, const uint32_t instance)
+{
+    return GetOrCreate(m_RenderTargets,
+        dimensions,
+        instance,
+        m_FrameIndex,
+        [this, &dimensions]()
+        {
+            MLG_DEBUG("Creating render target with size {}x{}",
+                dimensions.Width,
+                dimensions.Height);
+
+            return m_GpuHelper->CreateRenderTarget(dimensions.Width,
+                dimensions.Height,
+                "RenderTargetPool::RenderTarget");
+        });
+}
+
+Result<GpuDepthTarget>
+GpuRenderTargetPool::GetDepthBuffer(const Dimension2& dimensions, const uint32_t instance)
+{
+    return GetOrCreate(m_DepthBuffers,
+        dimensions,
+        instance,
+        m_FrameIndex,
+        [this, &dimensions]()
+        {
+            MLG_DEBUG("Creating depth buffer with size {}x{}", dimensions.Width, dimensions.Height);
+
+            return m_GpuHelper->CreateDepthBuffer(dimensions.Width,
+                dimensions.Height,
+                "RenderTargetPool::DepthBuffer");
+        });
+}
+
+void
+GpuRenderTargetPool::NextFrame()
+{
+    ++m_FrameIndex;
+
+    auto isIdle = [this](const auto& entry)
+    { return m_FrameIndex - entry.LastUsedFrame > kMaxIdleFrames; };
+
+    std::erase_if(m_RenderTargets, isIdle);
+    std::erase_if(m_DepthBuffers, isIdle);
+}
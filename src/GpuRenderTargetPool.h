@@ -0,0 +1,66 @@
+#pragma once
+
+#include "GpuTypes.h"
+#include "Result.h"
+#include "VecMath.h"
+
+#include <cstdint>
+#include <vector>
+
+class GpuHelper;
+
+/// @brief Keeps render targets and depth buffers, keyed by size and instance, for reuse across
+/// frames.
+///
+/// Rendering at a changing resolution only allocates the first time each size is used, as long
+/// as only a few sizes are used, e.g. because the resolution scale is quantized. Textures that
+/// haven't been used for kMaxIdleFrames frames are released by NextFrame().
+///
+/// Instances tell apart textures of the same size that are used in the same frame, such as the
+/// physical resources of a RenderGraph.
+class GpuRenderTargetPool final
+{
+public:
+    static constexpr uint64_t kMaxIdleFrames = 120;
+
+    GpuRenderTargetPool() = delete;
+    ~GpuRenderTargetPool() = default;
+    GpuRenderTargetPool(const GpuRenderTargetPool&) = delete;
+    GpuRenderTargetPool& operator=(const GpuRenderTargetPool&) = delete;
+    GpuRenderTargetPool(GpuRenderTargetPool&&) = default;
+    GpuRenderTargetPool& operator=(GpuRenderTargetPool&&) = default;
+
+    explicit GpuRenderTargetPool(const GpuHelper& gpuHelper)
+        : m_GpuHelper(&gpuHelper)
+    {
+    }
+
+    /// @brief Returns the given instance of the render targets of the given size, creating it if
+    /// the pool doesn't have it.
+    Result<GpuRenderTarget> GetRenderTarget(const Dimension2& dimensions,
+        const uint32_t instance = 0);
+
+    /// @brief Returns the given instance of the depth buffers of the given size, creating it if
+    /// the pool doesn't have it.
+    Result<GpuDepthTarget> GetDepthBuffer(const Dimension2& dimensions,
+        const uint32_t instance = 0);
+
+    /// @brief Starts a new frame and releases textures that have been idle for too long.
+    void NextFrame();
+
+private:
+    template<typename T>
+    struct Entry
+    {
+        Dimension2 Dimensions;
+        uint32_t Instance;
+        T Texture;
+        uint64_t LastUsedFrame;
+    };
+
+    const GpuHelper* m_GpuHelper{ nullptr };
+
+    std::vector<Entry<GpuRenderTarget>> m_RenderTargets;
+    std::vector<Entry<GpuDepthTarget>> m_DepthBuffers;
+    uint64_t m_FrameIndex{ 0 };
+};
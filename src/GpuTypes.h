@@ -7,6 +7,7 @@
 #include "Vertex.h"
 
 #include <type_traits>
+#include <variant>
 #include <webgpu/webgpu_cpp.h>
 
 class GpuRenderTarget
@@ -219,16 +220,38 @@ MLG_DEFINE_GPU_BUFFER_TRAITS(storage, Storage)
 
 // Strongly-typed GPU storage buffer classes.
 using GpuVertexBuffer = GpuBuffer<Vertex, GpuBufferUsage::Vertex>;
+using GpuQuantizedVertexBuffer = GpuBuffer<QuantizedVertex, GpuBufferUsage::Vertex>;
 using GpuIndexBuffer = GpuBuffer<VertexIndex, GpuBufferUsage::Index>;
+using GpuIndex16Buffer = GpuBuffer<VertexIndex16, GpuBufferUsage::Index>;
 using GpuDrawIndirectBuffer =
     GpuBuffer<ShaderInterop::DrawIndirectParams, GpuBufferUsage::Indirect>;
 using GpuWorldTransformBuffer = GpuBuffer<ShaderInterop::WorldTransform, GpuBufferUsage::Storage>;
 using GpuClipSpaceBuffer = GpuBuffer<ShaderInterop::ClipSpaceTransform, GpuBufferUsage::Storage>;
+using GpuNormalMatrixBuffer = GpuBuffer<ShaderInterop::NormalMatrix, GpuBufferUsage::Storage>;
 using GpuMeshPropertiesBuffer = GpuBuffer<ShaderInterop::MeshProperties, GpuBufferUsage::Storage>;
+using GpuInstanceRemapBuffer = GpuBuffer<ShaderInterop::InstanceRemap, GpuBufferUsage::Storage>;
 using GpuCameraParamsBuffer = GpuBuffer<ShaderInterop::CameraParams, GpuBufferUsage::Uniform>;
 using GpuMaterialConstantsBuffer =
     GpuBuffer<ShaderInterop::MaterialConstants, GpuBufferUsage::Storage>;
 
+/// @brief A vertex buffer in any of the supported vertex formats.
+/// Alternatives are in VertexFormat order.
+using GpuMeshVertexBuffer = std::variant<GpuVertexBuffer, GpuQuantizedVertexBuffer>;
+
+inline VertexFormat
+GetVertexFormat(const GpuMeshVertexBuffer& vertexBuffer)
+{
+    return static_cast<VertexFormat>(vertexBuffer.index());
+}
+
+inline const wgpu::Buffer&
+GetGpuBuffer(const GpuMeshVertexBuffer& vertexBuffer)
+{
+    return std::visit(
+        [](const auto& buffer) -> const wgpu::Buffer& { return buffer.GetGpuBuffer(); },
+        vertexBuffer);
+}
+
 inline bool
 operator==(const wgpu::Texture& a, const wgpu::Texture& b)
 {
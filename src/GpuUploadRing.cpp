@@ -0,0 +1,314 @@
+#define MLG_LOGGER_NAME "UPLD"
+
+#include "GpuUploadRing.h"
+
+#include "GpuHelper.h"
+#include "Log.h"
+#include "PerfMetrics.h"
+
+#include <algorithm>
+
+namespace
+{
+size_t
+AlignUp(const size_t value, const size_t alignment)
+{
+    return (value + alignment - 1) / alignment * alignment;
+}
+} // namespace
+
+Result<std::unique_ptr<GpuUploadRing>>
+GpuUploadRing::Create(wgpu::Instance instance, wgpu::Device device, const size_t chunkSize)
+{
+    MLG_CHECKV(instance, "Invalid wgpu::Instance");
+    MLG_CHECKV(device, "Invalid wgpu::Device");
+    MLG_CHECKV(chunkSize > 0 && chunkSize % kTextureCopyAlignment == 0,
+        "Chunk size must be a non-zero multiple of {}",
+        kTextureCopyAlignment);
+
+    return std::unique_ptr<GpuUploadRing>(
+        new GpuUploadRing(std::move(instance), std::move(device), chunkSize));
+}
+
+GpuUploadRing::~GpuUploadRing()
+{
+    // Fence and map callbacks reference the ring and its chunks. Wait for them to be delivered
+    // before releasing either.
+    auto isMapping = [](const std::unique_ptr<Chunk>& chunk)
+    {
+        return chunk->State == ChunkState::Mapping;
+    };
+
+    while(m_CompletedSerial < m_SubmitSerial || std::ranges::any_of(m_Chunks, isMapping))
+    {
+        m_Instance.ProcessEvents();
+    }
+}
+
+Result<GpuUploadRing::Allocation>
+GpuUploadRing::Allocate(const size_t size, const size_t alignment)
+{
+    static PerfCounter pcUploadBytes({ .Name = "GpuUploadRing.Bytes" });
+
+    MLG_CHECKV(size > 0 && size % kCopyAlignment == 0,
+        "Upload size must be a non-zero multiple of {}",
+        kCopyAlignment);
+    MLG_CHECKV(alignment > 0 && alignment % kCopyAlignment == 0,
+        "Upload alignment must be a multiple of {}",
+        kCopyAlignment);
+
+    Reclaim();
+
+    pcUploadBytes.Increment(size);
+
+    if(size > m_ChunkSize)
+    {
+        auto chunk = CreateChunk(size, true);
+        MLG_CHECK(chunk);
+
+        (*chunk)->Offset = size;
+        (*chunk)->IsWritten = true;
+
+        return Allocation{ .Buffer = (*chunk)->Buffer, .Offset = 0, .Data = (*chunk)->Mapped };
+    }
+
+    auto fits = [size, alignment](const Chunk& chunk)
+    {
+        return AlignUp(chunk.Offset, alignment) + size <= chunk.Mapped.size();
+    };
+
+    if(!m_CurrentChunk || !fits(*m_CurrentChunk))
+    {
+        auto it = std::ranges::find_if(m_Chunks,
+            [](const std::unique_ptr<Chunk>& chunk)
+            {
+                return chunk->State == ChunkState::Mapped && !chunk->IsWritten
+                    && !chunk->IsDedicated;
+            });
+
+        if(it != m_Chunks.end())
+        {
+            m_CurrentChunk = it->get();
+        }
+        else
+        {
+            auto chunk = CreateChunk(m_ChunkSize, false);
+            MLG_CHECK(chunk);
+
+            m_CurrentChunk = *chunk;
+        }
+    }
+
+    Chunk& chunk = *m_CurrentChunk;
+
+    const size_t offset = AlignUp(chunk.Offset, alignment);
+    chunk.Offset = offset + size;
+    chunk.IsWritten = true;
+
+    return Allocation{
+        .Buffer = chunk.Buffer,
+        .Offset = offset,
+        .Data = chunk.Mapped.subspan(offset, size),
+    };
+}
+
+Result<GpuUploadRing::Allocation>
+GpuUploadRing::AllocateTexture(const wgpu::Texture& texture)
+{
+    const size_t rowStride = GpuHelper::GetTextureAlignedRowStride(texture.GetWidth());
+
+    return Allocate(rowStride * texture.GetHeight(), kTextureCopyAlignment);
+}
+
+void
+GpuUploadRing::CopyToTexture(const wgpu::CommandEncoder& cmdEncoder,
+    const Allocation& allocation,
+    const wgpu::Texture& texture)
+{
+    const wgpu::TexelCopyBufferInfo copySrc = //
+        {
+            .layout = //
+            {
+                .offset = allocation.Offset,
+                .bytesPerRow = static_cast<uint32_t>(
+                    GpuHelper::GetTextureAlignedRowStride(texture.GetWidth())),
+                .rowsPerImage = texture.GetHeight(),
+            },
+            .buffer = allocation.Buffer,
+        };
+
+    const wgpu::TexelCopyTextureInfo copyDst = //
+        {
+            .texture = texture,
+            .mipLevel = 0,
+            .origin{},
+        };
+
+    const wgpu::Extent3D copySize = //
+        {
+            .width = texture.GetWidth(),
+            .height = texture.GetHeight(),
+            .depthOrArrayLayers = 1,
+        };
+
+    cmdEncoder.CopyBufferToTexture(&copySrc, &copyDst, &copySize);
+}
+
+void
+GpuUploadRing::BeginWorkerWrite()
+{
+    m_WorkerWrites.fetch_add(1, std::memory_order_relaxed);
+}
+
+void
+GpuUploadRing::EndWorkerWrite()
+{
+    [[maybe_unused]] const size_t previousWrites =
+        m_WorkerWrites.fetch_sub(1, std::memory_order_release);
+    MLG_ASSERT(previousWrites > 0, "EndWorkerWrite() without BeginWorkerWrite()");
+}
+
+Result<>
+GpuUploadRing::Submit(const wgpu::CommandBuffer& commandBuffer)
+{
+    MLG_CHECKV(m_WorkerWrites.load(std::memory_order_acquire) == 0,
+        "Cannot submit while worker threads are writing staging memory");
+
+    const uint64_t serial = m_SubmitSerial + 1;
+
+    // Staging buffers must be unmapped before the GPU can copy from them.
+    for(const std::unique_ptr<Chunk>& chunk : m_Chunks)
+    {
+        if(chunk->State == ChunkState::Mapped && chunk->IsWritten)
+        {
+            chunk->Buffer.Unmap();
+            chunk->Mapped = {};
+            chunk->State = ChunkState::InFlight;
+            chunk->FenceSerial = serial;
+        }
+    }
+
+    m_CurrentChunk = nullptr;
+
+    const wgpu::Queue queue = m_Device.GetQueue();
+    queue.Submit(1, &commandBuffer);
+    queue.OnSubmittedWorkDone(wgpu::CallbackMode::AllowProcessEvents, OnWorkDone, this);
+
+    m_SubmitSerial = serial;
+
+    return Result<>::Ok;
+}
+
+// private:
+
+GpuUploadRing::GpuUploadRing(wgpu::Instance instance, wgpu::Device device, const size_t chunkSize)
+    : m_Instance(std::move(instance)),
+      m_Device(std::move(device)),
+      m_ChunkSize(chunkSize)
+{
+}
+
+Result<GpuUploadRing::Chunk*>
+GpuUploadRing::CreateChunk(const size_t size, const bool isDedicated)
+{
+    static PerfCounter pcChunksCreated({ .Name = "GpuUploadRing.ChunksCreated" });
+
+    const wgpu::BufferDescriptor bufferDesc //
+        {
+            .label = isDedicated ? "UploadRing::DedicatedChunk" : "UploadRing::Chunk",
+            .usage = wgpu::BufferUsage::MapWrite | wgpu::BufferUsage::CopySrc,
+            .size = size,
+            .mappedAtCreation = true,
+        };
+
+    wgpu::Buffer buffer = m_Device.CreateBuffer(&bufferDesc);
+    MLG_CHECKV(buffer, "Failed to create upload buffer");
+
+    void* mapped = buffer.GetMappedRange();
+    MLG_CHECKV(mapped, "Failed to map upload buffer");
+
+    auto chunk = std::make_unique<Chunk>();
+    chunk->Buffer = std::move(buffer);
+    chunk->Mapped = std::span<std::byte>(static_cast<std::byte*>(mapped), size);
+    chunk->IsDedicated = isDedicated;
+
+    pcChunksCreated.Increment(1);
+
+    return m_Chunks.emplace_back(std::move(chunk)).get();
+}
+
+void
+GpuUploadRing::Reclaim()
+{
+    size_t idleChunkCount = static_cast<size_t>(std::ranges::count_if(m_Chunks,
+        [](const std::unique_ptr<Chunk>& chunk)
+        {
+            return chunk->State == ChunkState::Mapping
+                || (chunk->State == ChunkState::Mapped && !chunk->IsWritten);
+        }));
+
+    for(const std::unique_ptr<Chunk>& chunk : m_Chunks)
+    {
+        if(chunk->State != ChunkState::InFlight || chunk->FenceSerial > m_CompletedSerial)
+        {
+            continue;
+        }
+
+        // Bursts of uploads, e.g. while loading textures, can create many chunks. Only a few
+        // are kept for reuse.
+        if(chunk->IsDedicated || idleChunkCount >= kMaxIdleChunks)
+        {
+            chunk->Buffer.Destroy();
+            chunk->State = ChunkState::Retired;
+            continue;
+        }
+
+        // The GPU is done with the chunk so mapping completes without stalling.
+        ++idleChunkCount;
+        chunk->State = ChunkState::Mapping;
+        chunk->Buffer.MapAsync(wgpu::MapMode::Write,
+            0,
+            narrow_cast<size_t>(chunk->Buffer.GetSize()),
+            wgpu::CallbackMode::AllowProcessEvents,
+            OnMapped,
+            chunk.get());
+    }
+
+    std::erase_if(m_Chunks,
+        [](const std::unique_ptr<Chunk>& chunk) { return chunk->State == ChunkState::Retired; });
+}
+
+void
+GpuUploadRing::OnWorkDone(wgpu::QueueWorkDoneStatus status,
+    wgpu::StringView message,
+    GpuUploadRing* ring)
+{
+    if(status != wgpu::QueueWorkDoneStatus::Success)
+    {
+        MLG_ERROR("OnSubmittedWorkDone failed: {}", std::string_view(message.data, message.length));
+    }
+
+    // Work done callbacks are delivered in submission order. On failure the chunks' mapping
+    // fails as well and they are retired.
+    ++ring->m_CompletedSerial;
+}
+
+void
+GpuUploadRing::OnMapped(wgpu::MapAsyncStatus status, wgpu::StringView message, Chunk* chunk)
+{
+    if(status != wgpu::MapAsyncStatus::Success)
+    {
+        MLG_ERROR("Failed to map upload buffer: {}",
+            std::string_view(message.data, message.length));
+        chunk->State = ChunkState::Retired;
+        return;
+    }
+
+    const size_t size = narrow_cast<size_t>(chunk->Buffer.GetSize());
+
+    chunk->Mapped = std::span<std::byte>(static_cast<std::byte*>(chunk->Buffer.GetMappedRange()),
+        size);
+    chunk->Offset = 0;
+    chunk->IsWritten = false;
+    chunk->State = ChunkState::Mapped;
+}
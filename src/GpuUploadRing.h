@@ -0,0 +1,189 @@
+#pragma once
+
+#include "GpuTypes.h"
+#include "Result.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <span>
+#include <vector>
+
+/// @brief Frame-paced ring of mapped staging buffers for uploading data to the GPU.
+///
+/// Data is written directly into mapped staging memory and copied to its destination with
+/// CopyBufferToBuffer or CopyBufferToTexture commands. Staging buffers are allocated in large
+/// chunks that are reused across frames. Submit() unmaps the chunks written since the previous
+/// Submit() and fences them with Queue::OnSubmittedWorkDone. Once the GPU has consumed a chunk it
+/// is mapped again and returned to the ring.
+///
+/// Fence and map callbacks are delivered from Instance::ProcessEvents(), which must be called
+/// regularly (e.g. once per frame) for chunks to be recycled.
+///
+/// Allocations stay writable until the next Submit(). Every copy from an allocation must be
+/// recorded in a command buffer submitted by that Submit().
+///
+/// Allocations can be written by worker threads between BeginWorkerWrite() and EndWorkerWrite().
+/// Submit() fails while any worker writes are in progress, since it unmaps the memory they write.
+class GpuUploadRing final
+{
+public:
+    static constexpr size_t kDefaultChunkSize = 4 * 1024 * 1024;
+
+    /// @brief Maximum number of unused chunks kept mapped for reuse.
+    static constexpr size_t kMaxIdleChunks = 4;
+
+    /// @brief Alignment required for CopyBufferToBuffer offsets and sizes.
+    static constexpr size_t kCopyAlignment = 4;
+
+    /// @brief Alignment used for texture uploads.
+    static constexpr size_t kTextureCopyAlignment = 256;
+
+    /// @brief A region of mapped staging memory.
+    struct Allocation
+    {
+        wgpu::Buffer Buffer;
+        uint64_t Offset{ 0 };
+        std::span<std::byte> Data;
+    };
+
+    static Result<std::unique_ptr<GpuUploadRing>> Create(wgpu::Instance instance,
+        wgpu::Device device,
+        const size_t chunkSize = kDefaultChunkSize);
+
+    GpuUploadRing() = delete;
+    ~GpuUploadRing();
+    GpuUploadRing(const GpuUploadRing&) = delete;
+    GpuUploadRing& operator=(const GpuUploadRing&) = delete;
+    GpuUploadRing(GpuUploadRing&&) = delete;
+    GpuUploadRing& operator=(GpuUploadRing&&) = delete;
+
+    /// @brief Allocates staging memory.
+    /// Allocations larger than the chunk size get a dedicated staging buffer that is released
+    /// once the GPU has consumed it.
+    /// @param size The size of the allocation in bytes. Must be a multiple of kCopyAlignment.
+    /// @param alignment The alignment of the allocation's offset in its staging buffer.
+    Result<Allocation> Allocate(const size_t size, const size_t alignment = kCopyAlignment);
+
+    /// @brief Writes values to staging memory and records a copy of them into dst, starting at
+    /// the given element index.
+    template<typename T, GpuBufferUsage BufferUsage>
+    Result<> Upload(const wgpu::CommandEncoder& cmdEncoder,
+        const GpuBuffer<T, BufferUsage>& dst,
+        const size_t index,
+        const std::span<const T> values)
+    {
+        const size_t size = values.size() * sizeof(T);
+
+        // A copy past the end of dst would invalidate the whole command buffer.
+        MLG_CHECKV(((index * sizeof(T)) + size) <= dst.BufferSize(),
+            "Upload of {} bytes at index {} overruns a {} byte buffer",
+            size,
+            index,
+            dst.BufferSize());
+
+        if(size == 0)
+        {
+            return Result<>::Ok;
+        }
+
+        auto allocation = Allocate(size);
+        MLG_CHECK(allocation);
+
+        std::memcpy(allocation->Data.data(), values.data(), size);
+
+        cmdEncoder.CopyBufferToBuffer(allocation->Buffer,
+            allocation->Offset,
+            dst.GetGpuBuffer(),
+            index * sizeof(T),
+            size);
+
+        return Result<>::Ok;
+    }
+
+    /// @brief Writes values to staging memory and records a copy of them to the start of dst.
+    template<typename T, GpuBufferUsage BufferUsage>
+    Result<> Upload(const wgpu::CommandEncoder& cmdEncoder,
+        const GpuBuffer<T, BufferUsage>& dst,
+        const std::span<const T> values)
+    {
+        return Upload(cmdEncoder, dst, 0, values);
+    }
+
+    /// @brief Allocates staging memory for the texels of a texture.
+    /// Rows are laid out with GpuHelper::GetTextureAlignedRowStride().
+    Result<Allocation> AllocateTexture(const wgpu::Texture& texture);
+
+    /// @brief Records a copy of an allocation from AllocateTexture() into the texture.
+    static void CopyToTexture(const wgpu::CommandEncoder& cmdEncoder,
+        const Allocation& allocation,
+        const wgpu::Texture& texture);
+
+    /// @brief Marks the start of a write into an allocation by a worker thread.
+    /// Called on the main thread before handing the allocation to the worker.
+    void BeginWorkerWrite();
+
+    /// @brief Marks the end of a write started by BeginWorkerWrite(). Can be called from the
+    /// worker thread.
+    void EndWorkerWrite();
+
+    /// @brief Unmaps the staging memory written since the previous Submit(), submits the command
+    /// buffer and fences the staging memory for reuse.
+    /// Fails without submitting if worker threads are still writing staging memory.
+    Result<> Submit(const wgpu::CommandBuffer& commandBuffer);
+
+    size_t GetChunkCount() const { return m_Chunks.size(); }
+
+private:
+    enum class ChunkState
+    {
+        // Mapped and available for allocations.
+        Mapped,
+        // Unmapped and waiting for the GPU to consume it.
+        InFlight,
+        // Waiting for MapAsync to complete.
+        Mapping,
+        // Mapping failed or the chunk is no longer needed.
+        Retired,
+    };
+
+    struct Chunk
+    {
+        wgpu::Buffer Buffer;
+        std::span<std::byte> Mapped;
+        size_t Offset{ 0 };
+        uint64_t FenceSerial{ 0 };
+        ChunkState State{ ChunkState::Mapped };
+        bool IsDedicated{ false };
+        bool IsWritten{ false };
+    };
+
+    GpuUploadRing(wgpu::Instance instance, wgpu::Device device, const size_t chunkSize);
+
+    Result<Chunk*> CreateChunk(const size_t size, const bool isDedicated);
+
+    // Starts remapping chunks the GPU has finished with and releases retired chunks.
+    void Reclaim();
+
+    static void OnWorkDone(wgpu::QueueWorkDoneStatus status,
+        wgpu::StringView message,
+        GpuUploadRing* ring);
+
+    static void OnMapped(wgpu::MapAsyncStatus status, wgpu::StringView message, Chunk* chunk);
+
+    wgpu::Instance m_Instance;
+    wgpu::Device m_Device;
+    size_t m_ChunkSize;
+    std::vector<std::unique_ptr<Chunk>> m_Chunks;
+
+    // Chunk currently being filled.
+    Chunk* m_CurrentChunk{ nullptr };
+
+    // Number of Submit() calls, and number of those the GPU has completed.
+    uint64_t m_SubmitSerial{ 0 };
+    uint64_t m_CompletedSerial{ 0 };
+
+    // Number of writes by worker threads in progress.
+    std::atomic<size_t> m_WorkerWrites{ 0 };
+};
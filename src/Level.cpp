@@ -275,6 +275,11 @@ Level::CollectNodes(T nodeDefs,
 
         nodes.emplace_back(nodeDef.Transform, parentNode);
 
+        if(parentNode && parentNode->IsDynamic())
+        {
+            nodes.back().m_Flags = nodes.back().m_Flags | LevelNode::Flags::Dynamic;
+        }
+
         // If the node has a model, create a ModelNode and MeshInstances for each mesh in the model.
         if(nodeDef.Model)
         {
@@ -316,6 +321,8 @@ Level::CollectNodes(T nodeDefs,
                 MLG_CHECK(bodyId, "Failed to create rigid body for node {}", nodeDef.Name);
 
                 physicsNodes.push_back(PhysicsNode{ &nodes.back(), *bodyId });
+
+                nodes.back().m_Flags = nodes.back().m_Flags | LevelNode::Flags::Dynamic;
             }
         }
     }
@@ -423,7 +430,7 @@ Level::Level(std::vector<LevelNode>&& nodes,
 
     m_RootNodes = std::span(m_Nodes).subspan(0, rootNodeCount);
 
-    UpdateWorldTransforms(m_RootNodes);
+    UpdateWorldTransforms(m_RootNodes, false);
 }
 
 Level::~Level()
@@ -465,7 +472,9 @@ Level::Update(const float timeStep)
         node->m_AngularVelocity = Vec3f{ angVel.x, angVel.y, angVel.z };
     }
 
-    UpdateWorldTransforms(m_RootNodes);
+    // Static nodes never move. Leaving them alone also lets other threads read their
+    // transforms while the level updates on a simulation thread.
+    UpdateWorldTransforms(m_RootNodes, true);
 }
 
 void
@@ -533,10 +542,16 @@ Level::IsInLevel(const LevelNode& nodeRef) const
 }
 
 void
-Level::UpdateWorldTransforms(std::span<LevelNode> nodes)
+Level::UpdateWorldTransforms(std::span<LevelNode> nodes, const bool dynamicOnly)
 {
     for(LevelNode& node : nodes)
     {
+        // Children of dynamic nodes are dynamic, so static nodes only have static descendants.
+        if(dynamicOnly && !node.IsDynamic())
+        {
+            continue;
+        }
+
         if(node.m_Parent)
         {
             node.m_WorldTransform =
@@ -550,7 +565,7 @@ Level::UpdateWorldTransforms(std::span<LevelNode> nodes)
 
         if(!node.m_Children.empty())
         {
-            UpdateWorldTransforms(node.m_Children);
+            UpdateWorldTransforms(node.m_Children, dynamicOnly);
         }
     }
 }
\ No newline at end of file
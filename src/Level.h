@@ -63,7 +63,9 @@ private:
     // Returns true if the node is in the level.
     bool IsInLevel(const LevelNode& node) const;
 
-    void UpdateWorldTransforms(std::span<LevelNode> nodes);
+    // Recomputes world transforms from local transforms.
+    // If dynamicOnly is true, static subtrees are skipped.
+    void UpdateWorldTransforms(std::span<LevelNode> nodes, const bool dynamicOnly);
 
     std::vector<LevelNode> m_Nodes;
     std::vector<PhysicsNode> m_PhysicsNodes;
@@ -2,6 +2,7 @@
 
 #include "Color.h"
 #include "PhysicsTypes.h"
+#include "SceneTypes.h"
 #include "Vertex.h"
 
 #include <optional>
@@ -14,6 +15,9 @@ struct MaterialDef final
     RgbaColorf Color{ 1, 1, 1, 1 };
     float Metalness{ 0.0f };
     float Roughness{ 0.0f };
+    AlphaMode AlphaMode{ AlphaMode::Opaque };
+    // Only used by AlphaMode::Mask.
+    float AlphaCutoff{ 0.5f };
 
     // Used to deduplicate materials based on their properties.
     friend auto operator<=>(const MaterialDef& lhs, const MaterialDef& rhs)
@@ -50,6 +54,16 @@ struct MaterialDef final
             return cmp;
         }
 
+        if(auto cmp = lhs.AlphaMode <=> rhs.AlphaMode; cmp != 0)
+        {
+            return cmp;
+        }
+
+        if(auto cmp = std::strong_order(lhs.AlphaCutoff, rhs.AlphaCutoff); cmp != 0)
+        {
+            return cmp;
+        }
+
         return std::strong_ordering::equal;
     }
 };
@@ -70,6 +84,11 @@ struct ModelDef final
 struct PropKitDef final
 {
     std::vector<ModelDef> ModelDefs;
+    // Quantized vertices are half the size of float vertices, at a small cost in precision.
+    VertexFormat VertexFormat{ VertexFormat::Float };
+    // Reorders each mesh's triangles and vertices for the post-transform vertex cache, overdraw
+    // and vertex fetch before it's added to the property kit.
+    bool OptimizeMeshes{ false };
 };
 
 struct ModelRef final
@@ -190,4 +209,7 @@ struct RootNodeDef final
 struct LevelDef final
 {
     std::vector<RootNodeDef> NodeDefs;
+    // Level builders merge static nodes' meshes into world space batches, see StaticBatcher.
+    // Set before building the level, as builders add nodes to the level def they're given.
+    bool StaticBatching{ false };
 };
\ No newline at end of file
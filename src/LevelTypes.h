@@ -17,7 +17,10 @@ public:
         None = 0,
         Active = 1 << 0,
         Visible = 1 << 1,
-        All = Active | Visible
+        // The node's transform can change after the level is created, e.g. because the node or
+        // one of its ancestors is driven by a rigid body.
+        Dynamic = 1 << 2,
+        All = Active | Visible | Dynamic
     };
 
     LevelNode(const TrsTransformf& localTransform,
@@ -36,6 +39,7 @@ public:
 
     bool IsActive() const { return (m_Flags & Flags::Active) == Flags::Active; }
     bool IsVisible() const { return (m_Flags & Flags::Visible) == Flags::Visible; }
+    bool IsDynamic() const { return (m_Flags & Flags::Dynamic) == Flags::Dynamic; }
 
     const TrsTransformf& GetLocalTransform() const { return m_LocalTransform; }
     const Mat44f& GetWorldTransform() const { return m_WorldTransform; }
@@ -143,6 +147,9 @@ public:
 
     bool IsVisible() const { return m_Node->IsVisible(); }
 
+    /// @brief Returns true if the node's world transform never changes.
+    bool IsStatic() const { return !m_Node->IsDynamic(); }
+
 private:
     friend Level;
 
@@ -0,0 +1,533 @@
+#include "MeshOptimizer.h"
+
+#include "AssertHelper.h"
+#include "narrow_cast.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <limits>
+#include <unordered_map>
+#include <utility>
+
+namespace
+{
+constexpr uint32_t kCacheSize = MeshOptimizer::kCacheSize;
+
+constexpr VertexIndex kInvalidVertex = std::numeric_limits<VertexIndex>::max();
+
+// Triangles that use each vertex of a mesh, in compressed sparse row form.
+class VertexTriangles
+{
+public:
+    VertexTriangles(const size_t vertexCount, const std::span<const VertexIndex> indices)
+        : m_Offsets(vertexCount + 1, 0),
+          m_Triangles(indices.size())
+    {
+        for(const VertexIndex index : indices)
+        {
+            ++m_Offsets[index + 1];
+        }
+
+        for(size_t i = 1; i < m_Offsets.size(); ++i)
+        {
+            m_Offsets[i] += m_Offsets[i - 1];
+        }
+
+        std::vector<uint32_t> counts(vertexCount, 0);
+
+        for(size_t i = 0; i < indices.size(); ++i)
+        {
+            const VertexIndex index = indices[i];
+            m_Triangles[m_Offsets[index] + counts[index]++] = narrow_cast<uint32_t>(i / 3);
+        }
+    }
+
+    std::span<const uint32_t> Get(const VertexIndex vertex) const
+    {
+        return std::span<const uint32_t>(m_Triangles)
+            .subspan(m_Offsets[vertex], m_Offsets[vertex + 1] - m_Offsets[vertex]);
+    }
+
+private:
+    std::vector<uint32_t> m_Offsets;
+    std::vector<uint32_t> m_Triangles;
+};
+
+// FIFO post-transform cache. A vertex is cached if it was transformed within the last
+// kCacheSize transforms.
+class FifoCache
+{
+public:
+    explicit FifoCache(const size_t vertexCount)
+        : m_Timestamps(vertexCount, 0)
+    {
+    }
+
+    // Returns true if the vertex had to be transformed.
+    bool Access(const VertexIndex vertex)
+    {
+        if(m_Time - m_Timestamps[vertex] <= kCacheSize)
+        {
+            return false;
+        }
+
+        m_Timestamps[vertex] = m_Time++;
+        return true;
+    }
+
+    // Evicts every vertex.
+    void Flush() { m_Time += kCacheSize + 1; }
+
+private:
+    std::vector<uint32_t> m_Timestamps;
+    // Starts far enough ahead of the timestamps that nothing is cached.
+    uint32_t m_Time{ kCacheSize + 1 };
+};
+
+// A vertex's attributes as bits, with -0 turned into +0 so that the two compare equal.
+using VertexBits = std::array<uint32_t, sizeof(Vertex) / sizeof(float)>;
+
+VertexBits
+GetVertexBits(const Vertex& vertex)
+{
+    static_assert(sizeof(Vertex) % sizeof(float) == 0, "Vertex must only hold floats");
+
+    const auto floats = std::bit_cast<std::array<float, sizeof(Vertex) / sizeof(float)>>(vertex);
+
+    VertexBits bits;
+    std::ranges::transform(floats,
+        bits.begin(),
+        [](const float value) { return std::bit_cast<uint32_t>(value + 0.0f); });
+
+    return bits;
+}
+
+// NOLINTBEGIN(readability-magic-numbers,cppcoreguidelines-avoid-magic-numbers)
+uint64_t
+HashCombine(const uint64_t seed, const uint64_t value)
+{
+    return seed ^ (value + 0x9e3779b97f4a7c15 + (seed << 6) + (seed >> 2));
+}
+// NOLINTEND(readability-magic-numbers,cppcoreguidelines-avoid-magic-numbers)
+
+uint64_t
+HashVertex(uint64_t seed, const Vertex& vertex)
+{
+    for(const uint32_t word : GetVertexBits(vertex))
+    {
+        seed = HashCombine(seed, word);
+    }
+
+    return seed;
+}
+
+struct VertexBitsHash
+{
+    size_t operator()(const VertexBits& bits) const
+    {
+        uint64_t hash = 0;
+
+        for(const uint32_t word : bits)
+        {
+            hash = HashCombine(hash, word);
+        }
+
+        return static_cast<size_t>(hash);
+    }
+};
+
+// A contiguous range of triangles that overdraw ordering keeps together.
+struct Cluster
+{
+    uint32_t FirstTriangle;
+    uint32_t TriangleCount;
+    float SortKey;
+};
+
+// Splits triangles into clusters at points where the cache simulation sees every vertex of a
+// triangle miss, which is where Tipsify had to jump elsewhere in the mesh. Clusters are split
+// further wherever their ACMR so far is within threshold of the mesh's.
+std::vector<uint32_t>
+FindClusterStarts(const std::span<const VertexIndex> indices,
+    const size_t vertexCount,
+    const float meshAcmr,
+    const float threshold)
+{
+    const size_t triangleCount = indices.size() / 3;
+
+    std::vector<uint32_t> starts{ 0 };
+
+    FifoCache cache(vertexCount);
+    size_t clusterTriangles = 0;
+    size_t clusterTransforms = 0;
+
+    for(size_t triangle = 0; triangle < triangleCount; ++triangle)
+    {
+        size_t transforms = 0;
+
+        for(size_t corner = 0; corner < 3; ++corner)
+        {
+            transforms += cache.Access(indices[(triangle * 3) + corner]) ? 1u : 0u;
+        }
+
+        if(transforms == 3 && clusterTriangles > 0)
+        {
+            starts.push_back(narrow_cast<uint32_t>(triangle));
+            clusterTriangles = 0;
+            clusterTransforms = 0;
+        }
+
+        ++clusterTriangles;
+        clusterTransforms += transforms;
+
+        const bool cheapEnough = static_cast<float>(clusterTransforms)
+            <= meshAcmr * threshold * static_cast<float>(clusterTriangles);
+
+        if(cheapEnough && triangle + 1 < triangleCount)
+        {
+            // Start the next cluster cold so its cost doesn't depend on what precedes it.
+            starts.push_back(narrow_cast<uint32_t>(triangle + 1));
+            cache.Flush();
+            clusterTriangles = 0;
+            clusterTransforms = 0;
+        }
+    }
+
+    return starts;
+}
+} // namespace
+
+void
+MeshOptimizer::WeldVertices(std::vector<Vertex>& vertices, const std::span<VertexIndex> indices)
+{
+    std::unordered_map<VertexBits, VertexIndex, VertexBitsHash> uniqueVertices;
+    uniqueVertices.reserve(vertices.size());
+
+    std::vector<VertexIndex> remap(vertices.size());
+    std::vector<Vertex> outVertices;
+    outVertices.reserve(vertices.size());
+
+    for(size_t i = 0; i < vertices.size(); ++i)
+    {
+        const auto [it, inserted] = uniqueVertices.try_emplace(GetVertexBits(vertices[i]),
+            narrow_cast<VertexIndex>(outVertices.size()));
+
+        if(inserted)
+        {
+            outVertices.push_back(vertices[i]);
+        }
+
+        remap[i] = it->second;
+    }
+
+    if(outVertices.size() == vertices.size())
+    {
+        return;
+    }
+
+    for(VertexIndex& index : indices)
+    {
+        index = remap[index];
+    }
+
+    vertices = std::move(outVertices);
+}
+
+uint64_t
+MeshOptimizer::HashMesh(const std::span<const Vertex> vertices,
+    const std::span<const VertexIndex> indices)
+{
+    uint64_t hash = HashCombine(vertices.size(), indices.size());
+
+    for(const Vertex& vertex : vertices)
+    {
+        hash = HashVertex(hash, vertex);
+    }
+
+    for(const VertexIndex index : indices)
+    {
+        hash = HashCombine(hash, index);
+    }
+
+    return hash;
+}
+
+void
+MeshOptimizer::OptimizeVertexCache(const std::span<VertexIndex> indices, const size_t vertexCount)
+{
+    MLG_ASSERT(indices.size() % 3 == 0, "Index count must be a multiple of 3");
+
+    const size_t triangleCount = indices.size() / 3;
+
+    if(triangleCount == 0)
+    {
+        return;
+    }
+
+    const std::vector<VertexIndex> sourceIndices(indices.begin(), indices.end());
+    const VertexTriangles vertexTriangles(vertexCount, sourceIndices);
+
+    // Triangles not yet emitted that use each vertex.
+    std::vector<uint32_t> liveTriangles(vertexCount);
+    for(VertexIndex vertex = 0; vertex < vertexCount; ++vertex)
+    {
+        liveTriangles[vertex] = narrow_cast<uint32_t>(vertexTriangles.Get(vertex).size());
+    }
+
+    std::vector<uint32_t> cacheTimestamps(vertexCount, 0);
+    uint32_t time = kCacheSize + 1;
+
+    std::vector<bool> emitted(triangleCount, false);
+    // Recently used vertices to restart from when the fanning vertex has no triangles left.
+    std::vector<VertexIndex> deadEnds;
+    // Vertices of the triangles emitted around the current fanning vertex.
+    std::vector<VertexIndex> candidates;
+
+    VertexIndex nextVertex = 0;
+    size_t outTriangleCount = 0;
+
+    auto skipDeadEnd = [&]()
+    {
+        while(!deadEnds.empty())
+        {
+            const VertexIndex vertex = deadEnds.back();
+            deadEnds.pop_back();
+
+            if(liveTriangles[vertex] > 0)
+            {
+                return vertex;
+            }
+        }
+
+        // Scan forward in vertex order for the next vertex with triangles left.
+        while(nextVertex < vertexCount)
+        {
+            const VertexIndex vertex = nextVertex++;
+
+            if(liveTriangles[vertex] > 0)
+            {
+                return vertex;
+            }
+        }
+
+        return kInvalidVertex;
+    };
+
+    VertexIndex fanningVertex = skipDeadEnd();
+
+    while(fanningVertex != kInvalidVertex)
+    {
+        candidates.clear();
+
+        for(const uint32_t triangle : vertexTriangles.Get(fanningVertex))
+        {
+            if(emitted[triangle])
+            {
+                continue;
+            }
+
+            emitted[triangle] = true;
+
+            for(size_t corner = 0; corner < 3; ++corner)
+            {
+                const VertexIndex vertex = sourceIndices[(triangle * 3) + corner];
+
+                indices[(outTriangleCount * 3) + corner] = vertex;
+                deadEnds.push_back(vertex);
+                candidates.push_back(vertex);
+                --liveTriangles[vertex];
+
+                if(time - cacheTimestamps[vertex] > kCacheSize)
+                {
+                    cacheTimestamps[vertex] = time++;
+                }
+            }
+
+            ++outTriangleCount;
+        }
+
+        // Fan next around the candidate that will still be cached once its remaining
+        // triangles are emitted, preferring the one that entered the cache earliest.
+        fanningVertex = kInvalidVertex;
+        int64_t bestPriority = -1;
+
+        for(const VertexIndex vertex : candidates)
+        {
+            if(liveTriangles[vertex] == 0)
+            {
+                continue;
+            }
+
+            const uint32_t age = time - cacheTimestamps[vertex];
+            const int64_t priority = (age + (2 * liveTriangles[vertex])) <= kCacheSize ? age : 0;
+
+            if(priority > bestPriority)
+            {
+                bestPriority = priority;
+                fanningVertex = vertex;
+            }
+        }
+
+        if(fanningVertex == kInvalidVertex)
+        {
+            fanningVertex = skipDeadEnd();
+        }
+    }
+
+    MLG_ASSERT(outTriangleCount == triangleCount, "Not every triangle was emitted");
+}
+
+void
+MeshOptimizer::OptimizeOverdraw(const std::span<const Vec3f> positions,
+    const std::span<VertexIndex> indices,
+    const float threshold)
+{
+    MLG_ASSERT(indices.size() % 3 == 0, "Index count must be a multiple of 3");
+
+    const size_t triangleCount = indices.size() / 3;
+
+    if(triangleCount == 0)
+    {
+        return;
+    }
+
+    const float meshAcmr = AnalyzeVertexCache(indices, positions.size()).GetAcmr();
+    const std::vector<uint32_t> starts =
+        FindClusterStarts(indices, positions.size(), meshAcmr, threshold);
+
+    if(starts.size() < 2)
+    {
+        return;
+    }
+
+    // Area weighted centroids and normals. Triangle cross products are twice their area.
+    auto getTriangle = [&](const size_t triangle)
+    {
+        const Vec3f& p0 = positions[indices[triangle * 3]];
+        const Vec3f& p1 = positions[indices[(triangle * 3) + 1]];
+        const Vec3f& p2 = positions[indices[(triangle * 3) + 2]];
+
+        const Vec3f cross = (p1 - p0).Cross(p2 - p0);
+
+        return std::pair((p0 + p1 + p2) / 3.0f, cross);
+    };
+
+    Vec3f meshCentroid(0, 0, 0);
+    float meshArea = 0;
+
+    for(size_t triangle = 0; triangle < triangleCount; ++triangle)
+    {
+        const auto [centroid, cross] = getTriangle(triangle);
+        const float area = cross.Length();
+
+        meshCentroid += centroid * area;
+        meshArea += area;
+    }
+
+    if(meshArea > 0)
+    {
+        meshCentroid /= meshArea;
+    }
+
+    std::vector<Cluster> clusters;
+    clusters.reserve(starts.size());
+
+    for(size_t i = 0; i < starts.size(); ++i)
+    {
+        const uint32_t first = starts[i];
+        const uint32_t end =
+            i + 1 < starts.size() ? starts[i + 1] : narrow_cast<uint32_t>(triangleCount);
+
+        Vec3f clusterCentroid(0, 0, 0);
+        Vec3f clusterNormal(0, 0, 0);
+        float clusterArea = 0;
+
+        for(uint32_t triangle = first; triangle < end; ++triangle)
+        {
+            const auto [centroid, cross] = getTriangle(triangle);
+            const float area = cross.Length();
+
+            clusterCentroid += centroid * area;
+            clusterNormal += cross;
+            clusterArea += area;
+        }
+
+        const float normalLength = clusterNormal.Length();
+
+        // Degenerate clusters don't rasterize, so where they draw doesn't matter.
+        const float sortKey = clusterArea > 0 && normalLength > 0
+            ? ((clusterCentroid / clusterArea) - meshCentroid).Dot(clusterNormal / normalLength)
+            : 0.0f;
+
+        clusters.push_back(Cluster //
+            {
+                .FirstTriangle = first,
+                .TriangleCount = end - first,
+                .SortKey = sortKey,
+            });
+    }
+
+    // Clusters far out along their normals occlude the rest of the mesh.
+    std::ranges::stable_sort(clusters,
+        [](const Cluster& a, const Cluster& b) { return a.SortKey > b.SortKey; });
+
+    const std::vector<VertexIndex> sourceIndices(indices.begin(), indices.end());
+    auto outIndex = indices.begin();
+
+    for(const Cluster& cluster : clusters)
+    {
+        const auto first = sourceIndices.begin() + (cluster.FirstTriangle * 3);
+        outIndex = std::copy(first, first + (cluster.TriangleCount * 3), outIndex);
+    }
+}
+
+void
+MeshOptimizer::OptimizeVertexFetch(std::vector<Vertex>& vertices,
+    const std::span<VertexIndex> indices)
+{
+    std::vector<VertexIndex> remap(vertices.size(), kInvalidVertex);
+    std::vector<Vertex> outVertices;
+    outVertices.reserve(vertices.size());
+
+    for(VertexIndex& index : indices)
+    {
+        if(remap[index] == kInvalidVertex)
+        {
+            remap[index] = narrow_cast<VertexIndex>(outVertices.size());
+            outVertices.push_back(vertices[index]);
+        }
+
+        index = remap[index];
+    }
+
+    vertices = std::move(outVertices);
+}
+
+VertexCacheStats
+MeshOptimizer::AnalyzeVertexCache(const std::span<const VertexIndex> indices,
+    const size_t vertexCount)
+{
+    MLG_ASSERT(indices.size() % 3 == 0, "Index count must be a multiple of 3");
+
+    VertexCacheStats stats{ .TriangleCount = indices.size() / 3 };
+
+    FifoCache cache(vertexCount);
+    std::vector<bool> referenced(vertexCount, false);
+
+    for(const VertexIndex index : indices)
+    {
+        if(cache.Access(index))
+        {
+            ++stats.TransformCount;
+        }
+
+        if(!referenced[index])
+        {
+            referenced[index] = true;
+            ++stats.VertexCount;
+        }
+    }
+
+    return stats;
+}
@@ -0,0 +1,417 @@
+#include "MeshSimplifier.h"
+
+#include "AssertHelper.h"
+#include "narrow_cast.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <unordered_map>
+
+namespace
+{
+using Vec3d = Vec3<double>;
+
+using Triangle = std::array<VertexIndex, 3>;
+
+// Symmetric 4x4 matrix measuring the sum of squared distances from a point to a set of planes.
+struct Quadric
+{
+    double XX{ 0 }, XY{ 0 }, XZ{ 0 }, XW{ 0 };
+    double YY{ 0 }, YZ{ 0 }, YW{ 0 };
+    double ZZ{ 0 }, ZW{ 0 };
+    double WW{ 0 };
+
+    static Quadric FromPlane(const Vec3d& normal, const double distance)
+    {
+        return Quadric //
+            {
+                .XX = normal.x * normal.x,
+                .XY = normal.x * normal.y,
+                .XZ = normal.x * normal.z,
+                .XW = normal.x * distance,
+                .YY = normal.y * normal.y,
+                .YZ = normal.y * normal.z,
+                .YW = normal.y * distance,
+                .ZZ = normal.z * normal.z,
+                .ZW = normal.z * distance,
+                .WW = distance * distance,
+            };
+    }
+
+    Quadric& operator+=(const Quadric& that)
+    {
+        XX += that.XX;
+        XY += that.XY;
+        XZ += that.XZ;
+        XW += that.XW;
+        YY += that.YY;
+        YZ += that.YZ;
+        YW += that.YW;
+        ZZ += that.ZZ;
+        ZW += that.ZW;
+        WW += that.WW;
+        return *this;
+    }
+
+    friend Quadric operator+(Quadric a, const Quadric& b) { return a += b; }
+
+    // Returns the sum of squared distances from p to the quadric's planes.
+    double Evaluate(const Vec3d& p) const
+    {
+        const double error = (XX * p.x * p.x) + (YY * p.y * p.y) + (ZZ * p.z * p.z)
+            + 2 * ((XY * p.x * p.y) + (XZ * p.x * p.z) + (YZ * p.y * p.z))
+            + 2 * ((XW * p.x) + (YW * p.y) + (ZW * p.z)) + WW;
+
+        // Round off can produce small negative values.
+        return std::max(error, 0.0);
+    }
+};
+
+// Collapsing From onto To. Versions detect candidates made stale by later collapses.
+struct Collapse
+{
+    double Cost;
+    VertexIndex From;
+    VertexIndex To;
+    uint32_t FromVersion;
+    uint32_t ToVersion;
+};
+
+constexpr auto kCollapseGreater = [](const Collapse& a, const Collapse& b)
+{
+    return a.Cost > b.Cost;
+};
+
+uint64_t
+EdgeKey(const VertexIndex a, const VertexIndex b)
+{
+    return (uint64_t{ std::min(a, b) } << VERTEX_INDEX_BITS) | std::max(a, b);
+}
+
+Vec3d
+ToVec3d(const Vec3f& v)
+{
+    return Vec3d(v.x, v.y, v.z);
+}
+
+Vec3d
+TriangleNormal(const Vec3d& p0, const Vec3d& p1, const Vec3d& p2)
+{
+    return (p1 - p0).Cross(p2 - p0);
+}
+
+class Simplifier
+{
+public:
+    Simplifier(const std::span<const Vec3f> positions, const std::span<const VertexIndex> indices);
+
+    void Run(const size_t targetIndexCount, const double maxCost);
+
+    std::vector<VertexIndex> GetIndices() const;
+
+    double GetMaxCost() const { return m_MaxCost; }
+
+private:
+    void PushCollapse(const VertexIndex from, const VertexIndex to);
+
+    void PushCollapses(const VertexIndex vertex);
+
+    bool IsValidCollapse(const Collapse& collapse) const;
+
+    void ApplyCollapse(const Collapse& collapse);
+
+    std::vector<Vec3d> m_Positions;
+    std::vector<Triangle> m_Triangles;
+    std::vector<bool> m_TriangleAlive;
+    std::vector<std::vector<uint32_t>> m_VertexTriangles;
+    std::vector<Quadric> m_Quadrics;
+    std::vector<bool> m_Locked;
+    std::vector<bool> m_Removed;
+    std::vector<uint32_t> m_Versions;
+    std::vector<Collapse> m_Heap;
+    size_t m_IndexCount{ 0 };
+    double m_MaxCost{ 0 };
+};
+
+Simplifier::Simplifier(const std::span<const Vec3f> positions,
+    const std::span<const VertexIndex> indices)
+    : m_VertexTriangles(positions.size()),
+      m_Quadrics(positions.size()),
+      m_Locked(positions.size(), false),
+      m_Removed(positions.size(), false),
+      m_Versions(positions.size(), 0)
+{
+    m_Positions.reserve(positions.size());
+    for(const Vec3f& position : positions)
+    {
+        m_Positions.push_back(ToVec3d(position));
+    }
+
+    m_Triangles.reserve(indices.size() / 3);
+
+    std::unordered_map<uint64_t, uint32_t> edgeTriangleCounts;
+
+    for(size_t i = 0; i + 2 < indices.size(); i += 3)
+    {
+        const Triangle tri{ indices[i], indices[i + 1], indices[i + 2] };
+
+        MLG_ASSERT(tri[0] < positions.size() && tri[1] < positions.size()
+                && tri[2] < positions.size(),
+            "Vertex index out of range");
+
+        if(tri[0] == tri[1] || tri[1] == tri[2] || tri[2] == tri[0])
+        {
+            continue;
+        }
+
+        const Vec3d normal =
+            TriangleNormal(m_Positions[tri[0]], m_Positions[tri[1]], m_Positions[tri[2]]);
+        const double length = normal.Length();
+
+        if(length > 0)
+        {
+            // Unweighted planes keep quadric errors in units of squared distance.
+            const Vec3d unitNormal = normal / length;
+            const Quadric quadric =
+                Quadric::FromPlane(unitNormal, -unitNormal.Dot(m_Positions[tri[0]]));
+
+            for(const VertexIndex v : tri)
+            {
+                m_Quadrics[v] += quadric;
+            }
+        }
+
+        const uint32_t triIndex = narrow_cast<uint32_t>(m_Triangles.size());
+
+        for(size_t corner = 0; corner < 3; ++corner)
+        {
+            m_VertexTriangles[tri[corner]].push_back(triIndex);
+            ++edgeTriangleCounts[EdgeKey(tri[corner], tri[(corner + 1) % 3])];
+        }
+
+        m_Triangles.push_back(tri);
+    }
+
+    m_TriangleAlive.assign(m_Triangles.size(), true);
+    m_IndexCount = m_Triangles.size() * 3;
+
+    // Vertices on open or non-manifold edges are never moved. This preserves mesh borders and
+    // attribute seams, where vertices are split and triangles on either side don't share edges.
+    for(const auto& [edgeKey, triangleCount] : edgeTriangleCounts)
+    {
+        if(triangleCount != 2)
+        {
+            m_Locked[static_cast<VertexIndex>(edgeKey >> VERTEX_INDEX_BITS)] = true;
+            m_Locked[static_cast<VertexIndex>(edgeKey)] = true;
+        }
+    }
+
+    for(const Triangle& tri : m_Triangles)
+    {
+        for(size_t corner = 0; corner < 3; ++corner)
+        {
+            PushCollapse(tri[corner], tri[(corner + 1) % 3]);
+            PushCollapse(tri[(corner + 1) % 3], tri[corner]);
+        }
+    }
+}
+
+void
+Simplifier::Run(const size_t targetIndexCount, const double maxCost)
+{
+    while(m_IndexCount > targetIndexCount && !m_Heap.empty())
+    {
+        std::ranges::pop_heap(m_Heap, kCollapseGreater);
+        const Collapse collapse = m_Heap.back();
+        m_Heap.pop_back();
+
+        if(collapse.Cost > maxCost)
+        {
+            // The heap is ordered by cost so no remaining collapse is cheap enough.
+            break;
+        }
+
+        if(!IsValidCollapse(collapse))
+        {
+            continue;
+        }
+
+        ApplyCollapse(collapse);
+    }
+}
+
+std::vector<VertexIndex>
+Simplifier::GetIndices() const
+{
+    std::vector<VertexIndex> indices;
+    indices.reserve(m_IndexCount);
+
+    for(size_t i = 0; i < m_Triangles.size(); ++i)
+    {
+        if(m_TriangleAlive[i])
+        {
+            indices.insert(indices.end(), m_Triangles[i].begin(), m_Triangles[i].end());
+        }
+    }
+
+    return indices;
+}
+
+// private:
+
+void
+Simplifier::PushCollapse(const VertexIndex from, const VertexIndex to)
+{
+    if(m_Locked[from])
+    {
+        return;
+    }
+
+    const Collapse collapse //
+        {
+            .Cost = (m_Quadrics[from] + m_Quadrics[to]).Evaluate(m_Positions[to]),
+            .From = from,
+            .To = to,
+            .FromVersion = m_Versions[from],
+            .ToVersion = m_Versions[to],
+        };
+
+    m_Heap.push_back(collapse);
+    std::ranges::push_heap(m_Heap, kCollapseGreater);
+}
+
+void
+Simplifier::PushCollapses(const VertexIndex vertex)
+{
+    for(const uint32_t triIndex : m_VertexTriangles[vertex])
+    {
+        if(!m_TriangleAlive[triIndex])
+        {
+            continue;
+        }
+
+        for(const VertexIndex other : m_Triangles[triIndex])
+        {
+            if(other != vertex)
+            {
+                PushCollapse(vertex, other);
+                PushCollapse(other, vertex);
+            }
+        }
+    }
+}
+
+bool
+Simplifier::IsValidCollapse(const Collapse& collapse) const
+{
+    const VertexIndex from = collapse.From;
+    const VertexIndex to = collapse.To;
+
+    if(m_Removed[from] || m_Removed[to] || m_Versions[from] != collapse.FromVersion
+        || m_Versions[to] != collapse.ToVersion)
+    {
+        return false;
+    }
+
+    bool sharesTriangle = false;
+
+    for(const uint32_t triIndex : m_VertexTriangles[from])
+    {
+        if(!m_TriangleAlive[triIndex])
+        {
+            continue;
+        }
+
+        const Triangle& tri = m_Triangles[triIndex];
+
+        if(std::ranges::find(tri, to) != tri.end())
+        {
+            sharesTriangle = true;
+            continue;
+        }
+
+        // Reject collapses that would flip or flatten a remaining triangle.
+        std::array<Vec3d, 3> corners{};
+        for(size_t corner = 0; corner < 3; ++corner)
+        {
+            corners[corner] = m_Positions[tri[corner]];
+        }
+
+        const Vec3d oldNormal = TriangleNormal(corners[0], corners[1], corners[2]);
+
+        for(size_t corner = 0; corner < 3; ++corner)
+        {
+            if(tri[corner] == from)
+            {
+                corners[corner] = m_Positions[to];
+            }
+        }
+
+        const Vec3d newNormal = TriangleNormal(corners[0], corners[1], corners[2]);
+
+        if(oldNormal.Dot(newNormal) <= 0)
+        {
+            return false;
+        }
+    }
+
+    return sharesTriangle;
+}
+
+void
+Simplifier::ApplyCollapse(const Collapse& collapse)
+{
+    const VertexIndex from = collapse.From;
+    const VertexIndex to = collapse.To;
+
+    for(const uint32_t triIndex : m_VertexTriangles[from])
+    {
+        if(!m_TriangleAlive[triIndex])
+        {
+            continue;
+        }
+
+        Triangle& tri = m_Triangles[triIndex];
+
+        if(std::ranges::find(tri, to) != tri.end())
+        {
+            m_TriangleAlive[triIndex] = false;
+            m_IndexCount -= 3;
+            continue;
+        }
+
+        std::ranges::replace(tri, from, to);
+        m_VertexTriangles[to].push_back(triIndex);
+    }
+
+    m_VertexTriangles[from].clear();
+    m_Removed[from] = true;
+
+    m_Quadrics[to] += m_Quadrics[from];
+    ++m_Versions[to];
+
+    m_MaxCost = std::max(m_MaxCost, collapse.Cost);
+
+    PushCollapses(to);
+}
+} // namespace
+
+std::vector<VertexIndex>
+MeshSimplifier::Simplify(const std::span<const Vec3f> positions,
+    const std::span<const VertexIndex> indices,
+    const size_t targetIndexCount,
+    const float maxError,
+    float& outError)
+{
+    Simplifier simplifier(positions, indices);
+
+    const double maxCost = static_cast<double>(maxError) * static_cast<double>(maxError);
+
+    simplifier.Run(targetIndexCount, maxCost);
+
+    outError = static_cast<float>(std::sqrt(simplifier.GetMaxCost()));
+
+    return simplifier.GetIndices();
+}
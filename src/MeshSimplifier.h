@@ -0,0 +1,39 @@
+#pragma once
+
+#include "VecMath.h"
+#include "Vertex.h"
+
+#include <span>
+#include <vector>
+
+/// @brief Reduces the triangle count of indexed meshes using quadric error metric edge
+/// collapses (Garland and Heckbert).
+///
+/// Vertices are only ever collapsed onto one of their neighbors, so simplified meshes reference
+/// a subset of the original vertices and can share the original vertex buffer. Vertices on
+/// open borders, including attribute seams where vertices are split, are never moved.
+class MeshSimplifier final
+{
+public:
+
+    MeshSimplifier() = delete;
+    ~MeshSimplifier() = delete;
+    MeshSimplifier(const MeshSimplifier&) = delete;
+    MeshSimplifier& operator=(const MeshSimplifier&) = delete;
+    MeshSimplifier(MeshSimplifier&&) = delete;
+    MeshSimplifier& operator=(MeshSimplifier&&) = delete;
+
+    /// @brief Simplifies a triangle list.
+    /// @param positions The mesh's vertex positions.
+    /// @param indices The mesh's triangle list indices. Indices are relative to positions.
+    /// @param targetIndexCount Simplification stops once the index count is at or below this.
+    /// @param maxError Simplification stops before introducing more than this error, measured
+    /// as a distance in the same units as positions.
+    /// @param outError Receives the largest error introduced.
+    /// @return The simplified triangle list indices.
+    static std::vector<VertexIndex> Simplify(const std::span<const Vec3f> positions,
+        const std::span<const VertexIndex> indices,
+        const size_t targetIndexCount,
+        const float maxError,
+        float& outError);
+};
@@ -0,0 +1,275 @@
+#include "MeshletBuilder.h"
+
+#include "AssertHelper.h"
+#include "narrow_cast.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace
+{
+// Normal cones whose triangles diverge further than this from the axis are too wide to be
+// worth testing. cos(84 degrees).
+constexpr float kMinConeDot = 0.1f;
+
+// Triangles that share vertices with each vertex of a mesh, in compressed sparse row form.
+class VertexTriangles
+{
+public:
+    VertexTriangles(const size_t vertexCount, const std::span<const VertexIndex> indices)
+        : m_Offsets(vertexCount + 1, 0),
+          m_Triangles(indices.size())
+    {
+        for(const VertexIndex index : indices)
+        {
+            ++m_Offsets[index + 1];
+        }
+
+        for(size_t i = 1; i < m_Offsets.size(); ++i)
+        {
+            m_Offsets[i] += m_Offsets[i - 1];
+        }
+
+        std::vector<uint32_t> counts(vertexCount, 0);
+
+        for(size_t i = 0; i < indices.size(); ++i)
+        {
+            const VertexIndex index = indices[i];
+            m_Triangles[m_Offsets[index] + counts[index]++] = narrow_cast<uint32_t>(i / 3);
+        }
+    }
+
+    std::span<const uint32_t> Get(const VertexIndex vertex) const
+    {
+        return std::span<const uint32_t>(m_Triangles)
+            .subspan(m_Offsets[vertex], m_Offsets[vertex + 1] - m_Offsets[vertex]);
+    }
+
+private:
+    std::vector<uint32_t> m_Offsets;
+    std::vector<uint32_t> m_Triangles;
+};
+
+Meshlet
+MakeMeshlet(const std::span<const Vec3f> positions,
+    const std::span<const VertexIndex> indices,
+    const uint32_t firstIndex)
+{
+    Vec3f min = positions[indices[0]];
+    Vec3f max = min;
+
+    for(const VertexIndex index : indices)
+    {
+        const Vec3f& pos = positions[index];
+        min = Vec3f(std::min(min.x, pos.x), std::min(min.y, pos.y), std::min(min.z, pos.z));
+        max = Vec3f(std::max(max.x, pos.x), std::max(max.y, pos.y), std::max(max.z, pos.z));
+    }
+
+    // Unit normals so that large triangles don't dominate the cone axis.
+    std::vector<Vec3f> normals;
+    normals.reserve(indices.size() / 3);
+
+    Vec3f axis(0, 0, 0);
+
+    for(size_t i = 0; i < indices.size(); i += 3)
+    {
+        const Vec3f& p0 = positions[indices[i]];
+        const Vec3f& p1 = positions[indices[i + 1]];
+        const Vec3f& p2 = positions[indices[i + 2]];
+
+        const Vec3f normal = (p1 - p0).Cross(p2 - p0);
+        const float length = normal.Length();
+
+        // Degenerate triangles don't rasterize, so they don't constrain the cone.
+        if(length > 0)
+        {
+            normals.push_back(normal / length);
+            axis += normals.back();
+        }
+    }
+
+    const float axisLength = axis.Length();
+    float minDot = axisLength > 0 ? 1.0f : -1.0f;
+
+    if(axisLength > 0)
+    {
+        axis /= axisLength;
+
+        for(const Vec3f& normal : normals)
+        {
+            minDot = std::min(minDot, normal.Dot(axis));
+        }
+    }
+
+    const float coneCutoff = minDot > kMinConeDot ? std::sqrt(1 - (minDot * minDot)) : 1.0f;
+
+    return Meshlet //
+        {
+            .FirstIndex = firstIndex,
+            .IndexCount = narrow_cast<uint32_t>(indices.size()),
+            // Single points still need a positive radius.
+            .Bounds = BoundingSphere((min + max) * 0.5f,
+                std::max((max - min).Length() * 0.5f, std::numeric_limits<float>::min())),
+            .ConeAxis = axis,
+            .ConeCutoff = coneCutoff,
+        };
+}
+} // namespace
+
+void
+MeshletBuilder::Build(const std::span<const Vec3f> positions,
+    const std::span<VertexIndex> indices,
+    const uint32_t firstIndex,
+    std::vector<Meshlet>& outMeshlets)
+{
+    MLG_ASSERT(indices.size() % 3 == 0, "Index count must be a multiple of 3");
+
+    const size_t triangleCount = indices.size() / 3;
+
+    if(triangleCount == 0)
+    {
+        return;
+    }
+
+    const std::vector<VertexIndex> sourceIndices(indices.begin(), indices.end());
+    const VertexTriangles vertexTriangles(positions.size(), sourceIndices);
+
+    std::vector<bool> triangleUsed(triangleCount, false);
+    // Meshlet ordinal + 1 of the meshlet that last referenced each vertex.
+    std::vector<uint32_t> vertexMeshlet(positions.size(), 0);
+    // Unused triangles adjacent to the current meshlet, possibly with duplicates.
+    std::vector<uint32_t> candidates;
+
+    uint32_t meshlet = 1;
+    size_t meshletVertexCount = 0;
+    // Sum of the centroids of the current meshlet's triangles.
+    Vec3f meshletCentroidSum(0, 0, 0);
+    size_t meshletFirstTriangle = 0;
+    size_t outTriangleCount = 0;
+    size_t nextSeed = 0;
+
+    auto newVertexCount = [&](const uint32_t triangle)
+    {
+        size_t count = 0;
+
+        for(size_t corner = 0; corner < 3; ++corner)
+        {
+            if(vertexMeshlet[sourceIndices[(triangle * 3) + corner]] != meshlet)
+            {
+                ++count;
+            }
+        }
+
+        return count;
+    };
+
+    auto triangleCentroid = [&](const uint32_t triangle)
+    {
+        return (positions[sourceIndices[triangle * 3]]
+                   + positions[sourceIndices[(triangle * 3) + 1]]
+                   + positions[sourceIndices[(triangle * 3) + 2]])
+            / 3.0f;
+    };
+
+    auto closeMeshlet = [&]()
+    {
+        const size_t first = meshletFirstTriangle * 3;
+        const size_t count = (outTriangleCount - meshletFirstTriangle) * 3;
+
+        outMeshlets.push_back(MakeMeshlet(positions,
+            indices.subspan(first, count),
+            firstIndex + narrow_cast<uint32_t>(first)));
+
+        ++meshlet;
+        meshletVertexCount = 0;
+        meshletCentroidSum = Vec3f(0, 0, 0);
+        meshletFirstTriangle = outTriangleCount;
+        candidates.clear();
+    };
+
+    while(outTriangleCount < triangleCount)
+    {
+        // Prefer adjacent triangles that add no vertices, then the one nearest the meshlet's
+        // center, which keeps meshlets compact and their bounds tight.
+        uint32_t best = std::numeric_limits<uint32_t>::max();
+        size_t bestNewVertices = 4;
+        float bestDistance = std::numeric_limits<float>::max();
+
+        std::erase_if(candidates, [&triangleUsed](const uint32_t t) { return triangleUsed[t]; });
+
+        size_t meshletTriangleCount = outTriangleCount - meshletFirstTriangle;
+        const Vec3f meshletCenter = meshletTriangleCount > 0
+            ? meshletCentroidSum / static_cast<float>(meshletTriangleCount)
+            : Vec3f(0, 0, 0);
+
+        for(const uint32_t candidate : candidates)
+        {
+            const size_t count = newVertexCount(candidate);
+
+            if(count > 0 && bestNewVertices == 0)
+            {
+                continue;
+            }
+
+            const float distance = (triangleCentroid(candidate) - meshletCenter).Length2();
+
+            if((count == 0 && bestNewVertices > 0) || distance < bestDistance)
+            {
+                best = candidate;
+                bestNewVertices = count;
+                bestDistance = distance;
+            }
+        }
+
+        if(best == std::numeric_limits<uint32_t>::max())
+        {
+            // Nothing adjacent is left. Growing the meshlet elsewhere would spread its bounds,
+            // so start a new one from the next unused triangle in mesh order.
+            if(meshletTriangleCount > 0)
+            {
+                closeMeshlet();
+                meshletTriangleCount = 0;
+            }
+
+            while(triangleUsed[nextSeed])
+            {
+                ++nextSeed;
+            }
+
+            best = narrow_cast<uint32_t>(nextSeed);
+            bestNewVertices = newVertexCount(best);
+        }
+
+        if(meshletTriangleCount == kMaxTriangles
+            || meshletVertexCount + bestNewVertices > kMaxVertices)
+        {
+            closeMeshlet();
+            bestNewVertices = newVertexCount(best);
+        }
+
+        triangleUsed[best] = true;
+        meshletVertexCount += bestNewVertices;
+        meshletCentroidSum += triangleCentroid(best);
+
+        for(size_t corner = 0; corner < 3; ++corner)
+        {
+            const VertexIndex vertex = sourceIndices[(best * 3) + corner];
+
+            indices[(outTriangleCount * 3) + corner] = vertex;
+            vertexMeshlet[vertex] = meshlet;
+
+            for(const uint32_t neighbor : vertexTriangles.Get(vertex))
+            {
+                if(!triangleUsed[neighbor])
+                {
+                    candidates.push_back(neighbor);
+                }
+            }
+        }
+
+        ++outTriangleCount;
+    }
+
+    closeMeshlet();
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include "BoundingVolumes.h"
+#include "VecMath.h"
+#include "Vertex.h"
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+/// @brief A small cluster of a mesh's triangles that is culled on its own.
+///
+/// Meshlets of large meshes let partially visible meshes skip drawing the clusters that are off
+/// screen or facing away from the camera.
+struct Meshlet
+{
+    // Range of the index buffer holding the meshlet's triangles.
+    uint32_t FirstIndex;
+    uint32_t IndexCount;
+
+    // Bounds of the meshlet's vertices, in mesh space.
+    BoundingSphere Bounds;
+
+    // Normal cone of the meshlet's triangles, in mesh space. Every triangle normal is within
+    // the cone around ConeAxis. ConeCutoff is the sine of the cone's half angle, or 1 if the
+    // cone is too wide to ever cull the meshlet.
+    Vec3f ConeAxis;
+    float ConeCutoff;
+
+    /// @brief Returns true if every triangle of the meshlet faces away from viewPosition.
+    /// @param viewPosition The viewer's position in mesh space.
+    bool IsBackFacing(const Vec3f& viewPosition) const
+    {
+        const Vec3f toCenter = Bounds.GetCenter() - viewPosition;
+
+        return toCenter.Dot(ConeAxis) >= (ConeCutoff * toCenter.Length()) + Bounds.GetRadius();
+    }
+};
+
+/// @brief Calls emit(firstIndex, indexCount) for each run of adjacent meshlets that
+/// isVisible(meshlet) accepts. Meshlets are contiguous in the index buffer, so each run can be
+/// drawn with one indexed draw. A single mesh can be split into many runs.
+/// @return The number of meshlets culled.
+template<typename IsVisibleFunc, typename EmitFunc>
+size_t
+CullMeshlets(const std::span<const Meshlet> meshlets, IsVisibleFunc&& isVisible, EmitFunc&& emit)
+{
+    size_t culledCount = 0;
+    uint32_t runFirstIndex = 0;
+    uint32_t runIndexCount = 0;
+
+    for(const Meshlet& meshlet : meshlets)
+    {
+        if(!isVisible(meshlet))
+        {
+            ++culledCount;
+            continue;
+        }
+
+        if(runIndexCount > 0 && runFirstIndex + runIndexCount == meshlet.FirstIndex)
+        {
+            runIndexCount += meshlet.IndexCount;
+            continue;
+        }
+
+        if(runIndexCount > 0)
+        {
+            emit(runFirstIndex, runIndexCount);
+        }
+
+        runFirstIndex = meshlet.FirstIndex;
+        runIndexCount = meshlet.IndexCount;
+    }
+
+    if(runIndexCount > 0)
+    {
+        emit(runFirstIndex, runIndexCount);
+    }
+
+    return culledCount;
+}
+
+/// @brief Splits indexed triangle meshes into meshlets.
+///
+/// Meshlets are grown greedily from a seed triangle, adding the neighboring triangle that
+/// introduces the fewest new vertices until a vertex or triangle limit is reached. Triangles
+/// are reordered so that each meshlet is a contiguous range of indices and can be drawn with
+/// an ordinary indexed draw.
+class MeshletBuilder final
+{
+public:
+    static constexpr size_t kMaxVertices = 64;
+    static constexpr size_t kMaxTriangles = 124;
+
+    MeshletBuilder() = delete;
+    ~MeshletBuilder() = delete;
+    MeshletBuilder(const MeshletBuilder&) = delete;
+    MeshletBuilder& operator=(const MeshletBuilder&) = delete;
+    MeshletBuilder(MeshletBuilder&&) = delete;
+    MeshletBuilder& operator=(MeshletBuilder&&) = delete;
+
+    /// @brief Splits a triangle list into meshlets.
+    /// @param positions The mesh's vertex positions.
+    /// @param indices The mesh's triangle list indices. Indices are relative to positions.
+    /// Triangles are reordered in place so each meshlet's triangles are contiguous.
+    /// @param firstIndex Position of indices in the index buffer. Meshlet index ranges are
+    /// offset by it.
+    /// @param outMeshlets Receives the meshlets, appended in index order.
+    static void Build(const std::span<const Vec3f> positions,
+        const std::span<VertexIndex> indices,
+        const uint32_t firstIndex,
+        std::vector<Meshlet>& outMeshlets);
+};
@@ -0,0 +1,421 @@
+#include "OcclusionCuller.h"
+
+#include "narrow_cast.h"
+#include "PerfMetrics.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+namespace
+{
+// Depth of an empty pixel - the far plane.
+constexpr float kClearDepth = 1.0f;
+
+// Don't split the depth buffer into bands smaller than this.
+constexpr uint32_t kMinRowsPerBand = 8;
+
+// Triangles with a screen space area smaller than this cover no pixel centers worth testing.
+constexpr float kMinTriangleArea = 1e-6f;
+
+struct ScreenVertex
+{
+    float X;
+    float Y;
+    float Z;
+};
+
+// Returns true if the clip space position is in front of the near plane.
+bool
+InFrontOfNearPlane(const Vec4f& clipPos)
+{
+    return clipPos.z >= 0.0f && clipPos.w > 0.0f;
+}
+
+ScreenVertex
+ToScreen(const Vec4f& clipPos, const float width, const float height)
+{
+    const float invW = 1.0f / clipPos.w;
+
+    return ScreenVertex //
+        {
+            .X = ((clipPos.x * invW * 0.5f) + 0.5f) * width,
+            .Y = ((clipPos.y * invW * 0.5f) + 0.5f) * height,
+            .Z = clipPos.z * invW,
+        };
+}
+
+uint32_t
+ClampToPixel(const float value, const uint32_t size)
+{
+    const float maxValue = static_cast<float>(size - 1);
+    return static_cast<uint32_t>(std::clamp(value, 0.0f, maxValue));
+}
+} // namespace
+
+OcclusionCuller::OcclusionCuller(const uint32_t width, const uint32_t height)
+{
+    MLG_ABORTIF(width == 0 || height == 0, "Occlusion buffer dimensions must be non-zero");
+
+    uint32_t levelWidth = width;
+    uint32_t levelHeight = height;
+
+    while(true)
+    {
+        m_Levels.push_back(DepthLevel //
+            {
+                .Width = levelWidth,
+                .Height = levelHeight,
+                .Depth = std::vector<float>(size_t{ levelWidth } * levelHeight, kClearDepth),
+            });
+
+        if(levelWidth == 1 && levelHeight == 1)
+        {
+            break;
+        }
+
+        levelWidth = std::max(1u, (levelWidth + 1) / 2);
+        levelHeight = std::max(1u, (levelHeight + 1) / 2);
+    }
+}
+
+void
+OcclusionCuller::Begin(const Mat44f& viewProj)
+{
+    m_ViewProj = viewProj;
+    m_Triangles.clear();
+}
+
+void
+OcclusionCuller::AddOccluder(const Mat44f& worldTransform,
+    const std::span<const Vec3f> positions,
+    const std::span<const VertexIndex> indices)
+{
+    MLG_ASSERT(indices.size() % 3 == 0, "Occluder indices must be a triangle list");
+
+    const Mat44f worldViewProj = m_ViewProj.Mul(worldTransform);
+
+    const float width = static_cast<float>(GetWidth());
+    const float height = static_cast<float>(GetHeight());
+
+    for(size_t i = 0; i + 2 < indices.size(); i += 3)
+    {
+        const Vec4f clip[3] //
+            {
+                worldViewProj * positions[indices[i]],
+                worldViewProj * positions[indices[i + 1]],
+                worldViewProj * positions[indices[i + 2]],
+            };
+
+        // Parts of triangles crossing the near plane are clipped away when rendering, so they
+        // can't be relied upon to hide anything. Skipping them only makes culling less
+        // aggressive.
+        if(!InFrontOfNearPlane(clip[0]) || !InFrontOfNearPlane(clip[1])
+            || !InFrontOfNearPlane(clip[2]))
+        {
+            continue;
+        }
+
+        ScreenVertex v[3] //
+            {
+                ToScreen(clip[0], width, height),
+                ToScreen(clip[1], width, height),
+                ToScreen(clip[2], width, height),
+            };
+
+        const float minX = std::min({ v[0].X, v[1].X, v[2].X });
+        const float maxX = std::max({ v[0].X, v[1].X, v[2].X });
+        const float minY = std::min({ v[0].Y, v[1].Y, v[2].Y });
+        const float maxY = std::max({ v[0].Y, v[1].Y, v[2].Y });
+
+        if(maxX < 0.0f || maxY < 0.0f || minX >= width || minY >= height)
+        {
+            continue;
+        }
+
+        // Twice the signed area. Make the winding consistent so that edge functions are
+        // positive inside the triangle regardless of the original winding.
+        float area =
+            ((v[1].X - v[0].X) * (v[2].Y - v[0].Y)) - ((v[1].Y - v[0].Y) * (v[2].X - v[0].X));
+
+        if(std::abs(area) < kMinTriangleArea)
+        {
+            continue;
+        }
+
+        if(area < 0.0f)
+        {
+            std::swap(v[1], v[2]);
+            area = -area;
+        }
+
+        ScreenTriangle tri{};
+
+        for(size_t e = 0; e < 3; ++e)
+        {
+            // Edge e is opposite vertex e.
+            const ScreenVertex& a = v[(e + 1) % 3];
+            const ScreenVertex& b = v[(e + 2) % 3];
+
+            tri.EdgeA[e] = a.Y - b.Y;
+            tri.EdgeB[e] = b.X - a.X;
+            tri.EdgeC[e] = (a.X * b.Y) - (a.Y * b.X);
+        }
+
+        // Depth is linear in screen space after the perspective divide.
+        const float dx1 = v[1].X - v[0].X;
+        const float dy1 = v[1].Y - v[0].Y;
+        const float dz1 = v[1].Z - v[0].Z;
+        const float dx2 = v[2].X - v[0].X;
+        const float dy2 = v[2].Y - v[0].Y;
+        const float dz2 = v[2].Z - v[0].Z;
+
+        tri.DepthA = ((dz1 * dy2) - (dy1 * dz2)) / area;
+        tri.DepthB = ((dx1 * dz2) - (dz1 * dx2)) / area;
+        tri.DepthC = v[0].Z - (tri.DepthA * v[0].X) - (tri.DepthB * v[0].Y);
+
+        tri.MinX = ClampToPixel(std::floor(minX), GetWidth());
+        tri.MaxX = ClampToPixel(std::floor(maxX), GetWidth());
+        tri.MinY = ClampToPixel(std::floor(minY), GetHeight());
+        tri.MaxY = ClampToPixel(std::floor(maxY), GetHeight());
+
+        m_Triangles.push_back(tri);
+    }
+}
+
+void
+OcclusionCuller::Rasterize(ThreadPool* threadPool)
+{
+    MLG_SCOPED_TIMER("OcclusionCuller.Rasterize");
+
+    static PerfCounter pcTriangles({ .Name = "OcclusionCuller.Triangles" });
+    pcTriangles.Increment(m_Triangles.size());
+
+    DepthLevel& level0 = m_Levels.front();
+    std::ranges::fill(level0.Depth, kClearDepth);
+
+    const uint32_t height = level0.Height;
+
+    // The calling thread rasterizes a band too rather than waiting idle for the workers.
+    const size_t maxBands = std::max<size_t>(1, height / kMinRowsPerBand);
+    const size_t bandCount = (threadPool && !m_Triangles.empty())
+        ? std::min(threadPool->GetWorkerCount() + 1, maxBands)
+        : 1;
+
+    if(bandCount <= 1)
+    {
+        RasterizeRows(0, height);
+    }
+    else
+    {
+        // Each band writes a disjoint set of rows so bands can be rasterized concurrently.
+        const uint32_t rowsPerBand = narrow_cast<uint32_t>((height + bandCount - 1) / bandCount);
+
+        std::vector<std::atomic<bool>> completionFlags(bandCount);
+        std::vector<RasterizeBandParams> bands;
+        bands.reserve(bandCount);
+
+        for(uint32_t rowBegin = 0; rowBegin < height; rowBegin += rowsPerBand)
+        {
+            const RasterizeBandParams bandParams //
+                {
+                    .Culler = this,
+                    .RowBegin = rowBegin,
+                    .RowEnd = std::min(height, rowBegin + rowsPerBand),
+                    .CompletionFlag = &completionFlags[bands.size()],
+                };
+
+            RasterizeBandParams& params = bands.emplace_back(bandParams);
+
+            const bool isLastBand = params.RowEnd == height;
+
+            if(isLastBand || !threadPool->Enqueue<RasterizeBand>(&params))
+            {
+                // Last band, or job queue is full - do the work here.
+                RasterizeBand(&params);
+            }
+        }
+
+        // Jobs don't touch the flags or params after setting their flag, so both can be freed
+        // once every flag is set.
+        for(const RasterizeBandParams& band : bands)
+        {
+            while(!band.CompletionFlag->load(std::memory_order_acquire))
+            {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    BuildHiZ();
+}
+
+bool
+OcclusionCuller::IsVisible(const BoundingSphere& worldSphere) const
+{
+    if(m_Triangles.empty())
+    {
+        return true;
+    }
+
+    const Vec3f& center = worldSphere.GetCenter();
+    const float r = worldSphere.GetRadius();
+
+    const float width = static_cast<float>(GetWidth());
+    const float height = static_cast<float>(GetHeight());
+
+    float minX = width, maxX = 0, minY = height, maxY = 0, minZ = kClearDepth;
+
+    // Project the corners of the sphere's bounding box to get a conservative screen rectangle
+    // and nearest depth.
+    for(uint32_t corner = 0; corner < 8; ++corner)
+    {
+        const Vec3f p(center.x + ((corner & 1u) != 0 ? r : -r),
+            center.y + ((corner & 2u) != 0 ? r : -r),
+            center.z + ((corner & 4u) != 0 ? r : -r));
+
+        const Vec4f clipPos = m_ViewProj * p;
+
+        if(!InFrontOfNearPlane(clipPos))
+        {
+            // The sphere straddles the near plane - assume it's visible.
+            return true;
+        }
+
+        const ScreenVertex v = ToScreen(clipPos, width, height);
+
+        minX = std::min(minX, v.X);
+        maxX = std::max(maxX, v.X);
+        minY = std::min(minY, v.Y);
+        maxY = std::max(maxY, v.Y);
+        minZ = std::min(minZ, v.Z);
+    }
+
+    if(maxX < 0.0f || maxY < 0.0f || minX >= width || minY >= height)
+    {
+        // Off screen. Frustum culling is responsible for rejecting these.
+        return true;
+    }
+
+    const uint32_t x0 = ClampToPixel(std::floor(minX), GetWidth());
+    const uint32_t x1 = ClampToPixel(std::floor(maxX), GetWidth());
+    const uint32_t y0 = ClampToPixel(std::floor(minY), GetHeight());
+    const uint32_t y1 = ClampToPixel(std::floor(maxY), GetHeight());
+
+    // Choose the finest level at which the rectangle covers at most 2x2 texels.
+    size_t level = 0;
+    while(level + 1 < m_Levels.size()
+          && (((x1 >> level) - (x0 >> level)) > 1 || ((y1 >> level) - (y0 >> level)) > 1))
+    {
+        ++level;
+    }
+
+    float maxDepth = 0;
+
+    for(uint32_t y = y0 >> level; y <= (y1 >> level); ++y)
+    {
+        for(uint32_t x = x0 >> level; x <= (x1 >> level); ++x)
+        {
+            maxDepth = std::max(maxDepth, GetDepth(level, x, y));
+        }
+    }
+
+    return minZ <= maxDepth;
+}
+
+float
+OcclusionCuller::GetDepth(const size_t level, const uint32_t x, const uint32_t y) const
+{
+    MLG_ASSERT(level < m_Levels.size(), "Invalid Hi-Z level");
+
+    const DepthLevel& depthLevel = m_Levels[level];
+
+    MLG_ASSERT(x < depthLevel.Width && y < depthLevel.Height, "Texel out of bounds");
+
+    return depthLevel.Depth[(size_t{ y } * depthLevel.Width) + x];
+}
+
+// private:
+
+void
+OcclusionCuller::RasterizeBand(RasterizeBandParams* params)
+{
+    params->Culler->RasterizeRows(params->RowBegin, params->RowEnd);
+
+    params->CompletionFlag->store(true, std::memory_order_release);
+}
+
+void
+OcclusionCuller::RasterizeRows(const uint32_t rowBegin, const uint32_t rowEnd)
+{
+    DepthLevel& level0 = m_Levels.front();
+    const std::span<float> depth(level0.Depth);
+
+    for(const ScreenTriangle& tri : m_Triangles)
+    {
+        const uint32_t minY = std::max(tri.MinY, rowBegin);
+        const uint32_t maxY = std::min(tri.MaxY + 1, rowEnd);
+
+        for(uint32_t y = minY; y < maxY; ++y)
+        {
+            // Sample at pixel centers.
+            const float py = static_cast<float>(y) + 0.5f;
+            const float px0 = static_cast<float>(tri.MinX) + 0.5f;
+
+            float e0 = (tri.EdgeA[0] * px0) + (tri.EdgeB[0] * py) + tri.EdgeC[0];
+            float e1 = (tri.EdgeA[1] * px0) + (tri.EdgeB[1] * py) + tri.EdgeC[1];
+            float e2 = (tri.EdgeA[2] * px0) + (tri.EdgeB[2] * py) + tri.EdgeC[2];
+            float z = (tri.DepthA * px0) + (tri.DepthB * py) + tri.DepthC;
+
+            const std::span<float> row =
+                depth.subspan((size_t{ y } * level0.Width) + tri.MinX, tri.MaxX - tri.MinX + 1);
+
+            // Branch free so the compiler can vectorize it.
+            //VECTORIZE
+            for(float& pixelDepth : row)
+            {
+                const bool inside = (e0 >= 0.0f) & (e1 >= 0.0f) & (e2 >= 0.0f);
+                pixelDepth = inside ? std::min(pixelDepth, z) : pixelDepth;
+
+                e0 += tri.EdgeA[0];
+                e1 += tri.EdgeA[1];
+                e2 += tri.EdgeA[2];
+                z += tri.DepthA;
+            }
+        }
+    }
+}
+
+void
+OcclusionCuller::BuildHiZ()
+{
+    MLG_SCOPED_TIMER("OcclusionCuller.BuildHiZ");
+
+    for(size_t i = 1; i < m_Levels.size(); ++i)
+    {
+        const DepthLevel& src = m_Levels[i - 1];
+        DepthLevel& dst = m_Levels[i];
+
+        for(uint32_t y = 0; y < dst.Height; ++y)
+        {
+            const uint32_t sy0 = y * 2;
+            const uint32_t sy1 = std::min(sy0 + 1, src.Height - 1);
+
+            for(uint32_t x = 0; x < dst.Width; ++x)
+            {
+                const uint32_t sx0 = x * 2;
+                const uint32_t sx1 = std::min(sx0 + 1, src.Width - 1);
+
+                const size_t row0 = size_t{ sy0 } * src.Width;
+                const size_t row1 = size_t{ sy1 } * src.Width;
+
+                // Keep the farthest depth so tests against coarse levels stay conservative.
+                dst.Depth[(size_t{ y } * dst.Width) + x] = std::max({ src.Depth[row0 + sx0],
+                    src.Depth[row0 + sx1],
+                    src.Depth[row1 + sx0],
+                    src.Depth[row1 + sx1] });
+            }
+        }
+    }
+}
@@ -0,0 +1,118 @@
+#pragma once
+
+#include "BoundingVolumes.h"
+#include "VecMath.h"
+#include "Vertex.h"
+
+#include <atomic>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+class ThreadPool;
+
+/// @brief CPU occlusion culler.
+///
+/// A small set of occluder meshes is rasterized into a low resolution depth buffer, from which a
+/// hierarchical depth (Hi-Z) pyramid is built. Bounding spheres are then tested against the
+/// pyramid to reject objects that are completely hidden behind the occluders.
+///
+/// Each frame:
+///   1. Begin() with the camera's view-projection matrix.
+///   2. AddOccluder() for each occluder mesh.
+///   3. Rasterize() to rasterize occluders and build the Hi-Z pyramid.
+///   4. IsVisible() for each object to be tested.
+///
+/// Depth follows the left-handed [0, 1] convention used by Mat44f::PerspectiveLH, with 0 at
+/// the near plane.
+class OcclusionCuller
+{
+public:
+    static constexpr uint32_t kDefaultWidth = 256;
+    static constexpr uint32_t kDefaultHeight = 128;
+
+    OcclusionCuller() = delete;
+    OcclusionCuller(const uint32_t width, const uint32_t height);
+    ~OcclusionCuller() = default;
+    OcclusionCuller(const OcclusionCuller&) = delete;
+    OcclusionCuller& operator=(const OcclusionCuller&) = delete;
+    OcclusionCuller(OcclusionCuller&&) = default;
+    OcclusionCuller& operator=(OcclusionCuller&&) = default;
+
+    /// @brief Starts a new frame. Clears all occluders.
+    void Begin(const Mat44f& viewProj);
+
+    /// @brief Adds an occluder mesh.
+    /// @param worldTransform Transforms the mesh's positions to world space.
+    /// @param positions The mesh's vertex positions.
+    /// @param indices The mesh's triangle list indices. Indices are relative to positions.
+    void AddOccluder(const Mat44f& worldTransform,
+        const std::span<const Vec3f> positions,
+        const std::span<const VertexIndex> indices);
+
+    /// @brief Rasterizes occluders into the depth buffer and builds the Hi-Z pyramid.
+    /// If threadPool is not null the depth buffer is split into horizontal bands that are
+    /// rasterized in parallel on its workers.
+    void Rasterize(ThreadPool* threadPool);
+
+    /// @brief Returns false if the world space sphere is completely hidden by occluders.
+    bool IsVisible(const BoundingSphere& worldSphere) const;
+
+    uint32_t GetWidth() const { return m_Levels.front().Width; }
+    uint32_t GetHeight() const { return m_Levels.front().Height; }
+    size_t GetLevelCount() const { return m_Levels.size(); }
+    size_t GetTriangleCount() const { return m_Triangles.size(); }
+
+    /// @brief Returns the depth stored at the given texel of the given Hi-Z level.
+    /// Each texel holds the farthest depth of the level 0 pixels it covers.
+    float GetDepth(const size_t level, const uint32_t x, const uint32_t y) const;
+
+private:
+    // A triangle set up for rasterization with screen space edge functions and depth plane.
+    struct ScreenTriangle
+    {
+        // Edge function i is EdgeA[i] * x + EdgeB[i] * y + EdgeC[i], >= 0 inside the triangle.
+        float EdgeA[3];
+        float EdgeB[3];
+        float EdgeC[3];
+
+        // Depth plane: z = DepthA * x + DepthB * y + DepthC.
+        float DepthA;
+        float DepthB;
+        float DepthC;
+
+        // Pixel bounds, inclusive.
+        uint32_t MinX;
+        uint32_t MaxX;
+        uint32_t MinY;
+        uint32_t MaxY;
+    };
+
+    struct DepthLevel
+    {
+        uint32_t Width;
+        uint32_t Height;
+        std::vector<float> Depth;
+    };
+
+    struct RasterizeBandParams
+    {
+        OcclusionCuller* Culler{ nullptr };
+        uint32_t RowBegin{ 0 };
+        uint32_t RowEnd{ 0 };
+        // Set by the band's job as the last thing it touches, so the caller can free the
+        // band's params as soon as it sees the flag set.
+        std::atomic<bool>* CompletionFlag{ nullptr };
+    };
+
+    static void RasterizeBand(RasterizeBandParams* params);
+
+    // Rasterizes all triangles into rows [rowBegin, rowEnd) of the level 0 depth buffer.
+    void RasterizeRows(const uint32_t rowBegin, const uint32_t rowEnd);
+
+    void BuildHiZ();
+
+    Mat44f m_ViewProj{ Mat44f::Identity };
+    std::vector<ScreenTriangle> m_Triangles;
+    std::vector<DepthLevel> m_Levels;
+};
@@ -9,20 +9,177 @@
 #include "GpuHelper.h"
 #include "LevelDefs.h"
 #include "Log.h"
+#include "MeshOptimizer.h"
+#include "MeshSimplifier.h"
 #include "narrow_cast.h"
 #include "scope_exit.h"
 #include "TextureCache.h"
 #include "ThreadPool.h"
 #include "Timer.h"
+#include "VertexQuantization.h"
 
+#include <algorithm>
 #include <atomic>
+#include <bit>
 #include <filesystem>
+#include <format>
+#include <iterator>
 #include <map>
+#include <optional>
 #include <ranges>
 #include <stb_image.h>
+#include <unordered_map>
 
 namespace
 {
+// Each LOD targets this fraction of the previous LOD's triangles.
+constexpr float kLodReductionRatio = 0.5f;
+
+// A LOD is only kept if it removes at least this fraction of the previous LOD's triangles.
+constexpr float kMinLodReduction = 0.2f;
+
+// Largest simplification error allowed, relative to the mesh's bounding radius.
+constexpr float kMaxLodRelativeError = 0.1f;
+
+// Meshes with fewer indices aren't worth simplifying.
+constexpr size_t kMinLodIndexCount = 3 * 64;
+
+// Meshes with fewer indices are culled as a whole rather than split into meshlets.
+constexpr size_t kMinMeshletIndexCount = 3 * MeshletBuilder::kMaxTriangles * 4;
+
+// Most layers packed into one texture array. WebGPU's default maxTextureArrayLayers limit.
+constexpr size_t kMaxTextureArrayLayers = 256;
+
+// Index format of a mesh's indices. Indices are relative to the mesh's base vertex, so meshes
+// with few enough vertices fit 16-bit indices however large the property kit is.
+IndexFormat
+SelectIndexFormat(const MeshDef& meshDef)
+{
+    return meshDef.Vertices.size() <= kMaxVertexIndex16Count
+        ? IndexFormat::Uint16
+        : IndexFormat::Uint32;
+}
+
+// Reorders a mesh's triangles and vertices for rendering, and accumulates vertex cache
+// statistics from before and after.
+void
+OptimizeMesh(MeshDef& optimized, VertexCacheStats& outBefore, VertexCacheStats& outAfter)
+{
+    outBefore += MeshOptimizer::AnalyzeVertexCache(optimized.Indices, optimized.Vertices.size());
+
+    // Blended triangles must draw in their authored order.
+    if(optimized.MaterialDef.AlphaMode != AlphaMode::Blend)
+    {
+        MeshOptimizer::OptimizeVertexCache(optimized.Indices, optimized.Vertices.size());
+
+        std::vector<Vec3f> positions;
+        positions.reserve(optimized.Vertices.size());
+        std::ranges::transform(optimized.Vertices,
+            std::back_inserter(positions),
+            [](const Vertex& vertex) { return vertex.pos; });
+
+        MeshOptimizer::OptimizeOverdraw(positions, optimized.Indices);
+    }
+
+    MeshOptimizer::OptimizeVertexFetch(optimized.Vertices, optimized.Indices);
+
+    outAfter += MeshOptimizer::AnalyzeVertexCache(optimized.Indices, optimized.Vertices.size());
+}
+
+// Meshes whose geometry has been added to a property kit, for finding duplicates.
+class MeshGeometryCache
+{
+public:
+    // Returns the index of a mesh built from the same geometry, if any.
+    std::optional<size_t> Find(const MeshDef& meshDef, const uint64_t hash) const
+    {
+        const auto [first, last] = m_Meshes.equal_range(hash);
+
+        for(auto it = first; it != last; ++it)
+        {
+            if(IsSameGeometry(meshDef, *it->second.Source))
+            {
+                return it->second.MeshIndex;
+            }
+        }
+
+        return std::nullopt;
+    }
+
+    void Add(const MeshDef& meshDef, const uint64_t hash, const size_t meshIndex)
+    {
+        m_Meshes.emplace(hash, Entry{ .Source = &meshDef, .MeshIndex = meshIndex });
+    }
+
+private:
+    using VertexBytes = std::array<std::byte, sizeof(Vertex)>;
+
+    struct Entry
+    {
+        const MeshDef* Source;
+        size_t MeshIndex;
+    };
+
+    static bool IsSameGeometry(const MeshDef& a, const MeshDef& b)
+    {
+        // Blended meshes aren't reordered, so they can't share with meshes that are.
+        const bool aBlends = a.MaterialDef.AlphaMode == AlphaMode::Blend;
+        const bool bBlends = b.MaterialDef.AlphaMode == AlphaMode::Blend;
+
+        return aBlends == bBlends && a.Indices == b.Indices
+            && std::ranges::equal(a.Vertices,
+                b.Vertices,
+                [](const Vertex& x, const Vertex& y)
+                { return std::bit_cast<VertexBytes>(x) == std::bit_cast<VertexBytes>(y); });
+    }
+
+    std::unordered_multimap<uint64_t, Entry> m_Meshes;
+};
+
+// Appends progressively simplified LODs of a mesh to indices.
+// Each LOD is simplified from the full detail mesh so errors don't accumulate.
+void
+BuildMeshLods(const std::span<const Vec3f> positions,
+    const std::span<const VertexIndex> meshIndices,
+    const BoundingBox& boundingBox,
+    std::vector<VertexIndex>& indices,
+    std::vector<Mesh::Lod>& outLods)
+{
+    outLods.clear();
+
+    const float maxError = BoundingSphere(boundingBox).GetRadius() * kMaxLodRelativeError;
+    size_t prevIndexCount = meshIndices.size();
+
+    while(outLods.size() + 1 < Mesh::kMaxLodCount && prevIndexCount >= kMinLodIndexCount)
+    {
+        const auto targetIndexCount =
+            static_cast<size_t>(static_cast<float>(prevIndexCount) * kLodReductionRatio);
+
+        float error = 0;
+        const std::vector<VertexIndex> lodIndices =
+            MeshSimplifier::Simplify(positions, meshIndices, targetIndexCount, maxError, error);
+
+        const auto maxIndexCount =
+            static_cast<size_t>(static_cast<float>(prevIndexCount) * (1 - kMinLodReduction));
+
+        if(lodIndices.empty() || lodIndices.size() > maxIndexCount)
+        {
+            break;
+        }
+
+        const Mesh::Lod lod //
+            {
+                .IndexCount = narrow_cast<uint32_t>(lodIndices.size()),
+                .FirstIndex = narrow_cast<uint32_t>(indices.size()),
+                .Error = error,
+            };
+
+        outLods.push_back(lod);
+        indices.insert(indices.end(), lodIndices.begin(), lodIndices.end());
+        prevIndexCount = lodIndices.size();
+    }
+}
+
 ////////// TextureLoadTask
 
 class TextureLoadTask
@@ -79,6 +236,7 @@ public:
     {
         TextureLoadTask* task = static_cast<TextureLoadTask*>(userData);
         task->m_DecodeResult = task->Decode();
+        task->m_GpuHelper->GetUploadRing().EndWorkerWrite();
         task->m_CompletionFlag->store(true, std::memory_order_release);
     }
 
@@ -91,8 +249,7 @@ private:
     wgpu::CommandEncoder m_Encoder{ nullptr };
     FileFetcher::Request m_Request;
     wgpu::Texture m_Texture;
-    wgpu::Buffer m_StagingBuffer;
-    std::byte* m_MappedMemory{ nullptr };
+    GpuUploadRing::Allocation m_Staging;
     Result<> m_DecodeResult;
 
     std::atomic<bool>* m_CompletionFlag{ nullptr };
@@ -147,13 +304,9 @@ TextureLoadTask::Update()
                     MLG_ERROR("Failed to decode texture");
                     m_State = State::Failed;
                 }
-                else if(!GpuHelper::CommitStagingBuffer(m_Texture, m_StagingBuffer, m_Encoder))
-                {
-                    MLG_ERROR("Failed to commit texture");
-                    m_State = State::Failed;
-                }
                 else
                 {
+                    GpuUploadRing::CopyToTexture(m_Encoder, m_Staging, m_Texture);
                     MLG_DEBUG("Loaded");
                     m_TextureCache->AddOrReplace(m_Uri, m_Texture);
                     m_State = State::Succeeded;
@@ -200,21 +353,28 @@ TextureLoadTask::Stage()
 
     MLG_CHECK(texture);
 
-    auto stagingBuffer = m_GpuHelper->CreateStagingBuffer(*texture, m_Uri);
-    MLG_CHECK(stagingBuffer);
-
-    void* mapped = stagingBuffer->GetMappedRange();
-    MLG_CHECK(mapped);
-
-    // It appears that mapping/unmapping must be done on the same thread
+    // Staging memory comes from the upload ring and is unmapped when the texture copies are
+    // submitted. It appears that mapping/unmapping must be done on the same thread
     // as other wgpu::Device operations.  Learned that the hard way by trying to map
     // in the worker thread below.
+    GpuUploadRing& uploadRing = m_GpuHelper->GetUploadRing();
+
+    auto staging = uploadRing.AllocateTexture(*texture);
+    MLG_CHECK(staging);
+
     m_Texture = *texture;
-    m_StagingBuffer = *stagingBuffer;
-    m_MappedMemory = static_cast<std::byte*>(mapped);
+    m_Staging = *staging;
 
-    MLG_CHECK(m_ThreadPool->Enqueue(TextureLoadTask::Decode, this),
-        "Failed to enqueue texture decode task");
+    // The ring refuses to submit, and so unmap the staging memory, until the decode is done.
+    uploadRing.BeginWorkerWrite();
+
+    if(!m_ThreadPool->Enqueue(TextureLoadTask::Decode, this))
+    {
+        uploadRing.EndWorkerWrite();
+
+        MLG_ERROR("Failed to enqueue texture decode task");
+        return Result<>::Fail;
+    }
 
     return Result<>::Ok;
 }
@@ -258,8 +418,7 @@ TextureLoadTask::Decode() const
         "Decoded image size does not match texture size");
 
     const std::span<const stbi_uc> srcSpan(data, sizeofSrcData);
-    const std::span<std::byte> dstSpan(m_MappedMemory,
-        narrow_cast<size_t>(m_StagingBuffer.GetSize()));
+    const std::span<std::byte> dstSpan = m_Staging.Data;
     size_t dstOffset = 0, srcOffset = 0;
     const size_t srcRowStride = static_cast<size_t>(imgWidth) * GpuHelper::kNumTextureChannels;
     const size_t dstRowStride =
@@ -406,7 +565,7 @@ FetchTexturesTask::Update()
             if(m_Tasks.empty())
             {
                 const wgpu::CommandBuffer commandBuffer = m_Encoder.Finish();
-                m_GpuHelper->GetDevice().GetQueue().Submit(1, &commandBuffer);
+                MLG_CHECK(m_GpuHelper->GetUploadRing().Submit(commandBuffer));
 
                 m_State = State::Succeeded;
             }
@@ -449,28 +608,144 @@ FetchTextures(GpuHelper& gpuHelper,
     return Result<>::Ok;
 }
 
+// Packs the base textures of materials into 2D texture arrays, one layer per unique texture.
+// Textures of the same size share arrays so meshes with different materials can be drawn with
+// the same bind group. outMaterialTextures receives the array and layer of each material's
+// base texture and outBindGroups a bind group per array. Materials without a base texture are
+// drawn untextured and take no layer.
 Result<>
-CreateMaterialBindGroups(GpuHelper& gpuHelper,
+BuildTextureArrays(GpuHelper& gpuHelper,
     const std::span<const MaterialDef> materialDefs,
     const TextureCache& textureCache,
-    std::vector<wgpu::BindGroup>& materialBindGroups)
+    std::vector<MaterialTexture>& outMaterialTextures,
+    std::vector<wgpu::BindGroup>& outBindGroups)
 {
-    materialBindGroups.clear();
+    struct TextureArray
+    {
+        uint32_t Width;
+        uint32_t Height;
+        std::vector<wgpu::Texture> Layers;
+    };
+
+    std::vector<TextureArray> textureArrays;
+
+    // Materials often share textures, e.g. the default texture.
+    std::map<WGPUTexture, MaterialTexture> textureLayers;
 
-    materialBindGroups.reserve(materialDefs.size());
+    outMaterialTextures.clear();
+    outMaterialTextures.reserve(materialDefs.size());
 
     for(const auto& mtlDef : materialDefs)
     {
-        const wgpu::Texture& baseTexture = mtlDef.BaseTextureUri.empty()
-            ? gpuHelper.GetDefaultTexture()
-            : textureCache.Get(mtlDef.BaseTextureUri);
+        if(mtlDef.BaseTextureUri.empty())
+        {
+            outMaterialTextures.push_back(MaterialTexture{});
+            continue;
+        }
+
+        const wgpu::Texture baseTexture = textureCache.Get(mtlDef.BaseTextureUri);
+
+        auto it = textureLayers.find(baseTexture.Get());
+
+        if(it == textureLayers.end())
+        {
+            const uint32_t width = baseTexture.GetWidth();
+            const uint32_t height = baseTexture.GetHeight();
+
+            // Find an array of the same size with a free layer.
+            size_t arrayIndex = 0;
+            for(; arrayIndex < textureArrays.size(); ++arrayIndex)
+            {
+                const TextureArray& textureArray = textureArrays[arrayIndex];
+
+                if(textureArray.Width == width
+                    && textureArray.Height == height
+                    && textureArray.Layers.size() < kMaxTextureArrayLayers)
+                {
+                    break;
+                }
+            }
+
+            if(arrayIndex == textureArrays.size())
+            {
+                textureArrays.push_back({ .Width = width, .Height = height, .Layers = {} });
+            }
+
+            TextureArray& textureArray = textureArrays[arrayIndex];
+
+            const MaterialTexture materialTexture //
+                {
+                    .ArrayIndex = narrow_cast<uint32_t>(arrayIndex),
+                    .Layer = narrow_cast<uint32_t>(textureArray.Layers.size()),
+                    .Textured = true,
+                };
+
+            textureArray.Layers.push_back(baseTexture);
+            it = textureLayers.emplace(baseTexture.Get(), materialTexture).first;
+        }
+
+        outMaterialTextures.push_back(it->second);
+    }
+
+    const wgpu::CommandEncoder cmdEncoder = gpuHelper.GetDevice().CreateCommandEncoder();
+    MLG_CHECK(cmdEncoder, "Failed to create command encoder");
+
+    outBindGroups.clear();
+    outBindGroups.reserve(textureArrays.size());
+
+    for(const TextureArray& textureArray : textureArrays)
+    {
+        const std::string name = std::format("TextureArray{}x{}[{}]",
+            textureArray.Width,
+            textureArray.Height,
+            outBindGroups.size());
+
+        auto arrayTexture = gpuHelper.CreateTextureArray(textureArray.Width,
+            textureArray.Height,
+            narrow_cast<uint32_t>(textureArray.Layers.size()),
+            name);
+        MLG_CHECK(arrayTexture);
+
+        const wgpu::Extent3D copySize //
+            {
+                .width = textureArray.Width,
+                .height = textureArray.Height,
+                .depthOrArrayLayers = 1,
+            };
+
+        for(size_t layer = 0; layer < textureArray.Layers.size(); ++layer)
+        {
+            const wgpu::TexelCopyTextureInfo copySrc //
+                {
+                    .texture = textureArray.Layers[layer],
+                    .mipLevel = 0,
+                    .origin{},
+                };
+
+            const wgpu::TexelCopyTextureInfo copyDst //
+                {
+                    .texture = *arrayTexture,
+                    .mipLevel = 0,
+                    .origin{ .z = narrow_cast<uint32_t>(layer) },
+                };
+
+            cmdEncoder.CopyTextureToTexture(&copySrc, &copyDst, &copySize);
+        }
 
-        auto bindGroup = gpuHelper.CreateTextureBindGroup(baseTexture, mtlDef.BaseTextureUri);
+        auto bindGroup = gpuHelper.CreateTextureBindGroup(*arrayTexture, name);
         MLG_CHECK(bindGroup);
 
-        materialBindGroups.push_back(std::move(*bindGroup));
+        outBindGroups.push_back(std::move(*bindGroup));
     }
 
+    // Texture uploads were submitted earlier, so the copies see their contents.
+    const wgpu::CommandBuffer commandBuffer = cmdEncoder.Finish();
+    gpuHelper.GetDevice().GetQueue().Submit(1, &commandBuffer);
+
+    MLG_DEBUG("Packed {} textures into {} texture arrays",
+        textureLayers.size(),
+        textureArrays.size());
+
     return Result<>::Ok;
 }
 
@@ -487,6 +762,7 @@ BuildMaterialConstantsBuffer(GpuHelper& gpuHelper, const std::span<const Materia
                 .Color = mtlDef.Color,
                 .Metalness = mtlDef.Metalness,
                 .Roughness = mtlDef.Roughness,
+                .AlphaCutoff = mtlDef.AlphaCutoff,
             };
 
         materialConstants.push_back(mc);
@@ -502,6 +778,43 @@ BuildMaterialConstantsBuffer(GpuHelper& gpuHelper, const std::span<const Materia
 
     return buffer;
 }
+
+template<typename BufferType>
+Result<GpuMeshVertexBuffer>
+BuildVertexBuffer(GpuHelper& gpuHelper,
+    const std::span<const typename BufferType::value_type> vertices)
+{
+    auto buffer = gpuHelper.CreateVertexBuffer<BufferType>(vertices.size(), "VertexBuffer");
+    MLG_CHECK(buffer);
+
+    buffer->Store(vertices);
+
+    return GpuMeshVertexBuffer(std::move(*buffer));
+}
+
+Result<GpuIndex16Buffer>
+BuildIndex16Buffer(GpuHelper& gpuHelper, const std::span<const VertexIndex> indices)
+{
+    std::vector<VertexIndex16> indices16;
+    indices16.reserve(indices.size() + 1);
+
+    std::ranges::transform(indices,
+        std::back_inserter(indices16),
+        [](const VertexIndex index) { return narrow_cast<VertexIndex16>(index); });
+
+    // Buffer writes must be a multiple of 4 bytes.
+    if(indices16.size() % 2 != 0)
+    {
+        indices16.push_back(0);
+    }
+
+    auto buffer = gpuHelper.CreateIndexBuffer<GpuIndex16Buffer>(indices16.size(), "Index16Buffer");
+    MLG_CHECK(buffer);
+
+    buffer->Store(indices16);
+
+    return buffer;
+}
 } // namespace
 
 Result<PropKit>
@@ -514,7 +827,8 @@ PropKit::Create(GpuHelper& gpuHelper,
     Timer createTimer;
     createTimer.Start();
 
-    size_t vertexCount = 0, indexCount = 0, meshCount = 0, totalStringSize = 0;
+    size_t vertexCount = 0, meshCount = 0, totalStringSize = 0;
+    std::array<size_t, kIndexFormatCount> indexCounts{};
     size_t materialIndex = 0;
 
     std::map<MaterialDef, MaterialIdentifier> uniqueMaterialMap;
@@ -534,7 +848,7 @@ PropKit::Create(GpuHelper& gpuHelper,
             }
 
             vertexCount += mesh.Vertices.size();
-            indexCount += mesh.Indices.size();
+            indexCounts[static_cast<size_t>(SelectIndexFormat(mesh))] += mesh.Indices.size();
             meshCount += 1;
         }
     }
@@ -546,17 +860,52 @@ PropKit::Create(GpuHelper& gpuHelper,
         uniqueMaterials[id.GetValue()] = materialDef;
     }
 
+    // Textures are packed before meshes are built so meshes know their texture array layers.
+    TextureCache textureCache(gpuHelper.GetDefaultTexture());
+
+    MLG_CHECK(
+        FetchTextures(gpuHelper, threadPool, fileFetcher, rootPath, uniqueMaterials, textureCache));
+
+    std::vector<MaterialTexture> materialTextures;
+    std::vector<wgpu::BindGroup> textureArrayBindGroups;
+    MLG_CHECK(BuildTextureArrays(gpuHelper,
+        uniqueMaterials,
+        textureCache,
+        materialTextures,
+        textureArrayBindGroups));
+
+    const bool quantize = propKitDef.VertexFormat == VertexFormat::Quantized;
+
     std::vector<Vertex> vertices;
-    std::vector<VertexIndex> indices;
+    std::vector<QuantizedVertex> quantizedVertices;
+    std::vector<Vec3f> positions;
+    // Indices of each index format, widened to VertexIndex until they're uploaded.
+    std::array<std::vector<VertexIndex>, kIndexFormatCount> indices;
+    std::vector<Meshlet> meshlets;
     std::vector<Mesh> meshes;
     std::vector<Model> models;
     std::vector<NameIndexPair> modelNameIndex;
-    vertices.reserve(vertexCount);
-    indices.reserve(indexCount);
+    std::vector<Mesh::Lod> meshLods;
+    if(quantize)
+    {
+        quantizedVertices.reserve(vertexCount);
+    }
+    else
+    {
+        vertices.reserve(vertexCount);
+    }
+    positions.reserve(vertexCount);
+    for(size_t i = 0; i < kIndexFormatCount; ++i)
+    {
+        indices[i].reserve(indexCounts[i]);
+    }
     meshes.reserve(meshCount);
     models.reserve(propKitDef.ModelDefs.size());
     modelNameIndex.reserve(propKitDef.ModelDefs.size());
     StringArena stringArena(totalStringSize);
+    VertexCacheStats cacheStatsBefore, cacheStatsAfter;
+    MeshGeometryCache meshGeometryCache;
+    size_t weldedVertexCount = 0, sharedMeshCount = 0;
 
     for(const auto& modelDef : propKitDef.ModelDefs)
     {
@@ -564,21 +913,94 @@ PropKit::Create(GpuHelper& gpuHelper,
 
         const size_t firstMeshIdx = meshes.size();
 
-        for(const auto& meshDef : modelDef.MeshDefs)
+        for(const auto& sourceMeshDef : modelDef.MeshDefs)
         {
-            const Mesh::VertexParams vertexParams //
+            const MaterialIdentifier materialId = uniqueMaterialMap[sourceMeshDef.MaterialDef];
+            const MaterialTexture& materialTexture = materialTextures[materialId.GetValue()];
+
+            // Meshes with identical geometry share the vertex and index ranges of the first.
+            const uint64_t meshHash =
+                MeshOptimizer::HashMesh(sourceMeshDef.Vertices, sourceMeshDef.Indices);
+
+            if(const auto meshIndex = meshGeometryCache.Find(sourceMeshDef, meshHash))
+            {
+                meshes.emplace_back(meshes[*meshIndex],
+                    materialId,
+                    materialTexture,
+                    sourceMeshDef.MaterialDef.AlphaMode);
+                ++sharedMeshCount;
+                continue;
+            }
+
+            meshGeometryCache.Add(sourceMeshDef, meshHash, meshes.size());
+
+            MeshDef meshDef = sourceMeshDef;
+
+            MeshOptimizer::WeldVertices(meshDef.Vertices, meshDef.Indices);
+            weldedVertexCount += sourceMeshDef.Vertices.size() - meshDef.Vertices.size();
+
+            if(propKitDef.OptimizeMeshes)
+            {
+                OptimizeMesh(meshDef, cacheStatsBefore, cacheStatsAfter);
+            }
+
+            const IndexFormat indexFormat = SelectIndexFormat(meshDef);
+            std::vector<VertexIndex>& meshIndices = indices[static_cast<size_t>(indexFormat)];
+
+            Mesh::VertexParams vertexParams //
                 {
                     .IndexCount = narrow_cast<uint32_t>(meshDef.Indices.size()),
-                    .FirstIndex = narrow_cast<uint32_t>(indices.size()),
-                    .BaseVertex = narrow_cast<uint32_t>(vertices.size()),
+                    .FirstIndex = narrow_cast<uint32_t>(meshIndices.size()),
+                    .BaseVertex = narrow_cast<uint32_t>(positions.size()),
+                    .FirstMeshlet = narrow_cast<uint32_t>(meshlets.size()),
+                    .IndexFormat = indexFormat,
                 };
 
-            const MaterialIdentifier materialId = uniqueMaterialMap[meshDef.MaterialDef];
             const BoundingBox aabb = BoundingBox::FromVertices(meshDef.Vertices, meshDef.Indices);
 
-            meshes.emplace_back(vertexParams, materialId, aabb);
-            vertices.insert(vertices.end(), meshDef.Vertices.begin(), meshDef.Vertices.end());
-            indices.insert(indices.end(), meshDef.Indices.begin(), meshDef.Indices.end());
+            if(quantize)
+            {
+                // Scene passes the same bounds to the shader to decode positions.
+                VertexQuantization::Encode(meshDef.Vertices,
+                    PositionQuantization::FromBounds(aabb),
+                    quantizedVertices);
+            }
+            else
+            {
+                vertices.insert(vertices.end(), meshDef.Vertices.begin(), meshDef.Vertices.end());
+            }
+
+            std::ranges::transform(meshDef.Vertices,
+                std::back_inserter(positions),
+                [](const Vertex& vertex) { return vertex.pos; });
+            meshIndices.insert(meshIndices.end(), meshDef.Indices.begin(), meshDef.Indices.end());
+
+            // Meshlets reorder LOD 0's triangles, so they're built before anything else refers
+            // to its indices.
+            if(meshDef.Indices.size() >= kMinMeshletIndexCount)
+            {
+                MeshletBuilder::Build(
+                    std::span<const Vec3f>(positions).subspan(vertexParams.BaseVertex),
+                    std::span<VertexIndex>(meshIndices).subspan(vertexParams.FirstIndex),
+                    vertexParams.FirstIndex,
+                    meshlets);
+
+                vertexParams.MeshletCount =
+                    narrow_cast<uint32_t>(meshlets.size()) - vertexParams.FirstMeshlet;
+            }
+
+            BuildMeshLods(std::span<const Vec3f>(positions).subspan(vertexParams.BaseVertex),
+                meshDef.Indices,
+                aabb,
+                meshIndices,
+                meshLods);
+
+            meshes.emplace_back(vertexParams,
+                meshLods,
+                materialId,
+                materialTexture,
+                meshDef.MaterialDef.AlphaMode,
+                aabb);
         }
 
         // The span of meshes for this model starts at firstMeshIdx and goes to the end of the meshes vector.
@@ -593,32 +1015,48 @@ PropKit::Create(GpuHelper& gpuHelper,
         modelNameIndex.emplace_back(modelName, models.size() - 1);
     }
 
-    TextureCache textureCache(gpuHelper.GetDefaultTexture());
+    MLG_DEBUG("Welded {} vertices, {} meshes share geometry", weldedVertexCount, sharedMeshCount);
 
-    MLG_CHECK(
-        FetchTextures(gpuHelper, threadPool, fileFetcher, rootPath, uniqueMaterials, textureCache));
+    if(propKitDef.OptimizeMeshes)
+    {
+        MLG_INFO("Optimized meshes: ACMR {:.3f} -> {:.3f}, ATVR {:.3f} -> {:.3f}",
+            cacheStatsBefore.GetAcmr(),
+            cacheStatsAfter.GetAcmr(),
+            cacheStatsBefore.GetAtvr(),
+            cacheStatsAfter.GetAtvr());
+    }
 
-    auto vertexBuffer = gpuHelper.CreateVertexBuffer(vertices.size(), "VertexBuffer");
+    auto vertexBuffer = quantize
+        ? BuildVertexBuffer<GpuQuantizedVertexBuffer>(gpuHelper, quantizedVertices)
+        : BuildVertexBuffer<GpuVertexBuffer>(gpuHelper, vertices);
     MLG_CHECK(vertexBuffer);
 
-    vertexBuffer->Store(vertices);
+    const std::vector<VertexIndex>& indices32 = indices[static_cast<size_t>(IndexFormat::Uint32)];
 
-    auto indexBuffer = gpuHelper.CreateIndexBuffer(indices.size(), "IndexBuffer");
+    auto indexBuffer = gpuHelper.CreateIndexBuffer<GpuIndexBuffer>(indices32.size(), "IndexBuffer");
     MLG_CHECK(indexBuffer);
 
-    indexBuffer->Store(indices);
+    indexBuffer->Store(indices32);
+
+    auto index16Buffer =
+        BuildIndex16Buffer(gpuHelper, indices[static_cast<size_t>(IndexFormat::Uint16)]);
+    MLG_CHECK(index16Buffer);
+
+    MLG_DEBUG("{} 16-bit and {} 32-bit indices",
+        indices[static_cast<size_t>(IndexFormat::Uint16)].size(),
+        indices32.size());
 
     auto materialConstants = BuildMaterialConstantsBuffer(gpuHelper, uniqueMaterials);
     MLG_CHECK(materialConstants);
 
-    std::vector<wgpu::BindGroup> materialBindGroups;
-    MLG_CHECK(
-        CreateMaterialBindGroups(gpuHelper, uniqueMaterials, textureCache, materialBindGroups));
-
     PropKit propKit(std::move(*vertexBuffer),
         std::move(*indexBuffer),
+        std::move(*index16Buffer),
         std::move(*materialConstants),
-        std::move(materialBindGroups),
+        std::move(textureArrayBindGroups),
+        std::move(positions),
+        std::move(indices),
+        std::move(meshlets),
         std::move(meshes),
         std::move(models),
         std::move(modelNameIndex),
@@ -642,13 +1080,13 @@ PropKit::GetModel(const std::string_view& name) const
 }
 
 const wgpu::BindGroup*
-PropKit::GetMaterialBindGroup(const MaterialIdentifier& materialId) const
+PropKit::GetTextureArrayBindGroup(const uint32_t arrayIndex) const
 {
-    if(MLG_VERIFY(materialId.IsValid() && materialId.GetValue() < m_MaterialBindGroups.size(),
-           "Invalid material id: {}",
-           materialId.GetValue()))
+    if(MLG_VERIFY(arrayIndex < m_TextureArrayBindGroups.size(),
+           "Invalid texture array index: {}",
+           arrayIndex))
     {
-        return &m_MaterialBindGroups[materialId.GetValue()];
+        return &m_TextureArrayBindGroups[arrayIndex];
     }
 
     return nullptr;
@@ -656,18 +1094,26 @@ PropKit::GetMaterialBindGroup(const MaterialIdentifier& materialId) const
 
 // private:
 
-PropKit::PropKit(GpuVertexBuffer&& vertexBuffer,
+PropKit::PropKit(GpuMeshVertexBuffer&& vertexBuffer,
     GpuIndexBuffer&& indexBuffer,
+    GpuIndex16Buffer&& index16Buffer,
     GpuMaterialConstantsBuffer&& materialConstants,
-    std::vector<wgpu::BindGroup>&& materialBindGroups,
+    std::vector<wgpu::BindGroup>&& textureArrayBindGroups,
+    std::vector<Vec3f>&& positions,
+    std::array<std::vector<VertexIndex>, kIndexFormatCount>&& indices,
+    std::vector<Meshlet>&& meshlets,
     std::vector<Mesh>&& meshes,
     std::vector<Model>&& models,
     std::vector<NameIndexPair>&& modelNameIndex,
     StringArena&& stringArena)
     : m_VertexBuffer(std::move(vertexBuffer)),
       m_IndexBuffer(std::move(indexBuffer)),
+      m_Index16Buffer(std::move(index16Buffer)),
       m_MaterialConstants(std::move(materialConstants)),
-      m_MaterialBindGroups(std::move(materialBindGroups)),
+      m_TextureArrayBindGroups(std::move(textureArrayBindGroups)),
+      m_Positions(std::move(positions)),
+      m_Indices(std::move(indices)),
+      m_Meshlets(std::move(meshlets)),
       m_Meshes(std::move(meshes)),
       m_Models(std::move(models)),
       m_ModelNameIndex(std::move(modelNameIndex)),
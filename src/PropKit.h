@@ -1,10 +1,12 @@
 #pragma once
 
 #include "GpuTypes.h"
+#include "MeshletBuilder.h"
 #include "Result.h"
 #include "SceneTypes.h"
 #include "StringArena.h"
 
+#include <array>
 #include <filesystem>
 #include <vector>
 
@@ -31,14 +33,42 @@ public:
 
     const Model* GetModel(const std::string_view& name) const;
 
-    const wgpu::BindGroup* GetMaterialBindGroup(const MaterialIdentifier& materialId) const;
+    /// @brief Returns the bind group of a texture array holding material base textures.
+    /// Meshes select theirs with Mesh::GetMaterialTexture().
+    const wgpu::BindGroup* GetTextureArrayBindGroup(const uint32_t arrayIndex) const;
 
     GpuMaterialConstantsBuffer GetMaterialConstants() const { return m_MaterialConstants; }
 
-    GpuVertexBuffer GetVertexBuffer() const { return m_VertexBuffer; }
+    /// @brief Returns the vertex buffer, in the format requested by the PropKitDef.
+    /// Quantized positions are relative to each mesh's bounding box.
+    GpuMeshVertexBuffer GetVertexBuffer() const { return m_VertexBuffer; }
 
+    /// @brief Returns the index buffer of meshes with IndexFormat::Uint32.
     GpuIndexBuffer GetIndexBuffer() const { return m_IndexBuffer; }
 
+    /// @brief Returns the index buffer of meshes with IndexFormat::Uint16.
+    /// Meshes with at most kMaxVertexIndex16Count vertices use 16-bit indices.
+    GpuIndex16Buffer GetIndex16Buffer() const { return m_Index16Buffer; }
+
+    /// @brief CPU copy of the vertex positions in the vertex buffer.
+    /// Used for CPU side queries such as occlusion culling.
+    std::span<const Vec3f> GetPositions() const { return m_Positions; }
+
+    /// @brief CPU copy of the index buffer of the given format, widened to VertexIndex.
+    /// Mesh index ranges of that format index into it.
+    std::span<const VertexIndex> GetIndices(const IndexFormat indexFormat) const
+    {
+        return m_Indices[static_cast<size_t>(indexFormat)];
+    }
+
+    /// @brief Returns the meshlets that LOD 0 of a mesh is split into, used to cull parts of
+    /// large meshes. Empty for meshes that aren't split.
+    std::span<const Meshlet> GetMeshlets(const Mesh& mesh) const
+    {
+        return std::span<const Meshlet>(m_Meshlets).subspan(mesh.GetFirstMeshlet(),
+            mesh.GetMeshletCount());
+    }
+
 private:
 
     struct NameIndexPair
@@ -53,19 +83,29 @@ private:
         size_t Index;
     };
 
-    PropKit(GpuVertexBuffer&& vertexBuffer,
+    PropKit(GpuMeshVertexBuffer&& vertexBuffer,
         GpuIndexBuffer&& indexBuffer,
+        GpuIndex16Buffer&& index16Buffer,
         GpuMaterialConstantsBuffer&& materialConstants,
-        std::vector<wgpu::BindGroup>&& materialBindGroups,
+        std::vector<wgpu::BindGroup>&& textureArrayBindGroups,
+        std::vector<Vec3f>&& positions,
+        std::array<std::vector<VertexIndex>, kIndexFormatCount>&& indices,
+        std::vector<Meshlet>&& meshlets,
         std::vector<Mesh>&& meshes,
         std::vector<Model>&& models,
         std::vector<NameIndexPair>&& modelNameIndex,
         StringArena&& stringArena);
 
-    GpuVertexBuffer m_VertexBuffer;
+    GpuMeshVertexBuffer m_VertexBuffer;
     GpuIndexBuffer m_IndexBuffer;
+    GpuIndex16Buffer m_Index16Buffer;
     GpuMaterialConstantsBuffer m_MaterialConstants;
-    std::vector<wgpu::BindGroup> m_MaterialBindGroups;
+    std::vector<wgpu::BindGroup> m_TextureArrayBindGroups;
+
+    std::vector<Vec3f> m_Positions;
+    // Indexed by IndexFormat.
+    std::array<std::vector<VertexIndex>, kIndexFormatCount> m_Indices;
+    std::vector<Meshlet> m_Meshlets;
 
     std::vector<Mesh> m_Meshes;
     std::vector<Model> m_Models;
@@ -0,0 +1,91 @@
+#pragma once
+
+#include "AssertHelper.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <span>
+#include <type_traits>
+#include <utility>
+
+/// @brief Sorts items in ascending order of a 64-bit key using a stable LSD radix sort with
+/// 8-bit digits.
+///
+/// Histograms for every digit are built in a single sweep over the items, and passes in which
+/// all keys share the same digit are skipped. Keys that leave high or low bits unused therefore
+/// sort in fewer passes.
+///
+/// @param items The items to sort. On return contains the items in sorted order.
+/// @param scratch Scratch space used for ping-ponging. Must be at least as large as items.
+/// @param getKey Callable that returns the uint64_t sort key for an item.
+template<typename T, typename GetKey>
+void
+RadixSort(const std::span<T> items, const std::span<T> scratch, GetKey&& getKey)
+{
+    static_assert(std::is_trivially_copyable_v<T>, "RadixSort requires trivially copyable items");
+
+    MLG_ASSERT(scratch.size() >= items.size(), "Scratch space is smaller than the item count");
+
+    constexpr size_t kDigitBits = 8;
+    constexpr size_t kBucketCount = size_t{ 1 } << kDigitBits;
+    constexpr uint64_t kDigitMask = kBucketCount - 1;
+    constexpr size_t kPassCount = 64 / kDigitBits;
+
+    const size_t count = items.size();
+
+    if(count < 2)
+    {
+        return;
+    }
+
+    auto digitOf = [&getKey](const T& item, const size_t pass)
+    {
+        return static_cast<size_t>((getKey(item) >> (pass * kDigitBits)) & kDigitMask);
+    };
+
+    std::array<std::array<size_t, kBucketCount>, kPassCount> histograms{};
+
+    for(const T& item : items)
+    {
+        for(size_t pass = 0; pass < kPassCount; ++pass)
+        {
+            ++histograms[pass][digitOf(item, pass)];
+        }
+    }
+
+    std::span<T> src = items;
+    std::span<T> dst = scratch.first(count);
+
+    for(size_t pass = 0; pass < kPassCount; ++pass)
+    {
+        std::array<size_t, kBucketCount>& offsets = histograms[pass];
+
+        // Every key has the same digit - this pass wouldn't change the order.
+        if(offsets[digitOf(src[0], pass)] == count)
+        {
+            continue;
+        }
+
+        // Convert digit counts to starting offsets.
+        size_t offset = 0;
+        for(size_t& bucket : offsets)
+        {
+            const size_t bucketCount = bucket;
+            bucket = offset;
+            offset += bucketCount;
+        }
+
+        for(const T& item : src)
+        {
+            dst[offsets[digitOf(item, pass)]++] = item;
+        }
+
+        std::swap(src, dst);
+    }
+
+    if(src.data() != items.data())
+    {
+        std::ranges::copy(src, items.begin());
+    }
+}
@@ -0,0 +1,464 @@
+#define MLG_LOGGER_NAME "RGPH"
+
+#include "RenderGraph.h"
+
+#include "AssertHelper.h"
+#include "narrow_cast.h"
+
+#include <algorithm>
+
+namespace
+{
+// Returns whether resources of the given descriptions can share a physical resource.
+// Buffers can as they grow to the largest size assigned to them.
+bool
+AreCompatible(const RenderGraph::ResourceDesc& a, const RenderGraph::ResourceDesc& b)
+{
+    return a.Type == b.Type
+        && (a.Type == RenderGraph::ResourceType::Buffer || a.Dimensions == b.Dimensions);
+}
+
+// Returns whether a free physical buffer of candidateSize is a better fit for byteSize than one
+// of bestSize. Buffers that are large enough are preferred, then the smallest of those, or the
+// largest if none is large enough.
+bool
+IsBetterFit(const size_t candidateSize, const size_t bestSize, const size_t byteSize)
+{
+    const bool candidateFits = candidateSize >= byteSize;
+    const bool bestFits = bestSize >= byteSize;
+
+    if(candidateFits != bestFits)
+    {
+        return candidateFits;
+    }
+
+    return candidateFits ? candidateSize < bestSize : candidateSize > bestSize;
+}
+} // namespace
+
+RenderGraph::PassBuilder&
+RenderGraph::PassBuilder::Read(const ResourceHandle resource)
+{
+    m_Graph->AddAccess(m_PassIndex, resource, false);
+    return *this;
+}
+
+RenderGraph::PassBuilder&
+RenderGraph::PassBuilder::Write(const ResourceHandle resource)
+{
+    m_Graph->AddAccess(m_PassIndex, resource, true);
+    return *this;
+}
+
+RenderGraph::PassBuilder&
+RenderGraph::PassBuilder::SetSideEffects()
+{
+    m_Graph->m_Passes[m_PassIndex].HasSideEffects = true;
+    return *this;
+}
+
+void
+RenderGraph::Clear()
+{
+    m_Resources.clear();
+    m_Passes.clear();
+    m_Accesses.clear();
+    m_ExecutionOrder.clear();
+    m_PhysicalResources.clear();
+    m_IsCompiled = false;
+}
+
+RenderGraph::ResourceHandle
+RenderGraph::CreateTransient(const std::string_view& name, const ResourceDesc& desc)
+{
+    return AddResource(name, desc, false);
+}
+
+RenderGraph::ResourceHandle
+RenderGraph::Import(const std::string_view& name, const ResourceDesc& desc)
+{
+    return AddResource(name, desc, true);
+}
+
+void
+RenderGraph::MarkOutput(const ResourceHandle resource)
+{
+    MLG_ASSERT(resource.Index < m_Resources.size(), "Invalid resource");
+
+    m_Resources[resource.Index].IsOutput = true;
+    m_IsCompiled = false;
+}
+
+RenderGraph::PassBuilder
+RenderGraph::AddPass(const std::string_view& name, ExecuteFunc executeFunc, void* userData)
+{
+    MLG_ASSERT(executeFunc, "Pass '{}' has no execute function", name);
+
+    m_Passes.push_back(Pass //
+        {
+            .Name = std::string(name),
+            .Execute = executeFunc,
+            .UserData = userData,
+            .HasSideEffects = false,
+            .IsKept = false,
+        });
+
+    m_IsCompiled = false;
+
+    return PassBuilder(*this, narrow_cast<uint32_t>(m_Passes.size() - 1));
+}
+
+Result<>
+RenderGraph::Compile()
+{
+    CullPasses();
+
+    for(const Access& access : m_Accesses)
+    {
+        const Resource& resource = m_Resources[access.ResourceIndex];
+
+        if(access.IsWrite || resource.IsImported || !m_Passes[access.PassIndex].IsKept)
+        {
+            continue;
+        }
+
+        const bool isWritten = std::ranges::any_of(m_Accesses,
+            [&access](const Access& other)
+            { return other.IsWrite && other.ResourceIndex == access.ResourceIndex; });
+
+        MLG_CHECK(isWritten,
+            "Pass '{}' reads '{}', which no pass writes",
+            m_Passes[access.PassIndex].Name,
+            resource.Name);
+    }
+
+    MLG_CHECK(OrderPasses());
+
+    AssignPhysicalResources();
+
+    m_IsCompiled = true;
+
+    return Result<>::Ok;
+}
+
+bool
+RenderGraph::IsPassCulled(const uint32_t passIndex) const
+{
+    MLG_ASSERT(m_IsCompiled, "Graph is not compiled");
+
+    return !m_Passes[passIndex].IsKept;
+}
+
+bool
+RenderGraph::HasPhysicalResource(const ResourceHandle resource) const
+{
+    MLG_ASSERT(m_IsCompiled, "Graph is not compiled");
+    MLG_ASSERT(!m_Resources[resource.Index].IsImported, "Imported resources aren't assigned");
+
+    return m_Resources[resource.Index].PhysicalIndex != kNone;
+}
+
+const RenderGraph::PhysicalResource&
+RenderGraph::GetPhysicalResource(const ResourceHandle resource) const
+{
+    MLG_ASSERT(HasPhysicalResource(resource),
+        "'{}' is not used by any pass",
+        m_Resources[resource.Index].Name);
+
+    return m_PhysicalResources[m_Resources[resource.Index].PhysicalIndex];
+}
+
+Result<>
+RenderGraph::Execute() const
+{
+    MLG_CHECKV(m_IsCompiled, "Graph is not compiled");
+
+    for(const uint32_t passIndex : m_ExecutionOrder)
+    {
+        const Pass& pass = m_Passes[passIndex];
+
+        MLG_CHECK(pass.Execute(pass.UserData), "Pass '{}' failed", pass.Name);
+    }
+
+    return Result<>::Ok;
+}
+
+// private:
+
+RenderGraph::ResourceHandle
+RenderGraph::AddResource(const std::string_view& name,
+    const ResourceDesc& desc,
+    const bool isImported)
+{
+    m_Resources.push_back(Resource //
+        {
+            .Name = std::string(name),
+            .Desc = desc,
+            .IsImported = isImported,
+            .IsOutput = false,
+            .PhysicalIndex = kNone,
+        });
+
+    m_IsCompiled = false;
+
+    return ResourceHandle{ .Index = narrow_cast<uint32_t>(m_Resources.size() - 1) };
+}
+
+void
+RenderGraph::AddAccess(const uint32_t passIndex, const ResourceHandle resource, const bool isWrite)
+{
+    MLG_ASSERT(resource.Index < m_Resources.size(), "Invalid resource");
+
+    m_Accesses.push_back(Access //
+        {
+            .PassIndex = passIndex,
+            .ResourceIndex = resource.Index,
+            .IsWrite = isWrite,
+        });
+
+    m_IsCompiled = false;
+}
+
+bool
+RenderGraph::Writes(const uint32_t passIndex, const uint32_t resourceIndex) const
+{
+    return std::ranges::any_of(m_Accesses,
+        [passIndex, resourceIndex](const Access& access)
+        {
+            return access.IsWrite
+                && access.PassIndex == passIndex
+                && access.ResourceIndex == resourceIndex;
+        });
+}
+
+void
+RenderGraph::CullPasses()
+{
+    m_PassStack.clear();
+
+    for(uint32_t passIndex = 0; passIndex < m_Passes.size(); ++passIndex)
+    {
+        Pass& pass = m_Passes[passIndex];
+        pass.IsKept = pass.HasSideEffects;
+
+        if(pass.IsKept)
+        {
+            m_PassStack.push_back(passIndex);
+        }
+    }
+
+    for(const Access& access : m_Accesses)
+    {
+        Pass& pass = m_Passes[access.PassIndex];
+
+        if(access.IsWrite && m_Resources[access.ResourceIndex].IsOutput && !pass.IsKept)
+        {
+            pass.IsKept = true;
+            m_PassStack.push_back(access.PassIndex);
+        }
+    }
+
+    // Keep the writers of everything that kept passes read.
+    while(!m_PassStack.empty())
+    {
+        const uint32_t passIndex = m_PassStack.back();
+        m_PassStack.pop_back();
+
+        for(const Access& read : m_Accesses)
+        {
+            if(read.PassIndex != passIndex || read.IsWrite)
+            {
+                continue;
+            }
+
+            for(const Access& write : m_Accesses)
+            {
+                Pass& writer = m_Passes[write.PassIndex];
+
+                if(write.IsWrite && write.ResourceIndex == read.ResourceIndex && !writer.IsKept)
+                {
+                    writer.IsKept = true;
+                    m_PassStack.push_back(write.PassIndex);
+                }
+            }
+        }
+    }
+}
+
+Result<>
+RenderGraph::OrderPasses()
+{
+    // Writers of a resource run in the order they were added, and before passes that only
+    // read it.
+    auto precedes = [this](const Access& write, const Access& other)
+    {
+        if(!write.IsWrite
+            || other.ResourceIndex != write.ResourceIndex
+            || other.PassIndex == write.PassIndex
+            || !m_Passes[write.PassIndex].IsKept
+            || !m_Passes[other.PassIndex].IsKept)
+        {
+            return false;
+        }
+
+        return other.IsWrite ? write.PassIndex < other.PassIndex
+                             : !Writes(other.PassIndex, other.ResourceIndex);
+    };
+
+    m_DependencyCounts.assign(m_Passes.size(), 0);
+
+    for(const Access& write : m_Accesses)
+    {
+        for(const Access& other : m_Accesses)
+        {
+            if(precedes(write, other))
+            {
+                ++m_DependencyCounts[other.PassIndex];
+            }
+        }
+    }
+
+    const size_t keptCount =
+        static_cast<size_t>(std::ranges::count_if(m_Passes, &Pass::IsKept));
+
+    m_ExecutionOrder.clear();
+
+    while(m_ExecutionOrder.size() < keptCount)
+    {
+        // Of the passes that are ready, run the one that was added first.
+        uint32_t next = kNone;
+
+        for(uint32_t passIndex = 0; passIndex < m_Passes.size(); ++passIndex)
+        {
+            if(m_Passes[passIndex].IsKept && m_DependencyCounts[passIndex] == 0)
+            {
+                next = passIndex;
+                break;
+            }
+        }
+
+        MLG_CHECK(next != kNone, "Passes depend on each other in a cycle");
+
+        m_ExecutionOrder.push_back(next);
+        m_DependencyCounts[next] = kNone;
+
+        for(const Access& write : m_Accesses)
+        {
+            if(write.PassIndex != next)
+            {
+                continue;
+            }
+
+            for(const Access& other : m_Accesses)
+            {
+                if(precedes(write, other))
+                {
+                    --m_DependencyCounts[other.PassIndex];
+                }
+            }
+        }
+    }
+
+    return Result<>::Ok;
+}
+
+void
+RenderGraph::AssignPhysicalResources()
+{
+    // Lifetimes of resources, as positions in the execution order.
+    m_FirstUses.assign(m_Resources.size(), kNone);
+    m_LastUses.assign(m_Resources.size(), 0);
+
+    for(uint32_t position = 0; position < m_ExecutionOrder.size(); ++position)
+    {
+        for(const Access& access : m_Accesses)
+        {
+            if(access.PassIndex == m_ExecutionOrder[position])
+            {
+                m_FirstUses[access.ResourceIndex] =
+                    std::min(m_FirstUses[access.ResourceIndex], position);
+                m_LastUses[access.ResourceIndex] = position;
+            }
+        }
+    }
+
+    m_ResourceOrder.clear();
+
+    for(uint32_t resourceIndex = 0; resourceIndex < m_Resources.size(); ++resourceIndex)
+    {
+        Resource& resource = m_Resources[resourceIndex];
+        resource.PhysicalIndex = kNone;
+
+        if(resource.IsImported || m_FirstUses[resourceIndex] == kNone)
+        {
+            continue;
+        }
+
+        if(resource.IsOutput)
+        {
+            // Outputs are used after the graph executes.
+            m_LastUses[resourceIndex] = kNone;
+        }
+
+        m_ResourceOrder.push_back(resourceIndex);
+    }
+
+    std::ranges::stable_sort(m_ResourceOrder,
+        {},
+        [this](const uint32_t resourceIndex) { return m_FirstUses[resourceIndex]; });
+
+    m_PhysicalResources.clear();
+    m_PhysicalLastUses.clear();
+
+    for(const uint32_t resourceIndex : m_ResourceOrder)
+    {
+        Resource& resource = m_Resources[resourceIndex];
+        const ResourceDesc& desc = resource.Desc;
+
+        uint32_t best = kNone;
+        uint32_t compatibleCount = 0;
+
+        for(uint32_t physicalIndex = 0; physicalIndex < m_PhysicalResources.size();
+            ++physicalIndex)
+        {
+            const ResourceDesc& physicalDesc = m_PhysicalResources[physicalIndex].Desc;
+
+            if(!AreCompatible(physicalDesc, desc))
+            {
+                continue;
+            }
+
+            ++compatibleCount;
+
+            if(m_PhysicalLastUses[physicalIndex] >= m_FirstUses[resourceIndex])
+            {
+                // Still in use.
+                continue;
+            }
+
+            if(best == kNone
+                || (desc.Type == ResourceType::Buffer
+                    && IsBetterFit(physicalDesc.ByteSize,
+                        m_PhysicalResources[best].Desc.ByteSize,
+                        desc.ByteSize)))
+            {
+                best = physicalIndex;
+            }
+        }
+
+        if(best == kNone)
+        {
+            best = narrow_cast<uint32_t>(m_PhysicalResources.size());
+
+            m_PhysicalResources.push_back(
+                PhysicalResource{ .Desc = desc, .Instance = compatibleCount });
+            m_PhysicalLastUses.push_back(0);
+        }
+
+        ResourceDesc& physicalDesc = m_PhysicalResources[best].Desc;
+        physicalDesc.ByteSize = std::max(physicalDesc.ByteSize, desc.ByteSize);
+
+        m_PhysicalLastUses[best] = m_LastUses[resourceIndex];
+        resource.PhysicalIndex = best;
+    }
+}
@@ -0,0 +1,215 @@
+#pragma once
+
+#include "Result.h"
+#include "VecMath.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+/// @brief Orders, culls and executes the passes of a frame, and assigns the transient resources
+/// they use to physical resources.
+///
+/// Passes declare the resources they read and write. Compile() orders passes so the writers of
+/// a resource run before its readers, with writers of the same resource running in the order
+/// they were added. Passes whose writes are never read, neither by a pass that's kept nor as an
+/// output of the graph, are culled.
+///
+/// Transient resources live from the first to the last pass that uses them. Transient
+/// resources with the same description whose lifetimes don't overlap share a physical
+/// resource, so passes that only need a resource for part of the frame don't add to the memory
+/// used. Imported resources are created by the caller and are never shared.
+///
+/// The graph only deals with descriptions of resources, so it can be compiled without a GPU.
+/// The caller gets the physical resources, e.g. from a pool, before executing the graph.
+class RenderGraph final
+{
+public:
+    enum class ResourceType : uint8_t
+    {
+        ColorTarget,
+        DepthTarget,
+        Buffer,
+    };
+
+    struct ResourceDesc
+    {
+        ResourceType Type{ ResourceType::ColorTarget };
+        // Size of textures.
+        Dimension2 Dimensions{};
+        // Size of buffers, in bytes.
+        size_t ByteSize{ 0 };
+    };
+
+    /// @brief Identifies a resource in the graph that created it.
+    struct ResourceHandle
+    {
+        uint32_t Index;
+    };
+
+    /// @brief A resource that one or more transient resources are assigned to.
+    struct PhysicalResource
+    {
+        /// Buffers are as large as the largest transient buffer assigned to them.
+        ResourceDesc Desc;
+
+        /// Index of the resource among the physical textures of the same description, or among
+        /// the physical buffers. It doesn't change from frame to frame while the passes do, so
+        /// pooled resources can be matched to it.
+        uint32_t Instance;
+    };
+
+    using ExecuteFunc = Result<> (*)(void* userData);
+
+    /// @brief Declares the resources used by a pass.
+    class PassBuilder
+    {
+    public:
+        PassBuilder& Read(const ResourceHandle resource);
+
+        PassBuilder& Write(const ResourceHandle resource);
+
+        /// @brief Keeps the pass even if nothing reads what it writes.
+        PassBuilder& SetSideEffects();
+
+    private:
+        friend class RenderGraph;
+
+        PassBuilder(RenderGraph& graph, const uint32_t passIndex)
+            : m_Graph(&graph),
+              m_PassIndex(passIndex)
+        {
+        }
+
+        RenderGraph* m_Graph;
+        uint32_t m_PassIndex;
+    };
+
+    RenderGraph() = default;
+    ~RenderGraph() = default;
+    RenderGraph(const RenderGraph&) = delete;
+    RenderGraph& operator=(const RenderGraph&) = delete;
+    RenderGraph(RenderGraph&&) = default;
+    RenderGraph& operator=(RenderGraph&&) = default;
+
+    /// @brief Removes all passes and resources. Memory is kept for the next frame's graph.
+    void Clear();
+
+    /// @brief Adds a resource whose physical resource is assigned by Compile().
+    ResourceHandle CreateTransient(const std::string_view& name, const ResourceDesc& desc);
+
+    /// @brief Adds a resource created by the caller.
+    ResourceHandle Import(const std::string_view& name, const ResourceDesc& desc);
+
+    /// @brief Marks a resource as a result of the graph, so its writers are kept.
+    void MarkOutput(const ResourceHandle resource);
+
+    /// @brief Adds a pass that's executed by calling executeFunc with userData.
+    PassBuilder AddPass(const std::string_view& name, ExecuteFunc executeFunc, void* userData);
+
+    template<auto Func, typename T>
+    PassBuilder AddPass(const std::string_view& name, T* userData)
+    {
+        static_assert(std::is_invocable_r_v<Result<>, decltype(Func), T*>);
+
+        auto wrapperFunc = [](void* data) -> Result<>
+        { return std::invoke(Func, static_cast<T*>(data)); };
+
+        return AddPass(name, wrapperFunc, userData);
+    }
+
+    /// @brief Culls and orders passes and assigns transient resources to physical resources.
+    /// Fails if passes depend on each other in a cycle, or if a kept pass reads a transient
+    /// resource that no pass writes.
+    Result<> Compile();
+
+    /// @brief Returns the indices, in the order they were added, of the passes that are kept,
+    /// in the order they execute.
+    std::span<const uint32_t> GetExecutionOrder() const { return m_ExecutionOrder; }
+
+    uint32_t GetPassCount() const { return static_cast<uint32_t>(m_Passes.size()); }
+
+    std::string_view GetPassName(const uint32_t passIndex) const
+    {
+        return m_Passes[passIndex].Name;
+    }
+
+    bool IsPassCulled(const uint32_t passIndex) const;
+
+    std::span<const PhysicalResource> GetPhysicalResources() const { return m_PhysicalResources; }
+
+    /// @brief Returns whether a transient resource is used by a pass that's kept, and so has a
+    /// physical resource.
+    bool HasPhysicalResource(const ResourceHandle resource) const;
+
+    /// @brief Returns the physical resource assigned to a transient resource.
+    const PhysicalResource& GetPhysicalResource(const ResourceHandle resource) const;
+
+    /// @brief Executes the passes that are kept, in order.
+    Result<> Execute() const;
+
+private:
+    static constexpr uint32_t kNone = UINT32_MAX;
+
+    struct Resource
+    {
+        std::string Name;
+        ResourceDesc Desc;
+        bool IsImported;
+        bool IsOutput;
+        // Assigned by Compile().
+        uint32_t PhysicalIndex;
+    };
+
+    struct Pass
+    {
+        std::string Name;
+        ExecuteFunc Execute;
+        void* UserData;
+        bool HasSideEffects;
+        // Assigned by Compile().
+        bool IsKept;
+    };
+
+    struct Access
+    {
+        uint32_t PassIndex;
+        uint32_t ResourceIndex;
+        bool IsWrite;
+    };
+
+    ResourceHandle AddResource(const std::string_view& name,
+        const ResourceDesc& desc,
+        const bool isImported);
+
+    void AddAccess(const uint32_t passIndex, const ResourceHandle resource, const bool isWrite);
+
+    // Returns whether the pass writes the resource.
+    bool Writes(const uint32_t passIndex, const uint32_t resourceIndex) const;
+
+    void CullPasses();
+
+    Result<> OrderPasses();
+
+    void AssignPhysicalResources();
+
+    std::vector<Resource> m_Resources;
+    std::vector<Pass> m_Passes;
+    std::vector<Access> m_Accesses;
+    std::vector<uint32_t> m_ExecutionOrder;
+    std::vector<PhysicalResource> m_PhysicalResources;
+    bool m_IsCompiled{ false };
+
+    // Scratch space for Compile().
+    std::vector<uint32_t> m_PassStack;
+    std::vector<uint32_t> m_DependencyCounts;
+    std::vector<uint32_t> m_FirstUses;
+    std::vector<uint32_t> m_LastUses;
+    std::vector<uint32_t> m_PhysicalLastUses;
+    std::vector<uint32_t> m_ResourceOrder;
+};
@@ -7,109 +7,518 @@
 #include "narrow_cast.h"
 #include "PerfMetrics.h"
 #include "PropKit.h"
+#include "RadixSort.h"
 #include "SceneTypes.h"
 #include "Timer.h"
+#include "TransformSnapshotBuffer.h"
+#include "VertexQuantization.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <numbers>
+#include <ranges>
+#include <utility>
 
 namespace
 {
 
-size_t
-CountMeshInstances(const std::span<const ModelNode> modelNodes)
+// Draw sort key layout, from most to least significant bits:
+//   pipeline | texture array | depth bucket | mesh
+// Materials' textures are layers of a few texture arrays, so sorting by texture array before
+// depth keeps bind group changes low without grouping by material. Depth buckets are coarse and
+// logarithmic so that draws are roughly front to back while instances of the same mesh mostly
+// land in the same bucket and can still be batched.
+// The pipeline is the material's alpha mode, then its shader variant, so blended draws sort after
+// everything else. Untextured draws bind no texture array, so their texture array field is zero.
+// Blended draws must be drawn back to front, so their key replaces texture array and depth bucket
+// with the inverted depth:
+//   pipeline | inverted depth | mesh
+constexpr unsigned kSortKeyMeshBits = 32;
+constexpr unsigned kSortKeyDepthBits = 4;
+constexpr unsigned kSortKeyTextureArrayBits = 20;
+constexpr unsigned kSortKeyPipelineBits = 8;
+constexpr unsigned kSortKeyBlendDepthBits = kSortKeyTextureArrayBits + kSortKeyDepthBits;
+
+static_assert(
+    kSortKeyMeshBits + kSortKeyDepthBits + kSortKeyTextureArrayBits + kSortKeyPipelineBits == 64,
+    "Sort key fields must fill 64 bits");
+
+// Occluder selection limits. Screen size is the ratio of a mesh's bounding radius to its
+// distance from the camera.
+constexpr size_t kMaxOccluders = 32;
+constexpr size_t kMaxOccluderTriangles = 16 * 1024;
+constexpr float kMinOccluderScreenSize = 0.1f;
+
+// Minimum capacities of the scene's GPU arrays.
+constexpr size_t kMinNodeCapacity = 64;
+constexpr size_t kMinMeshCapacity = 256;
+
+// The finest LOD is used until its simplification error would cover more than this many pixels.
+constexpr float kMaxLodErrorPixels = 1.0f;
+
+// Static meshes are recorded into render bundles per static cell. A cell combines a cube of
+// camera positions with a bin of view directions. Direction bins divide each face of a cube
+// around the camera into kStaticCellDirectionBins x kStaticCellDirectionBins squares.
+constexpr float kStaticCellSize = 4.0f;
+constexpr uint32_t kStaticCellDirectionBins = 8;
+constexpr size_t kMaxStaticBundles = 64;
+
+// Camera positions and view directions covered by a static cell.
+struct StaticCellView
 {
-    size_t count = 0;
+    // The cell's center and the radius of a sphere enclosing it.
+    Vec3f Position;
+    float Radius;
+
+    // The direction through the center of the cell's direction bin and the half angle of a cone
+    // enclosing the view frusta of all directions in the bin.
+    Vec3f Direction;
+    float HalfAngle;
+};
+
+// Returns the half angle of a cone enclosing a camera's view frustum.
+float
+FrustumHalfAngle(const Camera& camera)
+{
+    const float tanHalfFov = std::tan(camera.GetFov().GetValue() * 0.5f);
+    const float aspectRatio = camera.GetAspectRatio();
 
-    for(const ModelNode& node : modelNodes)
+    return std::atan(tanHalfFov * std::sqrt(1 + (aspectRatio * aspectRatio)));
+}
+
+// Returns the camera positions and view directions covered by the static cell at the given
+// coordinates, whose direction bin is centered on direction.
+StaticCellView
+MakeStaticCellView(const int32_t x,
+    const int32_t y,
+    const int32_t z,
+    const Vec3f& direction,
+    const float frustumHalfAngle)
+{
+    // Half diagonal of a direction bin on the unit cube face, which bounds the angle between the
+    // bin's center and any direction in it.
+    constexpr float kDirectionBinRadius =
+        std::numbers::sqrt2_v<float> / static_cast<float>(kStaticCellDirectionBins);
+
+    return StaticCellView //
+        {
+            .Position =
+                (Vec3f(static_cast<float>(x), static_cast<float>(y), static_cast<float>(z))
+                    + Vec3f(0.5f))
+                * kStaticCellSize,
+            .Radius = kStaticCellSize * std::numbers::sqrt3_v<float> * 0.5f,
+            .Direction = direction,
+            .HalfAngle = frustumHalfAngle + kDirectionBinRadius,
+        };
+}
+
+// Quantizes a view direction to a direction bin. Returns the bin index and writes the direction
+// through the bin's center to outCenter.
+uint32_t
+QuantizeDirection(const Vec3f& direction, Vec3f& outCenter)
+{
+    constexpr float kBins = static_cast<float>(kStaticCellDirectionBins);
+
+    size_t axis = 0;
+    for(size_t i = 1; i < 3; ++i)
     {
-        count += node.GetModel()->GetMeshes().size();
+        if(std::abs(direction[i]) > std::abs(direction[axis]))
+        {
+            axis = i;
+        }
     }
 
-    return count;
+    const float major = direction[axis];
+
+    uint32_t bin = (narrow_cast<uint32_t>(axis) * 2) + (major < 0 ? 1 : 0);
+    outCenter[axis] = major < 0 ? -1.0f : 1.0f;
+
+    for(size_t i = 1; i < 3; ++i)
+    {
+        const size_t minorAxis = (axis + i) % 3;
+
+        // Position on the cube face, from 0 to 1.
+        const float t = ((direction[minorAxis] / std::abs(major)) + 1) * 0.5f;
+        const uint32_t minorBin = std::min(static_cast<uint32_t>(std::max(t * kBins, 0.0f)),
+            kStaticCellDirectionBins - 1);
+
+        bin = (bin * kStaticCellDirectionBins) + minorBin;
+        outCenter[minorAxis] = (((static_cast<float>(minorBin) + 0.5f) / kBins) * 2) - 1;
+    }
+
+    outCenter = outCenter.Normalize();
+
+    return bin;
 }
 
-Result<GpuDrawIndirectBuffer>
-BuildDrawIndirectBuffer(GpuHelper& gpuHelper, const std::span<const ModelNode> modelNodes)
+// Returns true if a sphere can intersect the view frustum of a camera anywhere in a static cell.
+bool
+IsVisibleFromCell(const StaticCellView& view, const BoundingSphere& sphere)
 {
-    const size_t meshInstanceCount = CountMeshInstances(modelNodes);
-    std::vector<ShaderInterop::DrawIndirectParams> drawIndirectParams;
-    drawIndirectParams.reserve(meshInstanceCount);
+    const Vec3f toCenter = sphere.GetCenter() - view.Position;
+    const float distance = toCenter.Length();
 
-    for(const ModelNode& modelNode : modelNodes)
+    // Moving the camera within the cell is equivalent to growing the sphere by the cell's radius.
+    const float radius = sphere.GetRadius() + view.Radius;
+
+    if(distance <= radius)
     {
-        for(const MeshInstance& meshInstance : modelNode.GetMeshInstances())
-        {
-            const ShaderInterop::DrawIndirectParams drawParams //
-                {
-                    .IndexCount = meshInstance.GetIndexCount(),
-                    .InstanceCount = 1,
-                    .FirstIndex = meshInstance.GetFirstIndex(),
-                    .BaseVertex = meshInstance.GetBaseVertex(),
-                    .FirstInstance = narrow_cast<uint32_t>(drawIndirectParams.size()),
-                };
+        return true;
+    }
+
+    const float angle = std::acos(std::clamp(toCenter.Dot(view.Direction) / distance, -1.0f, 1.0f));
+
+    return angle <= view.HalfAngle + std::asin(radius / distance);
+}
+
+// Returns true if a mesh instance of a node is drawn by static bundles while they're in use.
+// Meshes split into meshlets are culled per meshlet each frame instead, as a bundle would have
+// to draw every meshlet that faces any camera position in its cell.
+bool
+IsBundled(const ModelNode& modelNode, const MeshInstance& meshInstance)
+{
+    return modelNode.IsStatic() && meshInstance.GetMesh()->GetMeshletCount() == 0;
+}
+
+// Returns the largest axis scale of a transform.
+float
+MaxAxisScale(const Mat44f& transform)
+{
+    return std::max({
+        Vec3f(transform[0].x, transform[0].y, transform[0].z).Length(),
+        Vec3f(transform[1].x, transform[1].y, transform[1].z).Length(),
+        Vec3f(transform[2].x, transform[2].y, transform[2].z).Length(),
+    });
+}
+
+// Transforms a bounding sphere to world space. Unlike Mat44f * BoundingSphere the radius is
+// scaled by the largest axis scale of the transform, which keeps occlusion tests conservative
+// for scaled nodes.
+BoundingSphere
+ToWorldSphere(const Mat44f& worldTransform, const BoundingSphere& sphere)
+{
+    const Vec4f center = worldTransform * sphere.GetCenter();
+
+    return BoundingSphere(Vec3f(center.x, center.y, center.z),
+        sphere.GetRadius() * MaxAxisScale(worldTransform));
+}
+
+// Calls emit(firstIndex, indexCount) for each run of adjacent meshlets that may be visible:
+// meshlets that face the viewer and, if testFrustum is set, intersect the frustum.
+// meshViewPosition is the viewer's position in mesh space. Returns the number of meshlets culled.
+template<typename EmitFunc>
+size_t
+CullMeshlets(const std::span<const Meshlet> meshlets,
+    const Frustum& frustum,
+    const Mat44f& worldTransform,
+    const Vec3f& meshViewPosition,
+    const bool testFrustum,
+    EmitFunc&& emit)
+{
+    auto isVisible = [&](const Meshlet& meshlet)
+    {
+        return !meshlet.IsBackFacing(meshViewPosition)
+            && (!testFrustum
+                || frustum.Contains(ToWorldSphere(worldTransform, meshlet.Bounds))
+                    != Frustum::ContainsResult::Outside);
+    };
+
+    return ::CullMeshlets(meshlets, isVisible, std::forward<EmitFunc>(emit));
+}
 
-            drawIndirectParams.push_back(drawParams);
+// Returns the coarsest LOD of a mesh whose simplification error stays within
+// kMaxLodErrorPixels on screen.
+// pixelsPerUnit is the number of pixels covered by one mesh space unit at the mesh's nearest
+// point to the camera.
+uint32_t
+SelectLod(const Mesh& mesh, const float pixelsPerUnit)
+{
+    for(uint32_t lod = mesh.GetLodCount() - 1; lod > 0; --lod)
+    {
+        if(mesh.GetLod(lod).Error * pixelsPerUnit <= kMaxLodErrorPixels)
+        {
+            return lod;
         }
     }
 
-    auto buffer = gpuHelper.CreateIndirectBuffer<GpuDrawIndirectBuffer>(drawIndirectParams.size(),
-        "DrawIndirectBuffer");
-    MLG_CHECK(buffer);
+    return 0;
+}
+
+// Returns the distance of a point in front of the near plane.
+float
+ViewDepth(const Frustum& frustum, const Vec3f& point)
+{
+    const Vec4f& nearPlane = frustum.GetNear();
+    return (nearPlane.x * point.x) + (nearPlane.y * point.y) + (nearPlane.z * point.z)
+        + nearPlane.w;
+}
 
-    buffer->Store(drawIndirectParams);
+uint64_t
+MakeSortKey(const MeshInstance& meshInstance, const float viewDepth)
+{
+    constexpr uint64_t kMaxDepthBucket = (uint64_t{ 1 } << kSortKeyDepthBits) - 1;
+    constexpr uint64_t kMaxTextureArray = (uint64_t{ 1 } << kSortKeyTextureArrayBits) - 1;
+    constexpr uint64_t kMaxPipeline = (uint64_t{ 1 } << kSortKeyPipelineBits) - 1;
+    constexpr uint64_t kMaxBlendDepth = (uint64_t{ 1 } << kSortKeyBlendDepthBits) - 1;
+
+    const uint64_t pipelineIndex =
+        (static_cast<uint64_t>(meshInstance.GetAlphaMode()) * kShaderVariantCount)
+        + static_cast<uint64_t>(meshInstance.GetShaderVariant());
+    static_assert((kAlphaModeCount * kShaderVariantCount) - 1 <= kMaxPipeline,
+        "Pipelines don't fit in sort key");
+
+    // The first index and index format uniquely identify a mesh's geometry. The format is the
+    // mesh field's top bit, so draws that otherwise sort together are grouped by index buffer.
+    constexpr unsigned kFirstIndexBits = kSortKeyMeshBits - 1;
+    static_assert(kIndexFormatCount <= 2, "Index formats don't fit in sort key");
+    MLG_ASSERT(meshInstance.GetFirstIndex() < (uint64_t{ 1 } << kFirstIndexBits),
+        "First index {} doesn't fit in sort key",
+        meshInstance.GetFirstIndex());
+
+    const uint64_t mesh =
+        (static_cast<uint64_t>(meshInstance.GetIndexFormat()) << kFirstIndexBits)
+        | meshInstance.GetFirstIndex();
+
+    if(meshInstance.GetAlphaMode() == AlphaMode::Blend)
+    {
+        // The bits of a non-negative float order the same as its value. The most significant
+        // bits are enough to order draws.
+        const uint32_t depthBits = std::bit_cast<uint32_t>(std::max(viewDepth, 0.0f));
+        const uint64_t blendDepth = kMaxBlendDepth - (depthBits >> (32 - kSortKeyBlendDepthBits));
+
+        return (pipelineIndex << (kSortKeyBlendDepthBits + kSortKeyMeshBits))
+            | (blendDepth << kSortKeyMeshBits)
+            | mesh;
+    }
 
-    return buffer;
+    // log2(1 + depth) gives buckets of 1, 2, 4, 8... units.
+    const float depthLog = std::log2(1.0f + std::max(viewDepth, 0.0f));
+    const uint64_t depthBucket = std::min(static_cast<uint64_t>(depthLog), kMaxDepthBucket);
+
+    const uint64_t textureArray = meshInstance.GetShaderVariant() == ShaderVariant::Textured
+        ? meshInstance.GetMaterialTexture().ArrayIndex
+        : 0;
+    MLG_ASSERT(textureArray <= kMaxTextureArray,
+        "Texture array {} doesn't fit in sort key",
+        textureArray);
+
+    return (pipelineIndex << (kSortKeyTextureArrayBits + kSortKeyDepthBits + kSortKeyMeshBits))
+        | ((textureArray & kMaxTextureArray) << (kSortKeyDepthBits + kSortKeyMeshBits))
+        | (depthBucket << kSortKeyMeshBits)
+        | mesh;
 }
 
-Result<GpuMeshPropertiesBuffer>
-BuildMeshPropertiesBuffer(GpuHelper& gpuHelper, const std::span<const ModelNode> modelNodes)
+// Returns true if two instances can be drawn by the same instanced draw: they draw the same
+// geometry with the same pipeline and, if textured, the same texture array. Instances of
+// different meshes can share geometry, e.g. after meshes are deduplicated, and their materials
+// and texture layers are read from per-instance mesh properties. Instances that can be batched
+// have equal sort keys, apart from the depth, so they end up adjacent.
+bool
+CanBatch(const MeshInstance& a, const MeshInstance& b)
 {
-    const size_t meshInstanceCount = CountMeshInstances(modelNodes);
-    std::vector<ShaderInterop::MeshProperties> meshProperties;
-    meshProperties.reserve(meshInstanceCount);
+    const bool isTextured = a.GetShaderVariant() == ShaderVariant::Textured;
+
+    return a.GetFirstIndex() == b.GetFirstIndex()
+        && a.GetIndexCount() == b.GetIndexCount()
+        && a.GetBaseVertex() == b.GetBaseVertex()
+        && a.GetIndexFormat() == b.GetIndexFormat()
+        && a.GetAlphaMode() == b.GetAlphaMode()
+        && a.GetShaderVariant() == b.GetShaderVariant()
+        && (!isTextured || a.GetMaterialTexture().ArrayIndex == b.GetMaterialTexture().ArrayIndex);
+}
 
-    uint32_t transformIndex = 0;
+// Groups runs of instances that draw the same index range into instanced draws. Draw
+// parameters and instance remapping are appended to the outputs, with draw and instance indices
+// offset by baseIndex. Returns the number of triangles drawn.
+size_t
+AppendDrawBatches(const std::span<const MeshInstance> meshInstances,
+    const uint32_t baseIndex,
+    std::vector<DrawBatch>& outDrawBatches,
+    std::vector<ShaderInterop::DrawIndirectParams>& outDrawIndirectParams,
+    std::vector<ShaderInterop::InstanceRemap>& outInstanceRemap)
+{
+    size_t triangleCount = 0;
 
-    for(const ModelNode& modelNode : modelNodes)
+    // Each run of instances becomes one indirect draw whose instances are mapped to their
+    // mesh properties via the instance remap buffer.
+    for(size_t i = 0; i < meshInstances.size();)
     {
-        for(const MeshInstance& meshInstance : modelNode.GetMeshInstances())
+        const MeshInstance& first = meshInstances[i];
+        const uint32_t firstInstance = narrow_cast<uint32_t>(outInstanceRemap.size());
+
+        for(; i < meshInstances.size() && CanBatch(meshInstances[i], first); ++i)
         {
-            const ShaderInterop::MeshProperties meshProps //
+            const ShaderInterop::InstanceRemap remap //
                 {
-                    .TransformIndex = transformIndex,
-                    // FIXME(KB) - reconcile material ID
-                    .MaterialIndex = narrow_cast<uint32_t>(meshInstance.GetMaterialId().GetValue()),
+                    .MeshInstanceIndex =
+                        narrow_cast<uint32_t>(meshInstances[i].GetInstanceIndex()),
                 };
 
-            meshProperties.push_back(meshProps);
+            outInstanceRemap.push_back(remap);
         }
 
-        ++transformIndex;
+        const ShaderInterop::DrawIndirectParams drawParams //
+            {
+                .IndexCount = first.GetIndexCount(),
+                .InstanceCount = narrow_cast<uint32_t>(outInstanceRemap.size()) - firstInstance,
+                .FirstIndex = first.GetFirstIndex(),
+                .BaseVertex = first.GetBaseVertex(),
+                .FirstInstance = baseIndex + firstInstance,
+            };
+
+        const DrawBatch drawBatch //
+            {
+                .AlphaMode = first.GetAlphaMode(),
+                .ShaderVariant = first.GetShaderVariant(),
+                .TextureArrayIndex = first.GetMaterialTexture().ArrayIndex,
+                .IndexFormat = first.GetIndexFormat(),
+                .DrawIndex = baseIndex + narrow_cast<uint32_t>(outDrawIndirectParams.size()),
+            };
+
+        outDrawBatches.push_back(drawBatch);
+        outDrawIndirectParams.push_back(drawParams);
+
+        triangleCount += size_t{ drawParams.IndexCount / 3 } * drawParams.InstanceCount;
     }
 
-    auto buffer = gpuHelper.CreateStorageBuffer<GpuMeshPropertiesBuffer>(meshProperties.size(),
-        "MeshPropertiesBuffer");
-    MLG_CHECK(buffer);
+    return triangleCount;
+}
+
+size_t
+CountMeshInstances(const std::span<const ModelNode> modelNodes)
+{
+    size_t count = 0;
 
-    buffer->Store(meshProperties);
+    for(const ModelNode& node : modelNodes)
+    {
+        count += node.GetModel()->GetMeshes().size();
+    }
 
-    return buffer;
+    return count;
 }
 
-Result<GpuColorPass::Outputs>
-CreateColorPassTarget(const GpuHelper& gpuHelper, const uint32_t width, const uint32_t height)
+// Returns the index of node in nodes, or nodes.size() if it isn't one of them.
+size_t
+IndexOfNode(const std::span<const ModelNode> nodes, const ModelNode& node)
 {
-    MLG_DEBUG("Creating new color/depth target with size {}x{}", width, height);
+    if(nodes.empty() || &node < nodes.data() || &node > &nodes.back())
+    {
+        return nodes.size();
+    }
+
+    return static_cast<size_t>(&node - nodes.data());
+}
 
-    auto renderTarget = gpuHelper.CreateRenderTarget(width, height, "ColorPass::RenderTarget");
-    MLG_CHECK(renderTarget, "Failed to create color render target");
+// Returns the top three rows of an affine transform.
+ShaderInterop::WorldTransform
+ToGpuWorldTransform(const Mat44f& transform)
+{
+    ShaderInterop::WorldTransform gpuTransform;
 
-    auto depthBuffer = gpuHelper.CreateDepthBuffer(width, height, "ColorPass::DepthBuffer");
-    MLG_CHECK(depthBuffer, "Failed to create color depth buffer");
+    for(size_t row = 0; row < 3; ++row)
+    {
+        gpuTransform.Rows[row] =
+            Vec4f(transform[0][row], transform[1][row], transform[2][row], transform[3][row]);
+    }
 
-    return GpuColorPass::Outputs //
-        {
-            .RenderTarget = *renderTarget,
-            .DepthBuffer = *depthBuffer,
-        };
+    return gpuTransform;
+}
+
+// Returns the inverse transpose of an affine transform's upper 3x3 as half floats.
+ShaderInterop::NormalMatrix
+ToGpuNormalMatrix(const Mat44f& transform)
+{
+    const Mat44f normalTransform = transform.InverseAffine().Transpose();
+
+    // Shaders normalize transformed normals, so the matrix is scaled to its largest element to
+    // keep it in half float range whatever the transform's scale.
+    float largest = 0;
+    for(size_t column = 0; column < 3; ++column)
+    {
+        const Vec4f& c = normalTransform[column];
+        largest = std::max({ largest, std::abs(c.x), std::abs(c.y), std::abs(c.z) });
+    }
+
+    const float normalize = largest > 0 ? 1 / largest : 1;
+
+    auto toHalf = [normalize](const float value) -> uint32_t
+    { return VertexQuantization::FloatToHalf(value * normalize); };
+
+    constexpr unsigned kHalfBits = 16;
+
+    ShaderInterop::NormalMatrix normalMatrix;
+
+    for(size_t column = 0; column < 3; ++column)
+    {
+        const Vec4f& c = normalTransform[column];
+        normalMatrix.Columns[column][0] = toHalf(c.x) | (toHalf(c.y) << kHalfBits);
+        normalMatrix.Columns[column][1] = toHalf(c.z);
+    }
+
+    return normalMatrix;
+}
+
+// Returns the capacity of a GPU array grown to hold at least requiredCount elements.
+// Capacity at least doubles to amortize the cost of reallocating and copying.
+size_t
+GrowCapacity(const size_t capacity, const size_t requiredCount)
+{
+    return std::max(requiredCount, capacity * 2);
+}
+
+// Returns true if a texture is missing or isn't the viewport's size.
+bool
+NeedsResize(const wgpu::Texture* texture, const Viewport& viewport)
+{
+    return !texture
+        || texture->GetWidth() != viewport.GetWidth()
+        || texture->GetHeight() != viewport.GetHeight();
+}
+
+// Returns the viewport at the origin with the width and height of viewport scaled by scale.
+Viewport
+ScaleViewport(const Viewport& viewport, const float scale)
+{
+    auto scaleSize = [scale](const uint32_t size)
+    {
+        const float scaled = std::round(static_cast<float>(size) * scale);
+        return std::max(1u, static_cast<uint32_t>(scaled));
+    };
+
+    return Viewport(Dimension2{ .Width = scaleSize(viewport.GetWidth()),
+        .Height = scaleSize(viewport.GetHeight()) });
+}
+
+// Returns true if compositing a color pass rendered at the viewport's size into dstRect of
+// target would copy it pixel for pixel, so the color pass can render into target directly.
+bool
+CompositeIsPlainCopy(const Viewport& viewport, const GpuRenderTarget& target, const Rect& dstRect)
+{
+    const wgpu::TextureFormat format = target->GetFormat();
+
+    // Formats that store the color pass's output as the offscreen target does, if swizzled.
+    const bool sameFormat =
+        format == GpuHelper::kTextureFormat || format == wgpu::TextureFormat::BGRA8Unorm;
+
+    const bool renderable =
+        (target->GetUsage() & wgpu::TextureUsage::RenderAttachment) != wgpu::TextureUsage::None;
+
+    const Rect targetRect({ .X = 0,
+        .Y = 0,
+        .Width = target->GetWidth(),
+        .Height = target->GetHeight() });
+
+    return sameFormat
+        && renderable
+        && dstRect == targetRect
+        && viewport.GetX() == 0
+        && viewport.GetY() == 0
+        && !NeedsResize(&target.Get(), viewport);
 }
 } // namespace
 
@@ -129,35 +538,63 @@ Scene::Create(
     auto gpuTransformPassResult = GpuTransformPass::Create(gpuHelper, fileFetcher);
     MLG_CHECK(gpuTransformPassResult, "Failed to create GpuTransformPass");
 
-    auto transformBuffer = gpuHelper.CreateStorageBuffer<GpuWorldTransformBuffer>(modelNodes.size(),
-        "WorldTransforms");
+    // GPU arrays start out big enough for the initial nodes and grow as nodes are added.
+    const size_t nodeCapacity = std::max(modelNodes.size(), kMinNodeCapacity);
+    const size_t meshCapacity = std::max(CountMeshInstances(modelNodes), kMinMeshCapacity);
+
+    auto transformBuffer =
+        gpuHelper.CreateStorageBuffer<GpuWorldTransformBuffer>(nodeCapacity, "WorldTransforms");
     MLG_CHECK(transformBuffer);
 
     auto clipSpaceBuffer =
-        gpuHelper.CreateStorageBuffer<GpuClipSpaceBuffer>(modelNodes.size(), "ClipSpaceTransforms");
+        gpuHelper.CreateStorageBuffer<GpuClipSpaceBuffer>(nodeCapacity, "ClipSpaceTransforms");
     MLG_CHECK(clipSpaceBuffer);
 
-    auto drawIndirectBuffer = BuildDrawIndirectBuffer(gpuHelper, modelNodes);
+    auto normalMatrixBuffer =
+        gpuHelper.CreateStorageBuffer<GpuNormalMatrixBuffer>(nodeCapacity, "NormalMatrices");
+    MLG_CHECK(normalMatrixBuffer);
+
+    // Draw parameters and instance remapping are rebuilt each frame from the visible set.
+    // In the worst case every visible mesh instance ends up in its own draw.
+    auto drawIndirectBuffer =
+        gpuHelper.CreateIndirectBuffer<GpuDrawIndirectBuffer>(meshCapacity, "DrawIndirectBuffer");
     MLG_CHECK(drawIndirectBuffer);
 
-    auto meshPropertiesBuffer = BuildMeshPropertiesBuffer(gpuHelper, modelNodes);
+    auto instanceRemapBuffer =
+        gpuHelper.CreateStorageBuffer<GpuInstanceRemapBuffer>(meshCapacity, "InstanceRemap");
+    MLG_CHECK(instanceRemapBuffer);
+
+    auto meshPropertiesBuffer =
+        gpuHelper.CreateStorageBuffer<GpuMeshPropertiesBuffer>(meshCapacity, "MeshProperties");
     MLG_CHECK(meshPropertiesBuffer);
 
     auto cameraParamsBuf = gpuHelper.CreateUniformBuffer<GpuCameraParamsBuffer>(1, "CameraParams");
     MLG_CHECK(cameraParamsBuf);
 
     Scene scene(gpuHelper,
-        modelNodes,
         std::move(*gpuColorPassResult),
         std::move(*gpuCompositorPassResult),
         std::move(*gpuTransformPassResult),
         std::move(*transformBuffer),
         std::move(*clipSpaceBuffer),
+        std::move(*normalMatrixBuffer),
         std::move(*drawIndirectBuffer),
         std::move(*meshPropertiesBuffer),
+        std::move(*instanceRemapBuffer),
         std::move(*cameraParamsBuf));
 
-    MLG_CHECK(scene.SyncToGpu());
+    if(gpuHelper.GetDevice().HasFeature(wgpu::FeatureName::TimestampQuery))
+    {
+        auto frameTimer = GpuFrameTimer::Create(gpuHelper.GetInstance(), gpuHelper.GetDevice());
+        MLG_CHECK(frameTimer);
+
+        scene.m_FrameTimer = std::move(*frameTimer);
+    }
+
+    for(const ModelNode& modelNode : modelNodes)
+    {
+        MLG_CHECK(scene.AddNode(modelNode));
+    }
 
     MLG_INFO("Scene created in {} ms", createTimer.GetElapsedSeconds() * 1000);
 
@@ -165,94 +602,97 @@ Scene::Create(
 }
 
 Scene::Scene(const GpuHelper& gpuHelper,
-    const std::span<const ModelNode> modelNodes,
     GpuColorPass&& colorPass,
     GpuCompositorPass&& compositorPass,
     GpuTransformPass&& transformPass,
     GpuWorldTransformBuffer&& worldTransformBuffer,
     GpuClipSpaceBuffer&& clipSpaceBuffer,
+    GpuNormalMatrixBuffer&& normalMatrixBuffer,
     GpuDrawIndirectBuffer&& drawIndirectBuffer,
     GpuMeshPropertiesBuffer&& meshPropertiesBuffer,
+    GpuInstanceRemapBuffer&& instanceRemapBuffer,
     GpuCameraParamsBuffer&& cameraParamsBuffer)
     : m_GpuHelper(&gpuHelper),
-      m_ModelNodes(modelNodes),
+      m_RenderTargetPool(gpuHelper),
       m_ColorPass(std::move(colorPass)),
       m_CompositorPass(std::move(compositorPass)),
       m_TransformPass(std::move(transformPass)),
       m_WorldTransformBuffer(std::move(worldTransformBuffer)),
       m_ClipSpaceBuffer(std::move(clipSpaceBuffer)),
+      m_NormalMatrixBuffer(std::move(normalMatrixBuffer)),
       m_DrawIndirectBuffer(std::move(drawIndirectBuffer)),
       m_MeshPropertiesBuffer(std::move(meshPropertiesBuffer)),
+      m_InstanceRemapBuffer(std::move(instanceRemapBuffer)),
       m_CameraParamsBuffer(std::move(cameraParamsBuffer))
 {
-    const size_t meshInstanceCount = CountMeshInstances(m_ModelNodes);
+    const size_t meshInstanceCount = m_MeshPropertiesBuffer.Count();
+    m_Nodes.reserve(m_WorldTransformBuffer.Count());
     m_VisibleMeshes.reserve(meshInstanceCount);
+    m_VisibleMeshTransformSlots.reserve(meshInstanceCount);
+    m_SortedMeshes.reserve(meshInstanceCount);
+    m_SortItems.reserve(meshInstanceCount);
+    m_SortScratch.reserve(meshInstanceCount);
+    m_DrawBatches.reserve(meshInstanceCount);
+    m_DrawIndirectParams.reserve(meshInstanceCount);
+    m_InstanceRemap.reserve(meshInstanceCount);
 }
 
 Result<>
 Scene::Render(const Camera& camera, const TrTransformf& cameraXForm, const PropKit& propKit)
 {
-    MLG_SCOPED_TIMER("Scene.Render");
-
-    MLG_CHECK(SyncToGpu());
-
-    const wgpu::Device& gpuDevice = m_GpuHelper->GetDevice();
-
-    const wgpu::CommandEncoderDescriptor encoderDesc = { .label = "Renderer::Render" };
-    const wgpu::CommandEncoder cmdEncoder = gpuDevice.CreateCommandEncoder(&encoderDesc);
-    MLG_CHECK(cmdEncoder, "Failed to create command encoder");
-
-    auto transformNodesResult = TransformNodes(gpuDevice, cmdEncoder, cameraXForm, camera);
-    MLG_CHECK(transformNodesResult);
-
     const Viewport& viewport = camera.GetViewport();
 
-    if(!m_ColorPassOutputs
-        || m_ColorPassOutputs->RenderTarget->GetWidth() != viewport.GetWidth()
-        || m_ColorPassOutputs->RenderTarget->GetHeight() != viewport.GetHeight())
-    {
-        auto colorPassOutputs =
-            CreateColorPassTarget(*m_GpuHelper, viewport.GetWidth(), viewport.GetHeight());
-        MLG_CHECK(colorPassOutputs);
-
-        m_ColorPassOutputs = std::move(*colorPassOutputs);
-    }
-
-    const GpuColorPass::Inputs colorPassInputs //
+    const View view //
         {
-            .Viewport = viewport,
-            .Vertices = propKit.GetVertexBuffer(),
-            .Indices = propKit.GetIndexBuffer(),
-            .WorldTransforms = m_WorldTransformBuffer,
-            .ClipSpaceTransforms = m_ClipSpaceBuffer,
-            .MeshProperties = m_MeshPropertiesBuffer,
-            .MaterialConstants = propKit.GetMaterialConstants(),
-            .CameraParams = m_CameraParamsBuffer,
-            .DrawIndirectBuffer = m_DrawIndirectBuffer,
+            .ViewCamera = &camera,
+            .CameraXForm = cameraXForm,
+            .Target = nullptr,
+            .DstRect = Rect(
+                { .X = 0, .Y = 0, .Width = viewport.GetWidth(), .Height = viewport.GetHeight() }),
         };
 
-    MLG_CHECK(m_ColorPass.SetInputs(colorPassInputs));
-    MLG_CHECK(m_ColorPass.SetOutputs(*m_ColorPassOutputs));
-
-    auto invocation = m_ColorPass.Prepare(cmdEncoder);
-    MLG_CHECK(invocation);
+    return RenderFrame(std::span<const View>(&view, 1), propKit);
+}
 
-    m_VisibleMeshes.clear();
-    const Frustum frustum(camera, cameraXForm);
-    CollectVisibleMeshes(frustum, m_VisibleMeshes);
-    std::ranges::sort(m_VisibleMeshes, {}, &MeshInstance::GetMaterialId);
+Result<>
+Scene::Render(const Camera& camera,
+    const TrTransformf& cameraXForm,
+    const PropKit& propKit,
+    const GpuRenderTarget& target,
+    const Rect& dstRect)
+{
+    const View view //
+        {
+            .ViewCamera = &camera,
+            .CameraXForm = cameraXForm,
+            .Target = &target,
+            .DstRect = dstRect,
+        };
 
-    MLG_CHECK(invocation->Execute(m_VisibleMeshes, propKit));
+    return RenderFrame(std::span<const View>(&view, 1), propKit);
+}
 
-    const wgpu::CommandBuffer cmdBuf = cmdEncoder.Finish(nullptr);
-    MLG_CHECK(cmdBuf, "Failed to finish command buffer");
+Result<>
+Scene::Render(const Camera& camera,
+    const TrTransformf& cameraXForm,
+    const PropKit& propKit,
+    const GpuRenderTarget& target)
+{
+    const Rect dstRect(
+        { .X = 0, .Y = 0, .Width = target->GetWidth(), .Height = target->GetHeight() });
 
-    const wgpu::Queue queue = gpuDevice.GetQueue();
-    MLG_CHECK(queue, "Failed to get wgpu::Queue");
+    return Render(camera, cameraXForm, propKit, target, dstRect);
+}
 
-    queue.Submit(1, &cmdBuf);
+Result<>
+Scene::RenderViews(const std::span<const View> views, const PropKit& propKit)
+{
+    for(const View& view : views)
+    {
+        MLG_CHECKV(view.Target, "Views must have a target");
+    }
 
-    return Result<>::Ok;
+    return RenderFrame(views, propKit);
 }
 
 Result<>
@@ -267,21 +707,9 @@ Scene::Composite(const GpuRenderTarget& target)
 Result<>
 Scene::Composite(const GpuRenderTarget& target, const Rect& dstRect)
 {
-    MLG_CHECKV(m_ColorPassOutputs, "Color pass outputs are not valid");
-
-    const GpuCompositorPass::Inputs inputs //
-        {
-            .DstRect = dstRect,
-            .Texture = m_ColorPassOutputs->RenderTarget.Get(),
-        };
-
-    const GpuCompositorPass::Outputs outputs //
-        {
-            .RenderTarget = target,
-        };
+    MLG_CHECKV(m_OffscreenTarget, "Scene was not rendered offscreen");
 
-    MLG_CHECK(m_CompositorPass.SetInputs(inputs));
-    MLG_CHECK(m_CompositorPass.SetOutputs(outputs));
+    MLG_CHECK(SetCompositorTargets(*m_OffscreenTarget, target, dstRect, true));
 
     auto pass = m_CompositorPass.Prepare();
     MLG_CHECK(pass, "Failed to begin compositor pass");
@@ -291,99 +719,1323 @@ Scene::Composite(const GpuRenderTarget& target, const Rect& dstRect)
     return Result<>::Ok;
 }
 
-// private:
-
 void
-Scene::CollectVisibleMeshes(const Frustum& frustum,
-    std::vector<MeshInstance>& outVisibleMeshes) const
+Scene::SetOcclusionCullingEnabled(const bool enabled, ThreadPool* threadPool)
 {
-    static PerfCounter pcTotalMeshes({ .Name = "Scene.Meshes.Total" });
-    static PerfCounter pcVisibleMeshes({ .Name = "Scene.Meshes.Visible" });
-
-    outVisibleMeshes.clear();
-
-    size_t totalMeshes = 0;
-
-    for(const ModelNode& modelNode : m_ModelNodes)
+    if(enabled)
     {
-        totalMeshes += modelNode.GetMeshInstances().size();
-
-        if(!modelNode.IsVisible())
+        if(!m_OcclusionCuller)
         {
-            continue;
+            m_OcclusionCuller.emplace(OcclusionCuller::kDefaultWidth,
+                OcclusionCuller::kDefaultHeight);
         }
+    }
+    else
+    {
+        m_OcclusionCuller.reset();
+    }
 
-        const BoundingSphere& modelBs =
-            modelNode.GetWorldTransform() * modelNode.GetBoundingSphere();
-
-        const Frustum::ContainsResult result = frustum.Contains(modelBs);
-
-        if(result == Frustum::ContainsResult::Intersects)
-        {
-            // Model intersects frustum, check each mesh instance.
+    m_ThreadPool = threadPool;
+}
 
-            for(const MeshInstance& meshInstance : modelNode.GetMeshInstances())
-            {
-                const BoundingSphere& meshBs =
-                    modelNode.GetWorldTransform() * meshInstance.GetBoundingSphere();
+void
+Scene::SetDepthPrepassEnabled(const bool enabled)
+{
+    if(enabled != m_ColorPass.IsDepthPrepassEnabled())
+    {
+        m_ColorPass.SetDepthPrepassEnabled(enabled);
 
-                if(Frustum::ContainsResult::Outside == frustum.Contains(meshBs))
-                {
-                    continue;
-                }
+        // Bundles captured the color pipeline and lack depth prepass draws.
+        InvalidateStaticBundles();
+    }
+}
 
-                outVisibleMeshes.push_back(meshInstance);
-            }
-        }
-        else if(result == Frustum::ContainsResult::Inside)
-        {
-            // Model is fully inside frustum, add all mesh instances.
+void
+Scene::SetFusedTransformsEnabled(const bool enabled)
+{
+    if(enabled != m_ColorPass.IsFusedTransformsEnabled())
+    {
+        m_ColorPass.SetFusedTransformsEnabled(enabled);
 
-            for(const MeshInstance& meshInstance : modelNode.GetMeshInstances())
-            {
-                outVisibleMeshes.push_back(meshInstance);
-            }
-        }
-        else
-        {
-            // Model is fully outside frustum, skip all mesh instances.
-            continue;
-        }
+        // Bundles captured the color pipelines.
+        InvalidateStaticBundles();
     }
-
-    pcTotalMeshes.Increment(totalMeshes);
-    pcVisibleMeshes.Increment(outVisibleMeshes.size());
 }
 
-Result<>
-Scene::SyncToGpu()
+void
+Scene::SetNormalMatricesEnabled(const bool enabled)
 {
-    // Brute force copy everything for now.
-    uint64_t bufferOffset = 0;
-    for(const ModelNode& modelNode : m_ModelNodes)
+    if(enabled != m_ColorPass.IsNormalMatricesEnabled())
     {
-        const ShaderInterop::WorldTransform transform{ .Transform = modelNode.GetWorldTransform() };
-        m_GpuHelper->GetDevice().GetQueue().WriteBuffer(m_WorldTransformBuffer.GetGpuBuffer(),
-            bufferOffset,
-            &transform,
-            sizeof(transform));
+        m_ColorPass.SetNormalMatricesEnabled(enabled);
 
-        bufferOffset += sizeof(transform);
+        // Bundles captured the color pipelines.
+        InvalidateStaticBundles();
     }
-
-    return Result<>::Ok;
 }
 
-Result<>
-Scene::TransformNodes(const wgpu::Device& gpuDevice,
-    const wgpu::CommandEncoder& cmdEncoder,
-    const TrTransformf& cameraXForm,
-    const Camera& camera)
+void
+Scene::SetResolutionScale(const float scale)
 {
-    // Use inverse of camera transform as view matrix
-    const Mat44f viewMat = cameraXForm.Inverse().ToMatrix();
-    const Mat44f& projMat = camera.GetProjectionMatrix();
-    const Mat44f viewProjMat = projMat.Mul(viewMat);
+    MLG_ASSERT(scale > 0 && scale <= 1, "Resolution scale must be in (0, 1]: {}", scale);
+
+    m_ResolutionScale = scale;
+}
+
+void
+Scene::SetTransformSnapshots(const TransformSnapshotBuffer* snapshots,
+    const std::span<const ModelNode> modelNodes)
+{
+    MLG_ASSERT(!snapshots || snapshots->GetCount() == modelNodes.size(),
+        "Snapshots don't match the model nodes");
+
+    m_TransformSnapshots = snapshots;
+    m_SnapshotNodes = snapshots ? modelNodes : std::span<const ModelNode>();
+}
+
+Result<>
+Scene::AddNode(const ModelNode& modelNode)
+{
+    MLG_CHECKV(!m_NodeIndices.contains(&modelNode), "Node is already in the scene");
+
+    m_NodeIndices.emplace(&modelNode, m_Nodes.size());
+
+    SceneNode& node = m_Nodes.emplace_back(SceneNode //
+        {
+            .Node = &modelNode,
+            .TransformSlot = m_TransformSlots.Allocate(),
+            .MeshSlots = {},
+            .HasMeshlets = std::ranges::any_of(modelNode.GetMeshInstances(),
+                [](const MeshInstance& meshInstance)
+                { return meshInstance.GetMesh()->GetMeshletCount() > 0; }),
+        });
+
+    node.MeshSlots.reserve(modelNode.GetMeshInstances().size());
+
+    for(const MeshInstance& meshInstance : modelNode.GetMeshInstances())
+    {
+        // PropKit quantizes vertices relative to the mesh's bounds.
+        const PositionQuantization quantization =
+            PositionQuantization::FromBounds(meshInstance.GetBoundingBox());
+
+        const PendingMeshProperties pending //
+            {
+                .Slot = m_MeshSlots.Allocate(),
+                .Properties =
+                {
+                    .TransformIndex = node.TransformSlot,
+                    // FIXME(KB) - reconcile material ID
+                    .MaterialIndex = narrow_cast<uint32_t>(meshInstance.GetMaterialId().GetValue()),
+                    .TextureLayer = meshInstance.GetMaterialTexture().Layer,
+                    .PositionOffset = quantization.Offset,
+                    .PositionScale = quantization.Scale,
+                },
+            };
+
+        node.MeshSlots.push_back(pending.Slot);
+        m_PendingMeshProperties.push_back(pending);
+    }
+
+    if(modelNode.IsStatic())
+    {
+        m_StaticMeshInstanceCount += narrow_cast<uint32_t>(node.MeshSlots.size());
+        InvalidateStaticBundles(modelNode);
+    }
+
+    return Result<>::Ok;
+}
+
+Result<>
+Scene::RemoveNode(const ModelNode& modelNode)
+{
+    auto it = m_NodeIndices.find(&modelNode);
+    MLG_CHECKV(it != m_NodeIndices.end(), "Node is not in the scene");
+
+    const size_t index = it->second;
+    m_NodeIndices.erase(it);
+
+    SceneNode& node = m_Nodes[index];
+
+    m_TransformSlots.Free(node.TransformSlot);
+
+    for(const uint32_t meshSlot : node.MeshSlots)
+    {
+        m_MeshSlots.Free(meshSlot);
+    }
+
+    if(modelNode.IsStatic())
+    {
+        m_StaticMeshInstanceCount -= narrow_cast<uint32_t>(node.MeshSlots.size());
+        InvalidateStaticBundles(modelNode);
+    }
+
+    // Keep nodes dense by moving the last node into the removed node's place.
+    if(index != m_Nodes.size() - 1)
+    {
+        node = std::move(m_Nodes.back());
+        m_NodeIndices[node.Node] = index;
+    }
+
+    m_Nodes.pop_back();
+
+    return Result<>::Ok;
+}
+
+void
+Scene::InvalidateStaticBundles()
+{
+    m_StaticBundles.clear();
+    m_StaticRegionEnd = 0;
+}
+
+// private:
+
+void
+Scene::InvalidateStaticBundles(const ModelNode& modelNode)
+{
+    static PerfCounter pcInvalidatedBundles({ .Name = "Scene.StaticBundle.Invalidated" });
+
+    // Static nodes don't move, so this is the transform their bundles were recorded with.
+    const BoundingSphere worldBs =
+        ToWorldSphere(modelNode.GetWorldTransform(), modelNode.GetBoundingSphere());
+
+    // Bundles of cells the node can't be seen from neither draw it nor need to. Each bundle's
+    // region holds as many draws as it was recorded with, however the static nodes change.
+    const size_t invalidatedCount = std::erase_if(m_StaticBundles,
+        [&worldBs](const auto& entry)
+        {
+            const auto& [cell, staticBundle] = entry;
+
+            const StaticCellView view = MakeStaticCellView(cell.X,
+                cell.Y,
+                cell.Z,
+                staticBundle.Direction,
+                cell.HalfAngle);
+
+            return IsVisibleFromCell(view, worldBs);
+        });
+
+    pcInvalidatedBundles.Increment(invalidatedCount);
+}
+
+Result<>
+Scene::RenderFrame(const std::span<const View> views, const PropKit& propKit)
+{
+    MLG_SCOPED_TIMER("Scene.Render");
+
+    static PerfCounter pcViews({ .Name = "Scene.Views" });
+
+    MLG_CHECKV(!views.empty() && views.size() <= kMaxViews,
+        "View count must be 1 to {}: {}",
+        kMaxViews,
+        views.size());
+
+    const wgpu::Device& gpuDevice = m_GpuHelper->GetDevice();
+
+    const wgpu::CommandEncoderDescriptor encoderDesc = { .label = "Renderer::Render" };
+    const wgpu::CommandEncoder cmdEncoder = gpuDevice.CreateCommandEncoder(&encoderDesc);
+    MLG_CHECK(cmdEncoder, "Failed to create command encoder");
+
+    if(m_FrameTimer)
+    {
+        m_FrameTimer->BeginFrame(cmdEncoder);
+    }
+
+    CaptureWorldTransforms();
+
+    MLG_CHECK(SyncToGpu(cmdEncoder));
+
+    m_RenderTargetPool.NextFrame();
+
+    ++m_FrameIndex;
+
+    m_ViewCameras.clear();
+    m_ViewFrusta.clear();
+
+    for(const View& view : views)
+    {
+        // Keeps the camera's projection, so the scene covers the same view at the lower
+        // resolution.
+        Camera& renderCamera = m_ViewCameras.emplace_back(*view.ViewCamera);
+
+        if(m_ResolutionScale < 1)
+        {
+            renderCamera.SetViewport(
+                ScaleViewport(view.ViewCamera->GetViewport(), m_ResolutionScale));
+        }
+
+        m_ViewFrusta.emplace_back(renderCamera, view.CameraXForm);
+    }
+
+    // Static meshes are replayed from a render bundle unless they need to be occlusion culled
+    // each frame. Static meshes split into meshlets are always meshlet culled each frame.
+    const bool useStaticBundles = !m_OcclusionCuller && m_StaticMeshInstanceCount > 0;
+
+    CullNodes(m_ViewFrusta, useStaticBundles);
+
+    // When compositing would only copy the offscreen target, views render straight into their
+    // targets. Static bundles and color pipelines are recorded for one color format, so a view
+    // only renders directly if its target has the format every other view renders to.
+    std::array<bool, kMaxViews> directViews{};
+    for(uint32_t viewIndex = 0; viewIndex < views.size(); ++viewIndex)
+    {
+        const View& view = views[viewIndex];
+
+        directViews[viewIndex] = view.Target
+            && m_ResolutionScale == 1
+            && CompositeIsPlainCopy(view.ViewCamera->GetViewport(), *view.Target, view.DstRect);
+    }
+
+    const auto directSpan = std::span(directViews).first(views.size());
+
+    bool anyOffscreen = !std::ranges::all_of(directSpan, std::identity{});
+
+    if(!anyOffscreen)
+    {
+        const wgpu::TextureFormat format = (*views.front().Target)->GetFormat();
+
+        anyOffscreen = std::ranges::any_of(views,
+            [format](const View& view) { return (*view.Target)->GetFormat() != format; });
+    }
+
+    if(anyOffscreen)
+    {
+        for(uint32_t viewIndex = 0; viewIndex < views.size(); ++viewIndex)
+        {
+            directViews[viewIndex] = directViews[viewIndex]
+                && (*views[viewIndex].Target)->GetFormat() == GpuHelper::kTextureFormat;
+        }
+    }
+    else
+    {
+        // The pool releases the offscreen target once it has been idle for a while.
+        m_OffscreenTarget.reset();
+    }
+
+    // Views are recorded one after another, so they can share the scene's GPU buffers and
+    // pooled textures.
+    for(uint32_t viewIndex = 0; viewIndex < views.size(); ++viewIndex)
+    {
+        const View& view = views[viewIndex];
+
+        // Views composited into a target after the first keep what earlier views drew there.
+        const bool clearTarget = !view.Target
+            || std::ranges::none_of(views.first(viewIndex),
+                [&view](const View& other)
+                { return other.Target && *other.Target == *view.Target; });
+
+        MLG_CHECK(RenderView(cmdEncoder,
+            view,
+            viewIndex,
+            directViews[viewIndex],
+            clearTarget,
+            useStaticBundles,
+            propKit));
+    }
+
+    pcViews.Increment(views.size());
+
+    if(m_FrameTimer)
+    {
+        m_FrameTimer->EndFrame(cmdEncoder);
+    }
+
+    const wgpu::CommandBuffer cmdBuf = cmdEncoder.Finish(nullptr);
+    MLG_CHECK(cmdBuf, "Failed to finish command buffer");
+
+    MLG_CHECK(m_GpuHelper->GetUploadRing().Submit(cmdBuf));
+
+    if(m_FrameTimer)
+    {
+        m_FrameTimer->ReadBack();
+    }
+
+    return Result<>::Ok;
+}
+
+Result<>
+Scene::RenderView(const wgpu::CommandEncoder& cmdEncoder,
+    const View& view,
+    const uint32_t viewIndex,
+    const bool isDirect,
+    const bool clearTarget,
+    const bool useStaticBundles,
+    const PropKit& propKit)
+{
+    static PerfCounter pcDirect({ .Name = "Scene.DirectRenders" });
+    static PerfCounter pcCulledPasses({ .Name = "Scene.RenderGraph.CulledPasses" });
+
+    const Camera& renderCamera = m_ViewCameras[viewIndex];
+    const Frustum& frustum = m_ViewFrusta[viewIndex];
+    const TrTransformf& cameraXForm = view.CameraXForm;
+    const GpuRenderTarget* target = view.Target;
+
+    const Viewport& viewport = renderCamera.GetViewport();
+    const Dimension2 viewportSize{ .Width = viewport.GetWidth(), .Height = viewport.GetHeight() };
+
+    MLG_CHECK(UploadCameraParams(cmdEncoder, cameraXForm, renderCamera));
+
+    GraphFrame frame //
+        {
+            .Owner = this,
+            .CmdEncoder = &cmdEncoder,
+            .Props = &propKit,
+            .Bundle = nullptr,
+            .SceneColor = nullptr,
+            .Target = target,
+            .DstRect = &view.DstRect,
+            .ClearTarget = clearTarget,
+        };
+
+    m_RenderGraph.Clear();
+
+    const RenderGraph::ResourceDesc colorDesc //
+        {
+            .Type = RenderGraph::ResourceType::ColorTarget,
+            .Dimensions = viewportSize,
+        };
+
+    const RenderGraph::ResourceHandle clipSpace = m_RenderGraph.Import("ClipSpaceTransforms",
+        { .Type = RenderGraph::ResourceType::Buffer, .ByteSize = m_ClipSpaceBuffer.BufferSize() });
+
+    const RenderGraph::ResourceHandle depth = m_RenderGraph.CreateTransient("DepthBuffer",
+        { .Type = RenderGraph::ResourceType::DepthTarget, .Dimensions = viewportSize });
+
+    const RenderGraph::ResourceHandle sceneColor = isDirect
+        ? m_RenderGraph.Import("Target", colorDesc)
+        : m_RenderGraph.CreateTransient("SceneColor", colorDesc);
+
+    m_RenderGraph.AddPass<&Scene::ExecuteTransformPass>("Transform", &frame).Write(clipSpace);
+
+    RenderGraph::PassBuilder colorPass =
+        m_RenderGraph.AddPass<&Scene::ExecuteColorPass>("Color", &frame);
+    colorPass.Write(depth).Write(sceneColor);
+
+    // With fused transforms the color pass computes clip space positions itself, and the
+    // transform pass is culled.
+    if(!m_ColorPass.IsFusedTransformsEnabled())
+    {
+        colorPass.Read(clipSpace);
+    }
+
+    if(target && !isDirect)
+    {
+        const RenderGraph::ResourceDesc targetDesc //
+            {
+                .Type = RenderGraph::ResourceType::ColorTarget,
+                .Dimensions = { .Width = (*target)->GetWidth(), .Height = (*target)->GetHeight() },
+            };
+
+        const RenderGraph::ResourceHandle targetHandle =
+            m_RenderGraph.Import("Target", targetDesc);
+
+        m_RenderGraph.AddPass<&Scene::ExecuteCompositePass>("Composite", &frame)
+            .Read(sceneColor)
+            .Write(targetHandle);
+
+        m_RenderGraph.MarkOutput(targetHandle);
+    }
+    else
+    {
+        m_RenderGraph.MarkOutput(sceneColor);
+    }
+
+    MLG_CHECK(m_RenderGraph.Compile(), "Failed to compile render graph");
+
+    pcCulledPasses.Increment(
+        m_RenderGraph.GetPassCount() - m_RenderGraph.GetExecutionOrder().size());
+
+    auto depthBuffer = GetPooledDepthBuffer(depth);
+    MLG_CHECK(depthBuffer, "Failed to create color depth buffer");
+
+    if(isDirect)
+    {
+        frame.SceneColor = target;
+
+        pcDirect.Increment(1);
+    }
+    else
+    {
+        auto renderTarget = GetPooledRenderTarget(sceneColor);
+        MLG_CHECK(renderTarget, "Failed to create color render target");
+
+        m_OffscreenTarget = std::move(*renderTarget);
+        frame.SceneColor = &*m_OffscreenTarget;
+    }
+
+    const GpuRenderTarget& colorTarget = *frame.SceneColor;
+
+    if(colorTarget->GetFormat() != m_ColorFormat)
+    {
+        // Bundles can only be executed in passes with the color format they were recorded for.
+        m_ColorFormat = colorTarget->GetFormat();
+        InvalidateStaticBundles();
+    }
+
+    m_VisibleMeshes.clear();
+
+    // Pixels covered by one world space unit at a distance of one unit from the camera.
+    const float lodScale = static_cast<float>(viewport.GetHeight())
+        / (2 * std::tan(renderCamera.GetFov().GetValue() * 0.5f));
+
+    CollectVisibleMeshes(frustum,
+        viewIndex,
+        cameraXForm.T,
+        lodScale,
+        useStaticBundles,
+        propKit,
+        m_VisibleMeshes,
+        m_VisibleMeshTransformSlots,
+        m_SortItems);
+
+    if(m_OcclusionCuller)
+    {
+        CullOccludedMeshes(renderCamera, cameraXForm, propKit);
+    }
+
+    SortVisibleMeshes();
+
+    // Meshlet culling can split a mesh instance into several visible meshes, each at most one
+    // draw and one instance, so the draw arrays are sized for this view before the color pass
+    // captures them. There's also room for a static bundle recorded for this view.
+    const uint32_t bundleCount = useStaticBundles ? m_StaticMeshInstanceCount : 0;
+    MLG_CHECK(GrowDrawBuffers(size_t{ m_StaticRegionEnd } + bundleCount + m_VisibleMeshes.size()));
+
+    const GpuColorPass::Inputs colorPassInputs //
+        {
+            .Viewport = viewport,
+            .Vertices = propKit.GetVertexBuffer(),
+            .Indices = propKit.GetIndexBuffer(),
+            .Indices16 = propKit.GetIndex16Buffer(),
+            .WorldTransforms = m_WorldTransformBuffer,
+            .ClipSpaceTransforms = m_ClipSpaceBuffer,
+            .NormalMatrices = m_NormalMatrixBuffer,
+            .MeshProperties = m_MeshPropertiesBuffer,
+            .InstanceRemap = m_InstanceRemapBuffer,
+            .MaterialConstants = propKit.GetMaterialConstants(),
+            .CameraParams = m_CameraParamsBuffer,
+            .DrawIndirectBuffer = m_DrawIndirectBuffer,
+        };
+
+    // Inputs are needed to record static bundles.
+    MLG_CHECK(m_ColorPass.SetInputs(colorPassInputs));
+    MLG_CHECK(m_ColorPass.SetOutputs(
+        GpuColorPass::Outputs{ .RenderTarget = colorTarget, .DepthBuffer = *depthBuffer }));
+
+    const StaticBundle* staticBundle = nullptr;
+
+    if(useStaticBundles)
+    {
+        auto staticBundleResult =
+            GetStaticBundle(cmdEncoder, renderCamera, cameraXForm, lodScale, propKit);
+        MLG_CHECK(staticBundleResult);
+
+        staticBundle = *staticBundleResult;
+    }
+
+    // Dynamic draws follow the static region, and their parameters are copied into place before
+    // the color pass begins.
+    MLG_CHECK(BuildDrawBatches(cmdEncoder, m_VisibleMeshes, m_StaticRegionEnd));
+
+    frame.Bundle = staticBundle;
+
+    return m_RenderGraph.Execute();
+}
+
+size_t
+Scene::StaticCellHash::operator()(const StaticCell& cell) const
+{
+    size_t hash = std::hash<int32_t>{}(cell.X);
+
+    for(const uint32_t value : { static_cast<uint32_t>(cell.Y),
+            static_cast<uint32_t>(cell.Z),
+            cell.Direction,
+            std::bit_cast<uint32_t>(cell.LodScale),
+            std::bit_cast<uint32_t>(cell.HalfAngle) })
+    {
+        hash = (hash * 31) + value;
+    }
+
+    return hash;
+}
+
+void
+Scene::CullNodes(const std::span<const Frustum> frusta, const bool useStaticBundles)
+{
+    MLG_SCOPED_TIMER("Scene.CullNodes");
+
+    m_NodeVisibility.resize(m_Nodes.size());
+
+    for(auto&& [sceneNode, visibility] : std::views::zip(m_Nodes, m_NodeVisibility))
+    {
+        const ModelNode& modelNode = *sceneNode.Node;
+
+        visibility.Visible = 0;
+        visibility.Inside = 0;
+
+        if(!modelNode.IsVisible()
+            || (useStaticBundles && modelNode.IsStatic() && !sceneNode.HasMeshlets))
+        {
+            continue;
+        }
+
+        // Bounds are transformed once and tested against every view.
+        const Mat44f& worldTransform = m_WorldTransforms[sceneNode.TransformSlot];
+        const BoundingSphere modelBs = worldTransform * modelNode.GetBoundingSphere();
+
+        visibility.BoundsCenter = modelBs.GetCenter();
+
+        for(uint32_t viewIndex = 0; viewIndex < frusta.size(); ++viewIndex)
+        {
+            const ViewMask viewBit = ViewMask{ 1 } << viewIndex;
+
+            switch(frusta[viewIndex].Contains(modelBs))
+            {
+            case Frustum::ContainsResult::Inside:
+                visibility.Inside |= viewBit;
+                [[fallthrough]];
+            case Frustum::ContainsResult::Intersects:
+                visibility.Visible |= viewBit;
+                break;
+            case Frustum::ContainsResult::Outside:
+                break;
+            }
+        }
+    }
+}
+
+void
+Scene::CollectVisibleMeshes(const Frustum& frustum,
+    const uint32_t viewIndex,
+    const Vec3f& viewPosition,
+    const float lodScale,
+    const bool useStaticBundles,
+    const PropKit& propKit,
+    std::vector<MeshInstance>& outVisibleMeshes,
+    std::vector<uint32_t>& outVisibleMeshTransformSlots,
+    std::vector<SortItem>& outSortItems) const
+{
+    static PerfCounter pcTotalMeshes({ .Name = "Scene.Meshes.Total" });
+    static PerfCounter pcVisibleMeshes({ .Name = "Scene.Meshes.Visible" });
+    static PerfCounter pcTotalMeshlets({ .Name = "Scene.Meshlets.Total" });
+    static PerfCounter pcCulledMeshlets({ .Name = "Scene.Meshlets.Culled" });
+
+    outVisibleMeshes.clear();
+    outVisibleMeshTransformSlots.clear();
+    outSortItems.clear();
+
+    size_t totalMeshlets = 0;
+    size_t culledMeshlets = 0;
+
+    auto addDraw =
+        [&](const uint32_t transformSlot, const MeshInstance& lodInstance, const float viewDepth)
+    {
+        const SortItem sortItem //
+            {
+                .Key = MakeSortKey(lodInstance, viewDepth),
+                .VisibleMeshIndex = narrow_cast<uint32_t>(outVisibleMeshes.size()),
+            };
+
+        outSortItems.push_back(sortItem);
+        outVisibleMeshes.push_back(lodInstance);
+        outVisibleMeshTransformSlots.push_back(transformSlot);
+    };
+
+    // insideFrustum is set when the mesh is known to be inside the frustum.
+    auto addVisibleMesh = [&](const uint32_t transformSlot,
+                              const MeshInstance& meshInstance,
+                              const uint32_t meshSlot,
+                              const float viewDepth,
+                              const float pixelsPerUnit,
+                              const bool insideFrustum)
+    {
+        const Mesh& mesh = *meshInstance.GetMesh();
+
+        // Visible instances refer to their mesh properties by slot.
+        MeshInstance lodInstance(&mesh, meshSlot);
+        lodInstance.SetLod(SelectLod(mesh, pixelsPerUnit));
+
+        const std::span<const Meshlet> meshlets = propKit.GetMeshlets(mesh);
+
+        // Simplified LODs are small enough to draw whole.
+        if(lodInstance.GetLod() > 0 || meshlets.empty())
+        {
+            addDraw(transformSlot, lodInstance, viewDepth);
+            return;
+        }
+
+        const Mat44f& worldTransform = m_WorldTransforms[transformSlot];
+        const Vec4f meshViewPosition = worldTransform.InverseAffine() * viewPosition;
+
+        totalMeshlets += meshlets.size();
+
+        culledMeshlets += CullMeshlets(meshlets,
+            frustum,
+            worldTransform,
+            Vec3f(meshViewPosition.x, meshViewPosition.y, meshViewPosition.z),
+            !insideFrustum,
+            [&](const uint32_t firstIndex, const uint32_t indexCount)
+            {
+                MeshInstance rangeInstance = lodInstance;
+
+                // Instances that draw the whole mesh can still be batched together.
+                if(indexCount != mesh.GetIndexCount())
+                {
+                    rangeInstance.SetIndexRange(firstIndex, indexCount);
+                }
+
+                addDraw(transformSlot, rangeInstance, viewDepth);
+            });
+    };
+
+    const ViewMask viewBit = ViewMask{ 1 } << viewIndex;
+
+    size_t totalMeshes = 0;
+
+    for(auto&& [sceneNode, visibility] : std::views::zip(m_Nodes, m_NodeVisibility))
+    {
+        const ModelNode& modelNode = *sceneNode.Node;
+
+        totalMeshes += modelNode.GetMeshInstances().size();
+
+        // Model is hidden, or fully outside frustum, skip all mesh instances.
+        if(!(visibility.Visible & viewBit))
+        {
+            continue;
+        }
+
+        const Mat44f& worldTransform = m_WorldTransforms[sceneNode.TransformSlot];
+
+        const float nodeScale = MaxAxisScale(worldTransform);
+
+        // Pixels covered by one mesh space unit at the nearest point of a sphere.
+        // The camera is inside the sphere when distance <= 0 and the finest LOD is used.
+        auto pixelsPerUnit = [&](const float viewDepth, const float radius)
+        {
+            const float distance = viewDepth - (radius * nodeScale);
+            return distance > 0 ? lodScale * nodeScale / distance
+                                : std::numeric_limits<float>::infinity();
+        };
+
+        if(!(visibility.Inside & viewBit))
+        {
+            // Model intersects frustum, check each mesh instance.
+
+            for(auto&& [meshInstance, meshSlot] :
+                std::views::zip(modelNode.GetMeshInstances(), sceneNode.MeshSlots))
+            {
+                if(useStaticBundles && IsBundled(modelNode, meshInstance))
+                {
+                    continue;
+                }
+
+                const BoundingSphere& meshBs = worldTransform * meshInstance.GetBoundingSphere();
+
+                if(Frustum::ContainsResult::Outside == frustum.Contains(meshBs))
+                {
+                    continue;
+                }
+
+                const float viewDepth = ViewDepth(frustum, meshBs.GetCenter());
+
+                addVisibleMesh(sceneNode.TransformSlot,
+                    meshInstance,
+                    meshSlot,
+                    viewDepth,
+                    pixelsPerUnit(viewDepth, meshInstance.GetBoundingSphere().GetRadius()),
+                    false);
+            }
+        }
+        else
+        {
+            // Model is fully inside frustum, add all mesh instances.
+            // Use the model's depth rather than transforming each mesh's bounds.
+
+            const float viewDepth = ViewDepth(frustum, visibility.BoundsCenter);
+            const float modelPixelsPerUnit =
+                pixelsPerUnit(viewDepth, modelNode.GetBoundingSphere().GetRadius());
+
+            for(auto&& [meshInstance, meshSlot] :
+                std::views::zip(modelNode.GetMeshInstances(), sceneNode.MeshSlots))
+            {
+                if(useStaticBundles && IsBundled(modelNode, meshInstance))
+                {
+                    continue;
+                }
+
+                addVisibleMesh(sceneNode.TransformSlot,
+                    meshInstance,
+                    meshSlot,
+                    viewDepth,
+                    modelPixelsPerUnit,
+                    true);
+            }
+        }
+    }
+
+    pcTotalMeshes.Increment(totalMeshes);
+    pcVisibleMeshes.Increment(outVisibleMeshes.size());
+    pcTotalMeshlets.Increment(totalMeshlets);
+    pcCulledMeshlets.Increment(culledMeshlets);
+}
+
+void
+Scene::CullOccludedMeshes(const Camera& camera,
+    const TrTransformf& cameraXForm,
+    const PropKit& propKit)
+{
+    MLG_SCOPED_TIMER("Scene.CullOccludedMeshes");
+
+    static PerfCounter pcOccluders({ .Name = "Scene.Occluders" });
+    static PerfCounter pcOccludedMeshes({ .Name = "Scene.Meshes.Occluded" });
+
+    const Mat44f viewProj = camera.GetProjectionMatrix().Mul(cameraXForm.Inverse().ToMatrix());
+    const Vec3f cameraForward = cameraXForm.LocalZAxis();
+
+    m_VisibleMeshBounds.clear();
+    m_OccluderCandidates.clear();
+
+    for(size_t i = 0; i < m_VisibleMeshes.size(); ++i)
+    {
+        const BoundingSphere& worldBs = m_VisibleMeshBounds.emplace_back(
+            ToWorldSphere(m_WorldTransforms[m_VisibleMeshTransformSlots[i]],
+                m_VisibleMeshes[i].GetBoundingSphere()));
+
+        const float depth = (worldBs.GetCenter() - cameraXForm.T).Dot(cameraForward);
+        const float screenSize = worldBs.GetRadius() / std::max(depth, camera.GetNearClip());
+
+        if(screenSize >= kMinOccluderScreenSize)
+        {
+            m_OccluderCandidates.push_back(
+                { .ScreenSize = screenSize, .VisibleMeshIndex = narrow_cast<uint32_t>(i) });
+        }
+    }
+
+    // The meshes that cover the most screen space make the best occluders.
+    const size_t occluderCount = std::min(m_OccluderCandidates.size(), kMaxOccluders);
+    std::ranges::partial_sort(m_OccluderCandidates,
+        m_OccluderCandidates.begin() + narrow_cast<ptrdiff_t>(occluderCount),
+        std::ranges::greater{},
+        &OccluderCandidate::ScreenSize);
+
+    m_OcclusionCuller->Begin(viewProj);
+
+    size_t triangleCount = 0;
+
+    for(const OccluderCandidate& candidate :
+        std::span(m_OccluderCandidates).first(occluderCount))
+    {
+        // Occluders are rasterized at full detail. Simplified LODs can shrink inside the
+        // original surface and hide meshes that are actually visible.
+        const Mesh& mesh = *m_VisibleMeshes[candidate.VisibleMeshIndex].GetMesh();
+        const size_t meshTriangles = mesh.GetIndexCount() / 3;
+
+        if(triangleCount + meshTriangles > kMaxOccluderTriangles)
+        {
+            continue;
+        }
+
+        triangleCount += meshTriangles;
+
+        const std::span<const VertexIndex> indices =
+            propKit.GetIndices(mesh.GetIndexFormat())
+                .subspan(mesh.GetFirstIndex(), mesh.GetIndexCount());
+
+        m_OcclusionCuller->AddOccluder(
+            m_WorldTransforms[m_VisibleMeshTransformSlots[candidate.VisibleMeshIndex]],
+            propKit.GetPositions().subspan(mesh.GetBaseVertex()),
+            indices);
+
+        pcOccluders.Increment(1);
+    }
+
+    m_OcclusionCuller->Rasterize(m_ThreadPool);
+
+    // Compact the visible set, keeping sort items in step with their meshes.
+    size_t visibleCount = 0;
+
+    for(size_t i = 0; i < m_VisibleMeshes.size(); ++i)
+    {
+        if(!m_OcclusionCuller->IsVisible(m_VisibleMeshBounds[i]))
+        {
+            continue;
+        }
+
+        m_VisibleMeshes[visibleCount] = m_VisibleMeshes[i];
+        m_VisibleMeshTransformSlots[visibleCount] = m_VisibleMeshTransformSlots[i];
+        m_SortItems[visibleCount] = m_SortItems[i];
+        m_SortItems[visibleCount].VisibleMeshIndex = narrow_cast<uint32_t>(visibleCount);
+
+        ++visibleCount;
+    }
+
+    pcOccludedMeshes.Increment(m_VisibleMeshes.size() - visibleCount);
+
+    m_VisibleMeshes.erase(m_VisibleMeshes.begin() + narrow_cast<ptrdiff_t>(visibleCount),
+        m_VisibleMeshes.end());
+    m_VisibleMeshTransformSlots.resize(visibleCount);
+    m_SortItems.resize(visibleCount);
+}
+
+void
+Scene::SortVisibleMeshes()
+{
+    MLG_SCOPED_TIMER("Scene.SortVisibleMeshes");
+
+    m_SortScratch.resize(m_SortItems.size());
+
+    RadixSort(std::span<SortItem>(m_SortItems),
+        std::span<SortItem>(m_SortScratch),
+        [](const SortItem& item) { return item.Key; });
+
+    m_SortedMeshes.clear();
+
+    for(const SortItem& item : m_SortItems)
+    {
+        m_SortedMeshes.push_back(m_VisibleMeshes[item.VisibleMeshIndex]);
+    }
+
+    std::swap(m_VisibleMeshes, m_SortedMeshes);
+}
+
+Result<>
+Scene::BuildDrawBatches(const wgpu::CommandEncoder& cmdEncoder,
+    const std::span<const MeshInstance> visibleMeshes,
+    const uint32_t baseIndex)
+{
+    MLG_SCOPED_TIMER("Scene.BuildDrawBatches");
+
+    static PerfCounter pcDrawBatches({ .Name = "Scene.DrawBatches" });
+    static PerfCounter pcTriangles({ .Name = "Scene.Triangles" });
+
+    m_DrawBatches.clear();
+    m_DrawIndirectParams.clear();
+    m_InstanceRemap.clear();
+
+    // Visible meshes are sorted such that instances of the same mesh LOD are mostly adjacent.
+    const size_t triangleCount = AppendDrawBatches(visibleMeshes,
+        baseIndex,
+        m_DrawBatches,
+        m_DrawIndirectParams,
+        m_InstanceRemap);
+
+    GpuUploadRing& uploadRing = m_GpuHelper->GetUploadRing();
+    MLG_CHECK(uploadRing.Upload<ShaderInterop::DrawIndirectParams>(cmdEncoder,
+        m_DrawIndirectBuffer,
+        baseIndex,
+        m_DrawIndirectParams));
+    MLG_CHECK(uploadRing.Upload<ShaderInterop::InstanceRemap>(cmdEncoder,
+        m_InstanceRemapBuffer,
+        baseIndex,
+        m_InstanceRemap));
+
+    pcDrawBatches.Increment(m_DrawBatches.size());
+    pcTriangles.Increment(triangleCount);
+
+    return Result<>::Ok;
+}
+
+Result<const Scene::StaticBundle*>
+Scene::GetStaticBundle(const wgpu::CommandEncoder& cmdEncoder,
+    const Camera& camera,
+    const TrTransformf& cameraXForm,
+    const float lodScale,
+    const PropKit& propKit)
+{
+    static PerfCounter pcStaticTriangles({ .Name = "Scene.StaticBundle.Triangles" });
+
+    // Visible sets and LODs depend on the projection, so views with different projections,
+    // e.g. split screen and a minimap, get their own bundles.
+    Vec3f direction;
+    const StaticCell cell //
+        {
+            .X = static_cast<int32_t>(std::floor(cameraXForm.T.x / kStaticCellSize)),
+            .Y = static_cast<int32_t>(std::floor(cameraXForm.T.y / kStaticCellSize)),
+            .Z = static_cast<int32_t>(std::floor(cameraXForm.T.z / kStaticCellSize)),
+            .Direction = QuantizeDirection(cameraXForm.LocalZAxis(), direction),
+            .LodScale = lodScale,
+            .HalfAngle = FrustumHalfAngle(camera),
+        };
+
+    auto it = m_StaticBundles.find(cell);
+
+    if(it == m_StaticBundles.end())
+    {
+        MLG_SCOPED_TIMER("Scene.RecordStaticBundle");
+
+        if(m_StaticBundles.size() >= kMaxStaticBundles)
+        {
+            auto lru = std::ranges::min_element(m_StaticBundles,
+                {},
+                [](const auto& entry) { return entry.second.LastUsedFrame; });
+
+            m_StaticBundles.erase(lru);
+        }
+
+        const StaticCellView view =
+            MakeStaticCellView(cell.X, cell.Y, cell.Z, direction, cell.HalfAngle);
+
+        std::vector<MeshInstance> meshInstances;
+        std::vector<SortItem> sortItems;
+
+        for(const SceneNode& sceneNode : m_Nodes)
+        {
+            const ModelNode& modelNode = *sceneNode.Node;
+            const Mat44f& worldTransform = m_WorldTransforms[sceneNode.TransformSlot];
+
+            if(!modelNode.IsStatic() || !modelNode.IsVisible()
+                || !IsVisibleFromCell(view,
+                    ToWorldSphere(worldTransform, modelNode.GetBoundingSphere())))
+            {
+                continue;
+            }
+
+            const float nodeScale = MaxAxisScale(worldTransform);
+
+            for(auto&& [meshInstance, meshSlot] :
+                std::views::zip(modelNode.GetMeshInstances(), sceneNode.MeshSlots))
+            {
+                if(!IsBundled(modelNode, meshInstance))
+                {
+                    continue;
+                }
+
+                const BoundingSphere meshBs =
+                    ToWorldSphere(worldTransform, meshInstance.GetBoundingSphere());
+
+                if(!IsVisibleFromCell(view, meshBs))
+                {
+                    continue;
+                }
+
+                // LODs are selected for the nearest point of the cell.
+                const float cellDistance = (meshBs.GetCenter() - view.Position).Length();
+                const float distance = cellDistance - meshBs.GetRadius() - view.Radius;
+                const float pixelsPerUnit = distance > 0
+                    ? lodScale * nodeScale / distance
+                    : std::numeric_limits<float>::infinity();
+
+                MeshInstance lodInstance(meshInstance.GetMesh(), meshSlot);
+                lodInstance.SetLod(SelectLod(*meshInstance.GetMesh(), pixelsPerUnit));
+
+                const SortItem sortItem //
+                    {
+                        .Key = MakeSortKey(lodInstance, cellDistance),
+                        .VisibleMeshIndex = narrow_cast<uint32_t>(meshInstances.size()),
+                    };
+
+                sortItems.push_back(sortItem);
+                meshInstances.push_back(lodInstance);
+            }
+        }
+
+        std::vector<SortItem> sortScratch(sortItems.size());
+
+        RadixSort(std::span<SortItem>(sortItems),
+            std::span<SortItem>(sortScratch),
+            [](const SortItem& item) { return item.Key; });
+
+        std::vector<MeshInstance> sortedInstances;
+        sortedInstances.reserve(meshInstances.size());
+
+        for(const SortItem& item : sortItems)
+        {
+            sortedInstances.push_back(meshInstances[item.VisibleMeshIndex]);
+        }
+
+        // The regions of discarded bundles are only reclaimed by starting the static region
+        // over, once more than half of it is unused. Views rendered earlier in the frame have
+        // read their draws by the time the uploads recorded here overwrite them.
+        uint32_t usedCount = 0;
+        for(const StaticBundle& otherBundle : m_StaticBundles | std::views::values)
+        {
+            usedCount += otherBundle.InstanceCount;
+        }
+
+        if(m_StaticRegionEnd - usedCount > usedCount)
+        {
+            InvalidateStaticBundles();
+        }
+
+        StaticBundle staticBundle;
+        staticBundle.Direction = direction;
+        staticBundle.BaseIndex = m_StaticRegionEnd;
+        staticBundle.InstanceCount = narrow_cast<uint32_t>(sortedInstances.size());
+
+        std::vector<DrawBatch> drawBatches;
+        std::vector<ShaderInterop::DrawIndirectParams> drawIndirectParams;
+        std::vector<ShaderInterop::InstanceRemap> instanceRemap;
+
+        staticBundle.TriangleCount = AppendDrawBatches(sortedInstances,
+            staticBundle.BaseIndex,
+            drawBatches,
+            drawIndirectParams,
+            instanceRemap);
+
+        auto bundle = m_ColorPass.RecordBundle(drawBatches, propKit);
+        MLG_CHECK(bundle);
+
+        staticBundle.Bundle = std::move(*bundle);
+
+        // The bundle's region is written once. Other views and cells have their own regions.
+        GpuUploadRing& uploadRing = m_GpuHelper->GetUploadRing();
+        MLG_CHECK(uploadRing.Upload<ShaderInterop::DrawIndirectParams>(cmdEncoder,
+            m_DrawIndirectBuffer,
+            staticBundle.BaseIndex,
+            drawIndirectParams));
+        MLG_CHECK(uploadRing.Upload<ShaderInterop::InstanceRemap>(cmdEncoder,
+            m_InstanceRemapBuffer,
+            staticBundle.BaseIndex,
+            instanceRemap));
+
+        m_StaticRegionEnd += staticBundle.InstanceCount;
+
+        it = m_StaticBundles.emplace(cell, std::move(staticBundle)).first;
+    }
+
+    StaticBundle& staticBundle = it->second;
+    staticBundle.LastUsedFrame = m_FrameIndex;
+
+    pcStaticTriangles.Increment(staticBundle.TriangleCount);
+
+    return &staticBundle;
+}
+
+void
+Scene::CaptureWorldTransforms()
+{
+    m_WorldTransforms.resize(m_TransformSlots.GetSlotCount());
+
+    auto captureNodes = [this](const std::span<const Mat44f> snapshot)
+    {
+        for(const SceneNode& node : m_Nodes)
+        {
+            const size_t index = IndexOfNode(m_SnapshotNodes, *node.Node);
+
+            m_WorldTransforms[node.TransformSlot] =
+                index < snapshot.size() ? snapshot[index] : node.Node->GetWorldTransform();
+        }
+    };
+
+    if(m_TransformSnapshots)
+    {
+        static PerfCounter pcSnapshotStep({ .Name = "Scene.SnapshotStep" });
+
+        const uint64_t step = m_TransformSnapshots->Read(captureNodes);
+
+        pcSnapshotStep.Set(static_cast<double>(step));
+    }
+    else
+    {
+        captureNodes({});
+    }
+}
+
+Result<>
+Scene::SyncToGpu(const wgpu::CommandEncoder& cmdEncoder)
+{
+    MLG_CHECK(GrowBuffers(cmdEncoder));
+    MLG_CHECK(FlushMeshProperties(cmdEncoder));
+
+    if(m_Nodes.empty())
+    {
+        return Result<>::Ok;
+    }
+
+    // Brute force copy everything for now.
+    // Transforms are written straight into staging memory at their slots and copied with a
+    // single command. Free slots are copied too but nothing references them.
+    const size_t size = m_TransformSlots.GetSlotCount() * sizeof(ShaderInterop::WorldTransform);
+
+    auto staging = m_GpuHelper->GetUploadRing().Allocate(size);
+    MLG_CHECK(staging);
+
+    for(const SceneNode& node : m_Nodes)
+    {
+        const ShaderInterop::WorldTransform transform =
+            ToGpuWorldTransform(m_WorldTransforms[node.TransformSlot]);
+        const size_t offset = size_t{ node.TransformSlot } * sizeof(transform);
+        std::memcpy(&staging->Data[offset], &transform, sizeof(transform));
+    }
+
+    cmdEncoder.CopyBufferToBuffer(staging->Buffer,
+        staging->Offset,
+        m_WorldTransformBuffer.GetGpuBuffer(),
+        0,
+        size);
+
+    if(m_ColorPass.IsNormalMatricesEnabled())
+    {
+        const size_t normalMatricesSize =
+            m_TransformSlots.GetSlotCount() * sizeof(ShaderInterop::NormalMatrix);
+
+        auto normalStaging = m_GpuHelper->GetUploadRing().Allocate(normalMatricesSize);
+        MLG_CHECK(normalStaging);
+
+        for(const SceneNode& node : m_Nodes)
+        {
+            const ShaderInterop::NormalMatrix normalMatrix =
+                ToGpuNormalMatrix(m_WorldTransforms[node.TransformSlot]);
+            const size_t offset = size_t{ node.TransformSlot } * sizeof(normalMatrix);
+            std::memcpy(&normalStaging->Data[offset], &normalMatrix, sizeof(normalMatrix));
+        }
+
+        cmdEncoder.CopyBufferToBuffer(normalStaging->Buffer,
+            normalStaging->Offset,
+            m_NormalMatrixBuffer.GetGpuBuffer(),
+            0,
+            normalMatricesSize);
+    }
+
+    return Result<>::Ok;
+}
+
+Result<>
+Scene::GrowBuffers(const wgpu::CommandEncoder& cmdEncoder)
+{
+    const size_t nodeCount = m_TransformSlots.GetSlotCount();
+
+    if(nodeCount > m_WorldTransformBuffer.Count())
+    {
+        const size_t capacity = GrowCapacity(m_WorldTransformBuffer.Count(), nodeCount);
+
+        MLG_DEBUG("Growing transform arrays to {} nodes", capacity);
+
+        // World transforms and normal matrices are rewritten every frame and clip space
+        // transforms are computed from them, so none need to be copied.
+        auto worldTransforms =
+            m_GpuHelper->CreateStorageBuffer<GpuWorldTransformBuffer>(capacity, "WorldTransforms");
+        MLG_CHECK(worldTransforms);
+
+        auto clipSpaceTransforms =
+            m_GpuHelper->CreateStorageBuffer<GpuClipSpaceBuffer>(capacity, "ClipSpaceTransforms");
+        MLG_CHECK(clipSpaceTransforms);
+
+        auto normalMatrices =
+            m_GpuHelper->CreateStorageBuffer<GpuNormalMatrixBuffer>(capacity, "NormalMatrices");
+        MLG_CHECK(normalMatrices);
+
+        m_WorldTransformBuffer = std::move(*worldTransforms);
+        m_ClipSpaceBuffer = std::move(*clipSpaceTransforms);
+        m_NormalMatrixBuffer = std::move(*normalMatrices);
+
+        // Bundles captured bind groups that reference the old buffers.
+        InvalidateStaticBundles();
+    }
+
+    const size_t meshCount = m_MeshSlots.GetSlotCount();
+
+    if(meshCount > m_MeshPropertiesBuffer.Count())
+    {
+        const size_t capacity = GrowCapacity(m_MeshPropertiesBuffer.Count(), meshCount);
+
+        MLG_DEBUG("Growing mesh properties to {} mesh instances", capacity);
+
+        auto meshProperties =
+            m_GpuHelper->CreateStorageBuffer<GpuMeshPropertiesBuffer>(capacity, "MeshProperties");
+        MLG_CHECK(meshProperties);
+
+        // Mesh properties are only uploaded when nodes are added, so existing ones are copied.
+        cmdEncoder.CopyBufferToBuffer(m_MeshPropertiesBuffer.GetGpuBuffer(),
+            0,
+            meshProperties->GetGpuBuffer(),
+            0,
+            m_MeshPropertiesBuffer.BufferSize());
+
+        m_MeshPropertiesBuffer = std::move(*meshProperties);
+
+        InvalidateStaticBundles();
+    }
+
+    return Result<>::Ok;
+}
+
+Result<>
+Scene::GrowDrawBuffers(const size_t drawCount)
+{
+    if(drawCount <= m_DrawIndirectBuffer.Count() && drawCount <= m_InstanceRemapBuffer.Count())
+    {
+        return Result<>::Ok;
+    }
+
+    const size_t capacity = GrowCapacity(m_DrawIndirectBuffer.Count(), drawCount);
+
+    MLG_DEBUG("Growing draw arrays to {} draws", capacity);
+
+    // Draw parameters and instance remapping are rebuilt every frame, so none are copied.
+    auto drawIndirect =
+        m_GpuHelper->CreateIndirectBuffer<GpuDrawIndirectBuffer>(capacity, "DrawIndirectBuffer");
+    MLG_CHECK(drawIndirect);
+
+    auto instanceRemap =
+        m_GpuHelper->CreateStorageBuffer<GpuInstanceRemapBuffer>(capacity, "InstanceRemap");
+    MLG_CHECK(instanceRemap);
+
+    m_DrawIndirectBuffer = std::move(*drawIndirect);
+    m_InstanceRemapBuffer = std::move(*instanceRemap);
+
+    // Bundles captured the old buffers, and the static region is empty.
+    InvalidateStaticBundles();
+
+    return Result<>::Ok;
+}
+
+Result<>
+Scene::FlushMeshProperties(const wgpu::CommandEncoder& cmdEncoder)
+{
+    if(m_PendingMeshProperties.empty())
+    {
+        return Result<>::Ok;
+    }
+
+    // Stable so that later writes to a reused slot replace earlier ones.
+    std::ranges::stable_sort(m_PendingMeshProperties, {}, &PendingMeshProperties::Slot);
+
+    GpuUploadRing& uploadRing = m_GpuHelper->GetUploadRing();
+    std::vector<ShaderInterop::MeshProperties> run;
+
+    // Nodes added together get adjacent slots. Upload each run of adjacent slots with one copy.
+    for(size_t i = 0; i < m_PendingMeshProperties.size();)
+    {
+        const uint32_t firstSlot = m_PendingMeshProperties[i].Slot;
+        run.clear();
+
+        for(; i < m_PendingMeshProperties.size()
+            && m_PendingMeshProperties[i].Slot <= firstSlot + run.size();
+            ++i)
+        {
+            const PendingMeshProperties& pending = m_PendingMeshProperties[i];
+
+            if(pending.Slot < firstSlot + run.size())
+            {
+                run.back() = pending.Properties;
+            }
+            else
+            {
+                run.push_back(pending.Properties);
+            }
+        }
+
+        MLG_CHECK(uploadRing.Upload<ShaderInterop::MeshProperties>(cmdEncoder,
+            m_MeshPropertiesBuffer,
+            firstSlot,
+            run));
+    }
+
+    m_PendingMeshProperties.clear();
+
+    return Result<>::Ok;
+}
+
+Result<>
+Scene::UploadCameraParams(const wgpu::CommandEncoder& cmdEncoder,
+    const TrTransformf& cameraXForm,
+    const Camera& camera)
+{
+    // Use inverse of camera transform as view matrix
+    const Mat44f viewMat = cameraXForm.Inverse().ToMatrix();
+    const Mat44f& projMat = camera.GetProjectionMatrix();
+    const Mat44f viewProjMat = projMat.Mul(viewMat);
 
     const ShaderInterop::CameraParams cameraParams //
         {
@@ -392,11 +2044,16 @@ Scene::TransformNodes(const wgpu::Device& gpuDevice,
             .ViewProj = viewProjMat,
         };
 
-    gpuDevice.GetQueue().WriteBuffer(m_CameraParamsBuffer.GetGpuBuffer(),
-        0,
-        &cameraParams,
-        sizeof(ShaderInterop::CameraParams));
+    MLG_CHECK(m_GpuHelper->GetUploadRing().Upload(cmdEncoder,
+        m_CameraParamsBuffer,
+        std::span<const ShaderInterop::CameraParams>(&cameraParams, 1)));
 
+    return Result<>::Ok;
+}
+
+Result<>
+Scene::TransformNodes(const wgpu::CommandEncoder& cmdEncoder)
+{
     const GpuTransformPass::Inputs inputs //
         {
             .WorldTransforms = m_WorldTransformBuffer,
@@ -415,5 +2072,90 @@ Scene::TransformNodes(const wgpu::Device& gpuDevice,
 
     MLG_CHECK(invocation->Execute(), "Failed to execute transform pass");
 
+    return Result<>::Ok;
+}
+
+Result<>
+Scene::SetCompositorTargets(const GpuRenderTarget& source,
+    const GpuRenderTarget& target,
+    const Rect& dstRect,
+    const bool clearTarget)
+{
+    const GpuCompositorPass::Inputs inputs //
+        {
+            .DstRect = dstRect,
+            .Texture = source.Get(),
+        };
+
+    const GpuCompositorPass::Outputs outputs //
+        {
+            .RenderTarget = target,
+            .ClearTarget = clearTarget,
+        };
+
+    MLG_CHECK(m_CompositorPass.SetInputs(inputs));
+    MLG_CHECK(m_CompositorPass.SetOutputs(outputs));
+
+    return Result<>::Ok;
+}
+
+Result<GpuRenderTarget>
+Scene::GetPooledRenderTarget(const RenderGraph::ResourceHandle resource)
+{
+    const RenderGraph::PhysicalResource& physical = m_RenderGraph.GetPhysicalResource(resource);
+
+    MLG_ASSERT(physical.Desc.Type == RenderGraph::ResourceType::ColorTarget,
+        "Resource is not a color target");
+
+    return m_RenderTargetPool.GetRenderTarget(physical.Desc.Dimensions, physical.Instance);
+}
+
+Result<GpuDepthTarget>
+Scene::GetPooledDepthBuffer(const RenderGraph::ResourceHandle resource)
+{
+    const RenderGraph::PhysicalResource& physical = m_RenderGraph.GetPhysicalResource(resource);
+
+    MLG_ASSERT(physical.Desc.Type == RenderGraph::ResourceType::DepthTarget,
+        "Resource is not a depth target");
+
+    return m_RenderTargetPool.GetDepthBuffer(physical.Desc.Dimensions, physical.Instance);
+}
+
+Result<>
+Scene::ExecuteTransformPass(GraphFrame* frame)
+{
+    return frame->Owner->TransformNodes(*frame->CmdEncoder);
+}
+
+Result<>
+Scene::ExecuteColorPass(GraphFrame* frame)
+{
+    Scene& scene = *frame->Owner;
+
+    auto invocation = scene.m_ColorPass.Prepare(*frame->CmdEncoder);
+    MLG_CHECK(invocation);
+
+    const std::span<const GpuColorPass::Bundle> bundles = frame->Bundle
+        ? std::span<const GpuColorPass::Bundle>(&frame->Bundle->Bundle, 1)
+        : std::span<const GpuColorPass::Bundle>();
+
+    return invocation->Execute(scene.m_DrawBatches, bundles, *frame->Props);
+}
+
+Result<>
+Scene::ExecuteCompositePass(GraphFrame* frame)
+{
+    Scene& scene = *frame->Owner;
+
+    MLG_CHECK(scene.SetCompositorTargets(*frame->SceneColor,
+        *frame->Target,
+        *frame->DstRect,
+        frame->ClearTarget));
+
+    auto pass = scene.m_CompositorPass.Prepare(*frame->CmdEncoder);
+    MLG_CHECK(pass, "Failed to begin compositor pass");
+
+    MLG_CHECK(pass->Execute(), "Failed to execute compositor pass");
+
     return Result<>::Ok;
 }
\ No newline at end of file
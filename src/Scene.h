@@ -1,17 +1,41 @@
 #pragma once
 
+#include "Camera.h"
 #include "GpuColorPass.h"
 #include "GpuCompositorPass.h"
+#include "GpuFrameTimer.h"
+#include "GpuRenderTargetPool.h"
 #include "GpuTransformPass.h"
 #include "GpuTypes.h"
 #include "Level.h"
+#include "OcclusionCuller.h"
+#include "RenderGraph.h"
 #include "SceneTypes.h"
+#include "SlotAllocator.h"
 
+#include <memory>
+#include <optional>
+#include <unordered_map>
 #include <vector>
 
+class ThreadPool;
+class TransformSnapshotBuffer;
+
 class Scene
 {
 public:
+    /// @brief A camera and the rect of a target it's rendered into.
+    struct View
+    {
+        const Camera* ViewCamera;
+        TrTransformf CameraXForm;
+        const GpuRenderTarget* Target;
+        Rect DstRect;
+    };
+
+    static constexpr size_t kMaxViews = 32;
+
+    /// @brief Creates a scene that initially renders the given model nodes.
     static Result<Scene> Create(GpuHelper& gpuHelper,
         FileFetcher& fileFetcher,
         const std::span<const ModelNode> modelNodes);
@@ -23,49 +47,372 @@ public:
     Scene(Scene&& other) = default;
     Scene& operator=(Scene&& other) = default;
 
+    /// @brief Renders the scene into an offscreen target, for Composite() to composite.
+    /// The offscreen target is the camera's viewport size scaled by the resolution scale.
     Result<> Render(const Camera& camera, const TrTransformf& cameraXForm, const PropKit& propKit);
 
+    /// @brief Renders the scene and composites it into dstRect of target.
+    /// When compositing would be a plain copy, i.e. dstRect is the whole target, the camera's
+    /// viewport is the target's size, the resolution scale is 1 and the target's format stores
+    /// colors as the offscreen target does, the scene is rendered straight into target without an
+    /// offscreen target.
+    Result<> Render(const Camera& camera,
+        const TrTransformf& cameraXForm,
+        const PropKit& propKit,
+        const GpuRenderTarget& target,
+        const Rect& dstRect);
+
+    /// @brief Renders the scene and composites it into the whole of target.
+    Result<> Render(const Camera& camera,
+        const TrTransformf& cameraXForm,
+        const PropKit& propKit,
+        const GpuRenderTarget& target);
+
+    /// @brief Renders the scene once for each view and composites each one into its view's
+    /// target, e.g. for split screen.
+    /// Node transforms are synced to the GPU once, nodes are culled against every view's frustum
+    /// in a single pass, and all views are recorded into one command buffer. Views that share a
+    /// target are composited in order, and only the first of them clears the target.
+    /// @param views 1 to kMaxViews views. Every view must have a target.
+    Result<> RenderViews(const std::span<const View> views, const PropKit& propKit);
+
     Result<> Composite(const GpuRenderTarget& target);
 
     Result<> Composite(const GpuRenderTarget& target, const Rect& dstRect);
 
+    /// @brief Adds a model node to the scene.
+    /// The node must stay in place until it's removed or the scene is destroyed.
+    /// GPU arrays grow as needed on the next call to Render().
+    Result<> AddNode(const ModelNode& modelNode);
+
+    /// @brief Removes a model node from the scene and frees its GPU array slots for reuse.
+    Result<> RemoveNode(const ModelNode& modelNode);
+
+    /// @brief Enables or disables CPU occlusion culling.
+    /// When enabled, the visible meshes that cover the most screen space are rasterized as
+    /// occluders into a low resolution depth buffer, and meshes hidden behind them are not drawn.
+    /// @param threadPool If not null, occluders are rasterized on its workers.
+    void SetOcclusionCullingEnabled(const bool enabled, ThreadPool* threadPool);
+
+    /// @brief Enables or disables the color pass's depth prepass.
+    /// Worthwhile when overlapping meshes shade many hidden fragments.
+    /// See GpuColorPass::SetDepthPrepassEnabled().
+    void SetDepthPrepassEnabled(const bool enabled);
+
+    /// @brief Enables or disables fused transforms, which skip the transform pass and transform
+    /// vertices by world transforms and the camera's view-projection matrix in the color pass.
+    /// Which mode is faster depends on the scene. See GpuColorPass::SetFusedTransformsEnabled().
+    void SetFusedTransformsEnabled(const bool enabled);
+
+    /// @brief Enables or disables half precision normal matrices, uploaded alongside world
+    /// transforms, which keep normals perpendicular to surfaces under non-uniform scales.
+    /// Without them normals are transformed by world transforms, which is only correct for
+    /// uniform scales.
+    void SetNormalMatricesEnabled(const bool enabled);
+
+    /// @brief Sets the fraction of the camera viewport's width and height the scene is rendered
+    /// at. Composite() upscales the result to the destination rect.
+    /// Render targets are pooled by size, so the scale should come from a small set of values,
+    /// e.g. from DynamicResolution.
+    /// @param scale Greater than 0 and at most 1.
+    void SetResolutionScale(const float scale);
+
+    float GetResolutionScale() const { return m_ResolutionScale; }
+
+    /// @brief Returns how long the GPU took to render a recent frame, or 0 if GPU frame times
+    /// aren't measured. Measuring needs the TimestampQuery feature, and the result trails the
+    /// frame being rendered by a few frames.
+    float GetGpuFrameSeconds() const { return m_FrameTimer ? m_FrameTimer->GetFrameSeconds() : 0; }
+
+    /// @brief Reads node transforms from snapshots published by a simulation thread rather than
+    /// from the nodes, so the simulation can move nodes while the scene renders.
+    /// Transform i of each snapshot belongs to modelNodes[i]. Other nodes are read directly.
+    /// @param snapshots The snapshots to read, or null to read every node directly.
+    void SetTransformSnapshots(const TransformSnapshotBuffer* snapshots,
+        const std::span<const ModelNode> modelNodes);
+
+    /// @brief Discards the render bundles recorded for static nodes.
+    /// Bundles capture the visibility of static nodes and the property kit's buffers, so this
+    /// must be called after changing either of them.
+    void InvalidateStaticBundles();
+
 private:
     Scene(const GpuHelper& gpuHelper,
-        const std::span<const ModelNode> modelNodes,
         GpuColorPass&& colorPass,
         GpuCompositorPass&& compositorPass,
         GpuTransformPass&& transformPass,
         GpuWorldTransformBuffer&& worldTransformBuffer,
         GpuClipSpaceBuffer&& clipSpaceBuffer,
+        GpuNormalMatrixBuffer&& normalMatrixBuffer,
         GpuDrawIndirectBuffer&& drawIndirectBuffer,
         GpuMeshPropertiesBuffer&& meshPropertiesBuffer,
+        GpuInstanceRemapBuffer&& instanceRemapBuffer,
         GpuCameraParamsBuffer&& cameraParamsBuffer);
 
+    // A model node rendered by the scene and its slots in the scene's GPU arrays.
+    struct SceneNode
+    {
+        const ModelNode* Node;
+        // Slot in the world and clip space transform arrays.
+        uint32_t TransformSlot;
+        // Slots in the mesh properties array, one per mesh instance of the node.
+        std::vector<uint32_t> MeshSlots;
+        // Whether any of the node's meshes is split into meshlets.
+        bool HasMeshlets;
+    };
+
+    // Mesh properties waiting to be uploaded.
+    struct PendingMeshProperties
+    {
+        uint32_t Slot;
+        ShaderInterop::MeshProperties Properties;
+    };
+
+    // Pairs a visible mesh with the key used to order it in the draw list.
+    struct SortItem
+    {
+        uint64_t Key;
+        uint32_t VisibleMeshIndex;
+    };
+
+    // A visible mesh that could be used as an occluder.
+    struct OccluderCandidate
+    {
+        float ScreenSize;
+        uint32_t VisibleMeshIndex;
+    };
+
+    // A coarse region of camera positions and view directions, seen through a projection.
+    struct StaticCell
+    {
+        int32_t X;
+        int32_t Y;
+        int32_t Z;
+        uint32_t Direction;
+        float LodScale;
+        float HalfAngle;
+
+        friend bool operator==(const StaticCell& a, const StaticCell& b) = default;
+    };
+
+    struct StaticCellHash
+    {
+        size_t operator()(const StaticCell& cell) const;
+    };
+
+    // Draws of the static meshes that can be visible from anywhere in a static cell.
+    struct StaticBundle
+    {
+        GpuColorPass::Bundle Bundle;
+        // Direction through the center of the cell's direction bin.
+        Vec3f Direction{ 0 };
+        // Region of the draw indirect and instance remap buffers holding the bundle's draws.
+        uint32_t BaseIndex{ 0 };
+        uint32_t InstanceCount{ 0 };
+        size_t TriangleCount{ 0 };
+        uint64_t LastUsedFrame{ 0 };
+    };
+
+    // What the passes of the render graph need to record the frame being rendered.
+    struct GraphFrame
+    {
+        Scene* Owner;
+        const wgpu::CommandEncoder* CmdEncoder;
+        const PropKit* Props;
+        // Static bundle replayed by the color pass, if any.
+        const StaticBundle* Bundle;
+        // Target of the color pass.
+        const GpuRenderTarget* SceneColor;
+        // Target and rect the scene color is composited into, or null if it isn't.
+        const GpuRenderTarget* Target;
+        const Rect* DstRect;
+        // Whether compositing clears the rest of the target.
+        bool ClearTarget;
+    };
+
+    // Bit i is set for view i.
+    using ViewMask = uint32_t;
+
+    static_assert(kMaxViews <= sizeof(ViewMask) * 8, "View masks must have a bit per view");
+
+    // Views a node is visible from, found by CullNodes().
+    struct NodeVisibility
+    {
+        // Views whose frustum the node's bounds intersect or are inside of.
+        ViewMask Visible;
+        // Views whose frustum the node's bounds are inside of.
+        ViewMask Inside;
+        // Center of the node's bounds in world space.
+        Vec3f BoundsCenter;
+    };
+
+    // Discards the static bundles of the cells a static node can be visible from, when adding or
+    // removing the node. Other bundles stay valid.
+    void InvalidateStaticBundles(const ModelNode& modelNode);
+
+    // Renders the scene for each view into one command buffer. Views without a target are
+    // rendered offscreen for Composite(), others are rendered into their rect of their target.
+    Result<> RenderFrame(const std::span<const View> views, const PropKit& propKit);
+
+    // Records the render graph of one view of the frame. CullNodes() must have been called.
+    // Direct views render straight into their target rather than offscreen.
+    Result<> RenderView(const wgpu::CommandEncoder& cmdEncoder,
+        const View& view,
+        const uint32_t viewIndex,
+        const bool isDirect,
+        const bool clearTarget,
+        const bool useStaticBundles,
+        const PropKit& propKit);
+
+    // Tests the bounds of every node against all frusta and fills m_NodeVisibility.
+    // When static bundles are in use, static nodes they draw entirely are skipped.
+    void CullNodes(const std::span<const Frustum> frusta, const bool useStaticBundles);
+
+    // Collects mesh instances visible from view viewIndex, selects a LOD for each one and
+    // builds its sort key. Nodes must have been culled by CullNodes().
+    // Meshes drawn at full detail that are split into meshlets are culled per meshlet, and
+    // their visible meshlets are collected as instances that draw part of the mesh.
+    // When static bundles are in use, static meshes they draw are skipped.
+    // viewPosition is the camera's position in world space.
+    // lodScale is the number of pixels covered by one world space unit at a distance of one
+    // unit from the camera.
     void CollectVisibleMeshes(const Frustum& frustum,
-        std::vector<MeshInstance>& outVisibleMeshes) const;
+        const uint32_t viewIndex,
+        const Vec3f& viewPosition,
+        const float lodScale,
+        const bool useStaticBundles,
+        const PropKit& propKit,
+        std::vector<MeshInstance>& outVisibleMeshes,
+        std::vector<uint32_t>& outVisibleMeshTransformSlots,
+        std::vector<SortItem>& outSortItems) const;
+
+    // Removes visible meshes that are hidden behind occluders.
+    void CullOccludedMeshes(const Camera& camera,
+        const TrTransformf& cameraXForm,
+        const PropKit& propKit);
+
+    // Orders m_VisibleMeshes by their sort keys.
+    void SortVisibleMeshes();
+
+    // Groups visible instances of the same mesh into instanced draws and records uploads of
+    // the corresponding draw parameters and instance remapping, starting at baseIndex.
+    // Only adjacent instances of the same mesh are batched.
+    Result<> BuildDrawBatches(const wgpu::CommandEncoder& cmdEncoder,
+        const std::span<const MeshInstance> visibleMeshes,
+        const uint32_t baseIndex);
+
+    // Returns the static bundle for the camera's static cell, recording it and an upload of its
+    // draw parameters if needed.
+    Result<const StaticBundle*> GetStaticBundle(const wgpu::CommandEncoder& cmdEncoder,
+        const Camera& camera,
+        const TrTransformf& cameraXForm,
+        const float lodScale,
+        const PropKit& propKit);
+
+    // Copies the world transforms of nodes, from the latest snapshot if there is one, into
+    // m_WorldTransforms.
+    void CaptureWorldTransforms();
 
     // Sync updates from CPU -> GPU.
-    Result<> SyncToGpu();
+    Result<> SyncToGpu(const wgpu::CommandEncoder& cmdEncoder);
+
+    // Reallocates GPU arrays that are too small for the allocated slots.
+    Result<> GrowBuffers(const wgpu::CommandEncoder& cmdEncoder);
+
+    // Reallocates the draw indirect and instance remap arrays if they hold fewer than drawCount
+    // draws. Draws aren't bounded by mesh slots, as meshlet culling splits meshes into runs.
+    Result<> GrowDrawBuffers(const size_t drawCount);
+
+    // Records uploads of the mesh properties of added nodes.
+    Result<> FlushMeshProperties(const wgpu::CommandEncoder& cmdEncoder);
 
-    Result<> TransformNodes(const wgpu::Device& gpuDevice,
-        const wgpu::CommandEncoder& cmdEncoder,
+    Result<> UploadCameraParams(const wgpu::CommandEncoder& cmdEncoder,
         const TrTransformf& cameraXForm,
         const Camera& camera);
 
+    // Computes clip space transforms from world transforms and the camera parameters.
+    Result<> TransformNodes(const wgpu::CommandEncoder& cmdEncoder);
+
+    // Sets the compositor up to draw source into dstRect of target.
+    Result<> SetCompositorTargets(const GpuRenderTarget& source,
+        const GpuRenderTarget& target,
+        const Rect& dstRect,
+        const bool clearTarget);
+
+    // Return the pooled textures for the physical resources of render graph resources.
+    Result<GpuRenderTarget> GetPooledRenderTarget(const RenderGraph::ResourceHandle resource);
+    Result<GpuDepthTarget> GetPooledDepthBuffer(const RenderGraph::ResourceHandle resource);
+
+    // Render graph passes.
+    static Result<> ExecuteTransformPass(GraphFrame* frame);
+    static Result<> ExecuteColorPass(GraphFrame* frame);
+    static Result<> ExecuteCompositePass(GraphFrame* frame);
+
     const GpuHelper* m_GpuHelper{ nullptr };
 
-    std::span<const ModelNode> m_ModelNodes;
+    // Nodes are kept dense for culling. m_NodeIndices maps model nodes to their index.
+    std::vector<SceneNode> m_Nodes;
+    std::unordered_map<const ModelNode*, size_t> m_NodeIndices;
+    // Visibility of m_Nodes, by index, from the views of the current frame.
+    std::vector<NodeVisibility> m_NodeVisibility;
+    SlotAllocator m_TransformSlots;
+    SlotAllocator m_MeshSlots;
+    std::vector<PendingMeshProperties> m_PendingMeshProperties;
+
+    // World transforms of nodes for the current frame, indexed by transform slot.
+    std::vector<Mat44f> m_WorldTransforms;
+    const TransformSnapshotBuffer* m_TransformSnapshots{ nullptr };
+    std::span<const ModelNode> m_SnapshotNodes;
 
-    std::optional<GpuColorPass::Outputs> m_ColorPassOutputs;
+    // Color targets and depth buffers for each size the scene is rendered at, and for the
+    // transient textures of the render graph.
+    GpuRenderTargetPool m_RenderTargetPool;
+    // Passes of the frame being rendered. Rebuilt each frame, reusing its memory.
+    RenderGraph m_RenderGraph;
+    // Target of the last offscreen render. Reset by frames that render straight into targets.
+    std::optional<GpuRenderTarget> m_OffscreenTarget;
+    float m_ResolutionScale{ 1 };
+    // Measures the GPU time of frames, if timestamp queries are supported.
+    std::unique_ptr<GpuFrameTimer> m_FrameTimer;
+    // Format of the last color target. Static bundles are recorded for it.
+    wgpu::TextureFormat m_ColorFormat{ wgpu::TextureFormat::Undefined };
     GpuColorPass m_ColorPass;
     GpuCompositorPass m_CompositorPass;
     GpuTransformPass m_TransformPass;
 
     GpuWorldTransformBuffer m_WorldTransformBuffer;
     GpuClipSpaceBuffer m_ClipSpaceBuffer;
+    GpuNormalMatrixBuffer m_NormalMatrixBuffer;
     GpuDrawIndirectBuffer m_DrawIndirectBuffer;
     GpuMeshPropertiesBuffer m_MeshPropertiesBuffer;
+    GpuInstanceRemapBuffer m_InstanceRemapBuffer;
     GpuCameraParamsBuffer m_CameraParamsBuffer;
-    
+
+    // Cameras scaled by the resolution scale, and their frusta, for the views of the current
+    // frame.
+    std::vector<Camera> m_ViewCameras;
+    std::vector<Frustum> m_ViewFrusta;
+
     std::vector<MeshInstance> m_VisibleMeshes;
+    std::vector<uint32_t> m_VisibleMeshTransformSlots;
+    std::vector<MeshInstance> m_SortedMeshes;
+    std::vector<SortItem> m_SortItems;
+    std::vector<SortItem> m_SortScratch;
+    std::vector<DrawBatch> m_DrawBatches;
+    std::vector<ShaderInterop::DrawIndirectParams> m_DrawIndirectParams;
+    std::vector<ShaderInterop::InstanceRemap> m_InstanceRemap;
+
+    std::optional<OcclusionCuller> m_OcclusionCuller;
+    ThreadPool* m_ThreadPool{ nullptr };
+    std::vector<BoundingSphere> m_VisibleMeshBounds;
+    std::vector<OccluderCandidate> m_OccluderCandidates;
+
+    // Static bundles draw at most m_StaticMeshInstanceCount instances each.
+    uint32_t m_StaticMeshInstanceCount{ 0 };
+    std::unordered_map<StaticCell, StaticBundle, StaticCellHash> m_StaticBundles;
+    // The draws of static bundles occupy the first m_StaticRegionEnd elements of the draw
+    // indirect and instance remap buffers, each bundle in its own region, so views replaying
+    // different bundles don't overwrite each other's draws. Dynamic draws follow them.
+    uint32_t m_StaticRegionEnd{ 0 };
+    uint64_t m_FrameIndex{ 0 };
 };
\ No newline at end of file
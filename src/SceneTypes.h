@@ -2,6 +2,12 @@
 
 #include "BoundingVolumes.h"
 #include "SemanticIdentifier.h"
+#include "Vertex.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <span>
 
 using MaterialIdentifier = SemanticIdentifier<struct MaterialIdTag>;
 
@@ -10,42 +16,155 @@ namespace wgpu
 class BindGroup;
 }
 
+/// @brief How a material's alpha is used, as in glTF's alphaMode.
+/// Each mode is drawn with its own pipeline, in the order listed.
+enum class AlphaMode : uint8_t
+{
+    // Alpha is ignored.
+    Opaque,
+    // Fragments with alpha below the material's alpha cutoff are discarded.
+    Mask,
+    // Blended over the geometry behind it. Drawn back to front without writing depth.
+    Blend,
+};
+
+constexpr size_t kAlphaModeCount = 3;
+
+/// @brief Color pass shader variants, by the features a material uses.
+/// Each alpha mode has a pipeline per variant, and materials are drawn with the cheapest
+/// variant that renders them.
+enum class ShaderVariant : uint8_t
+{
+    // Lit material color. Doesn't sample a texture, so draws bind no texture array.
+    Untextured,
+    // Lit material color modulated by the base texture.
+    Textured,
+};
+
+constexpr size_t kShaderVariantCount = 2;
+
+/// @brief Locates a material's base texture: a layer of one of the PropKit's texture arrays.
+struct MaterialTexture
+{
+    // Index of the texture array. Meshes whose textures share an array share a bind group.
+    uint32_t ArrayIndex{ 0 };
+    uint32_t Layer{ 0 };
+    // False for materials without a base texture, whose array index and layer are unused.
+    bool Textured{ false };
+
+    ShaderVariant GetShaderVariant() const
+    {
+        return Textured ? ShaderVariant::Textured : ShaderVariant::Untextured;
+    }
+};
+
 class Mesh
 {
 public:
+    static constexpr size_t kMaxLodCount = 4;
+
     struct VertexParams
     {
         uint32_t IndexCount;
         uint32_t FirstIndex;
         uint32_t BaseVertex;
+
+        // Range of the property kit's meshlets that LOD 0 is split into. Empty for meshes
+        // that aren't split.
+        uint32_t FirstMeshlet{ 0 };
+        uint32_t MeshletCount{ 0 };
+
+        // Selects the property kit's index buffer that holds the mesh's indices, LODs included.
+        IndexFormat IndexFormat{ IndexFormat::Uint32 };
+    };
+
+    /// @brief A level of detail. Each LOD is a range of the mesh's index buffer that
+    /// references the mesh's vertices.
+    struct Lod
+    {
+        uint32_t IndexCount;
+        uint32_t FirstIndex;
+
+        // Largest geometric error introduced by simplification, in mesh space units.
+        float Error;
     };
 
     Mesh() = delete;
 
     Mesh(const VertexParams& vertexParams,
         const MaterialIdentifier materialId,
+        const MaterialTexture& materialTexture,
+        const AlphaMode alphaMode,
+        const BoundingBox& boundingBox)
+        : Mesh(vertexParams, {}, materialId, materialTexture, alphaMode, boundingBox)
+    {
+    }
+
+    /// @param vertexParams Describes the full detail mesh, LOD 0.
+    /// @param simplifiedLods Progressively simplified LODs, starting with LOD 1.
+    Mesh(const VertexParams& vertexParams,
+        const std::span<const Lod> simplifiedLods,
+        const MaterialIdentifier materialId,
+        const MaterialTexture& materialTexture,
+        const AlphaMode alphaMode,
         const BoundingBox& boundingBox)
-        : m_IndexCount(vertexParams.IndexCount),
-          m_FirstIndex(vertexParams.FirstIndex),
-          m_BaseVertex(vertexParams.BaseVertex),
+        : m_BaseVertex(vertexParams.BaseVertex),
+          m_FirstMeshlet(vertexParams.FirstMeshlet),
+          m_MeshletCount(vertexParams.MeshletCount),
+          m_IndexFormat(vertexParams.IndexFormat),
           m_MaterialId(materialId),
+          m_MaterialTexture(materialTexture),
+          m_AlphaMode(alphaMode),
           m_BoundingBox(boundingBox),
           m_BoundingSphere(boundingBox)
     {
+        MLG_ABORTIF(simplifiedLods.size() >= kMaxLodCount, "Too many LODs");
+
+        m_Lods[0] = { .IndexCount = vertexParams.IndexCount,
+            .FirstIndex = vertexParams.FirstIndex,
+            .Error = 0 };
+
+        std::ranges::copy(simplifiedLods, m_Lods.begin() + 1);
+        m_LodCount = static_cast<uint32_t>(simplifiedLods.size() + 1);
     }
 
-    uint32_t GetIndexCount() const { return m_IndexCount; }
-    uint32_t GetFirstIndex() const { return m_FirstIndex; }
+    /// @brief Shares another mesh's geometry, including its LODs and meshlets, with a
+    /// different material.
+    Mesh(const Mesh& geometry,
+        const MaterialIdentifier materialId,
+        const MaterialTexture& materialTexture,
+        const AlphaMode alphaMode)
+        : Mesh(geometry)
+    {
+        m_MaterialId = materialId;
+        m_MaterialTexture = materialTexture;
+        m_AlphaMode = alphaMode;
+    }
+
+    uint32_t GetIndexCount() const { return m_Lods[0].IndexCount; }
+    uint32_t GetFirstIndex() const { return m_Lods[0].FirstIndex; }
     uint32_t GetBaseVertex() const { return m_BaseVertex; }
+    uint32_t GetFirstMeshlet() const { return m_FirstMeshlet; }
+    uint32_t GetMeshletCount() const { return m_MeshletCount; }
+    IndexFormat GetIndexFormat() const { return m_IndexFormat; }
+    uint32_t GetLodCount() const { return m_LodCount; }
+    const Lod& GetLod(const uint32_t lod) const { return m_Lods[lod]; }
     MaterialIdentifier GetMaterialId() const { return m_MaterialId; }
+    const MaterialTexture& GetMaterialTexture() const { return m_MaterialTexture; }
+    AlphaMode GetAlphaMode() const { return m_AlphaMode; }
     const BoundingBox& GetBoundingBox() const { return m_BoundingBox; }
     const BoundingSphere& GetBoundingSphere() const { return m_BoundingSphere; }
 
 private:
-    uint32_t m_IndexCount;
-    uint32_t m_FirstIndex;
+    std::array<Lod, kMaxLodCount> m_Lods{};
+    uint32_t m_LodCount{ 1 };
     uint32_t m_BaseVertex;
+    uint32_t m_FirstMeshlet;
+    uint32_t m_MeshletCount;
+    IndexFormat m_IndexFormat;
     MaterialIdentifier m_MaterialId;
+    MaterialTexture m_MaterialTexture;
+    AlphaMode m_AlphaMode;
     BoundingBox m_BoundingBox;
     BoundingSphere m_BoundingSphere;
 };
@@ -86,10 +205,40 @@ public:
         MLG_ABORTIF(!mesh, "MeshInstance cannot be created with an invalid mesh pointer");
     }
 
+    /// @brief Selects the mesh LOD drawn for this instance.
+    void SetLod(const uint32_t lod)
+    {
+        MLG_ASSERT(lod < m_Mesh->GetLodCount(), "Invalid LOD: {}", lod);
+        m_Lod = lod;
+    }
+
+    /// @brief Draws only part of LOD 0, such as the mesh's visible meshlets.
+    void SetIndexRange(const uint32_t firstIndex, const uint32_t indexCount)
+    {
+        MLG_ASSERT(m_Lod == 0, "Index ranges are only supported for LOD 0");
+        MLG_ASSERT(firstIndex >= m_Mesh->GetFirstIndex()
+                && firstIndex + indexCount <= m_Mesh->GetFirstIndex() + m_Mesh->GetIndexCount(),
+            "Index range is outside the mesh");
+        m_FirstIndex = firstIndex;
+        m_IndexCount = indexCount;
+    }
+
+    const Mesh* GetMesh() const { return m_Mesh; }
+    uint32_t GetLod() const { return m_Lod; }
     MaterialIdentifier GetMaterialId() const { return m_Mesh->GetMaterialId(); }
-    uint32_t GetIndexCount() const { return m_Mesh->GetIndexCount(); }
-    uint32_t GetFirstIndex() const { return m_Mesh->GetFirstIndex(); }
+    const MaterialTexture& GetMaterialTexture() const { return m_Mesh->GetMaterialTexture(); }
+    ShaderVariant GetShaderVariant() const { return GetMaterialTexture().GetShaderVariant(); }
+    AlphaMode GetAlphaMode() const { return m_Mesh->GetAlphaMode(); }
+    uint32_t GetIndexCount() const
+    {
+        return m_IndexCount > 0 ? m_IndexCount : m_Mesh->GetLod(m_Lod).IndexCount;
+    }
+    uint32_t GetFirstIndex() const
+    {
+        return m_IndexCount > 0 ? m_FirstIndex : m_Mesh->GetLod(m_Lod).FirstIndex;
+    }
     uint32_t GetBaseVertex() const { return m_Mesh->GetBaseVertex(); }
+    IndexFormat GetIndexFormat() const { return m_Mesh->GetIndexFormat(); }
     const BoundingBox& GetBoundingBox() const { return m_Mesh->GetBoundingBox(); }
     const BoundingSphere& GetBoundingSphere() const { return m_Mesh->GetBoundingSphere(); }
     size_t GetInstanceIndex() const { return m_InstanceIndex; }
@@ -97,4 +246,27 @@ public:
 private:
     const Mesh* m_Mesh{ nullptr };
     size_t m_InstanceIndex{ 0 };
+    uint32_t m_Lod{ 0 };
+    // Set by SetIndexRange(). A count of zero draws the whole LOD.
+    uint32_t m_FirstIndex{ 0 };
+    uint32_t m_IndexCount{ 0 };
+};
+
+/// @brief A group of visible instances of the same mesh that are rendered with a single
+/// instanced indirect draw.
+struct DrawBatch
+{
+    // Select the pipeline the batch is drawn with.
+    AlphaMode AlphaMode{ AlphaMode::Opaque };
+    ShaderVariant ShaderVariant{ ShaderVariant::Textured };
+
+    // Selects the texture array bind group the batch is drawn with. Unused by untextured
+    // batches.
+    uint32_t TextureArrayIndex{ 0 };
+
+    // Selects the index buffer the batch is drawn with.
+    IndexFormat IndexFormat{ IndexFormat::Uint32 };
+
+    // Index of the batch's parameters in the draw indirect buffer.
+    uint32_t DrawIndex{ 0 };
 };
\ No newline at end of file
@@ -0,0 +1,182 @@
+#define MLG_LOGGER_NAME "SIM"
+
+#include "SimulationThread.h"
+
+#include "Log.h"
+#include "PerfMetrics.h"
+
+#include <chrono>
+
+namespace
+{
+std::vector<Mat44f>
+GetWorldTransforms(const std::span<const ModelNode> modelNodes)
+{
+    std::vector<Mat44f> transforms;
+    transforms.reserve(modelNodes.size());
+
+    for(const ModelNode& modelNode : modelNodes)
+    {
+        transforms.push_back(modelNode.GetWorldTransform());
+    }
+
+    return transforms;
+}
+} // namespace
+
+Result<std::unique_ptr<SimulationThread>>
+SimulationThread::Create(const float timeStep,
+    const std::span<const ModelNode> modelNodes,
+    StepFunc stepFunc,
+    void* userData)
+{
+    MLG_CHECKV(timeStep > 0, "Time step must be positive");
+    MLG_CHECKV(stepFunc, "Invalid step function");
+
+    std::unique_ptr<SimulationThread> simThread(
+        new SimulationThread(timeStep, modelNodes, stepFunc, userData));
+
+    simThread->m_Thread = std::thread(ThreadLoop, simThread.get());
+
+    MLG_DEBUG("Started simulation thread with time step {}s", timeStep);
+
+    return simThread;
+}
+
+SimulationThread::~SimulationThread()
+{
+    {
+        const std::lock_guard<std::mutex> lock(m_Mutex);
+        m_StopRequested = true;
+    }
+
+    m_WakeCv.notify_one();
+
+    if(m_Thread.joinable())
+    {
+        m_Thread.join();
+    }
+}
+
+void
+SimulationThread::Post(CommandFunc commandFunc, void* userData)
+{
+    {
+        const std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Commands.push_back({ .Func = commandFunc, .UserData = userData });
+    }
+
+    m_WakeCv.notify_one();
+}
+
+void
+SimulationThread::SetPaused(const bool paused)
+{
+    m_Paused.store(paused, std::memory_order_relaxed);
+    m_WakeCv.notify_one();
+}
+
+// private:
+
+SimulationThread::SimulationThread(const float timeStep,
+    const std::span<const ModelNode> modelNodes,
+    StepFunc stepFunc,
+    void* userData)
+    : m_TimeStep(timeStep),
+      m_ModelNodes(modelNodes),
+      m_StepFunc(stepFunc),
+      m_UserData(userData),
+      m_Snapshots(GetWorldTransforms(modelNodes))
+{
+    for(size_t i = 0; i < modelNodes.size(); ++i)
+    {
+        if(!modelNodes[i].IsStatic())
+        {
+            m_DynamicNodeIndices.push_back(i);
+        }
+    }
+}
+
+void
+SimulationThread::ThreadLoop(SimulationThread* simThread)
+{
+    using Clock = std::chrono::steady_clock;
+
+    const Clock::duration stepDuration = std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<float>(simThread->m_TimeStep));
+
+    Clock::time_point nextStepTime = Clock::now();
+    std::vector<Command> commands;
+
+    while(true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(simThread->m_Mutex);
+
+            // Sleep until the next step is due, waking early to run commands or stop.
+            simThread->m_WakeCv.wait_until(lock,
+                nextStepTime,
+                [simThread]
+                { return simThread->m_StopRequested || !simThread->m_Commands.empty(); });
+
+            if(simThread->m_StopRequested)
+            {
+                break;
+            }
+
+            std::swap(commands, simThread->m_Commands);
+        }
+
+        for(const Command& command : commands)
+        {
+            command.Func(command.UserData);
+        }
+
+        commands.clear();
+
+        const Clock::time_point now = Clock::now();
+
+        if(now < nextStepTime)
+        {
+            continue;
+        }
+
+        if(simThread->IsPaused())
+        {
+            nextStepTime = now + stepDuration;
+            continue;
+        }
+
+        // Drop lag beyond a few steps, e.g. after hitting a breakpoint, rather than stepping
+        // as fast as possible until caught up.
+        if(now - nextStepTime > stepDuration * kMaxCatchUpSteps)
+        {
+            nextStepTime = now;
+        }
+
+        simThread->m_StepFunc(simThread->m_UserData, simThread->m_TimeStep);
+        simThread->PublishSnapshot();
+
+        nextStepTime += stepDuration;
+    }
+}
+
+void
+SimulationThread::PublishSnapshot()
+{
+    static PerfCounter pcSteps({ .Name = "SimulationThread.Steps" });
+
+    const std::span<Mat44f> transforms = m_Snapshots.GetBackBuffer();
+
+    for(const size_t index : m_DynamicNodeIndices)
+    {
+        transforms[index] = m_ModelNodes[index].GetWorldTransform();
+    }
+
+    const uint64_t stepCount = m_StepCount.load(std::memory_order_relaxed) + 1;
+
+    m_Snapshots.Publish(stepCount);
+    m_StepCount.store(stepCount, std::memory_order_relaxed);
+
+    pcSteps.Increment(1);
+}
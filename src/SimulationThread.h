@@ -0,0 +1,125 @@
+#pragma once
+
+#include "LevelTypes.h"
+#include "Result.h"
+#include "TransformSnapshotBuffer.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <thread>
+#include <vector>
+
+/// @brief Steps a simulation at a fixed rate on its own thread and publishes the world
+/// transforms of model nodes after every step.
+///
+/// Every step advances the simulation by the same time step, so the outcome depends only on the
+/// number of steps taken and the commands run between them, not on how long frames take.
+/// Steps are paced by wall clock time. A simulation that falls behind catches up by at most
+/// kMaxCatchUpSteps steps and then drops the remaining lag.
+///
+/// While the thread runs it owns the simulation. Other threads change the simulation by
+/// posting commands, which run on the simulation thread between steps, and read model node
+/// transforms from the published snapshots. Steps must only move dynamic nodes; the transforms
+/// of static nodes are captured once.
+class SimulationThread final
+{
+public:
+    using StepFunc = void (*)(void* userData, float timeStep);
+    using CommandFunc = void (*)(void* userData);
+
+    static constexpr uint32_t kMaxCatchUpSteps = 4;
+
+    /// @brief Starts a simulation thread.
+    /// @param timeStep The time step, in seconds, passed to every step.
+    /// @param modelNodes The model nodes whose transforms are published. Transform i of each
+    /// snapshot belongs to modelNodes[i].
+    /// @param stepFunc Advances the simulation by one step.
+    static Result<std::unique_ptr<SimulationThread>> Create(const float timeStep,
+        const std::span<const ModelNode> modelNodes,
+        StepFunc stepFunc,
+        void* userData);
+
+    template<auto Func, typename T>
+    static Result<std::unique_ptr<SimulationThread>>
+    Create(const float timeStep, const std::span<const ModelNode> modelNodes, T* userData)
+    {
+        static_assert(std::is_invocable_v<decltype(Func), T*, float>);
+
+        auto wrapperFunc = [](void* data, float step) { Func(static_cast<T*>(data), step); };
+
+        return Create(timeStep, modelNodes, wrapperFunc, userData);
+    }
+
+    SimulationThread() = delete;
+    /// @brief Stops the thread after its current step. Commands that haven't run are dropped.
+    ~SimulationThread();
+    SimulationThread(const SimulationThread&) = delete;
+    SimulationThread& operator=(const SimulationThread&) = delete;
+    SimulationThread(SimulationThread&&) = delete;
+    SimulationThread& operator=(SimulationThread&&) = delete;
+
+    /// @brief Posts a command to run on the simulation thread before its next step.
+    /// Commands run in the order they're posted, including while the simulation is paused.
+    void Post(CommandFunc commandFunc, void* userData);
+
+    template<auto Func, typename T>
+    void Post(T* userData)
+    {
+        static_assert(std::is_invocable_v<decltype(Func), T*>);
+
+        auto wrapperFunc = [](void* data) { Func(static_cast<T*>(data)); };
+
+        Post(wrapperFunc, userData);
+    }
+
+    void SetPaused(const bool paused);
+
+    bool IsPaused() const { return m_Paused.load(std::memory_order_relaxed); }
+
+    /// @brief Returns the number of steps taken.
+    uint64_t GetStepCount() const { return m_StepCount.load(std::memory_order_relaxed); }
+
+    const TransformSnapshotBuffer& GetSnapshots() const { return m_Snapshots; }
+
+    std::span<const ModelNode> GetModelNodes() const { return m_ModelNodes; }
+
+private:
+    struct Command
+    {
+        CommandFunc Func;
+        void* UserData;
+    };
+
+    SimulationThread(const float timeStep,
+        const std::span<const ModelNode> modelNodes,
+        StepFunc stepFunc,
+        void* userData);
+
+    static void ThreadLoop(SimulationThread* simThread);
+
+    // Captures the transforms of dynamic nodes and publishes them.
+    void PublishSnapshot();
+
+    const float m_TimeStep;
+    const std::span<const ModelNode> m_ModelNodes;
+    const StepFunc m_StepFunc;
+    void* const m_UserData;
+
+    TransformSnapshotBuffer m_Snapshots;
+    // Indices of the model nodes that steps can move.
+    std::vector<size_t> m_DynamicNodeIndices;
+
+    // Guards m_Commands and m_StopRequested.
+    std::mutex m_Mutex;
+    std::condition_variable m_WakeCv;
+    std::vector<Command> m_Commands;
+    bool m_StopRequested{ false };
+
+    std::atomic<bool> m_Paused{ false };
+    std::atomic<uint64_t> m_StepCount{ 0 };
+    std::thread m_Thread;
+};
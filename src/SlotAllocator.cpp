@@ -0,0 +1,35 @@
+#include "SlotAllocator.h"
+
+#include "AssertHelper.h"
+
+#include <algorithm>
+#include <functional>
+
+uint32_t
+SlotAllocator::Allocate()
+{
+    if(m_FreeSlots.empty())
+    {
+        m_Allocated.push_back(true);
+        return GetSlotCount() - 1;
+    }
+
+    std::ranges::pop_heap(m_FreeSlots, std::greater{});
+    const uint32_t slot = m_FreeSlots.back();
+    m_FreeSlots.pop_back();
+
+    m_Allocated[slot] = true;
+
+    return slot;
+}
+
+void
+SlotAllocator::Free(const uint32_t slot)
+{
+    MLG_ASSERT(IsAllocated(slot), "Slot {} is not allocated", slot);
+
+    m_Allocated[slot] = false;
+
+    m_FreeSlots.push_back(slot);
+    std::ranges::push_heap(m_FreeSlots, std::greater{});
+}
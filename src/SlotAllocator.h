@@ -0,0 +1,46 @@
+#pragma once
+
+#include "narrow_cast.h"
+
+#include <cstdint>
+#include <vector>
+
+/// @brief Allocates slots, i.e. indices into a growable array such as a GPU buffer.
+///
+/// Freed slots are reused, lowest first, before new slots are added at the end. This keeps
+/// the array compact as items are added and removed.
+class SlotAllocator final
+{
+public:
+    SlotAllocator() = default;
+    ~SlotAllocator() = default;
+    SlotAllocator(const SlotAllocator&) = delete;
+    SlotAllocator& operator=(const SlotAllocator&) = delete;
+    SlotAllocator(SlotAllocator&&) = default;
+    SlotAllocator& operator=(SlotAllocator&&) = default;
+
+    /// @brief Allocates a slot.
+    uint32_t Allocate();
+
+    /// @brief Returns a slot for reuse.
+    void Free(const uint32_t slot);
+
+    bool IsAllocated(const uint32_t slot) const
+    {
+        return slot < m_Allocated.size() && m_Allocated[slot];
+    }
+
+    /// @brief Returns the number of slots currently allocated.
+    uint32_t GetAllocatedCount() const { return GetSlotCount() - GetFreeCount(); }
+
+    /// @brief Returns one past the highest slot ever allocated.
+    /// Arrays indexed by slots must hold at least this many elements.
+    uint32_t GetSlotCount() const { return narrow_cast<uint32_t>(m_Allocated.size()); }
+
+private:
+    uint32_t GetFreeCount() const { return narrow_cast<uint32_t>(m_FreeSlots.size()); }
+
+    // Min-heap of freed slots.
+    std::vector<uint32_t> m_FreeSlots;
+    std::vector<bool> m_Allocated;
+};
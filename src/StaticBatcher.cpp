@@ -0,0 +1,355 @@
+#include "StaticBatcher.h"
+
+#include "narrow_cast.h"
+
+#include <algorithm>
+#include <format>
+#include <map>
+#include <set>
+#include <span>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace
+{
+// A mesh of a batched node.
+struct BatchItem
+{
+    const MeshDef* Source;
+    Mat44f WorldTransform;
+    BoundingBox WorldBounds;
+};
+
+using ModelRefCounts = std::map<std::string, size_t, std::less<>>;
+
+// Nodes, root or not, whose model was batched.
+using BatchedNodes = std::unordered_set<const void*>;
+
+void
+CountModelRefs(const std::span<const LevelNodeDef> nodeDefs, ModelRefCounts& refCounts)
+{
+    for(const LevelNodeDef& nodeDef : nodeDefs)
+    {
+        if(nodeDef.Model)
+        {
+            ++refCounts[nodeDef.Model->Name];
+        }
+
+        CountModelRefs(nodeDef.Children, refCounts);
+    }
+}
+
+const ModelDef*
+FindModelDef(const PropKitDef& propKitDef, const std::string_view name)
+{
+    const auto it = std::ranges::find(propKitDef.ModelDefs, name, &ModelDef::Name);
+
+    return it != propKitDef.ModelDefs.end() ? &*it : nullptr;
+}
+
+// Moves the meshes of batchable nodes to items and removes the nodes' model references.
+template<typename T>
+void
+CollectBatchItems(T& nodeDef,
+    const Mat44f& parentTransform,
+    const PropKitDef& propKitDef,
+    const ModelRefCounts& refCounts,
+    std::vector<BatchItem>& outItems,
+    std::set<std::string, std::less<>>& outBatchedModels,
+    BatchedNodes& outBatchedNodes)
+{
+    const Mat44f worldTransform = parentTransform * nodeDef.Transform.ToMatrix();
+
+    if(nodeDef.Model)
+    {
+        const ModelDef* modelDef = FindModelDef(propKitDef, nodeDef.Model->Name);
+
+        const bool batchable = modelDef && refCounts.find(modelDef->Name)->second == 1
+            && std::ranges::none_of(modelDef->MeshDefs,
+                [](const MeshDef& meshDef)
+                { return meshDef.MaterialDef.AlphaMode == AlphaMode::Blend; });
+
+        if(batchable)
+        {
+            for(const MeshDef& meshDef : modelDef->MeshDefs)
+            {
+                if(meshDef.Indices.empty())
+                {
+                    continue;
+                }
+
+                outItems.push_back(BatchItem //
+                    {
+                        .Source = &meshDef,
+                        .WorldTransform = worldTransform,
+                        .WorldBounds = worldTransform
+                            * BoundingBox::FromVertices(meshDef.Vertices, meshDef.Indices),
+                    });
+            }
+
+            outBatchedModels.insert(modelDef->Name);
+            outBatchedNodes.insert(&nodeDef);
+            nodeDef.Model.reset();
+        }
+    }
+
+    for(LevelNodeDef& childDef : nodeDef.Children)
+    {
+        CollectBatchItems(childDef,
+            worldTransform,
+            propKitDef,
+            refCounts,
+            outItems,
+            outBatchedModels,
+            outBatchedNodes);
+    }
+}
+
+// Splits items into clusters at the median of their centers along the longest axis, until
+// clusters are small enough, or too few meshes to be worth splitting, and fit 16-bit indices.
+// Each cluster is a contiguous range.
+void
+SplitClusters(const std::span<BatchItem> items,
+    const float maxExtent,
+    std::vector<std::span<BatchItem>>& outClusters)
+{
+    BoundingBox bounds = items.front().WorldBounds;
+    Vec3f minCenter = items.front().WorldBounds.GetCenter();
+    Vec3f maxCenter = minCenter;
+    size_t vertexCount = 0;
+
+    for(const BatchItem& item : items)
+    {
+        const Vec3f& center = item.WorldBounds.GetCenter();
+
+        bounds += item.WorldBounds;
+        minCenter = Vec3f(std::min(minCenter.x, center.x),
+            std::min(minCenter.y, center.y),
+            std::min(minCenter.z, center.z));
+        maxCenter = Vec3f(std::max(maxCenter.x, center.x),
+            std::max(maxCenter.y, center.y),
+            std::max(maxCenter.z, center.z));
+        vertexCount += item.Source->Vertices.size();
+    }
+
+    const Vec3f extent = bounds.GetHalfExtents() * 2.0f;
+    const float largestExtent = std::max({ extent.x, extent.y, extent.z });
+
+    const bool smallEnough =
+        largestExtent <= maxExtent || items.size() <= StaticBatcher::kMinClusterMeshCount;
+
+    if(items.size() == 1 || (smallEnough && vertexCount <= kMaxVertexIndex16Count))
+    {
+        outClusters.push_back(items);
+        return;
+    }
+
+    const Vec3f centerExtent = maxCenter - minCenter;
+    size_t axis = 0;
+    for(size_t i = 1; i < 3; ++i)
+    {
+        if(centerExtent[i] > centerExtent[axis])
+        {
+            axis = i;
+        }
+    }
+
+    auto getCenter = [axis](const BatchItem& item) { return item.WorldBounds.GetCenter()[axis]; };
+
+    const auto median = items.begin() + narrow_cast<ptrdiff_t>(items.size() / 2);
+    std::ranges::nth_element(items, median, {}, getCenter);
+
+    const size_t half = items.size() / 2;
+    SplitClusters(items.first(half), maxExtent, outClusters);
+    SplitClusters(items.subspan(half), maxExtent, outClusters);
+}
+
+// Merges a cluster's meshes into one mesh in world space.
+MeshDef
+MergeCluster(const std::span<const BatchItem> cluster)
+{
+    MeshDef merged //
+        {
+            .Vertices = {},
+            .Indices = {},
+            .MaterialDef = cluster.front().Source->MaterialDef,
+        };
+
+    for(const BatchItem& item : cluster)
+    {
+        const MeshDef& meshDef = *item.Source;
+        const Mat44f& transform = item.WorldTransform;
+        // Normals transform by the inverse transpose so non-uniform scales keep them
+        // perpendicular to their surfaces.
+        const Mat44f normalTransform = transform.Inverse().Transpose();
+
+        const Vec3f col0(transform[0]);
+        const Vec3f col1(transform[1]);
+        const Vec3f col2(transform[2]);
+        // Mirroring transforms flip triangle winding.
+        const bool mirrored = col0.Dot(col1.Cross(col2)) < 0;
+
+        const VertexIndex baseVertex = narrow_cast<VertexIndex>(merged.Vertices.size());
+
+        for(const Vertex& vertex : meshDef.Vertices)
+        {
+            Vertex& outVertex = merged.Vertices.emplace_back(vertex);
+            outVertex.pos = Vec3f(transform * vertex.pos);
+
+            const Vec3f normal(normalTransform * Vec4f(vertex.normal, 0));
+            const float normalLength = normal.Length();
+            outVertex.normal = normalLength > 0 ? normal / normalLength : vertex.normal;
+        }
+
+        for(size_t i = 0; i < meshDef.Indices.size(); i += 3)
+        {
+            const VertexIndex i0 = baseVertex + meshDef.Indices[i];
+            const VertexIndex i1 = baseVertex + meshDef.Indices[i + 1];
+            const VertexIndex i2 = baseVertex + meshDef.Indices[i + 2];
+
+            if(mirrored)
+            {
+                merged.Indices.insert(merged.Indices.end(), { i0, i2, i1 });
+            }
+            else
+            {
+                merged.Indices.insert(merged.Indices.end(), { i0, i1, i2 });
+            }
+        }
+    }
+
+    return merged;
+}
+
+// Removes batched nodes left with no children, after pruning their children. Nodes that had no
+// model to begin with, e.g. anchors, are kept. Nodes must not have moved since they were
+// batched.
+template<typename T>
+void
+PruneBatchedNodes(std::vector<T>& nodeDefs, const BatchedNodes& batchedNodes)
+{
+    for(T& nodeDef : nodeDefs)
+    {
+        PruneBatchedNodes(nodeDef.Children, batchedNodes);
+    }
+
+    std::erase_if(nodeDefs,
+        [&batchedNodes](const T& nodeDef)
+        { return batchedNodes.contains(&nodeDef) && nodeDef.Children.empty(); });
+}
+} // namespace
+
+size_t
+StaticBatcher::Build(PropKitDef& propKitDef, LevelDef& levelDef)
+{
+    ModelRefCounts refCounts;
+
+    for(const RootNodeDef& rootDef : levelDef.NodeDefs)
+    {
+        if(rootDef.Model)
+        {
+            ++refCounts[rootDef.Model->Name];
+        }
+
+        CountModelRefs(rootDef.Children, refCounts);
+    }
+
+    std::vector<BatchItem> items;
+    std::set<std::string, std::less<>> batchedModels;
+    BatchedNodes batchedNodes;
+
+    for(RootNodeDef& rootDef : levelDef.NodeDefs)
+    {
+        // Rigid bodies move their nodes and everything under them.
+        if(rootDef.Body)
+        {
+            continue;
+        }
+
+        CollectBatchItems(rootDef,
+            Mat44f::Identity,
+            propKitDef,
+            refCounts,
+            items,
+            batchedModels,
+            batchedNodes);
+    }
+
+    if(items.empty())
+    {
+        return 0;
+    }
+
+    BoundingBox levelBounds = items.front().WorldBounds;
+    for(const BatchItem& item : items)
+    {
+        levelBounds += item.WorldBounds;
+    }
+
+    const Vec3f levelExtent = levelBounds.GetHalfExtents() * 2.0f;
+    const float maxExtent =
+        std::max({ levelExtent.x, levelExtent.y, levelExtent.z }) * kMaxClusterExtentFraction;
+
+    // Group by material, then split each group into spatial clusters.
+    std::map<MaterialDef, std::vector<BatchItem>> materialItems;
+    for(const BatchItem& item : items)
+    {
+        materialItems[item.Source->MaterialDef].push_back(item);
+    }
+
+    std::vector<std::span<BatchItem>> clusters;
+
+    for(auto& [materialDef, groupItems] : materialItems)
+    {
+        SplitClusters(groupItems, maxExtent, clusters);
+    }
+
+    // Pruned before batch nodes are added, while batched nodes are where they were found.
+    PruneBatchedNodes(levelDef.NodeDefs, batchedNodes);
+
+    // Batch names skip names of models already in the kit.
+    std::set<std::string, std::less<>> modelNames;
+    for(const ModelDef& modelDef : propKitDef.ModelDefs)
+    {
+        modelNames.insert(modelDef.Name);
+    }
+
+    size_t nextBatchIndex = 0;
+
+    // Batched models are removed only after merging, as items point into them.
+    std::vector<ModelDef> batchModelDefs;
+    batchModelDefs.reserve(clusters.size());
+
+    for(const std::span<BatchItem> cluster : clusters)
+    {
+        std::string name;
+        do
+        {
+            name = std::format("StaticBatch{}", nextBatchIndex++);
+        } while(modelNames.contains(name));
+
+        levelDef.NodeDefs.push_back(RootNodeDef //
+            {
+                .Name = name,
+                .Transform = TrsTransformf::Identity,
+                .Children = {},
+                .Model = ModelRef{ .Name = name },
+                .Body = std::nullopt,
+            });
+
+        batchModelDefs.push_back(ModelDef //
+            {
+                .Name = std::move(name),
+                .MeshDefs = { MergeCluster(cluster) },
+            });
+    }
+
+    std::erase_if(propKitDef.ModelDefs,
+        [&batchedModels](const ModelDef& modelDef)
+        { return batchedModels.contains(modelDef.Name); });
+
+    std::ranges::move(batchModelDefs, std::back_inserter(propKitDef.ModelDefs));
+
+    return items.size();
+}
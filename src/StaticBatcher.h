@@ -0,0 +1,40 @@
+#pragma once
+
+#include "LevelDefs.h"
+
+#include <cstddef>
+
+/// @brief Merges the meshes of static level nodes into batches pre-transformed to world space.
+///
+/// Each batch holds the meshes of one material within one spatial cluster, so a level of many
+/// small meshes draws with a few large ones. Clusters are split until they're a small fraction
+/// of the batched geometry's extent, or hold only a few meshes, and fit 16-bit indices, so
+/// batches still cull well.
+///
+/// A node is batched if it's static, i.e. not under a rigid body, and references a model that
+/// no other node references and that has no blended meshes. Models instanced more than once
+/// keep drawing instanced, and blended meshes keep drawing back to front.
+class StaticBatcher final
+{
+public:
+    // The largest batch is at most this fraction of the batched geometry's largest extent.
+    static constexpr float kMaxClusterExtentFraction = 0.125f;
+
+    // Clusters of at most this many meshes aren't split for size, as they cost few draws.
+    static constexpr size_t kMinClusterMeshCount = 4;
+
+    StaticBatcher() = delete;
+    ~StaticBatcher() = delete;
+    StaticBatcher(const StaticBatcher&) = delete;
+    StaticBatcher& operator=(const StaticBatcher&) = delete;
+    StaticBatcher(StaticBatcher&&) = delete;
+    StaticBatcher& operator=(StaticBatcher&&) = delete;
+
+    /// @brief Replaces the level's batchable nodes with batches.
+    ///
+    /// Batches are added to propKitDef as models, each referenced by a new root node with an
+    /// identity transform, and named so they don't collide with models already in the kit.
+    /// Batched models are removed, as are batched nodes left with no children.
+    /// @return The number of meshes that were batched.
+    static size_t Build(PropKitDef& propKitDef, LevelDef& levelDef);
+};
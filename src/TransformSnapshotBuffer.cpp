@@ -0,0 +1,18 @@
+#include "TransformSnapshotBuffer.h"
+
+TransformSnapshotBuffer::TransformSnapshotBuffer(const std::span<const Mat44f> transforms)
+    : m_Snapshots{ {
+          { .Transforms{ transforms.begin(), transforms.end() } },
+          { .Transforms{ transforms.begin(), transforms.end() } },
+      } }
+{
+}
+
+void
+TransformSnapshotBuffer::Publish(const uint64_t step)
+{
+    const std::lock_guard<std::mutex> lock(m_Mutex);
+
+    m_Snapshots[m_BackIndex].Step = step;
+    m_BackIndex = 1 - m_BackIndex;
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "VecMath.h"
+
+#include <array>
+#include <cstdint>
+#include <mutex>
+#include <span>
+#include <vector>
+
+/// @brief Double-buffered snapshots of world transforms, written by one thread and read by
+/// others.
+///
+/// The writer fills the back buffer without locking and makes it the latest snapshot with
+/// Publish(). Readers lock the latest snapshot while reading it, which keeps Publish() from
+/// handing it back to the writer, so readers always see a complete snapshot.
+class TransformSnapshotBuffer final
+{
+public:
+    /// @brief Creates snapshots holding the given transforms, published as step zero.
+    explicit TransformSnapshotBuffer(const std::span<const Mat44f> transforms);
+
+    TransformSnapshotBuffer() = delete;
+    ~TransformSnapshotBuffer() = default;
+    TransformSnapshotBuffer(const TransformSnapshotBuffer&) = delete;
+    TransformSnapshotBuffer& operator=(const TransformSnapshotBuffer&) = delete;
+    TransformSnapshotBuffer(TransformSnapshotBuffer&&) = delete;
+    TransformSnapshotBuffer& operator=(TransformSnapshotBuffer&&) = delete;
+
+    /// @brief Returns the back buffer. Only the writer may call this.
+    /// The back buffer holds the snapshot published before the latest one, so every transform
+    /// that changed since then must be rewritten before the next Publish().
+    std::span<Mat44f> GetBackBuffer() { return m_Snapshots[m_BackIndex].Transforms; }
+
+    /// @brief Makes the back buffer the latest snapshot. Only the writer may call this.
+    /// @param step The simulation step the snapshot was taken after.
+    void Publish(const uint64_t step);
+
+    /// @brief Calls readFunc with the transforms of the latest snapshot and returns the step it
+    /// was taken after.
+    /// The writer can't publish while readFunc runs, so it should return quickly.
+    template<typename F>
+    uint64_t Read(F&& readFunc) const
+    {
+        const std::lock_guard<std::mutex> lock(m_Mutex);
+
+        const Snapshot& front = m_Snapshots[1 - m_BackIndex];
+
+        readFunc(std::span<const Mat44f>(front.Transforms));
+
+        return front.Step;
+    }
+
+    /// @brief Returns the number of transforms in each snapshot.
+    size_t GetCount() const { return m_Snapshots[0].Transforms.size(); }
+
+private:
+    struct Snapshot
+    {
+        std::vector<Mat44f> Transforms;
+        uint64_t Step{ 0 };
+    };
+
+    std::array<Snapshot, 2> m_Snapshots;
+
+    // Only changed by the writer, while holding m_Mutex.
+    size_t m_BackIndex{ 0 };
+
+    mutable std::mutex m_Mutex;
+};
@@ -3,6 +3,7 @@
 #include "VecMath.h"
 
 #include <climits>
+#include <cstdint>
 
 struct UV2
 {
@@ -33,6 +34,42 @@ struct VertexT<0>
 
 using Vertex = VertexT<1>;
 
+/// @brief Compact form of Vertex. See VertexQuantization.
+struct QuantizedVertex
+{
+    // Unorm16 position relative to the mesh's bounds. w is padding.
+    uint16_t pos[4];
+    // Snorm16 octahedral encoded normal.
+    int16_t normal[2];
+    // Half float texture coordinates.
+    uint16_t uv[2];
+};
+
+/// @brief Layout of the vertices in a vertex buffer.
+enum class VertexFormat : uint8_t
+{
+    // Vertex
+    Float,
+    // QuantizedVertex
+    Quantized,
+};
+
 using VertexIndex = uint32_t;
 
+/// @brief Indices of meshes with at most kMaxVertexIndex16Count vertices.
+using VertexIndex16 = uint16_t;
+
+constexpr size_t kMaxVertexIndex16Count = size_t{ 1 } << 16;
+
+/// @brief Width of the indices in an index buffer.
+enum class IndexFormat : uint8_t
+{
+    // VertexIndex16
+    Uint16,
+    // VertexIndex
+    Uint32,
+};
+
+constexpr size_t kIndexFormatCount = 2;
+
 constexpr int VERTEX_INDEX_BITS = sizeof(VertexIndex) * CHAR_BIT;
\ No newline at end of file
@@ -0,0 +1,214 @@
+#include "VertexQuantization.h"
+
+#include "narrow_cast.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+namespace
+{
+constexpr float kUnorm16Max = 65535.0f;
+constexpr float kSnorm16Max = 32767.0f;
+
+uint16_t
+EncodeUnorm16(const float value, const float offset, const float scale)
+{
+    // Flat meshes have no extent along some axis.
+    const float normalized = scale > 0 ? std::clamp((value - offset) / scale, 0.0f, 1.0f) : 0.0f;
+
+    return static_cast<uint16_t>((normalized * kUnorm16Max) + 0.5f);
+}
+
+float
+DecodeUnorm16(const uint16_t value, const float offset, const float scale)
+{
+    return offset + ((static_cast<float>(value) / kUnorm16Max) * scale);
+}
+
+int16_t
+EncodeSnorm16(const float value)
+{
+    return narrow_cast<int16_t>(std::lround(std::clamp(value, -1.0f, 1.0f) * kSnorm16Max));
+}
+
+float
+DecodeSnorm16(const int16_t value)
+{
+    return std::max(static_cast<float>(value) / kSnorm16Max, -1.0f);
+}
+
+float
+SignNotZero(const float value)
+{
+    return value >= 0 ? 1.0f : -1.0f;
+}
+
+// Rounds value >> shift to nearest even.
+uint32_t
+ShiftRightRounded(const uint32_t value, const uint32_t shift)
+{
+    const uint32_t halfway = 1u << (shift - 1);
+    const uint32_t remainder = value & ((1u << shift) - 1);
+    const uint32_t shifted = value >> shift;
+
+    return (remainder > halfway || (remainder == halfway && (shifted & 1) != 0))
+        ? shifted + 1
+        : shifted;
+}
+} // namespace
+
+QuantizedVertex
+VertexQuantization::Encode(const Vertex& vertex, const PositionQuantization& quantization)
+{
+    const std::array<int16_t, 2> normal = EncodeOctahedral(vertex.normal);
+
+    return QuantizedVertex //
+        {
+            .pos =
+            {
+                EncodeUnorm16(vertex.pos.x, quantization.Offset.x, quantization.Scale.x),
+                EncodeUnorm16(vertex.pos.y, quantization.Offset.y, quantization.Scale.y),
+                EncodeUnorm16(vertex.pos.z, quantization.Offset.z, quantization.Scale.z),
+                0,
+            },
+            .normal = { normal[0], normal[1] },
+            .uv = { FloatToHalf(vertex.uvs[0].u), FloatToHalf(vertex.uvs[0].v) },
+        };
+}
+
+void
+VertexQuantization::Encode(const std::span<const Vertex> vertices,
+    const PositionQuantization& quantization,
+    std::vector<QuantizedVertex>& outVertices)
+{
+    outVertices.reserve(outVertices.size() + vertices.size());
+
+    for(const Vertex& vertex : vertices)
+    {
+        outVertices.push_back(Encode(vertex, quantization));
+    }
+}
+
+Vertex
+VertexQuantization::Decode(const QuantizedVertex& vertex, const PositionQuantization& quantization)
+{
+    return Vertex //
+        {
+            .pos = Vec3f(DecodeUnorm16(vertex.pos[0], quantization.Offset.x, quantization.Scale.x),
+                DecodeUnorm16(vertex.pos[1], quantization.Offset.y, quantization.Scale.y),
+                DecodeUnorm16(vertex.pos[2], quantization.Offset.z, quantization.Scale.z)),
+            .normal = DecodeOctahedral({ vertex.normal[0], vertex.normal[1] }),
+            .uvs = { { .u = HalfToFloat(vertex.uv[0]), .v = HalfToFloat(vertex.uv[1]) } },
+        };
+}
+
+std::array<int16_t, 2>
+VertexQuantization::EncodeOctahedral(const Vec3f& normal)
+{
+    const float l1Norm = std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z);
+
+    if(l1Norm <= 0)
+    {
+        return { 0, 0 };
+    }
+
+    // Project onto the octahedron, then fold the lower hemisphere over the upper one.
+    float x = normal.x / l1Norm;
+    float y = normal.y / l1Norm;
+
+    if(normal.z < 0)
+    {
+        const float foldedX = (1 - std::abs(y)) * SignNotZero(x);
+        const float foldedY = (1 - std::abs(x)) * SignNotZero(y);
+        x = foldedX;
+        y = foldedY;
+    }
+
+    return { EncodeSnorm16(x), EncodeSnorm16(y) };
+}
+
+Vec3f
+VertexQuantization::DecodeOctahedral(const std::array<int16_t, 2>& encoded)
+{
+    const float x = DecodeSnorm16(encoded[0]);
+    const float y = DecodeSnorm16(encoded[1]);
+    const float z = 1 - std::abs(x) - std::abs(y);
+
+    // Unfold the lower hemisphere.
+    const float t = std::max(-z, 0.0f);
+    const Vec3f normal(x >= 0 ? x - t : x + t, y >= 0 ? y - t : y + t, z);
+
+    return normal / normal.Length();
+}
+
+// NOLINTBEGIN(readability-magic-numbers,cppcoreguidelines-avoid-magic-numbers)
+// IEEE 754 bit layouts. Floats have 8 exponent and 23 mantissa bits, half floats 5 and 10.
+
+uint16_t
+VertexQuantization::FloatToHalf(const float value)
+{
+    const uint32_t bits = std::bit_cast<uint32_t>(value);
+    const uint32_t sign = (bits >> 16) & 0x8000;
+    const uint32_t exponent = (bits >> 23) & 0xff;
+    const uint32_t mantissa = bits & 0x7fffff;
+
+    // Infinities and NaNs.
+    if(exponent == 0xff)
+    {
+        return narrow_cast<uint16_t>(sign | 0x7c00 | (mantissa != 0 ? 0x200u : 0u));
+    }
+
+    const int32_t halfExponent = static_cast<int32_t>(exponent) - 127 + 15;
+
+    if(halfExponent >= 0x1f)
+    {
+        return narrow_cast<uint16_t>(sign | 0x7c00);
+    }
+
+    if(halfExponent <= 0)
+    {
+        // Less than half the smallest subnormal half.
+        if(halfExponent < -10)
+        {
+            return narrow_cast<uint16_t>(sign);
+        }
+
+        // Subnormal. The implicit leading bit becomes explicit. Rounding up can carry into
+        // the smallest normal exponent, which is still the correct encoding.
+        const uint32_t shift = static_cast<uint32_t>(14 - halfExponent);
+
+        return narrow_cast<uint16_t>(sign | ShiftRightRounded(mantissa | 0x800000, shift));
+    }
+
+    // Rounding up can carry into the exponent, up to infinity, which is also correct.
+    const uint32_t half =
+        ShiftRightRounded((static_cast<uint32_t>(halfExponent) << 23) | mantissa, 13);
+
+    return narrow_cast<uint16_t>(sign | half);
+}
+
+float
+VertexQuantization::HalfToFloat(const uint16_t value)
+{
+    const uint32_t bits = value;
+    const uint32_t sign = (bits & 0x8000) << 16;
+    const uint32_t exponent = (bits >> 10) & 0x1f;
+    const uint32_t mantissa = bits & 0x3ff;
+
+    if(exponent == 0)
+    {
+        // Zero or subnormal.
+        const float magnitude = std::ldexp(static_cast<float>(mantissa), -24);
+        return sign != 0 ? -magnitude : magnitude;
+    }
+
+    if(exponent == 0x1f)
+    {
+        return std::bit_cast<float>(sign | 0x7f800000 | (mantissa << 13));
+    }
+
+    return std::bit_cast<float>(sign | ((exponent + 112) << 23) | (mantissa << 13));
+}
+
+// NOLINTEND(readability-magic-numbers,cppcoreguidelines-avoid-magic-numbers)
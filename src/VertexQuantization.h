@@ -0,0 +1,65 @@
+#pragma once
+
+#include "BoundingVolumes.h"
+#include "VecMath.h"
+#include "Vertex.h"
+
+#include <array>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+/// @brief Maps unorm16 quantized positions back to mesh space.
+///
+/// A decoded position is Offset + (quantized / 65535) * Scale, evaluated per axis.
+struct PositionQuantization
+{
+    Vec3f Offset;
+    Vec3f Scale;
+
+    /// @brief Quantizes positions relative to a mesh's bounds.
+    static PositionQuantization FromBounds(const BoundingBox& bounds)
+    {
+        return PositionQuantization //
+            {
+                .Offset = bounds.GetCenter() - bounds.GetHalfExtents(),
+                .Scale = bounds.GetHalfExtents() * 2.0f,
+            };
+    }
+};
+
+/// @brief Encodes Vertex to the compact QuantizedVertex and back.
+///
+/// Positions are stored as unorm16 relative to the mesh's bounds, normals as snorm16 octahedral
+/// coordinates, and texture coordinates as half floats, halving the size of a vertex.
+/// Decoding mirrors the decoding done by ColorShader.wgsl.
+class VertexQuantization final
+{
+public:
+    VertexQuantization() = delete;
+    ~VertexQuantization() = delete;
+    VertexQuantization(const VertexQuantization&) = delete;
+    VertexQuantization& operator=(const VertexQuantization&) = delete;
+    VertexQuantization(VertexQuantization&&) = delete;
+    VertexQuantization& operator=(VertexQuantization&&) = delete;
+
+    static QuantizedVertex Encode(const Vertex& vertex, const PositionQuantization& quantization);
+
+    /// @brief Encodes a mesh's vertices, appending them to outVertices.
+    static void Encode(const std::span<const Vertex> vertices,
+        const PositionQuantization& quantization,
+        std::vector<QuantizedVertex>& outVertices);
+
+    static Vertex Decode(const QuantizedVertex& vertex, const PositionQuantization& quantization);
+
+    /// @brief Encodes a unit vector as snorm16 octahedral coordinates.
+    static std::array<int16_t, 2> EncodeOctahedral(const Vec3f& normal);
+
+    static Vec3f DecodeOctahedral(const std::array<int16_t, 2>& encoded);
+
+    /// @brief Converts a float to a half float, rounding to nearest even.
+    /// Values too large for a half float become infinities.
+    static uint16_t FloatToHalf(const float value);
+
+    static float HalfToFloat(const uint16_t value);
+};
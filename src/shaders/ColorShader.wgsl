@@ -1,6 +1,14 @@
+// An affine transform's top three rows, stored as the columns of a mat3x4 so that
+// vec4(p, 1.0) * rows transforms p. The bottom row is always (0, 0, 0, 1).
 struct WorldTransform
 {
-    xform : mat4x4<f32>,
+    rows : mat3x4<f32>,
+};
+
+// Inverse transpose of a world transform's upper 3x3. Each column is three packed half floats.
+struct NormalMatrix
+{
+    columns : array<vec2<u32>, 3>,
 };
 
 struct ClipSpaceTransform
@@ -12,6 +20,10 @@ struct MeshProperties
 {
     transformIndex : u32,
     materialIndex : u32,
+    textureLayer : u32,
+    // Maps quantized positions to mesh space.
+    positionOffset : vec3<f32>,
+    positionScale : vec3<f32>,
 };
 
 struct Material
@@ -19,9 +31,9 @@ struct Material
     color : vec4<f32>,
     metalness : f32,
     roughness : f32,
+    alphaCutoff : f32,
     // Align to 16 bytes.
     pad0 : f32,
-    pad1 : f32,
 };
 
 struct Camera
@@ -36,10 +48,24 @@ struct Camera
 @group(0) @binding(2) var<storage, read> meshProperties : array<MeshProperties>;
 @group(0) @binding(3) var<storage, read> materials : array<Material>;
 @group(0) @binding(4) var<uniform> camera : Camera;
+// Maps instance_index of an instanced draw to the index of the mesh instance it renders.
+@group(0) @binding(5) var<storage, read> instanceRemap : array<u32>;
+// Only read when NormalMatrices is true.
+@group(0) @binding(6) var<storage, read> normalMatrices : array<NormalMatrix>;
 
-@group(1) @binding(0) var texture0 : texture_2d<f32>;
+// Base textures of every material drawn with this bind group, one per layer. Only the textured
+// entry points use them, so untextured pipelines' layouts don't have this group.
+@group(1) @binding(0) var texture0 : texture_2d_array<f32>;
 @group(1) @binding(1) var textureSampler : sampler;
 
+// When true, positions are transformed by their world transform and the camera's viewProj
+// rather than by clip space transforms computed by the transform pass, which can be skipped.
+override FusedTransforms : bool = false;
+
+// When true, normals are transformed by normalMatrices, which keeps them perpendicular to surfaces
+// under non-uniform scales, rather than by the world transforms.
+override NormalMatrices : bool = false;
+
 struct VSInput
 {
     @location(0) inPosition: vec3<f32>,
@@ -49,41 +75,204 @@ struct VSInput
 
 struct FSInput
 {
-    @builtin(position) position: vec4<f32>,
+    // Invariant so the color pass reproduces the depth prepass's depths exactly.
+    @invariant @builtin(position) position: vec4<f32>,
     @location(0) fragNormal: vec3<f32>,
     @location(1) texCoord: vec2<f32>,
     @location(2) @interpolate(flat) instanceIndex : u32,
 };
 
-@vertex
-fn vs_main(input: VSInput, @builtin(instance_index) instance_index: u32) -> FSInput
+// Vertices of QuantizedVertex vertex buffers. The vertex fetch unpacks unorm16 positions,
+// snorm16 normals and half float texture coordinates to f32.
+struct QuantizedVSInput
+{
+    // Relative to the mesh's bounds. w is unused.
+    @location(0) inPosition: vec4<f32>,
+    // Octahedral encoded.
+    @location(1) inNormal: vec2<f32>,
+    @location(2) inTexCoord: vec2<f32>,
+};
+
+// Transforms a mesh space position to clip space.
+fn clipPosition(position: vec3<f32>, transformIndex: u32) -> vec4<f32>
+{
+    if(FusedTransforms)
+    {
+        let worldPosition = vec4<f32>(position, 1.0) * worldTransforms[transformIndex].rows;
+        return camera.viewProj * vec4<f32>(worldPosition, 1.0);
+    }
+
+    return clipSpaceTransforms[transformIndex].xform * vec4<f32>(position, 1.0);
+}
+
+fn unpackHalf3(packed: vec2<u32>) -> vec3<f32>
+{
+    return vec3<f32>(unpack2x16float(packed.x), unpack2x16float(packed.y).x);
+}
+
+// Transforms a mesh space normal to world space.
+fn worldNormal(normal: vec3<f32>, transformIndex: u32) -> vec3<f32>
+{
+    if(NormalMatrices)
+    {
+        let columns = normalMatrices[transformIndex].columns;
+        let normalMatrix = mat3x3<f32>(unpackHalf3(columns[0]),
+            unpackHalf3(columns[1]),
+            unpackHalf3(columns[2]));
+
+        return normalize(normalMatrix * normal);
+    }
+
+    return normalize(vec4<f32>(normal, 0.0) * worldTransforms[transformIndex].rows);
+}
+
+fn transformVertex(position: vec3<f32>,
+    normal: vec3<f32>,
+    texCoord: vec2<f32>,
+    meshInstanceIndex: u32) -> FSInput
 {
     var output: FSInput;
 
-    let transformIndex = meshProperties[instance_index].transformIndex;
-    let clipXform = clipSpaceTransforms[transformIndex].xform;
-    let worldTransform = worldTransforms[transformIndex].xform;
+    let transformIndex = meshProperties[meshInstanceIndex].transformIndex;
 
-    output.position = clipXform * vec4<f32>(input.inPosition, 1.0);
-    output.fragNormal = normalize((worldTransform * vec4<f32>(input.inNormal, 0.0)).xyz);
-    output.texCoord = input.inTexCoord;
-    output.instanceIndex = instance_index;
+    output.position = clipPosition(position, transformIndex);
+    output.fragNormal = worldNormal(normal, transformIndex);
+    output.texCoord = texCoord;
+    output.instanceIndex = meshInstanceIndex;
 
     return output;
 }
 
+fn dequantizePosition(position: vec4<f32>, meshInstanceIndex: u32) -> vec3<f32>
+{
+    let properties = meshProperties[meshInstanceIndex];
+    return properties.positionOffset + position.xyz * properties.positionScale;
+}
+
+// Mirrors VertexQuantization::DecodeOctahedral().
+fn decodeOctahedral(encoded: vec2<f32>) -> vec3<f32>
+{
+    var normal = vec3<f32>(encoded, 1.0 - abs(encoded.x) - abs(encoded.y));
+    let t = max(-normal.z, 0.0);
+    normal.x += select(t, -t, normal.x >= 0.0);
+    normal.y += select(t, -t, normal.y >= 0.0);
+    return normalize(normal);
+}
+
+@vertex
+fn vs_main(input: VSInput, @builtin(instance_index) instance_index: u32) -> FSInput
+{
+    return transformVertex(input.inPosition,
+        input.inNormal,
+        input.inTexCoord,
+        instanceRemap[instance_index]);
+}
+
+@vertex
+fn vs_main_quantized(input: QuantizedVSInput,
+    @builtin(instance_index) instance_index: u32) -> FSInput
+{
+    let meshInstanceIndex = instanceRemap[instance_index];
+
+    return transformVertex(dequantizePosition(input.inPosition, meshInstanceIndex),
+        decodeOctahedral(input.inNormal),
+        input.inTexCoord,
+        meshInstanceIndex);
+}
+
+fn transformDepthVertex(position: vec3<f32>, meshInstanceIndex: u32) -> vec4<f32>
+{
+    let transformIndex = meshProperties[meshInstanceIndex].transformIndex;
+
+    return clipPosition(position, transformIndex);
+}
+
+// Depth prepass. Must compute positions exactly as vs_main does.
+@vertex
+fn vs_depth(@location(0) inPosition: vec3<f32>,
+    @builtin(instance_index) instance_index: u32) -> @invariant @builtin(position) vec4<f32>
+{
+    return transformDepthVertex(inPosition, instanceRemap[instance_index]);
+}
+
+// Depth prepass for quantized vertices. Must compute positions exactly as vs_main_quantized does.
+@vertex
+fn vs_depth_quantized(@location(0) inPosition: vec4<f32>,
+    @builtin(instance_index) instance_index: u32) -> @invariant @builtin(position) vec4<f32>
+{
+    let meshInstanceIndex = instanceRemap[instance_index];
+
+    return transformDepthVertex(dequantizePosition(inPosition, meshInstanceIndex),
+        meshInstanceIndex);
+}
+
+// The depth prepass writes depth only.
 @fragment
-fn fs_main(input: FSInput) -> @location(0) vec4<f32>
+fn fs_depth()
 {
-    let material = materials[meshProperties[input.instanceIndex].materialIndex];
+}
+
+// Lit material color.
+fn shadeUntextured(input: FSInput) -> vec4<f32>
+{
+    let properties = meshProperties[input.instanceIndex];
+    let material = materials[properties.materialIndex];
     let lightDir = normalize(vec3<f32>(1.0, -1.0, 1.0));
     let ambientFactor = 0.1;
     let diff = max(-dot(input.fragNormal, lightDir), 0.0);
     let diffuse = diff * material.color.rgb;
     let ambient = ambientFactor * material.color.rgb;
     let color = clamp(diffuse + ambient, vec3<f32>(0.0), vec3<f32>(1.0));
-    let litColor = vec4<f32>(color, material.color.a);
-    return litColor * textureSample(texture0, textureSampler, input.texCoord);
+    return vec4<f32>(color, material.color.a);
+}
+
+// Lit material color modulated by the base texture.
+fn shade(input: FSInput) -> vec4<f32>
+{
+    let properties = meshProperties[input.instanceIndex];
+    return shadeUntextured(input)
+        * textureSample(texture0, textureSampler, input.texCoord, properties.textureLayer);
+}
+
+// Discards fragments whose alpha is below the material's alpha cutoff.
+fn alphaMask(input: FSInput, color: vec4<f32>) -> vec4<f32>
+{
+    let material = materials[meshProperties[input.instanceIndex].materialIndex];
+
+    if(color.a < material.alphaCutoff)
+    {
+        discard;
+    }
+
+    return color;
+}
+
+// Opaque and alpha blended materials.
+@fragment
+fn fs_main(input: FSInput) -> @location(0) vec4<f32>
+{
+    return shade(input);
+}
+
+// Alpha masked materials. Kept separate from fs_main so opaque draws keep early depth tests.
+@fragment
+fn fs_mask(input: FSInput) -> @location(0) vec4<f32>
+{
+    return alphaMask(input, shade(input));
+}
+
+// Opaque and alpha blended materials without a base texture.
+@fragment
+fn fs_main_untextured(input: FSInput) -> @location(0) vec4<f32>
+{
+    return shadeUntextured(input);
+}
+
+// Alpha masked materials without a base texture.
+@fragment
+fn fs_mask_untextured(input: FSInput) -> @location(0) vec4<f32>
+{
+    return alphaMask(input, shadeUntextured(input));
 }
 
 /*struct VSSphereOut
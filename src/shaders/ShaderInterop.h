@@ -52,15 +52,31 @@ public:
     /// @brief Roughness factor of the material.
     float Roughness{ 0 };
 
+    /// @brief Fragments with lower alpha are discarded by the alpha mask pipeline.
+    float AlphaCutoff{ 0 };
+
     // Align to 16 bytes for storage in a uniform/storage buffer.
     float pad0{ 0 };
-    float pad1{ 0 };
 };
 
+/// @brief An affine world transform, stored as the top three rows of its 4x4 matrix. The bottom
+/// row is always (0, 0, 0, 1).
 class WorldTransform
 {
 public:
-    Mat44f Transform;
+    Vec4f Rows[3];
+};
+
+static_assert(sizeof(WorldTransform) == 3 * kSizeofVec4,
+    "WorldTransform must match the shaders' mat3x4<f32>");
+
+/// @brief Transforms normals by the inverse transpose of a world transform's upper 3x3, so they
+/// stay perpendicular to surfaces under non-uniform scales.
+/// Each column is three half floats: x and y in the first word, z in the low half of the second.
+class NormalMatrix
+{
+public:
+    uint32_t Columns[3][2];
 };
 
 class ClipSpaceTransform
@@ -75,6 +91,27 @@ public:
 
     uint32_t TransformIndex;
     uint32_t MaterialIndex;
+
+    /// @brief Layer of the base texture in the bound texture array.
+    uint32_t TextureLayer;
+
+    float pad0{ 0 };
+
+    /// @brief Maps quantized vertex positions to mesh space:
+    /// position = PositionOffset + quantized * PositionScale.
+    /// Unused by meshes with float vertices.
+    Vec3f PositionOffset;
+    float pad1{ 0 };
+    Vec3f PositionScale;
+    float pad2{ 0 };
+};
+
+/// @brief Maps the instance index of an instanced indirect draw to the mesh instance
+/// (i.e. the MeshProperties entry) that it renders.
+class InstanceRemap
+{
+public:
+    uint32_t MeshInstanceIndex;
 };
 
 class CameraParams
@@ -1,6 +1,8 @@
+// An affine transform's top three rows, stored as the columns of a mat3x4. The bottom row is
+// always (0, 0, 0, 1).
 struct WorldTransform
 {
-    xform : mat4x4<f32>,
+    rows : mat3x4<f32>,
 };
 
 struct ClipSpaceTransform
@@ -32,5 +34,12 @@ fn cs_main(@builtin(global_invocation_id) gid: vec3<u32>)
         return;
     }
 
-    outMats[i].xform = camera.viewProj * inMats[i].xform;
+    // Columns of the affine transform, followed by its bottom row.
+    let columns = transpose(inMats[i].rows);
+    let world = mat4x4<f32>(vec4<f32>(columns[0], 0.0),
+        vec4<f32>(columns[1], 0.0),
+        vec4<f32>(columns[2], 0.0),
+        vec4<f32>(columns[3], 1.0));
+
+    outMats[i].xform = camera.viewProj * world;
 }
\ No newline at end of file
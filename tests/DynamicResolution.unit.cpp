@@ -0,0 +1,124 @@
+#include <gtest/gtest.h>
+
+#include "DynamicResolution.h"
+
+#include <cmath>
+
+// NOLINTBEGIN(readability-magic-numbers,cppcoreguidelines-avoid-magic-numbers)
+
+namespace
+{
+constexpr float kTargetSeconds = 1.0f / 60;
+
+// Runs frames whose cost is proportional to the number of pixels rendered.
+void
+RunFrames(DynamicResolution& controller, const float fullScaleSeconds, const int frameCount)
+{
+    for(int i = 0; i < frameCount; ++i)
+    {
+        const float scale = controller.GetScale();
+        controller.Update(fullScaleSeconds * scale * scale);
+    }
+}
+} // namespace
+
+TEST(DynamicResolution, StartsAtMaxScale)
+{
+    const DynamicResolution controller({ .TargetFrameSeconds = kTargetSeconds });
+
+    EXPECT_FLOAT_EQ(controller.GetScale(), 1.0f);
+}
+
+TEST(DynamicResolution, HoldsScaleWhenFast)
+{
+    DynamicResolution controller({ .TargetFrameSeconds = kTargetSeconds });
+
+    RunFrames(controller, kTargetSeconds * 0.5f, 100);
+
+    EXPECT_FLOAT_EQ(controller.GetScale(), 1.0f);
+}
+
+TEST(DynamicResolution, LowersScaleToHoldTarget)
+{
+    DynamicResolution controller({ .TargetFrameSeconds = kTargetSeconds });
+
+    RunFrames(controller, kTargetSeconds * 2, 200);
+
+    const float scale = controller.GetScale();
+
+    EXPECT_LT(scale, 1.0f);
+    EXPECT_LE(kTargetSeconds * 2 * scale * scale, kTargetSeconds);
+
+    // Within a step of the largest scale that holds the target.
+    const float raisedScale = scale + DynamicResolution::kScaleStep;
+    EXPECT_GT(kTargetSeconds * 2 * raisedScale * raisedScale, kTargetSeconds * 0.85f);
+}
+
+TEST(DynamicResolution, ScalesAreMultiplesOfStep)
+{
+    DynamicResolution controller({ .TargetFrameSeconds = kTargetSeconds });
+
+    for(int i = 0; i < 200; ++i)
+    {
+        const float scale = controller.GetScale();
+        controller.Update(kTargetSeconds * 1.7f * scale * scale);
+
+        const float steps = controller.GetScale() / DynamicResolution::kScaleStep;
+        EXPECT_FLOAT_EQ(steps, std::round(steps)) << i;
+    }
+}
+
+TEST(DynamicResolution, ClampsToMinScale)
+{
+    DynamicResolution controller(
+        { .TargetFrameSeconds = kTargetSeconds, .MinScale = 0.75f, .MaxScale = 1 });
+
+    RunFrames(controller, kTargetSeconds * 10, 200);
+
+    EXPECT_FLOAT_EQ(controller.GetScale(), 0.75f);
+}
+
+TEST(DynamicResolution, RaisesScaleWhenLoadDrops)
+{
+    DynamicResolution controller({ .TargetFrameSeconds = kTargetSeconds });
+
+    RunFrames(controller, kTargetSeconds * 3, 200);
+    EXPECT_LT(controller.GetScale(), 0.75f);
+
+    RunFrames(controller, kTargetSeconds * 0.5f, 400);
+    EXPECT_FLOAT_EQ(controller.GetScale(), 1.0f);
+}
+
+TEST(DynamicResolution, HoldsScaleAfterChange)
+{
+    DynamicResolution controller({ .TargetFrameSeconds = kTargetSeconds });
+
+    controller.Update(kTargetSeconds * 4);
+    const float scale = controller.GetScale();
+    EXPECT_LT(scale, 1.0f);
+
+    for(uint32_t i = 0; i < DynamicResolution::kSettleFrameCount; ++i)
+    {
+        controller.Update(kTargetSeconds * 4);
+        EXPECT_FLOAT_EQ(controller.GetScale(), scale);
+    }
+}
+
+TEST(DynamicResolution, ScalesDimensions)
+{
+    DynamicResolution controller({ .TargetFrameSeconds = kTargetSeconds });
+
+    RunFrames(controller, kTargetSeconds * 2, 200);
+
+    const float scale = controller.GetScale();
+    const Dimension2 scaled = controller.Scale({ .Width = 1280, .Height = 720 });
+
+    EXPECT_EQ(scaled.Width, static_cast<unsigned>(std::round(1280 * scale)));
+    EXPECT_EQ(scaled.Height, static_cast<unsigned>(std::round(720 * scale)));
+
+    const Dimension2 tiny = controller.Scale({ .Width = 1, .Height = 1 });
+    EXPECT_EQ(tiny.Width, 1u);
+    EXPECT_EQ(tiny.Height, 1u);
+}
+
+// NOLINTEND(readability-magic-numbers,cppcoreguidelines-avoid-magic-numbers)
@@ -0,0 +1,298 @@
+#include <gtest/gtest.h>
+
+#include "MeshOptimizer.h"
+#include "TestMeshes.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <random>
+#include <set>
+#include <span>
+#include <utility>
+#include <vector>
+
+// NOLINTBEGIN(readability-magic-numbers,cppcoreguidelines-avoid-magic-numbers)
+
+namespace
+{
+// A test mesh with full vertices, as the optimizer reorders and welds them.
+struct VertexMesh
+{
+    std::vector<Vertex> Vertices;
+    std::vector<VertexIndex> Indices;
+
+    std::vector<Vec3f> GetPositions() const
+    {
+        std::vector<Vec3f> positions;
+        std::ranges::transform(Vertices,
+            std::back_inserter(positions),
+            [](const Vertex& vertex) { return vertex.pos; });
+        return positions;
+    }
+};
+
+using Triangle = std::array<VertexIndex, 3>;
+
+Vertex
+MakeVertex(const float x, const float y, const float z)
+{
+    return Vertex{ .pos = Vec3f(x, y, z), .normal = Vec3f(x, y, z), .uvs = { { .u = x, .v = y } } };
+}
+
+VertexMesh
+ToVertexMesh(const TestMesh& mesh)
+{
+    VertexMesh vertexMesh{ .Vertices = {}, .Indices = mesh.Indices };
+
+    for(const Vec3f& pos : mesh.Positions)
+    {
+        vertexMesh.Vertices.push_back(MakeVertex(pos.x, pos.y, pos.z));
+    }
+
+    return vertexMesh;
+}
+
+// Shuffles the order of a mesh's triangles, as an unoptimized exporter might leave them.
+void
+ShuffleTriangles(VertexMesh& mesh)
+{
+    std::vector<Triangle> triangles;
+
+    for(size_t i = 0; i < mesh.Indices.size(); i += 3)
+    {
+        triangles.push_back({ mesh.Indices[i], mesh.Indices[i + 1], mesh.Indices[i + 2] });
+    }
+
+    std::mt19937 rng(1234);
+    std::ranges::shuffle(triangles, rng);
+
+    mesh.Indices.clear();
+
+    for(const Triangle& tri : triangles)
+    {
+        mesh.Indices.insert(mesh.Indices.end(), tri.begin(), tri.end());
+    }
+}
+
+// Triangles as vertex positions, rotated so the smallest position is first. Rotation preserves
+// winding.
+std::multiset<std::array<std::array<float, 3>, 3>>
+GetTriangles(const VertexMesh& mesh)
+{
+    std::multiset<std::array<std::array<float, 3>, 3>> triangles;
+
+    for(size_t i = 0; i < mesh.Indices.size(); i += 3)
+    {
+        std::array<std::array<float, 3>, 3> tri;
+
+        for(size_t corner = 0; corner < 3; ++corner)
+        {
+            const Vec3f& pos = mesh.Vertices[mesh.Indices[i + corner]].pos;
+            tri[corner] = { pos.x, pos.y, pos.z };
+        }
+
+        std::ranges::rotate(tri, std::ranges::min_element(tri));
+        triangles.insert(tri);
+    }
+
+    return triangles;
+}
+
+VertexCacheStats
+Analyze(const VertexMesh& mesh)
+{
+    return MeshOptimizer::AnalyzeVertexCache(mesh.Indices, mesh.Vertices.size());
+}
+} // namespace
+
+TEST(MeshOptimizer, AnalyzeVertexCacheCountsTransforms)
+{
+    // Two triangles sharing an edge transform four vertices.
+    const std::vector<VertexIndex> quad{ 0, 1, 2, 2, 1, 3 };
+    const VertexCacheStats stats = MeshOptimizer::AnalyzeVertexCache(quad, 4);
+
+    EXPECT_EQ(stats.TriangleCount, 2u);
+    EXPECT_EQ(stats.VertexCount, 4u);
+    EXPECT_EQ(stats.TransformCount, 4u);
+    EXPECT_FLOAT_EQ(stats.GetAcmr(), 2.0f);
+    EXPECT_FLOAT_EQ(stats.GetAtvr(), 1.0f);
+
+    // Vertices evicted from the cache are transformed again.
+    std::vector<VertexIndex> strip;
+    for(VertexIndex i = 0; i < MeshOptimizer::kCacheSize; ++i)
+    {
+        strip.insert(strip.end(), { 0, 1 + (2 * i), 2 + (2 * i) });
+    }
+
+    EXPECT_EQ(MeshOptimizer::AnalyzeVertexCache(strip, 1 + (2 * MeshOptimizer::kCacheSize))
+                  .TransformCount,
+        (2 * MeshOptimizer::kCacheSize) + 2);
+}
+
+TEST(MeshOptimizer, WeldVerticesMergesIdenticalVertices)
+{
+    const VertexMesh source = ToVertexMesh(MakeGrid(8));
+
+    // Unwelded, as if every triangle had been exported with its own vertices.
+    VertexMesh mesh;
+    for(const VertexIndex index : source.Indices)
+    {
+        mesh.Indices.push_back(static_cast<VertexIndex>(mesh.Vertices.size()));
+        mesh.Vertices.push_back(source.Vertices[index]);
+    }
+
+    // -0 welds with +0.
+    mesh.Vertices[0].pos.x = -0.0f;
+
+    const auto triangles = GetTriangles(mesh);
+
+    MeshOptimizer::WeldVertices(mesh.Vertices, mesh.Indices);
+
+    EXPECT_EQ(mesh.Vertices.size(), source.Vertices.size());
+    EXPECT_EQ(GetTriangles(mesh), triangles);
+}
+
+TEST(MeshOptimizer, WeldVerticesKeepsDistinctAttributes)
+{
+    VertexMesh mesh = ToVertexMesh(MakeGrid(4));
+    const size_t vertexCount = mesh.Vertices.size();
+
+    // A seam. Same position, different texture coordinates.
+    Vertex seamVertex = mesh.Vertices[mesh.Indices[0]];
+    seamVertex.uvs[0].u += 0.5f;
+    mesh.Vertices.push_back(seamVertex);
+    mesh.Indices[0] = static_cast<VertexIndex>(vertexCount);
+
+    MeshOptimizer::WeldVertices(mesh.Vertices, mesh.Indices);
+
+    EXPECT_EQ(mesh.Vertices.size(), vertexCount + 1);
+}
+
+TEST(MeshOptimizer, HashMeshMatchesIdenticalMeshes)
+{
+    const VertexMesh mesh = ToVertexMesh(MakeSphere(8, 16));
+    VertexMesh copy = mesh;
+
+    EXPECT_EQ(MeshOptimizer::HashMesh(mesh.Vertices, mesh.Indices),
+        MeshOptimizer::HashMesh(copy.Vertices, copy.Indices));
+
+    copy.Vertices[5].normal.y += 0.001f;
+
+    EXPECT_NE(MeshOptimizer::HashMesh(mesh.Vertices, mesh.Indices),
+        MeshOptimizer::HashMesh(copy.Vertices, copy.Indices));
+
+    copy = mesh;
+    std::swap(copy.Indices[0], copy.Indices[1]);
+
+    EXPECT_NE(MeshOptimizer::HashMesh(mesh.Vertices, mesh.Indices),
+        MeshOptimizer::HashMesh(copy.Vertices, copy.Indices));
+}
+
+TEST(MeshOptimizer, OptimizeVertexCachePreservesTriangles)
+{
+    VertexMesh mesh = ToVertexMesh(MakeSphere(24, 48));
+    ShuffleTriangles(mesh);
+
+    const auto triangles = GetTriangles(mesh);
+
+    MeshOptimizer::OptimizeVertexCache(mesh.Indices, mesh.Vertices.size());
+
+    EXPECT_EQ(GetTriangles(mesh), triangles);
+}
+
+TEST(MeshOptimizer, OptimizeVertexCacheReducesAcmr)
+{
+    VertexMesh mesh = ToVertexMesh(MakeGrid(64));
+    ShuffleTriangles(mesh);
+
+    const VertexCacheStats before = Analyze(mesh);
+
+    MeshOptimizer::OptimizeVertexCache(mesh.Indices, mesh.Vertices.size());
+
+    const VertexCacheStats after = Analyze(mesh);
+
+    // Shuffled triangles miss almost every time. Optimized grids approach 0.5 with an infinite
+    // cache and do well with a small one.
+    EXPECT_GT(before.GetAcmr(), 2.5f);
+    EXPECT_LT(after.GetAcmr(), 0.8f);
+    EXPECT_LT(after.GetAtvr(), 1.6f);
+}
+
+TEST(MeshOptimizer, OptimizeOverdrawPreservesTrianglesAndCacheEfficiency)
+{
+    VertexMesh mesh = ToVertexMesh(MakeSphere(32, 64));
+    ShuffleTriangles(mesh);
+
+    MeshOptimizer::OptimizeVertexCache(mesh.Indices, mesh.Vertices.size());
+
+    const auto triangles = GetTriangles(mesh);
+    const float acmr = Analyze(mesh).GetAcmr();
+
+    MeshOptimizer::OptimizeOverdraw(mesh.GetPositions(), mesh.Indices);
+
+    EXPECT_EQ(GetTriangles(mesh), triangles);
+    EXPECT_LE(Analyze(mesh).GetAcmr(), acmr * MeshOptimizer::kDefaultOverdrawThreshold * 1.1f);
+}
+
+TEST(MeshOptimizer, OptimizeOverdrawDrawsOutermostClustersFirst)
+{
+    // Two concentric spheres. Drawing the outer one first lets depth testing reject the inner.
+    VertexMesh mesh = ToVertexMesh(MakeSphere(16, 32));
+    const VertexMesh outer = ToVertexMesh(MakeSphere(16, 32));
+
+    for(Vertex& vertex : mesh.Vertices)
+    {
+        vertex.pos *= 0.5f;
+    }
+
+    const VertexIndex baseVertex = static_cast<VertexIndex>(mesh.Vertices.size());
+    mesh.Vertices.insert(mesh.Vertices.end(), outer.Vertices.begin(), outer.Vertices.end());
+
+    for(const VertexIndex index : outer.Indices)
+    {
+        mesh.Indices.push_back(baseVertex + index);
+    }
+
+    MeshOptimizer::OptimizeVertexCache(mesh.Indices, mesh.Vertices.size());
+    MeshOptimizer::OptimizeOverdraw(mesh.GetPositions(), mesh.Indices);
+
+    // Clusters are sorted by how far out they face, so large outer clusters can sort after
+    // small inner ones. Nearly all of the first half should still be the outer sphere.
+    const size_t half = mesh.Indices.size() / 2;
+    const auto outerCount = std::ranges::count_if(std::span(mesh.Indices).first(half),
+        [baseVertex](const VertexIndex index) { return index >= baseVertex; });
+
+    EXPECT_GT(static_cast<float>(outerCount), 0.9f * static_cast<float>(half));
+}
+
+TEST(MeshOptimizer, OptimizeVertexFetchOrdersVerticesByFirstUse)
+{
+    VertexMesh mesh = ToVertexMesh(MakeSphere(16, 32));
+    ShuffleTriangles(mesh);
+
+    // An unreferenced vertex is removed.
+    mesh.Vertices.push_back(MakeVertex(5, 5, 5));
+
+    const auto triangles = GetTriangles(mesh);
+
+    MeshOptimizer::OptimizeVertexFetch(mesh.Vertices, mesh.Indices);
+
+    EXPECT_EQ(GetTriangles(mesh), triangles);
+
+    VertexIndex nextVertex = 0;
+
+    for(const VertexIndex index : mesh.Indices)
+    {
+        ASSERT_LE(index, nextVertex);
+
+        if(index == nextVertex)
+        {
+            ++nextVertex;
+        }
+    }
+
+    EXPECT_EQ(nextVertex, mesh.Vertices.size());
+}
+
+// NOLINTEND(readability-magic-numbers,cppcoreguidelines-avoid-magic-numbers)
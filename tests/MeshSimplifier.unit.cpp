@@ -0,0 +1,133 @@
+#include <gtest/gtest.h>
+
+#include "MeshSimplifier.h"
+#include "TestMeshes.h"
+
+#include <cstdint>
+#include <set>
+#include <vector>
+
+// NOLINTBEGIN(readability-magic-numbers,cppcoreguidelines-avoid-magic-numbers)
+
+namespace
+{
+bool
+IsOnBorder(const Vec3f& p, const float gridSize)
+{
+    return p.x == 0 || p.y == 0 || p.x == gridSize || p.y == gridSize;
+}
+} // namespace
+
+TEST(MeshSimplifier, EmptyMesh)
+{
+    float error = -1;
+    const std::vector<VertexIndex> result = MeshSimplifier::Simplify({}, {}, 0, 1.0f, error);
+
+    EXPECT_TRUE(result.empty());
+    EXPECT_EQ(error, 0.0f);
+}
+
+TEST(MeshSimplifier, TargetAboveIndexCountLeavesMeshUnchanged)
+{
+    const TestMesh grid = MakeGrid(4);
+
+    float error = -1;
+    const std::vector<VertexIndex> result = MeshSimplifier::Simplify(grid.Positions,
+        grid.Indices,
+        grid.Indices.size(),
+        1.0f,
+        error);
+
+    EXPECT_EQ(result, grid.Indices);
+    EXPECT_EQ(error, 0.0f);
+}
+
+TEST(MeshSimplifier, FlatGridSimplifiesWithoutError)
+{
+    const TestMesh grid = MakeGrid(8);
+
+    float error = -1;
+    const std::vector<VertexIndex> result =
+        MeshSimplifier::Simplify(grid.Positions, grid.Indices, 0, 1e-4f, error);
+
+    // Every interior vertex lies in the plane, so all of them can be removed for free.
+    EXPECT_LT(result.size(), grid.Indices.size() / 4);
+    EXPECT_EQ(result.size() % 3, 0u);
+    EXPECT_NEAR(error, 0.0f, 1e-4f);
+}
+
+TEST(MeshSimplifier, BorderVerticesArePreserved)
+{
+    constexpr uint32_t kGridSize = 8;
+    const TestMesh grid = MakeGrid(kGridSize);
+
+    float error = -1;
+    const std::vector<VertexIndex> result =
+        MeshSimplifier::Simplify(grid.Positions, grid.Indices, 0, 1e-4f, error);
+
+    const std::set<VertexIndex> remaining(result.begin(), result.end());
+
+    for(VertexIndex i = 0; i < grid.Positions.size(); ++i)
+    {
+        if(IsOnBorder(grid.Positions[i], kGridSize))
+        {
+            EXPECT_TRUE(remaining.contains(i)) << "Border vertex " << i << " was removed";
+        }
+    }
+}
+
+TEST(MeshSimplifier, SimplifiedTrianglesKeepTheirOrientation)
+{
+    const TestMesh grid = MakeGrid(8);
+
+    float error = -1;
+    const std::vector<VertexIndex> result =
+        MeshSimplifier::Simplify(grid.Positions, grid.Indices, 0, 1e-4f, error);
+
+    ASSERT_FALSE(result.empty());
+
+    // The grid's triangles all face -Z.
+    for(size_t i = 0; i < result.size(); i += 3)
+    {
+        const Vec3f& p0 = grid.Positions[result[i]];
+        const Vec3f& p1 = grid.Positions[result[i + 1]];
+        const Vec3f& p2 = grid.Positions[result[i + 2]];
+
+        EXPECT_LT((p1 - p0).Cross(p2 - p0).z, 0.0f);
+    }
+}
+
+TEST(MeshSimplifier, SphereReachesTargetIndexCount)
+{
+    const TestMesh sphere = MakeSphere(16, 32);
+    const size_t target = sphere.Indices.size() / 4;
+
+    float error = -1;
+    const std::vector<VertexIndex> result =
+        MeshSimplifier::Simplify(sphere.Positions, sphere.Indices, target, 1.0f, error);
+
+    EXPECT_LE(result.size(), target);
+    EXPECT_GT(result.size(), 0u);
+    EXPECT_GT(error, 0.0f);
+    EXPECT_LT(error, 1.0f);
+}
+
+TEST(MeshSimplifier, MaxErrorLimitsSimplification)
+{
+    const TestMesh sphere = MakeSphere(16, 32);
+
+    float looseError = -1;
+    const std::vector<VertexIndex> loose =
+        MeshSimplifier::Simplify(sphere.Positions, sphere.Indices, 0, 0.5f, looseError);
+
+    float tightError = -1;
+    const std::vector<VertexIndex> tight =
+        MeshSimplifier::Simplify(sphere.Positions, sphere.Indices, 0, 0.01f, tightError);
+
+    EXPECT_LE(tightError, 0.01f);
+    EXPECT_LE(looseError, 0.5f);
+    EXPECT_LT(loose.size(), tight.size());
+    EXPECT_LT(tight.size(), sphere.Indices.size());
+}
+
+// NOLINTEND(readability-magic-numbers,cppcoreguidelines-avoid-magic-numbers)
@@ -0,0 +1,222 @@
+#include <gtest/gtest.h>
+
+#include "MeshletBuilder.h"
+#include "TestMeshes.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <set>
+#include <utility>
+#include <vector>
+
+// NOLINTBEGIN(readability-magic-numbers,cppcoreguidelines-avoid-magic-numbers)
+
+namespace
+{
+using Triangle = std::array<VertexIndex, 3>;
+
+Vec3f
+TriangleNormal(const TestMesh& mesh, const size_t firstIndex)
+{
+    const Vec3f& p0 = mesh.Positions[mesh.Indices[firstIndex]];
+    const Vec3f& p1 = mesh.Positions[mesh.Indices[firstIndex + 1]];
+    const Vec3f& p2 = mesh.Positions[mesh.Indices[firstIndex + 2]];
+
+    return (p1 - p0).Cross(p2 - p0);
+}
+
+std::multiset<Triangle>
+GetTriangles(const std::span<const VertexIndex> indices)
+{
+    std::multiset<Triangle> triangles;
+
+    for(size_t i = 0; i < indices.size(); i += 3)
+    {
+        // Rotate so the smallest index is first. Rotation preserves winding.
+        Triangle tri{ indices[i], indices[i + 1], indices[i + 2] };
+        std::ranges::rotate(tri, std::ranges::min_element(tri));
+        triangles.insert(tri);
+    }
+
+    return triangles;
+}
+} // namespace
+
+TEST(MeshletBuilder, PreservesTriangles)
+{
+    const TestMesh source = MakeSphere(24, 48);
+    TestMesh mesh = source;
+
+    std::vector<Meshlet> meshlets;
+    MeshletBuilder::Build(mesh.Positions, mesh.Indices, 0, meshlets);
+
+    ASSERT_FALSE(meshlets.empty());
+    EXPECT_EQ(GetTriangles(mesh.Indices), GetTriangles(source.Indices));
+}
+
+TEST(MeshletBuilder, MeshletsCoverIndicesInOrder)
+{
+    TestMesh mesh = MakeGrid(40);
+
+    constexpr uint32_t kFirstIndex = 300;
+
+    std::vector<Meshlet> meshlets;
+    MeshletBuilder::Build(mesh.Positions, mesh.Indices, kFirstIndex, meshlets);
+
+    uint32_t nextIndex = kFirstIndex;
+
+    for(const Meshlet& meshlet : meshlets)
+    {
+        EXPECT_EQ(meshlet.FirstIndex, nextIndex);
+        EXPECT_GT(meshlet.IndexCount, 0u);
+        EXPECT_EQ(meshlet.IndexCount % 3, 0u);
+
+        nextIndex += meshlet.IndexCount;
+    }
+
+    EXPECT_EQ(nextIndex, kFirstIndex + mesh.Indices.size());
+}
+
+TEST(MeshletBuilder, RespectsLimits)
+{
+    TestMesh mesh = MakeSphere(32, 64);
+
+    std::vector<Meshlet> meshlets;
+    MeshletBuilder::Build(mesh.Positions, mesh.Indices, 0, meshlets);
+
+    for(const Meshlet& meshlet : meshlets)
+    {
+        const std::span<const VertexIndex> indices =
+            std::span<const VertexIndex>(mesh.Indices).subspan(meshlet.FirstIndex,
+                meshlet.IndexCount);
+
+        const std::set<VertexIndex> vertices(indices.begin(), indices.end());
+
+        EXPECT_LE(vertices.size(), MeshletBuilder::kMaxVertices);
+        EXPECT_LE(indices.size() / 3, MeshletBuilder::kMaxTriangles);
+    }
+}
+
+TEST(MeshletBuilder, BoundsContainVertices)
+{
+    TestMesh mesh = MakeSphere(16, 32);
+
+    std::vector<Meshlet> meshlets;
+    MeshletBuilder::Build(mesh.Positions, mesh.Indices, 0, meshlets);
+
+    for(const Meshlet& meshlet : meshlets)
+    {
+        for(uint32_t i = 0; i < meshlet.IndexCount; ++i)
+        {
+            const Vec3f& pos = mesh.Positions[mesh.Indices[meshlet.FirstIndex + i]];
+            const float distance = (pos - meshlet.Bounds.GetCenter()).Length();
+
+            EXPECT_LE(distance, meshlet.Bounds.GetRadius() * 1.0001f);
+        }
+    }
+}
+
+TEST(MeshletBuilder, FlatMeshletFacesAwayFromViewerBehindIt)
+{
+    TestMesh mesh = MakeGrid(8);
+
+    std::vector<Meshlet> meshlets;
+    MeshletBuilder::Build(mesh.Positions, mesh.Indices, 0, meshlets);
+
+    ASSERT_FALSE(meshlets.empty());
+
+    for(const Meshlet& meshlet : meshlets)
+    {
+        // The grid faces -Z.
+        EXPECT_NEAR(meshlet.ConeAxis.z, -1.0f, 1e-5f);
+        EXPECT_FALSE(meshlet.IsBackFacing(Vec3f(4, 4, -100)));
+        EXPECT_TRUE(meshlet.IsBackFacing(Vec3f(4, 4, 100)));
+    }
+}
+
+TEST(MeshletBuilder, BackFacingMeshletsHaveNoFrontFacingTriangles)
+{
+    TestMesh mesh = MakeSphere(32, 64);
+
+    std::vector<Meshlet> meshlets;
+    MeshletBuilder::Build(mesh.Positions, mesh.Indices, 0, meshlets);
+
+    const std::array<Vec3f, 4> viewPositions //
+        {
+            Vec3f(0, 0, -5),
+            Vec3f(3, 1, 0),
+            Vec3f(0, -20, 0),
+            Vec3f(1.5f, 1.5f, 1.5f),
+        };
+
+    for(const Vec3f& viewPosition : viewPositions)
+    {
+        size_t backFacingCount = 0;
+
+        for(const Meshlet& meshlet : meshlets)
+        {
+            if(!meshlet.IsBackFacing(viewPosition))
+            {
+                continue;
+            }
+
+            ++backFacingCount;
+
+            for(uint32_t i = 0; i < meshlet.IndexCount; i += 3)
+            {
+                const size_t firstIndex = meshlet.FirstIndex + i;
+                const Vec3f& p0 = mesh.Positions[mesh.Indices[firstIndex]];
+
+                EXPECT_GE(TriangleNormal(mesh, firstIndex).Dot(p0 - viewPosition), 0.0f);
+            }
+        }
+
+        // Roughly half of a sphere faces away from any outside viewer.
+        EXPECT_GT(backFacingCount, 0u);
+        EXPECT_LT(backFacingCount, meshlets.size());
+    }
+}
+
+TEST(MeshletBuilder, CullingSplitsAMeshIntoRunsOfVisibleMeshlets)
+{
+    TestMesh mesh = MakeGrid(40);
+
+    std::vector<Meshlet> meshlets;
+    MeshletBuilder::Build(mesh.Positions, mesh.Indices, 0, meshlets);
+
+    ASSERT_GE(meshlets.size(), 8u);
+
+    // Adjacent visible meshlets are drawn together.
+    size_t runCount = 0;
+    size_t culledCount = CullMeshlets(meshlets,
+        [](const Meshlet&) { return true; },
+        [&](const uint32_t firstIndex, const uint32_t indexCount)
+        {
+            EXPECT_EQ(firstIndex, 0u);
+            EXPECT_EQ(indexCount, mesh.Indices.size());
+            ++runCount;
+        });
+
+    EXPECT_EQ(culledCount, 0u);
+    EXPECT_EQ(runCount, 1u);
+
+    // Culling every other meshlet splits one mesh, i.e. one mesh slot, into a run per visible
+    // meshlet, so a mesh can need many more draws than it has slots.
+    std::vector<std::pair<uint32_t, uint32_t>> runs;
+    culledCount = CullMeshlets(meshlets,
+        [&meshlets](const Meshlet& meshlet) { return (&meshlet - meshlets.data()) % 2 == 0; },
+        [&runs](const uint32_t firstIndex, const uint32_t indexCount)
+        { runs.emplace_back(firstIndex, indexCount); });
+
+    EXPECT_EQ(culledCount, meshlets.size() / 2);
+    ASSERT_EQ(runs.size(), meshlets.size() - culledCount);
+
+    for(size_t i = 0; i < runs.size(); ++i)
+    {
+        EXPECT_EQ(runs[i].first, meshlets[i * 2].FirstIndex);
+        EXPECT_EQ(runs[i].second, meshlets[i * 2].IndexCount);
+    }
+}
+
+// NOLINTEND(readability-magic-numbers,cppcoreguidelines-avoid-magic-numbers)
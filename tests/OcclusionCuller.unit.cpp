@@ -0,0 +1,189 @@
+#include <gtest/gtest.h>
+
+#include "OcclusionCuller.h"
+#include "ThreadPool.h"
+#include "VecMath.h"
+
+#include <algorithm>
+#include <array>
+#include <vector>
+
+// NOLINTBEGIN(readability-magic-numbers,cppcoreguidelines-avoid-magic-numbers)
+
+namespace
+{
+// Camera at the origin looking down +Z.
+Mat44f
+MakeViewProj()
+{
+    return Mat44f::PerspectiveLH(Radiansf::FromDegrees(90.0f), 2.0f, 0.1f, 100.0f);
+}
+
+// A square in the XY plane at the given depth, centered on the Z axis.
+struct Quad
+{
+    std::array<Vec3f, 4> Positions;
+    std::array<VertexIndex, 6> Indices{ 0, 1, 2, 0, 2, 3 };
+};
+
+Quad
+MakeQuad(const float halfSize, const float z)
+{
+    return Quad //
+        {
+            .Positions = {
+                Vec3f(-halfSize, -halfSize, z),
+                Vec3f(-halfSize, halfSize, z),
+                Vec3f(halfSize, halfSize, z),
+                Vec3f(halfSize, -halfSize, z),
+            },
+        };
+}
+
+OcclusionCuller
+MakeCullerWithWall(const float halfSize, const float z)
+{
+    OcclusionCuller culler(OcclusionCuller::kDefaultWidth, OcclusionCuller::kDefaultHeight);
+    const Quad quad = MakeQuad(halfSize, z);
+
+    culler.Begin(MakeViewProj());
+    culler.AddOccluder(Mat44f::Identity, quad.Positions, quad.Indices);
+    culler.Rasterize(nullptr);
+
+    return culler;
+}
+} // namespace
+
+TEST(OcclusionCuller, BuildsHiZPyramidDownToOneTexel)
+{
+    const OcclusionCuller culler(256, 128);
+
+    EXPECT_EQ(culler.GetWidth(), 256u);
+    EXPECT_EQ(culler.GetHeight(), 128u);
+    EXPECT_EQ(culler.GetLevelCount(), 9u);
+    EXPECT_EQ(culler.GetDepth(culler.GetLevelCount() - 1, 0, 0), 1.0f);
+}
+
+TEST(OcclusionCuller, EverythingVisibleWithoutOccluders)
+{
+    OcclusionCuller culler(64, 32);
+    culler.Begin(MakeViewProj());
+    culler.Rasterize(nullptr);
+
+    EXPECT_TRUE(culler.IsVisible(BoundingSphere(Vec3f(0, 0, 50), 0.5f)));
+}
+
+TEST(OcclusionCuller, SphereBehindWallIsOccluded)
+{
+    const OcclusionCuller culler = MakeCullerWithWall(20.0f, 10.0f);
+
+    EXPECT_EQ(culler.GetTriangleCount(), 2u);
+    EXPECT_FALSE(culler.IsVisible(BoundingSphere(Vec3f(0, 0, 30), 1.0f)));
+    EXPECT_FALSE(culler.IsVisible(BoundingSphere(Vec3f(3, -2, 50), 2.0f)));
+}
+
+TEST(OcclusionCuller, SphereInFrontOfWallIsVisible)
+{
+    const OcclusionCuller culler = MakeCullerWithWall(20.0f, 10.0f);
+
+    EXPECT_TRUE(culler.IsVisible(BoundingSphere(Vec3f(0, 0, 5), 1.0f)));
+}
+
+TEST(OcclusionCuller, SphereIntersectingWallIsVisible)
+{
+    const OcclusionCuller culler = MakeCullerWithWall(20.0f, 10.0f);
+
+    EXPECT_TRUE(culler.IsVisible(BoundingSphere(Vec3f(0, 0, 10.5f), 1.0f)));
+}
+
+TEST(OcclusionCuller, SpherePeekingAroundWallIsVisible)
+{
+    // A small wall that covers only the center of the screen.
+    const OcclusionCuller culler = MakeCullerWithWall(1.0f, 10.0f);
+
+    EXPECT_FALSE(culler.IsVisible(BoundingSphere(Vec3f(0, 0, 20), 0.5f)));
+    EXPECT_TRUE(culler.IsVisible(BoundingSphere(Vec3f(3, 0, 20), 0.5f)));
+    EXPECT_TRUE(culler.IsVisible(BoundingSphere(Vec3f(0, 0, 20), 5.0f)));
+}
+
+TEST(OcclusionCuller, SphereStraddlingNearPlaneIsVisible)
+{
+    const OcclusionCuller culler = MakeCullerWithWall(20.0f, 10.0f);
+
+    EXPECT_TRUE(culler.IsVisible(BoundingSphere(Vec3f(0, 0, 0), 1.0f)));
+}
+
+TEST(OcclusionCuller, WindingDoesNotMatter)
+{
+    OcclusionCuller culler(OcclusionCuller::kDefaultWidth, OcclusionCuller::kDefaultHeight);
+    Quad quad = MakeQuad(20.0f, 10.0f);
+    quad.Indices = { 0, 2, 1, 0, 3, 2 };
+
+    culler.Begin(MakeViewProj());
+    culler.AddOccluder(Mat44f::Identity, quad.Positions, quad.Indices);
+    culler.Rasterize(nullptr);
+
+    EXPECT_FALSE(culler.IsVisible(BoundingSphere(Vec3f(0, 0, 30), 1.0f)));
+}
+
+TEST(OcclusionCuller, CoarseLevelsHoldFarthestDepth)
+{
+    const OcclusionCuller culler = MakeCullerWithWall(1.0f, 10.0f);
+
+    // The wall covers only part of the screen so the single texel at the top of the pyramid
+    // must keep the cleared far depth.
+    EXPECT_EQ(culler.GetDepth(culler.GetLevelCount() - 1, 0, 0), 1.0f);
+
+    // The center of level 0 is covered by the wall.
+    EXPECT_LT(culler.GetDepth(0, culler.GetWidth() / 2, culler.GetHeight() / 2), 1.0f);
+}
+
+TEST(OcclusionCuller, ThreadPoolMatchesSingleThreaded)
+{
+    auto threadPool = ThreadPool::Create();
+    ASSERT_TRUE(threadPool);
+
+    // Walls at different depths and sizes overlap so every band has triangles to resolve.
+    const Quad quads[] = { MakeQuad(20.0f, 30.0f), MakeQuad(4.0f, 10.0f), MakeQuad(1.0f, 5.0f) };
+
+    OcclusionCuller expected(OcclusionCuller::kDefaultWidth, OcclusionCuller::kDefaultHeight);
+    OcclusionCuller actual(OcclusionCuller::kDefaultWidth, OcclusionCuller::kDefaultHeight);
+
+    for(OcclusionCuller* culler : { &expected, &actual })
+    {
+        culler->Begin(MakeViewProj());
+
+        for(const Quad& quad : quads)
+        {
+            culler->AddOccluder(Mat44f::Identity, quad.Positions, quad.Indices);
+        }
+    }
+
+    expected.Rasterize(nullptr);
+
+    // Repeated so bands finishing in any order are exercised.
+    for(int i = 0; i < 100; ++i)
+    {
+        actual.Rasterize(threadPool->get());
+    }
+
+    uint32_t width = expected.GetWidth();
+    uint32_t height = expected.GetHeight();
+
+    for(size_t level = 0; level < expected.GetLevelCount(); ++level)
+    {
+        for(uint32_t y = 0; y < height; ++y)
+        {
+            for(uint32_t x = 0; x < width; ++x)
+            {
+                ASSERT_EQ(actual.GetDepth(level, x, y), expected.GetDepth(level, x, y))
+                    << "level " << level << " texel " << x << "," << y;
+            }
+        }
+
+        width = std::max(1u, (width + 1) / 2);
+        height = std::max(1u, (height + 1) / 2);
+    }
+}
+
+// NOLINTEND(readability-magic-numbers,cppcoreguidelines-avoid-magic-numbers)
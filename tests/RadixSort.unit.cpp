@@ -0,0 +1,107 @@
+#include <gtest/gtest.h>
+
+#include "RadixSort.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+// NOLINTBEGIN(readability-magic-numbers,cppcoreguidelines-avoid-magic-numbers)
+
+namespace
+{
+struct Item
+{
+    uint64_t Key;
+    uint32_t Payload;
+
+    friend bool operator==(const Item& a, const Item& b) = default;
+};
+
+std::vector<Item>
+SortWithRadix(std::vector<Item> items)
+{
+    std::vector<Item> scratch(items.size());
+    RadixSort(std::span<Item>(items),
+        std::span<Item>(scratch),
+        [](const Item& item) { return item.Key; });
+    return items;
+}
+
+std::vector<Item>
+SortWithStd(std::vector<Item> items)
+{
+    std::ranges::stable_sort(items, {}, &Item::Key);
+    return items;
+}
+} // namespace
+
+TEST(RadixSort, EmptyAndSingleItem)
+{
+    EXPECT_TRUE(SortWithRadix({}).empty());
+
+    const std::vector<Item> single{ { .Key = 42, .Payload = 7 } };
+    EXPECT_EQ(SortWithRadix(single), single);
+}
+
+TEST(RadixSort, MatchesStableSortForRandomKeys)
+{
+    std::mt19937_64 rng(1234);
+
+    std::vector<Item> items;
+    for(uint32_t i = 0; i < 5000; ++i)
+    {
+        items.push_back({ .Key = rng(), .Payload = i });
+    }
+
+    EXPECT_EQ(SortWithRadix(items), SortWithStd(items));
+}
+
+TEST(RadixSort, IsStableForDuplicateKeys)
+{
+    std::mt19937_64 rng(5678);
+
+    std::vector<Item> items;
+    for(uint32_t i = 0; i < 1000; ++i)
+    {
+        // Few distinct keys spread across high and low bits.
+        const uint64_t key = ((rng() % 4) << 60) | (rng() % 8);
+        items.push_back({ .Key = key, .Payload = i });
+    }
+
+    EXPECT_EQ(SortWithRadix(items), SortWithStd(items));
+}
+
+TEST(RadixSort, IdenticalKeysPreserveOrder)
+{
+    std::vector<Item> items;
+    for(uint32_t i = 0; i < 100; ++i)
+    {
+        items.push_back({ .Key = 0x0123456789ABCDEFull, .Payload = i });
+    }
+
+    EXPECT_EQ(SortWithRadix(items), items);
+}
+
+TEST(RadixSort, OddNumberOfPassesLeavesResultInItems)
+{
+    // Keys differ only in the lowest byte, so exactly one pass runs and the sorted result
+    // must be copied back from the scratch buffer.
+    std::vector<Item> items{
+        { .Key = 3, .Payload = 0 },
+        { .Key = 1, .Payload = 1 },
+        { .Key = 2, .Payload = 2 },
+        { .Key = 0, .Payload = 3 },
+    };
+
+    const std::vector<Item> sorted = SortWithRadix(items);
+
+    ASSERT_EQ(sorted.size(), 4u);
+    EXPECT_EQ(sorted[0].Payload, 3u);
+    EXPECT_EQ(sorted[1].Payload, 1u);
+    EXPECT_EQ(sorted[2].Payload, 2u);
+    EXPECT_EQ(sorted[3].Payload, 0u);
+}
+
+// NOLINTEND(readability-magic-numbers,cppcoreguidelines-avoid-magic-numbers)
@@ -0,0 +1,346 @@
+#include <gtest/gtest.h>
+
+#include "RenderGraph.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// NOLINTBEGIN(readability-magic-numbers,cppcoreguidelines-avoid-magic-numbers)
+
+namespace
+{
+using ResourceType = RenderGraph::ResourceType;
+
+constexpr RenderGraph::ResourceDesc kColorDesc //
+    {
+        .Type = ResourceType::ColorTarget,
+        .Dimensions = { .Width = 640, .Height = 480 },
+    };
+
+constexpr RenderGraph::ResourceDesc kDepthDesc //
+    {
+        .Type = ResourceType::DepthTarget,
+        .Dimensions = { .Width = 640, .Height = 480 },
+    };
+
+// Records the names of passes as they execute.
+struct ExecutionLog
+{
+    std::vector<std::string> Names;
+};
+
+struct PassData
+{
+    ExecutionLog* Log;
+    std::string Name;
+};
+
+Result<>
+RecordPass(PassData* data)
+{
+    data->Log->Names.push_back(data->Name);
+    return Result<>::Ok;
+}
+
+std::vector<std::string>
+GetExecutionOrder(const RenderGraph& graph)
+{
+    std::vector<std::string> names;
+
+    for(const uint32_t passIndex : graph.GetExecutionOrder())
+    {
+        names.emplace_back(graph.GetPassName(passIndex));
+    }
+
+    return names;
+}
+
+RenderGraph::ResourceDesc
+BufferDesc(const size_t byteSize)
+{
+    return { .Type = ResourceType::Buffer, .ByteSize = byteSize };
+}
+} // namespace
+
+TEST(RenderGraph, OrdersWritersBeforeReaders)
+{
+    RenderGraph graph;
+
+    const auto target = graph.Import("Target", kColorDesc);
+    const auto color = graph.CreateTransient("Color", kColorDesc);
+    const auto depth = graph.CreateTransient("Depth", kDepthDesc);
+    graph.MarkOutput(target);
+
+    ExecutionLog log;
+    PassData composite{ .Log = &log, .Name = "Composite" };
+    PassData draw{ .Log = &log, .Name = "Draw" };
+    PassData prepass{ .Log = &log, .Name = "Prepass" };
+
+    // The reader is added before the writers.
+    graph.AddPass<&RecordPass>("Composite", &composite).Read(color).Write(target);
+    graph.AddPass<&RecordPass>("Prepass", &prepass).Write(depth);
+    graph.AddPass<&RecordPass>("Draw", &draw).Read(depth).Write(depth).Write(color);
+
+    ASSERT_TRUE(graph.Compile());
+
+    const std::vector<std::string> expected{ "Prepass", "Draw", "Composite" };
+    EXPECT_EQ(GetExecutionOrder(graph), expected);
+
+    ASSERT_TRUE(graph.Execute());
+    EXPECT_EQ(log.Names, expected);
+}
+
+TEST(RenderGraph, WritersRunInTheOrderAdded)
+{
+    RenderGraph graph;
+
+    const auto target = graph.Import("Target", kColorDesc);
+    graph.MarkOutput(target);
+
+    ExecutionLog log;
+    PassData first{ .Log = &log, .Name = "First" };
+    PassData second{ .Log = &log, .Name = "Second" };
+
+    graph.AddPass<&RecordPass>("First", &first).Write(target);
+    graph.AddPass<&RecordPass>("Second", &second).Write(target);
+
+    ASSERT_TRUE(graph.Compile());
+
+    EXPECT_EQ(GetExecutionOrder(graph), (std::vector<std::string>{ "First", "Second" }));
+}
+
+TEST(RenderGraph, CullsPassesWhoseWritesAreNotRead)
+{
+    RenderGraph graph;
+
+    const auto target = graph.Import("Target", kColorDesc);
+    const auto unused = graph.CreateTransient("Unused", kColorDesc);
+    const auto clipSpace = graph.Import("ClipSpace", BufferDesc(1024));
+    graph.MarkOutput(target);
+
+    ExecutionLog log;
+    PassData transform{ .Log = &log, .Name = "Transform" };
+    PassData debug{ .Log = &log, .Name = "Debug" };
+    PassData draw{ .Log = &log, .Name = "Draw" };
+
+    // Imported resources that aren't outputs don't keep their writers.
+    const uint32_t transformIndex = graph.GetPassCount();
+    graph.AddPass<&RecordPass>("Transform", &transform).Write(clipSpace);
+    const uint32_t debugIndex = graph.GetPassCount();
+    graph.AddPass<&RecordPass>("Debug", &debug).Write(unused);
+    const uint32_t drawIndex = graph.GetPassCount();
+    graph.AddPass<&RecordPass>("Draw", &draw).Write(target);
+
+    ASSERT_TRUE(graph.Compile());
+
+    EXPECT_TRUE(graph.IsPassCulled(transformIndex));
+    EXPECT_TRUE(graph.IsPassCulled(debugIndex));
+    EXPECT_FALSE(graph.IsPassCulled(drawIndex));
+    EXPECT_FALSE(graph.HasPhysicalResource(unused));
+
+    ASSERT_TRUE(graph.Execute());
+    EXPECT_EQ(log.Names, (std::vector<std::string>{ "Draw" }));
+}
+
+TEST(RenderGraph, KeepsWritersOfResourcesReadByKeptPasses)
+{
+    RenderGraph graph;
+
+    const auto target = graph.Import("Target", kColorDesc);
+    const auto clipSpace = graph.Import("ClipSpace", BufferDesc(1024));
+    const auto marker = graph.CreateTransient("Marker", BufferDesc(16));
+    graph.MarkOutput(target);
+
+    ExecutionLog log;
+    PassData transform{ .Log = &log, .Name = "Transform" };
+    PassData draw{ .Log = &log, .Name = "Draw" };
+    PassData readback{ .Log = &log, .Name = "Readback" };
+
+    graph.AddPass<&RecordPass>("Transform", &transform).Write(clipSpace);
+    graph.AddPass<&RecordPass>("Draw", &draw).Read(clipSpace).Write(target);
+    graph.AddPass<&RecordPass>("Readback", &readback).Write(marker).SetSideEffects();
+
+    ASSERT_TRUE(graph.Compile());
+
+    EXPECT_EQ(GetExecutionOrder(graph),
+        (std::vector<std::string>{ "Transform", "Draw", "Readback" }));
+}
+
+TEST(RenderGraph, FailsOnCycles)
+{
+    RenderGraph graph;
+
+    const auto a = graph.CreateTransient("A", kColorDesc);
+    const auto b = graph.CreateTransient("B", kColorDesc);
+    const auto target = graph.Import("Target", kColorDesc);
+    graph.MarkOutput(target);
+
+    ExecutionLog log;
+    PassData first{ .Log = &log, .Name = "First" };
+    PassData second{ .Log = &log, .Name = "Second" };
+
+    graph.AddPass<&RecordPass>("First", &first).Read(b).Write(a);
+    graph.AddPass<&RecordPass>("Second", &second).Read(a).Write(b).Write(target);
+
+    EXPECT_FALSE(graph.Compile());
+}
+
+TEST(RenderGraph, FailsOnReadsOfUnwrittenTransients)
+{
+    RenderGraph graph;
+
+    const auto color = graph.CreateTransient("Color", kColorDesc);
+    const auto target = graph.Import("Target", kColorDesc);
+    graph.MarkOutput(target);
+
+    ExecutionLog log;
+    PassData composite{ .Log = &log, .Name = "Composite" };
+
+    graph.AddPass<&RecordPass>("Composite", &composite).Read(color).Write(target);
+
+    EXPECT_FALSE(graph.Compile());
+}
+
+TEST(RenderGraph, AliasesTransientsWithDisjointLifetimes)
+{
+    RenderGraph graph;
+
+    const auto target = graph.Import("Target", kColorDesc);
+    const auto shadow = graph.CreateTransient("Shadow", kDepthDesc);
+    const auto lighting = graph.CreateTransient("Lighting", kColorDesc);
+    const auto depth = graph.CreateTransient("Depth", kDepthDesc);
+    const auto color = graph.CreateTransient("Color", kColorDesc);
+    graph.MarkOutput(target);
+
+    ExecutionLog log;
+    PassData passes[4]{
+        { .Log = &log, .Name = "Shadow" },
+        { .Log = &log, .Name = "Lighting" },
+        { .Log = &log, .Name = "Draw" },
+        { .Log = &log, .Name = "Composite" },
+    };
+
+    graph.AddPass<&RecordPass>("Shadow", &passes[0]).Write(shadow);
+    graph.AddPass<&RecordPass>("Lighting", &passes[1]).Read(shadow).Write(lighting);
+    graph.AddPass<&RecordPass>("Draw", &passes[2]).Read(lighting).Write(depth).Write(color);
+    graph.AddPass<&RecordPass>("Composite", &passes[3]).Read(color).Write(target);
+
+    ASSERT_TRUE(graph.Compile());
+
+    // The shadow map is done with before the depth buffer is needed, but the lighting target
+    // is still being read when the color target is written.
+    EXPECT_EQ(&graph.GetPhysicalResource(shadow), &graph.GetPhysicalResource(depth));
+    EXPECT_NE(&graph.GetPhysicalResource(lighting), &graph.GetPhysicalResource(color));
+    EXPECT_EQ(graph.GetPhysicalResources().size(), 3u);
+
+    EXPECT_EQ(graph.GetPhysicalResource(lighting).Instance, 0u);
+    EXPECT_EQ(graph.GetPhysicalResource(color).Instance, 1u);
+}
+
+TEST(RenderGraph, DoesNotAliasDifferentDescriptions)
+{
+    RenderGraph graph;
+
+    const auto target = graph.Import("Target", kColorDesc);
+    const auto small = graph.CreateTransient("Small",
+        { .Type = ResourceType::ColorTarget, .Dimensions = { .Width = 320, .Height = 240 } });
+    const auto color = graph.CreateTransient("Color", kColorDesc);
+    graph.MarkOutput(target);
+
+    ExecutionLog log;
+    PassData first{ .Log = &log, .Name = "First" };
+    PassData second{ .Log = &log, .Name = "Second" };
+    PassData third{ .Log = &log, .Name = "Third" };
+
+    graph.AddPass<&RecordPass>("First", &first).Write(small);
+    graph.AddPass<&RecordPass>("Second", &second).Read(small).Write(color);
+    graph.AddPass<&RecordPass>("Third", &third).Read(color).Write(target);
+
+    ASSERT_TRUE(graph.Compile());
+
+    EXPECT_EQ(graph.GetPhysicalResources().size(), 2u);
+    EXPECT_EQ(graph.GetPhysicalResource(small).Instance, 0u);
+    EXPECT_EQ(graph.GetPhysicalResource(color).Instance, 0u);
+}
+
+TEST(RenderGraph, OutputsAreNotAliased)
+{
+    RenderGraph graph;
+
+    const auto color = graph.CreateTransient("Color", kColorDesc);
+    const auto scratch = graph.CreateTransient("Scratch", kColorDesc);
+    const auto target = graph.Import("Target", kColorDesc);
+    graph.MarkOutput(color);
+    graph.MarkOutput(target);
+
+    ExecutionLog log;
+    PassData draw{ .Log = &log, .Name = "Draw" };
+    PassData blur{ .Log = &log, .Name = "Blur" };
+    PassData resolve{ .Log = &log, .Name = "Resolve" };
+
+    // Nothing in the graph uses the color target after it's drawn.
+    graph.AddPass<&RecordPass>("Draw", &draw).Write(color);
+    graph.AddPass<&RecordPass>("Blur", &blur).Write(scratch);
+    graph.AddPass<&RecordPass>("Resolve", &resolve).Read(scratch).Write(target);
+
+    ASSERT_TRUE(graph.Compile());
+
+    EXPECT_NE(&graph.GetPhysicalResource(color), &graph.GetPhysicalResource(scratch));
+}
+
+TEST(RenderGraph, BuffersGrowToTheLargestAssigned)
+{
+    RenderGraph graph;
+
+    const auto target = graph.Import("Target", kColorDesc);
+    const auto small = graph.CreateTransient("Small", BufferDesc(256));
+    const auto large = graph.CreateTransient("Large", BufferDesc(4096));
+    const auto result = graph.CreateTransient("Result", kColorDesc);
+    graph.MarkOutput(target);
+
+    ExecutionLog log;
+    PassData passes[4]{
+        { .Log = &log, .Name = "A" },
+        { .Log = &log, .Name = "B" },
+        { .Log = &log, .Name = "C" },
+        { .Log = &log, .Name = "D" },
+    };
+
+    graph.AddPass<&RecordPass>("A", &passes[0]).Write(small);
+    graph.AddPass<&RecordPass>("B", &passes[1]).Read(small).Write(result);
+    graph.AddPass<&RecordPass>("C", &passes[2]).Read(result).Write(large);
+    graph.AddPass<&RecordPass>("D", &passes[3]).Read(large).Write(target);
+
+    ASSERT_TRUE(graph.Compile());
+
+    const RenderGraph::PhysicalResource& physical = graph.GetPhysicalResource(small);
+
+    EXPECT_EQ(&physical, &graph.GetPhysicalResource(large));
+    EXPECT_EQ(physical.Desc.ByteSize, 4096u);
+}
+
+TEST(RenderGraph, ClearKeepsNothing)
+{
+    RenderGraph graph;
+
+    const auto target = graph.Import("Target", kColorDesc);
+    graph.MarkOutput(target);
+
+    ExecutionLog log;
+    PassData draw{ .Log = &log, .Name = "Draw" };
+
+    graph.AddPass<&RecordPass>("Draw", &draw).Write(target);
+    ASSERT_TRUE(graph.Compile());
+
+    graph.Clear();
+    EXPECT_EQ(graph.GetPassCount(), 0u);
+
+    ASSERT_TRUE(graph.Compile());
+    ASSERT_TRUE(graph.Execute());
+
+    EXPECT_TRUE(graph.GetExecutionOrder().empty());
+    EXPECT_TRUE(log.Names.empty());
+}
+
+// NOLINTEND(readability-magic-numbers,cppcoreguidelines-avoid-magic-numbers)
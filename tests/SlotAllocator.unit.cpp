@@ -0,0 +1,65 @@
+#include <gtest/gtest.h>
+
+#include "SlotAllocator.h"
+
+#include <cstdint>
+
+// NOLINTBEGIN(readability-magic-numbers,cppcoreguidelines-avoid-magic-numbers)
+
+TEST(SlotAllocator, AllocatesSequentialSlots)
+{
+    SlotAllocator slots;
+
+    for(uint32_t i = 0; i < 8; ++i)
+    {
+        EXPECT_EQ(slots.Allocate(), i);
+    }
+
+    EXPECT_EQ(slots.GetAllocatedCount(), 8u);
+    EXPECT_EQ(slots.GetSlotCount(), 8u);
+}
+
+TEST(SlotAllocator, FreedSlotsAreReusedLowestFirst)
+{
+    SlotAllocator slots;
+
+    for(uint32_t i = 0; i < 8; ++i)
+    {
+        slots.Allocate();
+    }
+
+    slots.Free(5);
+    slots.Free(2);
+    slots.Free(6);
+
+    EXPECT_EQ(slots.GetAllocatedCount(), 5u);
+    EXPECT_EQ(slots.GetSlotCount(), 8u);
+    EXPECT_FALSE(slots.IsAllocated(2));
+
+    EXPECT_EQ(slots.Allocate(), 2u);
+    EXPECT_EQ(slots.Allocate(), 5u);
+    EXPECT_EQ(slots.Allocate(), 6u);
+
+    // No free slots remain so the array grows.
+    EXPECT_EQ(slots.Allocate(), 8u);
+    EXPECT_EQ(slots.GetSlotCount(), 9u);
+}
+
+TEST(SlotAllocator, SlotCountDoesNotShrink)
+{
+    SlotAllocator slots;
+
+    const uint32_t a = slots.Allocate();
+    const uint32_t b = slots.Allocate();
+
+    slots.Free(b);
+    slots.Free(a);
+
+    EXPECT_EQ(slots.GetAllocatedCount(), 0u);
+    EXPECT_EQ(slots.GetSlotCount(), 2u);
+    EXPECT_FALSE(slots.IsAllocated(a));
+    EXPECT_FALSE(slots.IsAllocated(b));
+    EXPECT_FALSE(slots.IsAllocated(100));
+}
+
+// NOLINTEND(readability-magic-numbers,cppcoreguidelines-avoid-magic-numbers)
@@ -0,0 +1,302 @@
+#include <gtest/gtest.h>
+
+#include "StaticBatcher.h"
+
+#include <algorithm>
+#include <ranges>
+#include <string>
+#include <vector>
+
+// NOLINTBEGIN(readability-magic-numbers,cppcoreguidelines-avoid-magic-numbers)
+
+namespace
+{
+MaterialDef
+MakeMaterial(const float red, const AlphaMode alphaMode = AlphaMode::Opaque)
+{
+    MaterialDef materialDef;
+    materialDef.Color = RgbaColorf{ red, 1, 1, 1 };
+    materialDef.AlphaMode = alphaMode;
+    return materialDef;
+}
+
+// A unit quad in the XY plane facing +Z.
+ModelDef
+MakeQuadModel(const std::string& name, const MaterialDef& materialDef)
+{
+    const Vec3f normal(0, 0, 1);
+
+    MeshDef meshDef //
+        {
+            .Vertices =
+            {
+                { .pos = Vec3f(0, 0, 0), .normal = normal, .uvs = { { .u = 0, .v = 0 } } },
+                { .pos = Vec3f(1, 0, 0), .normal = normal, .uvs = { { .u = 1, .v = 0 } } },
+                { .pos = Vec3f(0, 1, 0), .normal = normal, .uvs = { { .u = 0, .v = 1 } } },
+                { .pos = Vec3f(1, 1, 0), .normal = normal, .uvs = { { .u = 1, .v = 1 } } },
+            },
+            .Indices = { 0, 1, 2, 2, 1, 3 },
+            .MaterialDef = materialDef,
+        };
+
+    return ModelDef{ .Name = name, .MeshDefs = { std::move(meshDef) } };
+}
+
+RootNodeDef
+MakeRootNode(const std::string& modelName, const Vec3f& translation)
+{
+    RootNodeDef nodeDef;
+    nodeDef.Name = modelName;
+    nodeDef.Transform.T = translation;
+    nodeDef.Model = ModelRef{ .Name = modelName };
+    return nodeDef;
+}
+
+const ModelDef*
+FindModel(const PropKitDef& propKitDef, const std::string& name)
+{
+    const auto it = std::ranges::find(propKitDef.ModelDefs, name, &ModelDef::Name);
+    return it != propKitDef.ModelDefs.end() ? &*it : nullptr;
+}
+
+size_t
+CountBatches(const PropKitDef& propKitDef)
+{
+    return static_cast<size_t>(std::ranges::count_if(propKitDef.ModelDefs,
+        [](const ModelDef& modelDef) { return modelDef.Name.starts_with("StaticBatch"); }));
+}
+} // namespace
+
+TEST(StaticBatcher, MergesStaticMeshesWithTheSameMaterial)
+{
+    const MaterialDef material = MakeMaterial(1);
+
+    PropKitDef propKitDef;
+    propKitDef.ModelDefs.push_back(MakeQuadModel("A", material));
+    propKitDef.ModelDefs.push_back(MakeQuadModel("B", material));
+
+    LevelDef levelDef;
+    levelDef.NodeDefs.push_back(MakeRootNode("A", Vec3f(0, 0, 0)));
+    levelDef.NodeDefs.push_back(MakeRootNode("B", Vec3f(2, 0, 0)));
+
+    EXPECT_EQ(StaticBatcher::Build(propKitDef, levelDef), 2u);
+
+    // The batched models and their nodes are replaced by one batch.
+    ASSERT_EQ(propKitDef.ModelDefs.size(), 1u);
+    ASSERT_EQ(levelDef.NodeDefs.size(), 1u);
+    EXPECT_EQ(levelDef.NodeDefs[0].Model->Name, propKitDef.ModelDefs[0].Name);
+    EXPECT_EQ(levelDef.NodeDefs[0].Transform, TrsTransformf::Identity);
+
+    const ModelDef& batch = propKitDef.ModelDefs[0];
+    ASSERT_EQ(batch.MeshDefs.size(), 1u);
+
+    const MeshDef& meshDef = batch.MeshDefs[0];
+    EXPECT_EQ(meshDef.Vertices.size(), 8u);
+    EXPECT_EQ(meshDef.Indices.size(), 12u);
+
+    // Vertices are in world space.
+    const auto [minX, maxX] = std::ranges::minmax(meshDef.Vertices | std::views::transform(
+        [](const Vertex& vertex) { return vertex.pos.x; }));
+
+    EXPECT_FLOAT_EQ(minX, 0);
+    EXPECT_FLOAT_EQ(maxX, 3);
+}
+
+TEST(StaticBatcher, KeepsMaterialsSeparate)
+{
+    PropKitDef propKitDef;
+    propKitDef.ModelDefs.push_back(MakeQuadModel("A", MakeMaterial(1)));
+    propKitDef.ModelDefs.push_back(MakeQuadModel("B", MakeMaterial(0.5f)));
+    propKitDef.ModelDefs.push_back(MakeQuadModel("C", MakeMaterial(1)));
+
+    LevelDef levelDef;
+    levelDef.NodeDefs.push_back(MakeRootNode("A", Vec3f(0, 0, 0)));
+    levelDef.NodeDefs.push_back(MakeRootNode("B", Vec3f(1, 0, 0)));
+    levelDef.NodeDefs.push_back(MakeRootNode("C", Vec3f(2, 0, 0)));
+
+    EXPECT_EQ(StaticBatcher::Build(propKitDef, levelDef), 3u);
+    EXPECT_EQ(CountBatches(propKitDef), 2u);
+
+    for(const ModelDef& modelDef : propKitDef.ModelDefs)
+    {
+        ASSERT_EQ(modelDef.MeshDefs.size(), 1u);
+    }
+}
+
+TEST(StaticBatcher, SkipsInstancedDynamicAndBlendedModels)
+{
+    PropKitDef propKitDef;
+    propKitDef.ModelDefs.push_back(MakeQuadModel("Instanced", MakeMaterial(1)));
+    propKitDef.ModelDefs.push_back(MakeQuadModel("Dynamic", MakeMaterial(1)));
+    propKitDef.ModelDefs.push_back(MakeQuadModel("Blended", MakeMaterial(1, AlphaMode::Blend)));
+
+    LevelDef levelDef;
+    levelDef.NodeDefs.push_back(MakeRootNode("Instanced", Vec3f(0, 0, 0)));
+    levelDef.NodeDefs.push_back(MakeRootNode("Instanced", Vec3f(1, 0, 0)));
+    levelDef.NodeDefs.push_back(MakeRootNode("Blended", Vec3f(2, 0, 0)));
+
+    RootNodeDef dynamicNode = MakeRootNode("Dynamic", Vec3f(3, 0, 0));
+    dynamicNode.Body = RigidBodyDef //
+        {
+            .Mass = Mass(1),
+            .MotionType = MotionType::Dynamic,
+            .Colliders = {},
+        };
+    levelDef.NodeDefs.push_back(std::move(dynamicNode));
+
+    EXPECT_EQ(StaticBatcher::Build(propKitDef, levelDef), 0u);
+    EXPECT_EQ(propKitDef.ModelDefs.size(), 3u);
+    EXPECT_EQ(levelDef.NodeDefs.size(), 4u);
+}
+
+TEST(StaticBatcher, PrunesEmptiedChildNodes)
+{
+    PropKitDef propKitDef;
+    propKitDef.ModelDefs.push_back(MakeQuadModel("Child", MakeMaterial(1)));
+    propKitDef.ModelDefs.push_back(MakeQuadModel("Instanced", MakeMaterial(0.5f)));
+
+    RootNodeDef root = MakeRootNode("Instanced", Vec3f(10, 0, 0));
+    root.Children.push_back(LevelNodeDef //
+        {
+            .Name = "Child",
+            .Transform = TrsTransformf{ .T = Vec3f(0, 5, 0) },
+            .Children = {},
+            .Model = ModelRef{ .Name = "Child" },
+        });
+
+    LevelDef levelDef;
+    levelDef.NodeDefs.push_back(std::move(root));
+    levelDef.NodeDefs.push_back(MakeRootNode("Instanced", Vec3f(20, 0, 0)));
+
+    EXPECT_EQ(StaticBatcher::Build(propKitDef, levelDef), 1u);
+
+    // The child's parent transform is baked into the batch.
+    ASSERT_TRUE(levelDef.NodeDefs[0].Children.empty());
+    ASSERT_NE(FindModel(propKitDef, "StaticBatch0"), nullptr);
+    EXPECT_EQ(FindModel(propKitDef, "Child"), nullptr);
+
+    const MeshDef& meshDef = FindModel(propKitDef, "StaticBatch0")->MeshDefs[0];
+    EXPECT_FLOAT_EQ(meshDef.Vertices[0].pos.x, 10);
+    EXPECT_FLOAT_EQ(meshDef.Vertices[0].pos.y, 5);
+}
+
+TEST(StaticBatcher, KeepsNodesThatHadNoModel)
+{
+    PropKitDef propKitDef;
+    propKitDef.ModelDefs.push_back(MakeQuadModel("A", MakeMaterial(1)));
+
+    RootNodeDef anchor;
+    anchor.Name = "Anchor";
+    anchor.Children.push_back(LevelNodeDef //
+        {
+            .Name = "Empty",
+            .Transform = TrsTransformf::Identity,
+            .Children = {},
+            .Model = std::nullopt,
+        });
+
+    LevelDef levelDef;
+    levelDef.NodeDefs.push_back(std::move(anchor));
+    levelDef.NodeDefs.push_back(MakeRootNode("A", Vec3f(0, 0, 0)));
+
+    EXPECT_EQ(StaticBatcher::Build(propKitDef, levelDef), 1u);
+
+    // The batched node is replaced by the batch node, the anchor and its child are kept.
+    ASSERT_EQ(levelDef.NodeDefs.size(), 2u);
+    EXPECT_EQ(levelDef.NodeDefs[0].Name, "Anchor");
+    ASSERT_EQ(levelDef.NodeDefs[0].Children.size(), 1u);
+    EXPECT_EQ(levelDef.NodeDefs[0].Children[0].Name, "Empty");
+}
+
+TEST(StaticBatcher, BatchNamesDontCollideWithModelNames)
+{
+    PropKitDef propKitDef;
+    propKitDef.ModelDefs.push_back(MakeQuadModel("StaticBatch0", MakeMaterial(0.5f)));
+    propKitDef.ModelDefs.push_back(MakeQuadModel("A", MakeMaterial(1)));
+
+    LevelDef levelDef;
+    levelDef.NodeDefs.push_back(MakeRootNode("StaticBatch0", Vec3f(0, 0, 0)));
+    levelDef.NodeDefs.push_back(MakeRootNode("StaticBatch0", Vec3f(1, 0, 0)));
+    levelDef.NodeDefs.push_back(MakeRootNode("A", Vec3f(2, 0, 0)));
+
+    EXPECT_EQ(StaticBatcher::Build(propKitDef, levelDef), 1u);
+    ASSERT_EQ(propKitDef.ModelDefs.size(), 2u);
+
+    // The instanced model keeps its name and the batch gets another.
+    EXPECT_EQ(propKitDef.ModelDefs[0].Name, "StaticBatch0");
+    EXPECT_EQ(propKitDef.ModelDefs[0].MeshDefs[0].Vertices[0].pos.x, 0);
+    EXPECT_NE(propKitDef.ModelDefs[1].Name, "StaticBatch0");
+    EXPECT_EQ(levelDef.NodeDefs.back().Model->Name, propKitDef.ModelDefs[1].Name);
+}
+
+TEST(StaticBatcher, SplitsDistantMeshesIntoClusters)
+{
+    const MaterialDef material = MakeMaterial(1);
+
+    PropKitDef propKitDef;
+    LevelDef levelDef;
+
+    constexpr size_t kNodeCount = 64;
+    constexpr float kSpacing = 4;
+
+    for(size_t i = 0; i < kNodeCount; ++i)
+    {
+        const std::string name = "Quad" + std::to_string(i);
+        propKitDef.ModelDefs.push_back(MakeQuadModel(name, material));
+        levelDef.NodeDefs.push_back(
+            MakeRootNode(name, Vec3f(static_cast<float>(i) * kSpacing, 0, 0)));
+    }
+
+    EXPECT_EQ(StaticBatcher::Build(propKitDef, levelDef), kNodeCount);
+
+    const float levelExtent = ((kNodeCount - 1) * kSpacing) + 1;
+    const float maxExtent = levelExtent * StaticBatcher::kMaxClusterExtentFraction;
+
+    EXPECT_GE(propKitDef.ModelDefs.size(), 8u);
+    EXPECT_LT(propKitDef.ModelDefs.size(), kNodeCount);
+
+    size_t vertexCount = 0;
+
+    for(const ModelDef& modelDef : propKitDef.ModelDefs)
+    {
+        const MeshDef& meshDef = modelDef.MeshDefs[0];
+        const BoundingBox bounds = BoundingBox::FromVertices(meshDef.Vertices, meshDef.Indices);
+
+        EXPECT_LE(bounds.GetHalfExtents().x * 2, maxExtent);
+        vertexCount += meshDef.Vertices.size();
+    }
+
+    EXPECT_EQ(vertexCount, kNodeCount * 4);
+}
+
+TEST(StaticBatcher, MirroredTransformsKeepTrianglesFacingTheirNormals)
+{
+    PropKitDef propKitDef;
+    propKitDef.ModelDefs.push_back(MakeQuadModel("A", MakeMaterial(1)));
+    propKitDef.ModelDefs.push_back(MakeQuadModel("B", MakeMaterial(1)));
+
+    RootNodeDef mirrored = MakeRootNode("B", Vec3f(0, 0, 0));
+    mirrored.Transform.S = Vec3f(1, 1, -1);
+
+    LevelDef levelDef;
+    levelDef.NodeDefs.push_back(MakeRootNode("A", Vec3f(0, 0, 0)));
+    levelDef.NodeDefs.push_back(std::move(mirrored));
+
+    EXPECT_EQ(StaticBatcher::Build(propKitDef, levelDef), 2u);
+    ASSERT_EQ(propKitDef.ModelDefs.size(), 1u);
+
+    const MeshDef& meshDef = propKitDef.ModelDefs[0].MeshDefs[0];
+
+    for(size_t i = 0; i < meshDef.Indices.size(); i += 3)
+    {
+        const Vertex& v0 = meshDef.Vertices[meshDef.Indices[i]];
+        const Vertex& v1 = meshDef.Vertices[meshDef.Indices[i + 1]];
+        const Vertex& v2 = meshDef.Vertices[meshDef.Indices[i + 2]];
+
+        const Vec3f faceNormal = (v1.pos - v0.pos).Cross(v2.pos - v0.pos);
+
+        EXPECT_GT(faceNormal.Dot(v0.normal), 0) << i;
+    }
+}
+
+// NOLINTEND(readability-magic-numbers,cppcoreguidelines-avoid-magic-numbers)
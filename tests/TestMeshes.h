@@ -0,0 +1,107 @@
+#pragma once
+
+#include "VecMath.h"
+#include "Vertex.h"
+
+#include <cmath>
+#include <cstdint>
+#include <numbers>
+#include <vector>
+
+// Indexed triangle meshes shared by the tests of mesh processing.
+
+struct TestMesh
+{
+    std::vector<Vec3f> Positions;
+    std::vector<VertexIndex> Indices;
+};
+
+// A flat grid in the XY plane with gridSize x gridSize quads, facing -Z.
+inline TestMesh
+MakeGrid(const uint32_t gridSize)
+{
+    TestMesh mesh;
+
+    for(uint32_t y = 0; y <= gridSize; ++y)
+    {
+        for(uint32_t x = 0; x <= gridSize; ++x)
+        {
+            mesh.Positions.emplace_back(static_cast<float>(x), static_cast<float>(y), 0.0f);
+        }
+    }
+
+    const uint32_t stride = gridSize + 1;
+
+    for(uint32_t y = 0; y < gridSize; ++y)
+    {
+        for(uint32_t x = 0; x < gridSize; ++x)
+        {
+            const VertexIndex i0 = (y * stride) + x;
+            const VertexIndex i1 = i0 + 1;
+            const VertexIndex i2 = i0 + stride;
+            const VertexIndex i3 = i2 + 1;
+
+            mesh.Indices.insert(mesh.Indices.end(), { i0, i2, i1, i1, i2, i3 });
+        }
+    }
+
+    return mesh;
+}
+
+// A closed unit sphere with outward facing triangles, shared vertices and single vertices at
+// the poles.
+inline TestMesh
+MakeSphere(const uint32_t rings, const uint32_t segments)
+{
+    TestMesh mesh;
+
+    mesh.Positions.emplace_back(0.0f, 1.0f, 0.0f);
+
+    for(uint32_t ring = 1; ring < rings; ++ring)
+    {
+        const float phi = std::numbers::pi_v<float> * static_cast<float>(ring)
+            / static_cast<float>(rings);
+
+        for(uint32_t segment = 0; segment < segments; ++segment)
+        {
+            const float theta = 2 * std::numbers::pi_v<float> * static_cast<float>(segment)
+                / static_cast<float>(segments);
+
+            mesh.Positions.emplace_back(std::sin(phi) * std::cos(theta),
+                std::cos(phi),
+                std::sin(phi) * std::sin(theta));
+        }
+    }
+
+    mesh.Positions.emplace_back(0.0f, -1.0f, 0.0f);
+
+    const VertexIndex bottom = static_cast<VertexIndex>(mesh.Positions.size() - 1);
+    auto ringVertex = [segments](const uint32_t ring, const uint32_t segment)
+    {
+        return 1 + ((ring - 1) * segments) + (segment % segments);
+    };
+
+    for(uint32_t segment = 0; segment < segments; ++segment)
+    {
+        mesh.Indices.insert(mesh.Indices.end(),
+            { 0, ringVertex(1, segment + 1), ringVertex(1, segment) });
+
+        mesh.Indices.insert(mesh.Indices.end(),
+            { bottom, ringVertex(rings - 1, segment), ringVertex(rings - 1, segment + 1) });
+    }
+
+    for(uint32_t ring = 1; ring + 1 < rings; ++ring)
+    {
+        for(uint32_t segment = 0; segment < segments; ++segment)
+        {
+            const VertexIndex i0 = ringVertex(ring, segment);
+            const VertexIndex i1 = ringVertex(ring, segment + 1);
+            const VertexIndex i2 = ringVertex(ring + 1, segment);
+            const VertexIndex i3 = ringVertex(ring + 1, segment + 1);
+
+            mesh.Indices.insert(mesh.Indices.end(), { i0, i1, i2, i1, i3, i2 });
+        }
+    }
+
+    return mesh;
+}
@@ -0,0 +1,147 @@
+#include <gtest/gtest.h>
+
+#include "TransformSnapshotBuffer.h"
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+// NOLINTBEGIN(readability-magic-numbers,cppcoreguidelines-avoid-magic-numbers)
+
+namespace
+{
+Mat44f
+Translation(const float x)
+{
+    return TrsTransformf{ .T{ x, 0, 0 } }.ToMatrix();
+}
+
+float
+TranslationX(const Mat44f& transform)
+{
+    return transform.Mul(Vec4f(0, 0, 0, 1)).x;
+}
+
+std::vector<float>
+ReadTranslations(const TransformSnapshotBuffer& snapshots, uint64_t& outStep)
+{
+    std::vector<float> translations;
+
+    outStep = snapshots.Read(
+        [&translations](const std::span<const Mat44f> transforms)
+        {
+            for(const Mat44f& transform : transforms)
+            {
+                translations.push_back(TranslationX(transform));
+            }
+        });
+
+    return translations;
+}
+} // namespace
+
+TEST(TransformSnapshotBuffer, InitialSnapshotIsStepZero)
+{
+    const std::vector<Mat44f> transforms{ Translation(1), Translation(2), Translation(3) };
+    const TransformSnapshotBuffer snapshots(transforms);
+
+    uint64_t step = 1;
+    const std::vector<float> translations = ReadTranslations(snapshots, step);
+
+    EXPECT_EQ(snapshots.GetCount(), 3u);
+    EXPECT_EQ(step, 0u);
+    EXPECT_EQ(translations, (std::vector<float>{ 1, 2, 3 }));
+}
+
+TEST(TransformSnapshotBuffer, WritesAreVisibleAfterPublish)
+{
+    const std::vector<Mat44f> transforms{ Translation(1), Translation(2) };
+    TransformSnapshotBuffer snapshots(transforms);
+
+    snapshots.GetBackBuffer()[1] = Translation(5);
+
+    uint64_t step = 1;
+    EXPECT_EQ(ReadTranslations(snapshots, step), (std::vector<float>{ 1, 2 }));
+    EXPECT_EQ(step, 0u);
+
+    snapshots.Publish(1);
+
+    EXPECT_EQ(ReadTranslations(snapshots, step), (std::vector<float>{ 1, 5 }));
+    EXPECT_EQ(step, 1u);
+}
+
+TEST(TransformSnapshotBuffer, BackBufferHoldsPreviousSnapshot)
+{
+    const std::vector<Mat44f> transforms{ Translation(0) };
+    TransformSnapshotBuffer snapshots(transforms);
+
+    snapshots.GetBackBuffer()[0] = Translation(1);
+    snapshots.Publish(1);
+
+    // The back buffer is the snapshot published before the latest one.
+    EXPECT_EQ(TranslationX(snapshots.GetBackBuffer()[0]), 0.0f);
+
+    snapshots.GetBackBuffer()[0] = Translation(2);
+    snapshots.Publish(2);
+
+    EXPECT_EQ(TranslationX(snapshots.GetBackBuffer()[0]), 1.0f);
+}
+
+TEST(TransformSnapshotBuffer, ReadersNeverSeePartialSnapshots)
+{
+    constexpr size_t kCount = 64;
+    constexpr uint64_t kStepCount = 2000;
+
+    const std::vector<Mat44f> transforms(kCount, Translation(0));
+    TransformSnapshotBuffer snapshots(transforms);
+
+    std::atomic<bool> done{ false };
+
+    // Every transform in the snapshot for step n is a translation by n.
+    std::thread writer(
+        [&snapshots, &done]
+        {
+            for(uint64_t step = 1; step <= kStepCount; ++step)
+            {
+                for(Mat44f& transform : snapshots.GetBackBuffer())
+                {
+                    transform = Translation(static_cast<float>(step));
+                }
+
+                snapshots.Publish(step);
+            }
+
+            done.store(true);
+        });
+
+    uint64_t lastStep = 0;
+    bool consistent = true;
+    bool ordered = true;
+
+    while(!done.load())
+    {
+        uint64_t step = 0;
+        const std::vector<float> translations = ReadTranslations(snapshots, step);
+
+        for(const float translation : translations)
+        {
+            consistent = consistent && translation == static_cast<float>(step);
+        }
+
+        ordered = ordered && step >= lastStep;
+        lastStep = step;
+    }
+
+    writer.join();
+
+    uint64_t finalStep = 0;
+    const std::vector<float> finalTranslations = ReadTranslations(snapshots, finalStep);
+
+    EXPECT_TRUE(consistent);
+    EXPECT_TRUE(ordered);
+    EXPECT_EQ(finalStep, kStepCount);
+    EXPECT_EQ(finalTranslations, std::vector<float>(kCount, static_cast<float>(kStepCount)));
+}
+
+// NOLINTEND(readability-magic-numbers,cppcoreguidelines-avoid-magic-numbers)
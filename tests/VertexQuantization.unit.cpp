@@ -0,0 +1,226 @@
+#include <gtest/gtest.h>
+
+#include "VertexQuantization.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <numbers>
+#include <vector>
+
+// NOLINTBEGIN(readability-magic-numbers,cppcoreguidelines-avoid-magic-numbers)
+
+namespace
+{
+// Unit vectors spread over the sphere, including the poles and the octahedron's edges.
+std::vector<Vec3f>
+MakeNormals()
+{
+    std::vector<Vec3f> normals //
+        {
+            Vec3f(1, 0, 0),
+            Vec3f(-1, 0, 0),
+            Vec3f(0, 1, 0),
+            Vec3f(0, -1, 0),
+            Vec3f(0, 0, 1),
+            Vec3f(0, 0, -1),
+            Vec3f(1, 1, 0).Normalize(),
+            Vec3f(-1, 0, -1).Normalize(),
+        };
+
+    constexpr uint32_t kRings = 64;
+    constexpr uint32_t kSegments = 128;
+
+    for(uint32_t ring = 1; ring < kRings; ++ring)
+    {
+        const float phi = std::numbers::pi_v<float> * static_cast<float>(ring)
+            / static_cast<float>(kRings);
+
+        for(uint32_t segment = 0; segment < kSegments; ++segment)
+        {
+            const float theta = 2 * std::numbers::pi_v<float> * static_cast<float>(segment)
+                / static_cast<float>(kSegments);
+
+            normals.emplace_back(std::sin(phi) * std::cos(theta),
+                std::sin(phi) * std::sin(theta),
+                std::cos(phi));
+        }
+    }
+
+    return normals;
+}
+} // namespace
+
+TEST(VertexQuantization, PositionErrorIsWithinHalfAStep)
+{
+    const BoundingBox bounds(Vec3f(-3, 10, 0), Vec3f(5, 10.5f, 200));
+    const PositionQuantization quantization = PositionQuantization::FromBounds(bounds);
+
+    const Vec3f step = quantization.Scale / 65535.0f;
+
+    for(uint32_t i = 0; i <= 1000; ++i)
+    {
+        const float t = static_cast<float>(i) / 1000.0f;
+        const Vertex vertex //
+            {
+                .pos = Vec3f(-3 + (8 * t), 10 + (0.5f * (1 - t)), 200 * t * t),
+                .normal = Vec3f(0, 1, 0),
+                .uvs = { { .u = 0, .v = 0 } },
+            };
+
+        const Vertex decoded =
+            VertexQuantization::Decode(VertexQuantization::Encode(vertex, quantization),
+                quantization);
+
+        // Half a quantization step, plus float rounding of the decode.
+        EXPECT_NEAR(decoded.pos.x, vertex.pos.x, (step.x * 0.5f) + 1e-6f);
+        EXPECT_NEAR(decoded.pos.y, vertex.pos.y, (step.y * 0.5f) + 1e-5f);
+        EXPECT_NEAR(decoded.pos.z, vertex.pos.z, (step.z * 0.5f) + 1e-5f);
+    }
+}
+
+TEST(VertexQuantization, BoundsCornersAreExact)
+{
+    const BoundingBox bounds(Vec3f(-1, -2, -4), Vec3f(1, 2, 4));
+    const PositionQuantization quantization = PositionQuantization::FromBounds(bounds);
+
+    const Vertex minCorner{ .pos = Vec3f(-1, -2, -4), .normal = Vec3f(0, 0, 1), .uvs{} };
+    const Vertex maxCorner{ .pos = Vec3f(1, 2, 4), .normal = Vec3f(0, 0, 1), .uvs{} };
+
+    const QuantizedVertex encodedMin = VertexQuantization::Encode(minCorner, quantization);
+    const QuantizedVertex encodedMax = VertexQuantization::Encode(maxCorner, quantization);
+
+    EXPECT_EQ(encodedMin.pos[0], 0u);
+    EXPECT_EQ(encodedMin.pos[1], 0u);
+    EXPECT_EQ(encodedMin.pos[2], 0u);
+    EXPECT_EQ(encodedMax.pos[0], 65535u);
+    EXPECT_EQ(encodedMax.pos[1], 65535u);
+    EXPECT_EQ(encodedMax.pos[2], 65535u);
+
+    const Vertex decodedMax = VertexQuantization::Decode(encodedMax, quantization);
+
+    EXPECT_FLOAT_EQ(decodedMax.pos.x, 1);
+    EXPECT_FLOAT_EQ(decodedMax.pos.y, 2);
+    EXPECT_FLOAT_EQ(decodedMax.pos.z, 4);
+}
+
+TEST(VertexQuantization, FlatMeshesDecodeToTheirPlane)
+{
+    // No extent along Y.
+    const BoundingBox bounds(Vec3f(0, 3, 0), Vec3f(10, 3, 10));
+    const PositionQuantization quantization = PositionQuantization::FromBounds(bounds);
+
+    const Vertex vertex{ .pos = Vec3f(2, 3, 7), .normal = Vec3f(0, 1, 0), .uvs{} };
+    const Vertex decoded =
+        VertexQuantization::Decode(VertexQuantization::Encode(vertex, quantization), quantization);
+
+    EXPECT_FLOAT_EQ(decoded.pos.y, 3);
+    EXPECT_NEAR(decoded.pos.x, 2, 1e-4f);
+    EXPECT_NEAR(decoded.pos.z, 7, 1e-4f);
+}
+
+TEST(VertexQuantization, OctahedralNormalErrorIsSmall)
+{
+    float maxAngle = 0;
+
+    for(const Vec3f& normal : MakeNormals())
+    {
+        const Vec3f decoded =
+            VertexQuantization::DecodeOctahedral(VertexQuantization::EncodeOctahedral(normal));
+
+        EXPECT_NEAR(decoded.Length(), 1.0f, 1e-5f);
+
+        const float angle = std::acos(std::clamp(decoded.Dot(normal), -1.0f, 1.0f));
+        maxAngle = std::max(maxAngle, angle);
+    }
+
+    // 16 bit octahedral normals are accurate to a few thousandths of a degree. acos() of a dot
+    // product near 1 is imprecise, so this bound is looser than the encoding's.
+    EXPECT_LT(maxAngle, 0.001f);
+}
+
+TEST(VertexQuantization, OctahedralAxesAreExact)
+{
+    for(const Vec3f& axis : { Vec3f(1, 0, 0),
+            Vec3f(-1, 0, 0),
+            Vec3f(0, 1, 0),
+            Vec3f(0, -1, 0),
+            Vec3f(0, 0, 1),
+            Vec3f(0, 0, -1) })
+    {
+        const Vec3f decoded =
+            VertexQuantization::DecodeOctahedral(VertexQuantization::EncodeOctahedral(axis));
+
+        EXPECT_FLOAT_EQ(decoded.x, axis.x);
+        EXPECT_FLOAT_EQ(decoded.y, axis.y);
+        EXPECT_FLOAT_EQ(decoded.z, axis.z);
+    }
+}
+
+TEST(VertexQuantization, HalfFloatRelativeErrorIsWithinHalfAnUlp)
+{
+    // Half floats have 10 explicit mantissa bits.
+    constexpr float kMaxRelativeError = 1.0f / 2048.0f;
+
+    // From the smallest normal half to beyond the largest.
+    for(float magnitude = 6.103515625e-5f; magnitude < 100000.0f; magnitude *= 1.0137f)
+    {
+        for(const float value : { magnitude, -magnitude })
+        {
+            const float decoded =
+                VertexQuantization::HalfToFloat(VertexQuantization::FloatToHalf(value));
+
+            if(magnitude >= 65520.0f)
+            {
+                EXPECT_TRUE(std::isinf(decoded)) << value;
+            }
+            else
+            {
+                EXPECT_LE(std::abs(decoded - value), magnitude * kMaxRelativeError) << value;
+            }
+        }
+    }
+
+    for(uint32_t i = 0; i <= 4096; ++i)
+    {
+        // Texture coordinates in and around [0, 1].
+        const float value = (static_cast<float>(i) / 1024.0f) - 1.5f;
+        const float decoded =
+            VertexQuantization::HalfToFloat(VertexQuantization::FloatToHalf(value));
+
+        EXPECT_LE(std::abs(decoded - value), std::abs(value) * kMaxRelativeError) << value;
+    }
+}
+
+TEST(VertexQuantization, HalfFloatSpecialValues)
+{
+    EXPECT_EQ(VertexQuantization::FloatToHalf(0.0f), 0x0000u);
+    EXPECT_EQ(VertexQuantization::FloatToHalf(-0.0f), 0x8000u);
+    EXPECT_EQ(VertexQuantization::FloatToHalf(1.0f), 0x3c00u);
+    EXPECT_EQ(VertexQuantization::FloatToHalf(-2.0f), 0xc000u);
+    EXPECT_EQ(VertexQuantization::FloatToHalf(65504.0f), 0x7bffu);
+    EXPECT_EQ(VertexQuantization::FloatToHalf(std::numeric_limits<float>::infinity()), 0x7c00u);
+
+    // Smallest subnormal half, and ties round to even.
+    EXPECT_EQ(VertexQuantization::FloatToHalf(5.9604645e-8f), 0x0001u);
+    EXPECT_EQ(VertexQuantization::FloatToHalf(1.0f + (1.0f / 2048.0f)), 0x3c00u);
+    EXPECT_EQ(VertexQuantization::FloatToHalf(1.0f + (3.0f / 2048.0f)), 0x3c02u);
+
+    EXPECT_TRUE(std::isnan(VertexQuantization::HalfToFloat(
+        VertexQuantization::FloatToHalf(std::numeric_limits<float>::quiet_NaN()))));
+
+    // Every finite half survives a round trip through float.
+    for(uint32_t half = 0; half < 0x10000; ++half)
+    {
+        if((half & 0x7c00) == 0x7c00)
+        {
+            continue;
+        }
+
+        const auto value = static_cast<uint16_t>(half);
+        EXPECT_EQ(VertexQuantization::FloatToHalf(VertexQuantization::HalfToFloat(value)), value);
+    }
+}
+
+// NOLINTEND(readability-magic-numbers,cppcoreguidelines-avoid-magic-numbers)